@@ -0,0 +1,427 @@
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+#include <mbedtls/ssl.h>
+
+#include "dtls.h"
+#include "tls_arena.h"
+
+// Three reports on DTLS:
+//
+// Ciphers: the server's startup self-benchmark, which times each record
+// cipher and decides the suite order every context offers.
+//
+// Memory: the heap each session holds once it is set up, which is what the
+// server's preallocated pool keeps for every client slot, counted by the TLS
+// arena pool mbedTLS allocates from. Most of it is mbedTLS's record buffers,
+// sized by MBEDTLS_SSL_IN/OUT_CONTENT_LEN; the rest is the SSL context's
+// handshake state, released when a handshake completes. Build once per mbedTLS
+// configuration to compare them.
+//
+// Handshakes: full handshakes against ones resumed from a session ticket, as a
+// reconnecting client would make, for a server with an RSA-2048 key and one
+// with an ECDSA P-256 key. Client and server run on one thread and exchange
+// datagrams in memory, so a row's time is both sides' CPU combined. Needs the
+// certificates from `make certs`; an identity whose files are missing is
+// skipped. Each identity also reports what one server session held at the
+// peak of its full handshake and keeps once established.
+//
+// Records: the same game-sized records carried by DTLS sessions and by the
+// plaintext transport (sc_dtls_context_create_plain()), written by the client,
+// fed to the server and read back. The difference between the two rows is what
+// record protection costs per datagram; the rest is framing and our own code.
+
+#define BENCH_CERT_PATH        ".secrets/certs/server.crt"
+#define BENCH_KEY_PATH         ".secrets/certs/server.key"
+#define BENCH_RSA_CERT_PATH    ".secrets/certs/server-rsa.crt"
+#define BENCH_RSA_KEY_PATH     ".secrets/certs/server-rsa.key"
+#define BENCH_FULL_HANDSHAKES  100
+#define BENCH_RESUMED          1000
+#define BENCH_FLIGHT_DATAGRAMS 16
+#define BENCH_DATAGRAM_SIZE    8192
+#define BENCH_MAX_ROUNDS       16
+#define BENCH_RECORDS          200000
+#define BENCH_RECORD_SIZE      64
+
+static const size_t g_session_counts[] = {100, 1000, 10000};
+
+// Datagrams one side sent and the other has not been handed yet
+typedef struct {
+  uint8_t data[BENCH_FLIGHT_DATAGRAMS][BENCH_DATAGRAM_SIZE];
+  size_t len[BENCH_FLIGHT_DATAGRAMS];
+  size_t count;
+} flight_t;
+
+// A server certificate and key the handshake benchmark runs against
+typedef struct {
+  const char *name;
+  const char *cert_path;
+  const char *key_path;
+} bench_identity_t;
+
+static const bench_identity_t g_identities[] = {
+  {"RSA-2048", BENCH_RSA_CERT_PATH, BENCH_RSA_KEY_PATH},
+  {"ECDSA P-256", BENCH_CERT_PATH, BENCH_KEY_PATH},
+};
+
+#define BENCH_IDENTITY_COUNT (sizeof(g_identities) / sizeof(g_identities[0]))
+
+// A client and server context wired to each other through two flights
+typedef struct {
+  dtls_context_t *client_ctx;
+  dtls_context_t *server_ctx;
+  int fd;
+  struct sockaddr_in client_addr;
+  struct sockaddr_in server_addr;
+  flight_t to_server;
+  flight_t to_client;
+} bench_link_t;
+
+static double elapsed_ns(const struct timespec *start, const struct timespec *end) {
+  return (double) (end->tv_sec - start->tv_sec) * 1e9 + (double) (end->tv_nsec - start->tv_nsec);
+}
+
+// Bytes mbedTLS holds across all sessions and contexts
+static size_t tls_in_use(void) {
+  sc_tls_pool_stats_t stats = sc_tls_arena_pool_stats();
+  return stats.in_use_bytes + stats.large_bytes;
+}
+
+static void bench_ciphers(void) {
+  if (sc_dtls_rank_ciphers() != DTLS_OK) {
+    fprintf(stderr, "cipher self-benchmark failed\n");
+    exit(1);
+  }
+
+  const dtls_cipher_ranking_t *ranking = sc_dtls_cipher_ranking();
+  printf("Record ciphers (1 KB records, fastest first)\n");
+  char unit[32];
+  snprintf(unit, sizeof(unit), "bytes/%s", ranking->unit);
+  printf("%20s %14s\n", "cipher", unit);
+  for (size_t i = 0; i < DTLS_CIPHER_COUNT; i++) {
+    printf("%20s %14.3f\n", ranking->rates[i].name, ranking->rates[i].bytes_per_tick);
+  }
+  printf("Preferred suite: %s\n\n", ranking->preferred_suite);
+}
+
+static void bench_sessions(size_t sessions) {
+  // Client contexts need no certificate; their sessions are set up exactly
+  // like the server's
+  dtls_context_t *ctx = sc_dtls_context_create(DTLS_ROLE_CLIENT, NULL, NULL, NULL, 0);
+  if (!ctx) {
+    fprintf(stderr, "context creation failed\n");
+    exit(1);
+  }
+
+  size_t before = tls_in_use();
+  if (sc_dtls_context_reserve_sessions(ctx, sessions) != DTLS_OK) {
+    fprintf(stderr, "reserving %zu sessions failed\n", sessions);
+    exit(1);
+  }
+  size_t after = tls_in_use();
+
+  double per_session = (double) (after - before) / (double) sessions;
+  printf("%10zu %16.0f %14.1f\n", sessions, per_session,
+         (double) (after - before) / (1024.0 * 1024.0));
+
+  sc_dtls_context_destroy(ctx);
+}
+
+// Transmit function: queue the datagram for the other side
+static ssize_t capture(void *user_data, const struct sockaddr *addr, socklen_t addr_len,
+                       const uint8_t *buf, size_t len) {
+  flight_t *flight = user_data;
+  (void) addr;
+  (void) addr_len;
+  if (flight->count == BENCH_FLIGHT_DATAGRAMS || len > BENCH_DATAGRAM_SIZE) {
+    errno = EMSGSIZE;
+    return -1;
+  }
+  memcpy(flight->data[flight->count], buf, len);
+  flight->len[flight->count++] = len;
+  return (ssize_t) len;
+}
+
+// Connect a new client session to a new server session the way the server
+// does: screen hellos until one carries a cookie, then create the session
+// Parameters:
+//   link - Contexts to connect through
+//   client_out - Receives the client session on success
+//   server_out - Receives the server session on success
+// Returns: true if both sides completed the handshake; on failure both
+//          sessions are destroyed
+static bool connect_pair(bench_link_t *link, dtls_session_t **client_out,
+                         dtls_session_t **server_out) {
+  const struct sockaddr *client_addr = (const struct sockaddr *) &link->client_addr;
+  const struct sockaddr *server_addr = (const struct sockaddr *) &link->server_addr;
+
+  link->to_server.count  = 0;
+  link->to_client.count  = 0;
+  dtls_session_t *client = sc_dtls_session_create(link->client_ctx, link->fd, server_addr,
+                                                  sizeof(link->server_addr));
+  dtls_session_t *server = NULL;
+  if (!client) {
+    return false;
+  }
+
+  dtls_result_t client_state = sc_dtls_handshake(client);
+  dtls_result_t server_state = DTLS_ERROR_WOULD_BLOCK;
+  for (int round = 0; round < BENCH_MAX_ROUNDS; round++) {
+    for (size_t i = 0; i < link->to_server.count; i++) {
+      const uint8_t *datagram = link->to_server.data[i];
+      size_t len              = link->to_server.len[i];
+      if (!server) {
+        if (sc_dtls_check_hello(link->server_ctx, link->fd, client_addr, sizeof(link->client_addr),
+                                datagram, len) != DTLS_HELLO_VERIFIED) {
+          continue;
+        }
+        server = sc_dtls_session_create(link->server_ctx, link->fd, client_addr,
+                                        sizeof(link->client_addr));
+        if (!server) {
+          break;
+        }
+      }
+      sc_dtls_feed(server, datagram, len);
+      server_state = sc_dtls_handshake(server);
+    }
+    link->to_server.count = 0;
+
+    for (size_t i = 0; i < link->to_client.count; i++) {
+      sc_dtls_feed(client, link->to_client.data[i], link->to_client.len[i]);
+      client_state = sc_dtls_handshake(client);
+    }
+    link->to_client.count = 0;
+
+    bool failed = (client_state != DTLS_OK && client_state != DTLS_ERROR_WOULD_BLOCK) ||
+                  (server_state != DTLS_OK && server_state != DTLS_ERROR_WOULD_BLOCK);
+    if (failed || (client_state == DTLS_OK && server_state == DTLS_OK)) {
+      break;
+    }
+  }
+
+  if (client_state != DTLS_OK || server_state != DTLS_OK) {
+    sc_dtls_session_destroy(server);
+    sc_dtls_session_destroy(client);
+    return false;
+  }
+  *client_out = client;
+  *server_out = server;
+  return true;
+}
+
+// Connect a client and server session and drop them again
+// Returns: true if both sides completed the handshake
+static bool connect_once(bench_link_t *link) {
+  dtls_session_t *client;
+  dtls_session_t *server;
+  if (!connect_pair(link, &client, &server)) {
+    return false;
+  }
+  sc_dtls_session_destroy(server);
+  sc_dtls_session_destroy(client);
+  return true;
+}
+
+// Point a link's contexts at each other over loopback addresses
+static void link_contexts(bench_link_t *link) {
+  sc_dtls_context_set_send(link->client_ctx, capture, &link->to_server);
+  sc_dtls_context_set_send(link->server_ctx, capture, &link->to_client);
+
+  link->client_addr.sin_family      = AF_INET;
+  link->client_addr.sin_port        = htons(50000);
+  link->client_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  link->server_addr                 = link->client_addr;
+  link->server_addr.sin_port        = htons(19840);
+}
+
+// Run handshakes and print their rate
+// Returns: Handshakes per second
+static double bench_handshakes(bench_link_t *link, const bench_identity_t *identity,
+                               const char *label, size_t count, bool resume) {
+  struct timespec start;
+  struct timespec end;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (size_t i = 0; i < count; i++) {
+    if (!resume) {
+      sc_dtls_context_forget_session(link->client_ctx);
+    }
+    if (!connect_once(link)) {
+      fprintf(stderr, "%s %s handshake %zu failed\n", identity->name, label, i);
+      exit(1);
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  double ns = elapsed_ns(&start, &end) / (double) count;
+  printf("%12s %10s %14.0f %14.3f\n", identity->name, label, 1e9 / ns, ns / 1e6);
+  return 1e9 / ns;
+}
+
+// Full and resumed handshakes against one server identity
+// Returns: Full handshakes per second, or 0 if the identity's files are missing
+static double bench_identity(const bench_identity_t *identity) {
+  static bench_link_t link;
+  link.server_ctx =
+    sc_dtls_context_create(DTLS_ROLE_SERVER, identity->cert_path, identity->key_path, NULL, 0);
+  if (!link.server_ctx) {
+    printf("%12s skipped: no %s (run make certs)\n", identity->name, identity->cert_path);
+    return 0;
+  }
+  link.client_ctx = sc_dtls_context_create(DTLS_ROLE_CLIENT, NULL, NULL, NULL, 0);
+  link.fd         = socket(AF_INET, SOCK_DGRAM, 0);
+  if (!link.client_ctx || link.fd < 0) {
+    fprintf(stderr, "handshake benchmark setup failed\n");
+    exit(1);
+  }
+  link_contexts(&link);
+
+  double full = bench_handshakes(&link, identity, "full", BENCH_FULL_HANDSHAKES, false);
+
+  dtls_session_t *client;
+  dtls_session_t *server;
+  sc_dtls_context_forget_session(link.client_ctx);
+  if (!connect_pair(&link, &client, &server)) {
+    fprintf(stderr, "%s handshake failed\n", identity->name);
+    exit(1);
+  }
+  dtls_memory_stats_t memory = sc_dtls_session_memory(server);
+  printf("%12s server session: %zu bytes at handshake peak, %zu established\n", identity->name,
+         memory.handshake_peak, memory.established_bytes);
+  sc_dtls_session_destroy(server);
+  sc_dtls_session_destroy(client);
+
+  // The client kept the last full handshake's session and resumes from here on
+  dtls_ticket_stats_t before = sc_dtls_context_ticket_stats(link.server_ctx);
+  double resumed             = bench_handshakes(&link, identity, "resumed", BENCH_RESUMED, true);
+  dtls_ticket_stats_t after  = sc_dtls_context_ticket_stats(link.server_ctx);
+  if (after.resumed - before.resumed != BENCH_RESUMED) {
+    fprintf(stderr, "only %" PRIu64 " of %d handshakes resumed\n", after.resumed - before.resumed,
+            BENCH_RESUMED);
+    exit(1);
+  }
+  printf("%12s %10s %14.1fx\n", identity->name, "speedup", resumed / full);
+
+  close(link.fd);
+  sc_dtls_context_destroy(link.client_ctx);
+  sc_dtls_context_destroy(link.server_ctx);
+  return full;
+}
+
+static void bench_identities(void) {
+  double full[BENCH_IDENTITY_COUNT];
+
+  printf("\nDTLS handshakes (client and server on one thread)\n");
+  printf("%12s %10s %14s %14s\n", "identity", "handshake", "per second", "ms each");
+  for (size_t i = 0; i < BENCH_IDENTITY_COUNT; i++) {
+    full[i] = bench_identity(&g_identities[i]);
+  }
+
+  if (full[0] > 0 && full[1] > 0) {
+    printf("Full handshakes, %s over %s: %.1fx\n", g_identities[1].name, g_identities[0].name,
+           full[1] / full[0]);
+  }
+}
+
+// Send records from a connected client session to its server session
+// Returns: Nanoseconds per record, write through read
+static double bench_record_link(bench_link_t *link, const char *name) {
+  dtls_session_t *client;
+  dtls_session_t *server;
+  link_contexts(link);
+  if (!link->client_ctx || !link->server_ctx || !connect_pair(link, &client, &server)) {
+    fprintf(stderr, "%s record benchmark setup failed\n", name);
+    exit(1);
+  }
+
+  uint8_t record[BENCH_RECORD_SIZE];
+  uint8_t received[BENCH_DATAGRAM_SIZE];
+  memset(record, 0xa5, sizeof(record));
+
+  struct timespec start;
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (size_t i = 0; i < BENCH_RECORDS; i++) {
+    size_t written        = 0;
+    size_t got            = 0;
+    link->to_server.count = 0;
+    if (sc_dtls_write(client, record, sizeof(record), &written) != DTLS_OK ||
+        link->to_server.count != 1 ||
+        sc_dtls_feed(server, link->to_server.data[0], link->to_server.len[0]) != DTLS_OK ||
+        sc_dtls_read(server, received, sizeof(received), &got) != DTLS_OK ||
+        got != sizeof(record)) {
+      fprintf(stderr, "%s record %zu failed\n", name, i);
+      exit(1);
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  double ns = elapsed_ns(&start, &end) / (double) BENCH_RECORDS;
+  printf("%12s %14.0f %14.0f\n", name, ns, 1e9 / ns);
+
+  sc_dtls_session_destroy(server);
+  sc_dtls_session_destroy(client);
+  sc_dtls_context_destroy(link->client_ctx);
+  sc_dtls_context_destroy(link->server_ctx);
+  return ns;
+}
+
+static void bench_records(void) {
+  static bench_link_t link;
+  link.fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (link.fd < 0) {
+    fprintf(stderr, "record benchmark setup failed\n");
+    exit(1);
+  }
+
+  printf("\nRecords (%d-byte payload, client write to server read)\n", BENCH_RECORD_SIZE);
+  printf("%12s %14s %14s\n", "transport", "ns/record", "per second");
+
+  link.server_ctx = sc_dtls_context_create_plain(DTLS_ROLE_SERVER);
+  link.client_ctx = sc_dtls_context_create_plain(DTLS_ROLE_CLIENT);
+  double plain    = bench_record_link(&link, "plaintext");
+
+  link.server_ctx =
+    sc_dtls_context_create(DTLS_ROLE_SERVER, BENCH_CERT_PATH, BENCH_KEY_PATH, NULL, 0);
+  if (!link.server_ctx) {
+    printf("%12s skipped: no %s (run make certs)\n", "DTLS", BENCH_CERT_PATH);
+    close(link.fd);
+    return;
+  }
+  link.client_ctx = sc_dtls_context_create(DTLS_ROLE_CLIENT, NULL, NULL, NULL, 0);
+  double dtls     = bench_record_link(&link, "DTLS");
+
+  printf("Record protection: %.0f ns/record, %.0f%% of the DTLS path\n", dtls - plain,
+         100.0 * (dtls - plain) / dtls);
+  close(link.fd);
+}
+
+int main(void) {
+  if (sc_dtls_init() != DTLS_OK) {
+    fprintf(stderr, "DTLS initialization failed\n");
+    return 1;
+  }
+
+  // Ranking goes first; it must not run while contexts exist
+  bench_ciphers();
+
+  printf("DTLS session memory (record buffers for %d-byte in / %d-byte out records)\n",
+         MBEDTLS_SSL_IN_CONTENT_LEN, MBEDTLS_SSL_OUT_CONTENT_LEN);
+  printf("%10s %16s %14s\n", "sessions", "bytes/session", "total MiB");
+
+  for (size_t i = 0; i < sizeof(g_session_counts) / sizeof(g_session_counts[0]); i++) {
+    bench_sessions(g_session_counts[i]);
+  }
+
+  bench_identities();
+  bench_records();
+
+  sc_dtls_cleanup();
+  return 0;
+}
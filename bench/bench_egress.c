@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include "egress.h"
+
+// Measures the cost of one broadcast burst, the server's 4 Hz state fan-out,
+// sent three ways over loopback:
+//   sendto:        one system call per datagram, as udp_send() did
+//   sendmmsg:      sc_egress with GSO disabled, one message per datagram
+//   sendmmsg+GSO:  sc_egress coalescing each peer's records into one message
+// Two shapes are timed: every peer receiving one small record, and every peer
+// receiving a run of MTU-sized records. CPU time is the sending thread's own,
+// which on loopback includes delivering the datagrams to the receivers.
+
+#define BENCH_PEERS        64
+#define BENCH_BURSTS       2000
+#define BENCH_SOCKET_BYTES (4 * 1024 * 1024)
+
+typedef enum { MODE_SENDTO, MODE_SENDMMSG, MODE_GSO } bench_mode_t;
+
+static const char *const g_mode_names[] = {"sendto", "sendmmsg", "sendmmsg+GSO"};
+
+static int g_peer_fds[BENCH_PEERS];
+static struct sockaddr_in g_peer_addrs[BENCH_PEERS];
+
+static double elapsed_ns(const struct timespec *start, const struct timespec *end) {
+  return (double) (end->tv_sec - start->tv_sec) * 1e9 + (double) (end->tv_nsec - start->tv_nsec);
+}
+
+static void fail(const char *what) {
+  fprintf(stderr, "%s: %s\n", what, strerror(errno));
+  exit(1);
+}
+
+// Bind a UDP socket to an ephemeral loopback port
+static int bind_loopback(struct sockaddr_in *addr) {
+  int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+  if (fd < 0) {
+    fail("socket");
+  }
+
+  int bytes = BENCH_SOCKET_BYTES;
+  setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bytes, sizeof(bytes));
+  setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &bytes, sizeof(bytes));
+
+  memset(addr, 0, sizeof(*addr));
+  addr->sin_family      = AF_INET;
+  addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len         = sizeof(*addr);
+  if (bind(fd, (struct sockaddr *) addr, sizeof(*addr)) < 0 ||
+      getsockname(fd, (struct sockaddr *) addr, &len) < 0) {
+    fail("bind");
+  }
+  return fd;
+}
+
+// Empty every receiver between bursts so none of them starts dropping
+static void drain_peers(void) {
+  uint8_t buf[2048];
+  for (size_t i = 0; i < BENCH_PEERS; i++) {
+    while (recv(g_peer_fds[i], buf, sizeof(buf), 0) > 0) {
+    }
+  }
+}
+
+static void run(bench_mode_t mode, size_t records, size_t record_size) {
+  struct sockaddr_in addr;
+  int fd = bind_loopback(&addr);
+
+  sc_egress_t *egress = sc_egress_init(fd, BENCH_PEERS * records, record_size);
+  if (!egress) {
+    fail("sc_egress_init");
+  }
+  if (mode == MODE_GSO && !egress->gso) {
+    printf("%-14s %16s\n", g_mode_names[mode], "(kernel lacks UDP GSO)");
+    sc_egress_nuke(egress);
+    close(fd);
+    return;
+  }
+  egress->gso = mode == MODE_GSO;
+
+  uint8_t record[1500];
+  memset(record, 0x5a, sizeof(record));
+
+  double cpu_ns     = 0;
+  uint64_t calls    = 0;
+  uint64_t failures = 0;
+  for (size_t burst = 0; burst < BENCH_BURSTS; burst++) {
+    struct timespec cpu_start;
+    struct timespec cpu_end;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_start);
+
+    for (size_t peer = 0; peer < BENCH_PEERS; peer++) {
+      const struct sockaddr *to = (const struct sockaddr *) &g_peer_addrs[peer];
+      for (size_t r = 0; r < records; r++) {
+        if (mode == MODE_SENDTO) {
+          calls++;
+          if (sendto(fd, record, record_size, MSG_DONTWAIT, to, sizeof(g_peer_addrs[peer])) < 0) {
+            failures++;
+          }
+        } else {
+          sc_egress_queue(egress, to, sizeof(g_peer_addrs[peer]), record, record_size);
+        }
+      }
+    }
+    sc_egress_flush(egress);
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_end);
+    cpu_ns += elapsed_ns(&cpu_start, &cpu_end);
+    drain_peers();
+  }
+
+  if (mode != MODE_SENDTO) {
+    calls    = egress->calls;
+    failures = egress->errors + egress->dropped;
+  }
+  double datagrams = (double) BENCH_BURSTS * BENCH_PEERS * (double) records;
+  printf("%-14s %16.1f %18.3f %10" PRIu64 "\n", g_mode_names[mode], cpu_ns / datagrams,
+         (double) calls / datagrams, failures);
+
+  sc_egress_nuke(egress);
+  close(fd);
+}
+
+int main(void) {
+  for (size_t i = 0; i < BENCH_PEERS; i++) {
+    g_peer_fds[i] = bind_loopback(&g_peer_addrs[i]);
+  }
+
+  static const struct {
+    size_t records;
+    size_t record_size;
+  } shapes[] = {{1, 200}, {8, 1200}};
+
+  for (size_t s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s++) {
+    printf("\n%d peers x %zu record(s) of %zu bytes, %d bursts\n", BENCH_PEERS, shapes[s].records,
+           shapes[s].record_size, BENCH_BURSTS);
+    printf("%-14s %16s %18s %10s\n", "egress", "CPU ns/datagram", "syscalls/datagram", "failed");
+    for (bench_mode_t mode = MODE_SENDTO; mode <= MODE_GSO; mode++) {
+      run(mode, shapes[s].records, shapes[s].record_size);
+    }
+  }
+
+  for (size_t i = 0; i < BENCH_PEERS; i++) {
+    close(g_peer_fds[i]);
+  }
+  return 0;
+}
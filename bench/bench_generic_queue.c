@@ -0,0 +1,163 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "generic_queue.h"
+
+// Per-item cost of the queue's batch operations as the batch grows, against
+// moving the same items one at a time with try_add/try_pop.
+//
+// Uncontended: one thread adds a batch and pops it straight back, so a row is
+// the queue's own bookkeeping with every cache line already local.
+//
+// Handoff: a producer thread adds batches while the main thread pops them, as
+// the network thread feeds a game worker. Every batch moves the queue's
+// indices between cores once instead of once per item, which is where
+// batching pays most.
+
+#define BENCH_CAPACITY 1024
+#define BENCH_ITEMS    (1 << 20) // Every batch size divides it, so no batch is cut short
+
+static const size_t g_batch_sizes[] = {1, 2, 4, 8, 16, 32, 64, 128, 256};
+
+#define BENCH_BATCH_COUNT (sizeof(g_batch_sizes) / sizeof(g_batch_sizes[0]))
+#define BENCH_MAX_BATCH   256
+
+// Work for the handoff producer
+typedef struct {
+  sc_generic_queue_t *queue;
+  size_t batch;
+} producer_t;
+
+static double elapsed_ns(const struct timespec *start, const struct timespec *end) {
+  return (double) (end->tv_sec - start->tv_sec) * 1e9 + (double) (end->tv_nsec - start->tv_nsec);
+}
+
+// Fills items with distinct non-NULL pointers
+static void fill_items(void **items, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    items[i] = (void *) (uintptr_t) (i + 1);
+  }
+}
+
+static sc_generic_queue_t *make_queue(void) {
+  sc_generic_queue_t *queue = sc_generic_queue_init(BENCH_CAPACITY);
+  if (!queue) {
+    fprintf(stderr, "queue creation failed\n");
+    exit(1);
+  }
+  return queue;
+}
+
+// Moves BENCH_ITEMS through a queue on one thread, batch items at a time
+// @return Nanoseconds per item
+static double bench_uncontended(size_t batch, bool batched) {
+  sc_generic_queue_t *queue = make_queue();
+  void *items[BENCH_MAX_BATCH];
+  void *popped[BENCH_MAX_BATCH];
+  fill_items(items, batch);
+
+  struct timespec start;
+  struct timespec end;
+  size_t moved = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  while (moved < BENCH_ITEMS) {
+    size_t got = 0;
+    if (batched) {
+      sc_generic_queue_add_n(queue, items, batch);
+      got = sc_generic_queue_pop_n(queue, popped, batch);
+    } else {
+      for (size_t i = 0; i < batch; i++) {
+        sc_generic_queue_try_add(queue, items[i]);
+      }
+      for (size_t i = 0; i < batch; i++) {
+        got += sc_generic_queue_try_pop(queue, &popped[i]) == SC_GENERIC_QUEUE_SUCCESS;
+      }
+    }
+    if (got != batch) {
+      fprintf(stderr, "moved %zu of %zu items\n", got, batch);
+      exit(1);
+    }
+    moved += got;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  sc_generic_queue_nuke(queue);
+  return elapsed_ns(&start, &end) / (double) moved;
+}
+
+// Adds BENCH_ITEMS in batches, retrying whatever did not fit
+// Both sides yield rather than spin when they stall, so the row still means
+// something on a machine with fewer cores than threads.
+static void *produce(void *arg) {
+  producer_t *producer = arg;
+  size_t batch         = producer->batch;
+  void *items[BENCH_MAX_BATCH];
+  fill_items(items, batch);
+
+  size_t produced = 0;
+  while (produced < BENCH_ITEMS) {
+    size_t added = 0;
+    while (added < batch) {
+      size_t count = sc_generic_queue_add_n(producer->queue, items + added, batch - added);
+      if (count == 0) {
+        sched_yield();
+      }
+      added += count;
+    }
+    produced += added;
+  }
+  return NULL;
+}
+
+// Pops BENCH_ITEMS handed over by a producer thread
+// @return Nanoseconds per item
+static double bench_handoff(size_t batch) {
+  sc_generic_queue_t *queue = make_queue();
+  producer_t producer       = {queue, batch};
+  void *popped[BENCH_MAX_BATCH];
+
+  struct timespec start;
+  struct timespec end;
+  pthread_t thread;
+  size_t taken = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  if (pthread_create(&thread, NULL, produce, &producer) != 0) {
+    fprintf(stderr, "thread creation failed\n");
+    exit(1);
+  }
+  while (taken < BENCH_ITEMS) {
+    size_t count = sc_generic_queue_pop_n(queue, popped, batch);
+    if (count == 0) {
+      sched_yield();
+    }
+    taken += count;
+  }
+  pthread_join(thread, NULL);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  sc_generic_queue_nuke(queue);
+  return elapsed_ns(&start, &end) / (double) taken;
+}
+
+int main(void) {
+  printf("Generic queue per-item cost (%d items per row, capacity %d)\n", BENCH_ITEMS,
+         BENCH_CAPACITY);
+  printf("%8s %14s %14s %14s\n", "batch", "single ns", "batched ns", "handoff ns");
+
+  for (size_t i = 0; i < BENCH_BATCH_COUNT; i++) {
+    size_t batch   = g_batch_sizes[i];
+    double single  = bench_uncontended(batch, false);
+    double batched = bench_uncontended(batch, true);
+    double handoff = bench_handoff(batch);
+    printf("%8zu %14.1f %14.1f %14.1f\n", batch, single, batched, handoff);
+  }
+
+  return 0;
+}
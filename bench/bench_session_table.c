@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <arpa/inet.h>
+
+#include "session_table.h"
+
+// Compares client lookup cost of the session table against the singly linked
+// list the server used before it. Each run looks up random connected clients,
+// which is what the receive path does for every datagram.
+
+#define BENCH_LOOKUPS 1000000
+#define BENCH_SEED    42
+
+static const size_t g_session_counts[] = {100, 1000, 10000};
+
+// Mirrors the old server's client_session_t list node
+typedef struct list_session {
+  struct sockaddr_in addr;
+  void *dtls_session;
+  time_t last_activity;
+  struct list_session *next;
+} list_session_t;
+
+// Old find_client(): linear scan comparing address and port
+static list_session_t *list_find(list_session_t *head, const struct sockaddr_in *addr) {
+  for (list_session_t *node = head; node; node = node->next) {
+    if (node->addr.sin_addr.s_addr == addr->sin_addr.s_addr &&
+        node->addr.sin_port == addr->sin_port) {
+      return node;
+    }
+  }
+  return NULL;
+}
+
+static double elapsed_ns(const struct timespec *start, const struct timespec *end) {
+  return (double) (end->tv_sec - start->tv_sec) * 1e9 + (double) (end->tv_nsec - start->tv_nsec);
+}
+
+static void bench_sessions(size_t sessions) {
+  list_session_t **nodes    = calloc(sessions, sizeof(list_session_t *));
+  size_t *lookups           = malloc(BENCH_LOOKUPS * sizeof(size_t));
+  sc_session_table_t *table = sc_session_table_init(0);
+  if (!nodes || !lookups || !table) {
+    fprintf(stderr, "allocation failed\n");
+    exit(1);
+  }
+
+  // Individually allocated nodes, prepended like add_client() did
+  list_session_t *head = NULL;
+  for (size_t i = 0; i < sessions; i++) {
+    list_session_t *node = calloc(1, sizeof(list_session_t));
+    if (!node) {
+      fprintf(stderr, "allocation failed\n");
+      exit(1);
+    }
+    node->addr.sin_family      = AF_INET;
+    node->addr.sin_addr.s_addr = htonl(0xc0a80000u | (uint32_t) (i / 16));
+    node->addr.sin_port        = htons((uint16_t) (50000 + i % 16));
+    node->next                 = head;
+    head                       = node;
+    nodes[i]                   = node;
+
+    if (sc_session_table_put(table, sc_session_table_key(&node->addr), node) < 0) {
+      fprintf(stderr, "table insert failed\n");
+      exit(1);
+    }
+  }
+
+  srand(BENCH_SEED);
+  for (size_t i = 0; i < BENCH_LOOKUPS; i++) {
+    lookups[i] = (size_t) rand() % sessions;
+  }
+
+  struct timespec start;
+  struct timespec end;
+  size_t hits = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (size_t i = 0; i < BENCH_LOOKUPS; i++) {
+    hits += list_find(head, &nodes[lookups[i]]->addr) != NULL;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double list_ns = elapsed_ns(&start, &end) / BENCH_LOOKUPS;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (size_t i = 0; i < BENCH_LOOKUPS; i++) {
+    hits += sc_session_table_get(table, sc_session_table_key(&nodes[lookups[i]]->addr)) != NULL;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double table_ns = elapsed_ns(&start, &end) / BENCH_LOOKUPS;
+
+  if (hits != 2 * (size_t) BENCH_LOOKUPS) {
+    fprintf(stderr, "lookup mismatch: %zu hits\n", hits);
+    exit(1);
+  }
+
+  printf("%10zu %14.1f %14.1f %9.1fx\n", sessions, list_ns, table_ns, list_ns / table_ns);
+
+  sc_session_table_nuke(table);
+  for (size_t i = 0; i < sessions; i++) {
+    free(nodes[i]);
+  }
+  free(lookups);
+  free(nodes);
+}
+
+int main(void) {
+  printf("Client session lookup (%d random lookups per row)\n", BENCH_LOOKUPS);
+  printf("%10s %14s %14s %10s\n", "sessions", "list ns/op", "table ns/op", "speedup");
+
+  for (size_t i = 0; i < sizeof(g_session_counts) / sizeof(g_session_counts[0]); i++) {
+    bench_sessions(g_session_counts[i]);
+  }
+
+  return 0;
+}
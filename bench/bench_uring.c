@@ -0,0 +1,247 @@
+#define _GNU_SOURCE // sendmmsg(2) and struct mmsghdr
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include "ingress.h"
+#include "uring.h"
+
+// Compares the two server I/O engines on a UDP echo over loopback. A sender
+// thread floods the socket while the measured thread receives every datagram
+// and sends it back, which is the server's receive/reply path without DTLS:
+//   epoll:    edge-triggered epoll_wait, recvmmsg batches, one sendto per reply
+//   io_uring: multishot recvmsg into provided buffers, replies queued and
+//             submitted together with the next wait
+// CPU time is the measured thread's own (CLOCK_THREAD_CPUTIME_ID), which
+// includes the kernel work done on its behalf in system calls.
+
+#define BENCH_SECONDS      2
+#define BENCH_PAYLOAD      64
+#define BENCH_SEND_BURST   64
+#define BENCH_BATCH_SIZE   64   // recvmmsg batch, as INGRESS_BATCH_SIZE
+#define BENCH_URING_SLOTS  1024 // io_uring receive buffers and send slots
+#define BENCH_SOCKET_BYTES (4 * 1024 * 1024)
+
+typedef struct {
+  const char *name;
+  uint64_t packets;
+  uint64_t syscalls;
+  double wall_ns;
+  double cpu_ns;
+} bench_result_t;
+
+static atomic_bool g_stop;
+static struct sockaddr_in g_server_addr;
+static struct sockaddr_in g_client_addr;
+
+static double elapsed_ns(const struct timespec *start, const struct timespec *end) {
+  return (double) (end->tv_sec - start->tv_sec) * 1e9 + (double) (end->tv_nsec - start->tv_nsec);
+}
+
+static void fail(const char *what) {
+  fprintf(stderr, "%s: %s\n", what, strerror(errno));
+  exit(1);
+}
+
+// Bind a UDP socket to an ephemeral loopback port
+static int bind_loopback(struct sockaddr_in *addr) {
+  int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+  if (fd < 0) {
+    fail("socket");
+  }
+
+  int bytes = BENCH_SOCKET_BYTES;
+  setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bytes, sizeof(bytes));
+  setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &bytes, sizeof(bytes));
+
+  memset(addr, 0, sizeof(*addr));
+  addr->sin_family      = AF_INET;
+  addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len         = sizeof(*addr);
+  if (bind(fd, (struct sockaddr *) addr, sizeof(*addr)) < 0 ||
+      getsockname(fd, (struct sockaddr *) addr, &len) < 0) {
+    fail("bind");
+  }
+  return fd;
+}
+
+// Sender thread: flood the server socket in sendmmsg bursts until stopped
+static void *flood(void *arg) {
+  int fd = *(int *) arg;
+
+  uint8_t payload[BENCH_PAYLOAD];
+  memset(payload, 0xab, sizeof(payload));
+
+  struct iovec iov = {.iov_base = payload, .iov_len = sizeof(payload)};
+  struct mmsghdr msgs[BENCH_SEND_BURST];
+  memset(msgs, 0, sizeof(msgs));
+  for (size_t i = 0; i < BENCH_SEND_BURST; i++) {
+    msgs[i].msg_hdr.msg_iov     = &iov;
+    msgs[i].msg_hdr.msg_iovlen  = 1;
+    msgs[i].msg_hdr.msg_name    = &g_server_addr;
+    msgs[i].msg_hdr.msg_namelen = sizeof(g_server_addr);
+  }
+
+  while (!atomic_load_explicit(&g_stop, memory_order_relaxed)) {
+    if (sendmmsg(fd, msgs, BENCH_SEND_BURST, 0) < 0 && errno != EAGAIN && errno != ENOBUFS) {
+      fail("sendmmsg");
+    }
+  }
+  return NULL;
+}
+
+static void bench_epoll(int fd, bench_result_t *result) {
+  sc_ingress_t *ingress = sc_ingress_init(BENCH_BATCH_SIZE, BENCH_PAYLOAD);
+  int epoll_fd          = epoll_create1(0);
+  if (!ingress || epoll_fd < 0) {
+    fail("epoll setup");
+  }
+
+  struct epoll_event ev = {.events = EPOLLIN | EPOLLET, .data.fd = fd};
+  if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+    fail("epoll_ctl");
+  }
+
+  struct timespec start;
+  struct timespec now;
+  struct timespec cpu_start;
+  struct timespec cpu_end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_start);
+
+  do {
+    struct epoll_event events[1];
+    int nfds = epoll_wait(epoll_fd, events, 1, 100);
+    result->syscalls++;
+
+    // Drain as the server does, but under a sustained flood the socket never
+    // runs dry, so the deadline is checked after every batch as well
+    for (int n = 0; n < nfds; n++) {
+      bool drained = false;
+      while (!drained) {
+        int count = sc_ingress_recv(ingress, fd);
+        result->syscalls++;
+        if (count < 0) {
+          fail("recvmmsg");
+        }
+
+        for (int i = 0; i < count; i++) {
+          const sc_ingress_packet_t *packet = &ingress->packets[i];
+          sendto(fd, packet->data, packet->len, MSG_DONTWAIT,
+                 (const struct sockaddr *) &packet->addr, packet->addr_len);
+          result->syscalls++;
+        }
+        result->packets += (uint64_t) count;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        drained = ingress->drained || elapsed_ns(&start, &now) >= BENCH_SECONDS * 1e9;
+      }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+  } while (elapsed_ns(&start, &now) < BENCH_SECONDS * 1e9);
+
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_end);
+  result->wall_ns = elapsed_ns(&start, &now);
+  result->cpu_ns  = elapsed_ns(&cpu_start, &cpu_end);
+
+  close(epoll_fd);
+  sc_ingress_nuke(ingress);
+}
+
+static void bench_uring(int fd, bench_result_t *result) {
+  sc_uring_t *uring = sc_uring_init(fd, BENCH_URING_SLOTS, BENCH_URING_SLOTS, BENCH_PAYLOAD);
+  if (!uring) {
+    fprintf(stderr, "io_uring unavailable, skipping\n");
+    return;
+  }
+
+  struct timespec start;
+  struct timespec now;
+  struct timespec cpu_start;
+  struct timespec cpu_end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_start);
+
+  do {
+    if (sc_uring_wait(uring, 100) < 0) {
+      fail("io_uring_enter");
+    }
+
+    const sc_ingress_packet_t *packets;
+    size_t count;
+    while ((count = sc_uring_recv(uring, &packets)) > 0) {
+      for (size_t i = 0; i < count; i++) {
+        sc_uring_send(uring, (const struct sockaddr *) &packets[i].addr, packets[i].addr_len,
+                      packets[i].data, packets[i].len);
+      }
+      result->packets += count;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+  } while (elapsed_ns(&start, &now) < BENCH_SECONDS * 1e9);
+
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_end);
+  result->wall_ns  = elapsed_ns(&start, &now);
+  result->cpu_ns   = elapsed_ns(&cpu_start, &cpu_end);
+  result->syscalls = sc_uring_stats(uring)->enters;
+
+  sc_uring_nuke(uring);
+}
+
+static void run(void (*engine)(int, bench_result_t *), bench_result_t *result) {
+  int server_fd = bind_loopback(&g_server_addr);
+  int client_fd = bind_loopback(&g_client_addr);
+
+  // Sends block so the flood backs off instead of spinning on EAGAIN; the
+  // timeout lets the sender notice g_stop once the receiver stops draining
+  int flags              = fcntl(client_fd, F_GETFL, 0);
+  struct timeval timeout  = {.tv_sec = 0, .tv_usec = 100000};
+  fcntl(client_fd, F_SETFL, flags & ~O_NONBLOCK);
+  setsockopt(client_fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+  atomic_store(&g_stop, false);
+  pthread_t sender;
+  if (pthread_create(&sender, NULL, flood, &client_fd) != 0) {
+    fail("pthread_create");
+  }
+
+  engine(server_fd, result);
+
+  atomic_store(&g_stop, true);
+  pthread_join(sender, NULL);
+  close(client_fd);
+  close(server_fd);
+
+  if (result->packets == 0) {
+    return;
+  }
+  double packets = (double) result->packets;
+  printf("%-10s %14.0f %16.1f %17.3f\n", result->name, packets / (result->wall_ns / 1e9),
+         result->cpu_ns / packets, (double) result->syscalls / packets);
+}
+
+int main(void) {
+  printf("UDP echo over loopback (%d-byte datagrams, %d s per engine)\n", BENCH_PAYLOAD,
+         BENCH_SECONDS);
+  printf("%-10s %14s %16s %17s\n", "engine", "packets/s", "CPU ns/packet", "syscalls/packet");
+
+  bench_result_t epoll_result = {.name = "epoll"};
+  bench_result_t uring_result = {.name = "io_uring"};
+  run(bench_epoll, &epoll_result);
+  run(bench_uring, &uring_result);
+
+  return 0;
+}
@@ -5,9 +5,32 @@
 #define PROTOCOL_VERSION 0x0001 // Protocol version for v0.1.0
 
 // Server Configuration
-#define SERVER_PORT            19840
-#define EPOLL_MAX_EVENTS       64
-#define SOCKET_BUFFER_SIZE     4096
-#define CLIENT_TIMEOUT_SECONDS 30 // 30-second inactivity timeout
+#define SERVER_PORT                19840
+#define EPOLL_MAX_EVENTS           64
+#define SOCKET_BUFFER_SIZE         4096
+#define CLIENT_TIMEOUT_SECONDS     30    // 30-second inactivity timeout
+#define INGRESS_BATCH_SIZE         64    // Datagrams drained per recvmmsg call
+#define INGRESS_GRO_SLOT_SIZE      65535 // Receive slot size, room for a UDP_GRO coalesced run
+#define EGRESS_BATCH_SIZE          256   // Datagrams queued per shard between sendmmsg flushes
+#define STATS_LOG_INTERVAL_SECONDS 60    // Interval between statistics log lines
+#define SERVER_MAX_CLIENTS         2048  // Default client sessions (SC_SERVER_MAX_CLIENTS)
+#define SHARD_CLIENT_HEADROOM      50    // Percent more slots a shard gets than an even share
+#define SERVER_MAX_SHARDS          64    // Upper limit on SC_SERVER_SHARDS
+#define TIMER_WHEEL_TICK_MS        10    // Resolution of session timers
+#define URING_RECV_BUFFERS         256   // io_uring receive buffers per shard (power of two)
+#define URING_SEND_SLOTS           256   // io_uring sends in flight per shard
+#define HANDSHAKE_THREADS          2     // Default crypto threads (SC_SERVER_HANDSHAKE_THREADS)
+#define HANDSHAKE_JOBS_PER_SHARD   64    // Handshake datagrams a shard can have queued or running
+#define HANDSHAKE_BUDGET           16    // Finished handshake steps taken per loop iteration
+#define GAME_WORKERS               2     // Default game worker threads (SC_SERVER_GAME_WORKERS)
+#define GAME_INBOX_CAPACITY        4096  // Messages waiting for one game worker
+#define GAME_BATCH_SIZE            64    // Messages a game worker takes per wakeup
+#define MESSAGES_PER_SHARD         1024  // Decoded messages a shard can have with game workers
+#define REPLY_BUDGET               64    // Game worker replies sent per loop iteration
+#define TICKET_LIFETIME_SECONDS    3600  // Session ticket validity and ticket key rotation period
+
+// Kernel socket buffers (SO_RCVBUF/SO_SNDBUF, capped by net.core.rmem_max and
+// wmem_max); a tick's broadcast burst must fit in the send buffer
+#define SOCKET_KERNEL_BUFFER_SIZE (1024 * 1024)
 
 #endif // CONFIG_H
@@ -1,59 +1,237 @@
 #include "dtls.h"
+#include "config.h"
 #include "log.h"
+#include "slab.h"
+#include "tls_arena.h"
 #include <string.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <threads.h>
+#include <time.h>
 #include <arpa/inet.h>
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
 
 // Mbed TLS headers
 #include <mbedtls/config.h>
 #include <mbedtls/platform.h>
 #include <mbedtls/entropy.h>
 #include <mbedtls/ctr_drbg.h>
+#include <mbedtls/cipher.h>
+#include <mbedtls/ecp.h>
 #include <mbedtls/ssl.h>
 #include <mbedtls/ssl_cookie.h>
+#include <mbedtls/ssl_ticket.h>
 #include <mbedtls/net_sockets.h>
 #include <mbedtls/error.h>
 #include <mbedtls/debug.h>
-#include <mbedtls/timing.h>
 #include <mbedtls/sha256.h>
 #include <mbedtls/x509_crt.h>
 #include <mbedtls/pk.h>
+#include <mbedtls/rsa.h>
+
+// DTLS record and handshake layout read by the stateless ClientHello check
+#define DTLS_RECORD_HEADER_LEN    13
+#define DTLS_HANDSHAKE_HEADER_LEN 12
+#define DTLS_CONTENT_ALERT        21
+#define DTLS_CONTENT_HANDSHAKE    22
+#define DTLS_CONTENT_APPLICATION  23
+#define DTLS_HS_CLIENT_HELLO      1
+#define DTLS_HS_HELLO_VERIFY      3
+#define DTLS_RANDOM_LEN           32
+#define DTLS_MAX_SESSION_ID_LEN   32
+#define DTLS_MAX_COOKIE_LEN       255
+
+// Largest record either peer sends, negotiated with max_fragment_length so the
+// record buffers (MBEDTLS_SSL_IN/OUT_CONTENT_LEN) can be sized for game
+// messages rather than 16 KB TLS records
+#define DTLS_MAX_FRAG_LEN      4096
+#define DTLS_MAX_FRAG_LEN_CODE MBEDTLS_SSL_MAX_FRAG_LEN_4096
+
+#if SOCKET_BUFFER_SIZE > DTLS_MAX_FRAG_LEN
+#error "SOCKET_BUFFER_SIZE does not fit in a negotiated DTLS record"
+#endif
+#if MBEDTLS_SSL_IN_CONTENT_LEN < DTLS_MAX_FRAG_LEN || \
+  MBEDTLS_SSL_OUT_CONTENT_LEN < DTLS_MAX_FRAG_LEN
+#error "mbedTLS record buffers are smaller than DTLS_MAX_FRAG_LEN"
+#endif
+#if !defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+#error "mbedTLS must be built with MBEDTLS_SSL_MAX_FRAGMENT_LENGTH (src/mbedtls_user_config.h)"
+#endif
+#if !defined(MBEDTLS_SSL_DTLS_CONNECTION_ID) || MBEDTLS_SSL_CID_IN_LEN_MAX < DTLS_CID_LEN || \
+  MBEDTLS_SSL_CID_OUT_LEN_MAX < DTLS_CID_LEN
+#error "mbedTLS must be built with DTLS_CID_LEN-byte connection IDs (src/mbedtls_user_config.h)"
+#endif
+#if MBEDTLS_SSL_MSG_CID != DTLS_CID_CONTENT_TYPE
+#error "DTLS_CID_CONTENT_TYPE does not match mbedTLS"
+#endif
+#if !defined(MBEDTLS_PLATFORM_MEMORY)
+#error "mbedTLS must be built with MBEDTLS_PLATFORM_MEMORY (src/mbedtls_user_config.h)"
+#endif
+#if !defined(MBEDTLS_GCM_C) || !defined(MBEDTLS_CHACHAPOLY_C)
+#error "mbedTLS must be built with AES-GCM and ChaCha20-Poly1305 (src/mbedtls_user_config.h)"
+#endif
+
+// Cipher self-benchmark: records about the size of a game state update, timed
+// in the best of a few rounds so a preempted round does not count
+#define CIPHER_BENCH_RECORD_LEN 1024
+#define CIPHER_BENCH_RECORDS    256
+#define CIPHER_BENCH_ROUNDS     3
+#define CIPHER_BENCH_IV_LEN     12
+#define CIPHER_BENCH_TAG_LEN    16
+
+// Record numbers: the 16-bit epoch above the 48-bit sequence number, so a
+// later record always compares higher
+#define RECORD_SEQ_BITS 48
+#define RECORD_SEQ_MASK ((UINT64_C(1) << RECORD_SEQ_BITS) - 1)
+
+// Plaintext transport (sc_dtls_context_create_plain()): records keep the
+// DTLS header, epoch 0 for the hello exchange and 1 for data. The client's
+// hello payload is the marker, the length of the cookie it echoes and the
+// cookie. A hello without a valid cookie gets a challenge carrying one, like
+// a HelloVerifyRequest; the server's answer to one with a valid cookie
+// appends the length of the connection ID it assigned and the ID.
+#define PLAIN_HELLO          "sc-plain"
+#define PLAIN_HELLO_LEN      (sizeof(PLAIN_HELLO) - 1)
+#define PLAIN_VERIFY         "sc-verify"
+#define PLAIN_VERIFY_LEN     (sizeof(PLAIN_VERIFY) - 1)
+#define PLAIN_MAX_COOKIE_LEN 32 // mbedTLS cookies: a 4-byte time and a 28-byte HMAC
+#define PLAIN_DATA_EPOCH     1
+#define PLAIN_REPLAY_WINDOW  64
+#define PLAIN_RECORD_MAX_LEN (DTLS_RECORD_HEADER_LEN + DTLS_CID_LEN + DTLS_MAX_FRAG_LEN + 1)
 
 // Internal structure definitions
 struct dtls_context {
   dtls_role_t role;
+  bool plain; // Plaintext transport, no mbedTLS state at all
   mbedtls_ssl_config conf;
   mbedtls_x509_crt cert;
   mbedtls_pk_context pkey;
-  mbedtls_entropy_context entropy;
-  mbedtls_ctr_drbg_context ctr_drbg;
   mbedtls_ssl_cookie_ctx cookie_ctx;
+  mbedtls_ssl_ticket_context ticket_ctx; // Session ticket keys (server)
+  dtls_context_t *ticket_source;         // Context whose ticket keys are used, often this one
+  mbedtls_ssl_session saved_session;     // Last completed session, resumed next time (client)
+  mbedtls_pk_context signer;             // RSA-alt wrapper that serializes use of pkey
+  pthread_mutex_t cookie_lock;           // Guards cookie_ctx
+  pthread_mutex_t key_lock;              // Serializes RSA private key operations
+  pthread_mutex_t ticket_lock;           // Guards ticket_ctx and stats of contexts sharing it
   uint8_t *pinned_cert_hash;
   size_t pinned_cert_hash_len;
   bool initialized;
-  bool rng_initialized;
   bool config_initialized;
   bool cert_initialized;
   bool pkey_initialized;
   bool cookie_initialized;
+  bool ticket_initialized;
+  bool session_saved;
+  bool signer_initialized;
+  bool locks_initialized;
+  sc_slab_t *session_pool; // Preallocated sessions, NULL to allocate on demand
+  dtls_send_fn send_fn;    // Replaces sendto(2) when set
+  void *send_user_data;
+  dtls_hello_stats_t hello_stats;
+  dtls_ticket_stats_t ticket_stats; // Updated under ticket_source->ticket_lock
 };
 
+// Record state of a plaintext session; mbedTLS keeps the same for DTLS ones
+typedef struct {
+  uint64_t out_seq;          // Sequence number of the last data record sent
+  uint64_t in_top;           // Highest data sequence number accepted
+  uint64_t in_window;        // Bit i set: in_top - i was accepted
+  uint32_t timeout_ms;       // Current hello retransmission timeout (client)
+  uint8_t cid[DTLS_CID_LEN]; // Connection ID the client's records carry
+  bool has_cid;
+  uint8_t cookie[PLAIN_MAX_COOKIE_LEN]; // Last cookie the server challenged with (client)
+  size_t cookie_len;
+} plain_state_t;
+
 struct dtls_session {
   dtls_context_t *ctx;
   mbedtls_ssl_context ssl;
-  mbedtls_timing_delay_context timer;
+  sc_tls_arena_t arena; // Memory mbedTLS allocates for ssl
+  plain_state_t plain; // Plaintext sessions only
+  uint64_t timer_int_ms; // Intermediate retransmission deadline (monotonic ms)
+  uint64_t timer_fin_ms; // Final retransmission deadline, 0 while no timer runs
   int fd;
   struct sockaddr_storage client_addr;
   socklen_t addr_len;
   bool handshake_complete;
+  // In-memory receive BIO fed by sc_dtls_feed()
+  const uint8_t *pending; // Datagram not yet consumed by mbedtls (caller-owned)
+  size_t pending_len;
+  bool memory_bio;      // Receive only from sc_dtls_feed(), never from the socket
+  bool ssl_ready;       // mbedtls_ssl_setup() has run on ssl
+  dtls_send_fn send_fn; // Overrides the context's transmit function when set
+  void *send_user_data;
+  uint64_t last_record;   // Epoch and sequence number of the record last read
+  uint64_t newest_record; // Highest last_record so far
+};
+
+// A record cipher and the suites that use it with each kind of server key
+typedef struct {
+  mbedtls_cipher_type_t type;
+  const char *name;
+  int rsa_suite;
+  int ecdsa_suite;
+} cipher_choice_t;
+
+static const cipher_choice_t g_cipher_choices[DTLS_CIPHER_COUNT] = {
+  {MBEDTLS_CIPHER_AES_128_GCM, "AES-128-GCM", MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
+   MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256},
+  {MBEDTLS_CIPHER_AES_256_GCM, "AES-256-GCM", MBEDTLS_TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384,
+   MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384},
+  {MBEDTLS_CIPHER_CHACHA20_POLY1305, "ChaCha20-Poly1305",
+   MBEDTLS_TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256,
+   MBEDTLS_TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256},
 };
 
+// Suites every context offers, in g_cipher_choices order until
+// sc_dtls_rank_ciphers() reorders them. A server can only pick the suites its
+// key signs for; ECDSA comes first because `make certs` generates P-256 keys.
+static int g_ciphersuites[2 * DTLS_CIPHER_COUNT + 1] = {
+  MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+  MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
+  MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384,
+  MBEDTLS_TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384,
+  MBEDTLS_TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256,
+  MBEDTLS_TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256,
+  0};
+
+// Key exchange curves, most preferred first. X25519 costs a fraction of a
+// P-256 exchange. P-256 stays for peers without X25519, and because a client
+// only accepts an ECDSA server key on a curve it offers.
+static const mbedtls_ecp_group_id g_curves[] = {
+  MBEDTLS_ECP_DP_CURVE25519,
+  MBEDTLS_ECP_DP_SECP256R1,
+  MBEDTLS_ECP_DP_NONE};
+
+static dtls_cipher_ranking_t g_cipher_ranking;
+static bool g_ciphers_ranked = false;
+
 // Static initialization flag
 static bool g_dtls_initialized = false;
 
+// mbedTLS allocates from the TLS arena pool once sc_dtls_init() has run. The
+// hooks are never removed again: a block from the pool must not reach free(3).
+static bool g_allocator_installed = false;
+
+// Randomness: every thread draws from a CTR-DRBG of its own, seeded on its
+// first draw, so handshakes and ticket sealing on different threads never
+// contend for one generator. Each DRBG reseeds itself from the shared entropy
+// pool every MBEDTLS_CTR_DRBG_RESEED_INTERVAL requests; the pool is the only
+// RNG state threads share, and it is locked. A thread's DRBG is freed when the
+// thread exits.
+#define DTLS_RNG_PERSONALIZATION "space_captain_dtls"
+
+static mbedtls_entropy_context g_entropy;
+static pthread_mutex_t g_entropy_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t g_rng_key;
+static thread_local mbedtls_ctr_drbg_context *t_rng = NULL;
+
 // Error string mapping
 const char *sc_dtls_error_string(dtls_result_t result) {
   switch (result) {
@@ -100,13 +278,28 @@ static void debug_callback(void *ctx, int level, const char *file, int line, con
 #endif
 }
 
-// UDP send callback for mbedtls
-static int udp_send(void *ctx, const unsigned char *buf, size_t len) {
-  dtls_session_t *session = (dtls_session_t *) ctx;
+// Send one datagram through the context's transmit function, or on fd without one
+static ssize_t transmit(const dtls_context_t *ctx, int fd, const struct sockaddr *addr,
+                        socklen_t addr_len, const uint8_t *buf, size_t len) {
+  if (ctx->send_fn) {
+    return ctx->send_fn(ctx->send_user_data, addr, addr_len, buf, len);
+  }
+  return sendto(fd, buf, len, MSG_DONTWAIT, addr, addr_len);
+}
 
-  ssize_t ret = sendto(session->fd, buf, len, MSG_DONTWAIT,
-                       (struct sockaddr *) &session->client_addr, session->addr_len);
+// Send one datagram to a session's peer through the session's transmit
+// function, else the context's, else the socket
+static ssize_t session_send(const dtls_session_t *session, const uint8_t *buf, size_t len) {
+  const struct sockaddr *addr = (const struct sockaddr *) &session->client_addr;
+  if (session->send_fn) {
+    return session->send_fn(session->send_user_data, addr, session->addr_len, buf, len);
+  }
+  return transmit(session->ctx, session->fd, addr, session->addr_len, buf, len);
+}
 
+// UDP send callback for mbedtls
+static int udp_send(void *ctx, const unsigned char *buf, size_t len) {
+  ssize_t ret = session_send((const dtls_session_t *) ctx, buf, len);
   if (ret < 0) {
     if (errno == EAGAIN || errno == EWOULDBLOCK) {
       return MBEDTLS_ERR_SSL_WANT_WRITE;
@@ -121,10 +314,21 @@ static int udp_send(void *ctx, const unsigned char *buf, size_t len) {
 static int udp_recv(void *ctx, unsigned char *buf, size_t len) {
   dtls_session_t *session = (dtls_session_t *) ctx;
 
-  struct sockaddr_storage addr;
-  socklen_t addr_len = sizeof(addr);
+  // Sessions sharing a socket are fed by the caller, which has already read
+  // the datagram and matched it to this session by source address
+  if (session->memory_bio) {
+    if (!session->pending) {
+      return MBEDTLS_ERR_SSL_WANT_READ;
+    }
+
+    size_t copy_len = session->pending_len < len ? session->pending_len : len;
+    memcpy(buf, session->pending, copy_len);
+    session->pending     = NULL;
+    session->pending_len = 0;
+    return (int) copy_len;
+  }
 
-  ssize_t ret = recvfrom(session->fd, buf, len, MSG_DONTWAIT, (struct sockaddr *) &addr, &addr_len);
+  ssize_t ret = recv(session->fd, buf, len, MSG_DONTWAIT);
 
   if (ret < 0) {
     if (errno == EAGAIN || errno == EWOULDBLOCK) {
@@ -133,39 +337,698 @@ static int udp_recv(void *ctx, unsigned char *buf, size_t len) {
     return MBEDTLS_ERR_NET_RECV_FAILED;
   }
 
-  // For server, verify packet is from expected client
+  return (int) ret;
+}
+
+// Read the monotonic clock in milliseconds
+static uint64_t monotonic_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000u + (uint64_t) ts.tv_nsec / 1000000u;
+}
+
+// Retransmission timer callbacks for mbedtls
+// The timer only records deadlines; nothing waits on it. The caller's event
+// loop sleeps until sc_dtls_session_timeout_ms() and then calls
+// sc_dtls_handle_timeout(), whose handshake call finds the timer expired and
+// resends the flight. Reads never block, so no receive-timeout callback is set.
+static void set_timer(void *ctx, uint32_t int_ms, uint32_t fin_ms) {
+  dtls_session_t *session = (dtls_session_t *) ctx;
+  if (fin_ms == 0) {
+    session->timer_int_ms = 0;
+    session->timer_fin_ms = 0;
+    return;
+  }
+
+  uint64_t now          = monotonic_ms();
+  session->timer_int_ms = now + int_ms;
+  session->timer_fin_ms = now + fin_ms;
+}
+
+// mbedtls reads -1 as cancelled, 0 as running, 1 as past the intermediate
+// deadline and 2 as past the final one
+static int get_timer(void *ctx) {
+  const dtls_session_t *session = (const dtls_session_t *) ctx;
+  if (session->timer_fin_ms == 0) {
+    return -1;
+  }
+
+  uint64_t now = monotonic_ms();
+  if (now >= session->timer_fin_ms) {
+    return 2;
+  }
+  if (now >= session->timer_int_ms) {
+    return 1;
+  }
+  return 0;
+}
+
+// Forget a fed datagram that mbedtls did not consume during the last call
+// The buffer belongs to the caller and is not guaranteed to outlive that call.
+static void drop_pending(dtls_session_t *session) {
+  session->pending     = NULL;
+  session->pending_len = 0;
+}
+
+// Keep a client session's parameters and ticket for the context's next connection
+// The copy belongs to the context, outside the session's arena.
+static void save_session(dtls_session_t *session) {
+  dtls_context_t *ctx      = session->ctx;
+  sc_tls_arena_t *previous = sc_tls_arena_enter(NULL);
+  mbedtls_ssl_session_free(&ctx->saved_session);
+  mbedtls_ssl_session_init(&ctx->saved_session);
+
+  int ret = mbedtls_ssl_get_session(&session->ssl, &ctx->saved_session);
+  sc_tls_arena_leave(previous);
+  ctx->session_saved = (ret == 0);
+  if (ret != 0) {
+    log_warn("Failed to save DTLS session for resumption: %d", ret);
+  }
+}
+
+// Set up a session's SSL context from scratch, in a fresh arena; everything
+// mbedTLS allocates for it from here on comes from that arena
+// Returns: 0 on success, or the mbedTLS error
+static int setup_ssl(dtls_session_t *session) {
+  sc_tls_arena_init(&session->arena);
+  mbedtls_ssl_init(&session->ssl);
+
+  sc_tls_arena_t *previous = sc_tls_arena_enter(&session->arena);
+  sc_tls_arena_begin_handshake(&session->arena);
+  int ret = mbedtls_ssl_setup(&session->ssl, &session->ctx->conf);
+  if (ret != 0) {
+    mbedtls_ssl_free(&session->ssl);
+  }
+  sc_tls_arena_leave(previous);
+  sc_tls_arena_release(&session->arena);
+
+  session->ssl_ready = (ret == 0);
+  return ret;
+}
+
+// Release a session's SSL context and return its memory to the pool
+static void free_ssl(dtls_session_t *session) {
+  sc_tls_arena_t *previous = sc_tls_arena_enter(&session->arena);
+  mbedtls_ssl_free(&session->ssl);
+  sc_tls_arena_leave(previous);
+  sc_tls_arena_release(&session->arena);
+  session->ssl_ready = false;
+}
+
+// Sessions of one context may run on different threads (see the handshake
+// pool), so the state they share is only reached through these wrappers.
+// mbedTLS is built without MBEDTLS_THREADING_C and does no locking of its own.
+
+// Entropy callback for the per-thread DRBGs: gathering mixes into the pool
+static int locked_entropy(void *data, unsigned char *output, size_t len) {
+  (void) data;
+  pthread_mutex_lock(&g_entropy_lock);
+  int ret = mbedtls_entropy_func(&g_entropy, output, len);
+  pthread_mutex_unlock(&g_entropy_lock);
+  return ret;
+}
+
+// Thread-exit destructor for g_rng_key
+static void free_thread_rng(void *rng) {
+  mbedtls_ctr_drbg_free(rng);
+  free(rng);
+}
+
+// The calling thread's DRBG, created and seeded on first use
+// Returns: The DRBG, or NULL if it could not be allocated or seeded
+static mbedtls_ctr_drbg_context *thread_rng(void) {
+  if (t_rng) {
+    return t_rng;
+  }
+
+  mbedtls_ctr_drbg_context *rng = malloc(sizeof(*rng));
+  if (!rng) {
+    log_error("%s", "Failed to allocate random number generator");
+    return NULL;
+  }
+  mbedtls_ctr_drbg_init(rng);
+
+  // The thread's ID personalizes its DRBG, on top of the entropy it draws
+  pthread_t self = pthread_self();
+  unsigned char pers[sizeof(DTLS_RNG_PERSONALIZATION) - 1 + sizeof(self)];
+  memcpy(pers, DTLS_RNG_PERSONALIZATION, sizeof(DTLS_RNG_PERSONALIZATION) - 1);
+  memcpy(pers + sizeof(DTLS_RNG_PERSONALIZATION) - 1, &self, sizeof(self));
+
+  int ret = mbedtls_ctr_drbg_seed(rng, locked_entropy, NULL, pers, sizeof(pers));
+  if (ret != 0) {
+    log_error("Failed to seed random number generator: %d", ret);
+    free_thread_rng(rng);
+    return NULL;
+  }
+  if (pthread_setspecific(g_rng_key, rng) != 0) {
+    log_error("%s", "Failed to register random number generator");
+    free_thread_rng(rng);
+    return NULL;
+  }
+
+  t_rng = rng;
+  return rng;
+}
+
+// RNG callback for everything mbedTLS does: draw from the calling thread's DRBG
+static int thread_random(void *p_rng, unsigned char *output, size_t len) {
+  (void) p_rng;
+  mbedtls_ctr_drbg_context *rng = thread_rng();
+  if (!rng) {
+    return MBEDTLS_ERR_CTR_DRBG_ENTROPY_SOURCE_FAILED;
+  }
+  return mbedtls_ctr_drbg_random(rng, output, len);
+}
+
+// The callbacks below work on context state that outlives any one session, so
+// what mbedTLS allocates or frees in them must not be billed to the session
+// whose arena the calling thread has entered.
+
+// Cookie callbacks: the cookie HMAC context is reset and reused by every call
+static int locked_cookie_write(void *p_ctx, unsigned char **p, unsigned char *end,
+                               const unsigned char *cli_id, size_t cli_id_len) {
+  dtls_context_t *ctx      = p_ctx;
+  sc_tls_arena_t *previous = sc_tls_arena_enter(NULL);
+  pthread_mutex_lock(&ctx->cookie_lock);
+  int ret = mbedtls_ssl_cookie_write(&ctx->cookie_ctx, p, end, cli_id, cli_id_len);
+  pthread_mutex_unlock(&ctx->cookie_lock);
+  sc_tls_arena_leave(previous);
+  return ret;
+}
+
+static int locked_cookie_check(void *p_ctx, const unsigned char *cookie, size_t cookie_len,
+                               const unsigned char *cli_id, size_t cli_id_len) {
+  dtls_context_t *ctx      = p_ctx;
+  sc_tls_arena_t *previous = sc_tls_arena_enter(NULL);
+  pthread_mutex_lock(&ctx->cookie_lock);
+  int ret = mbedtls_ssl_cookie_check(&ctx->cookie_ctx, cookie, cookie_len, cli_id, cli_id_len);
+  pthread_mutex_unlock(&ctx->cookie_lock);
+  sc_tls_arena_leave(previous);
+  return ret;
+}
+
+// RSA-alt callbacks: mbedtls_rsa_private() refreshes the key's blinding values
+// on every call, so two threads must never use the same RSA key at once
+static int locked_rsa_decrypt(void *key, int mode, size_t *olen, const unsigned char *input,
+                              unsigned char *output, size_t output_max_len) {
+  dtls_context_t *ctx      = key;
+  sc_tls_arena_t *previous = sc_tls_arena_enter(NULL);
+  pthread_mutex_lock(&ctx->key_lock);
+  int ret = mbedtls_rsa_pkcs1_decrypt(mbedtls_pk_rsa(ctx->pkey), thread_random, NULL, mode, olen,
+                                      input, output, output_max_len);
+  pthread_mutex_unlock(&ctx->key_lock);
+  sc_tls_arena_leave(previous);
+  return ret;
+}
+
+static int locked_rsa_sign(void *key, int (*f_rng)(void *, unsigned char *, size_t), void *p_rng,
+                           int mode, mbedtls_md_type_t md_alg, unsigned int hashlen,
+                           const unsigned char *hash, unsigned char *sig) {
+  dtls_context_t *ctx      = key;
+  sc_tls_arena_t *previous = sc_tls_arena_enter(NULL);
+  pthread_mutex_lock(&ctx->key_lock);
+  int ret = mbedtls_rsa_pkcs1_sign(mbedtls_pk_rsa(ctx->pkey), f_rng, p_rng, mode, md_alg, hashlen,
+                                   hash, sig);
+  pthread_mutex_unlock(&ctx->key_lock);
+  sc_tls_arena_leave(previous);
+  return ret;
+}
+
+// Ticket callbacks: both may rotate the keys, and sealing draws from the RNG.
+// A context sharing another's keys locks the owner, which counts into the
+// sharing context's stats.
+static int locked_ticket_write(void *p_ticket, const mbedtls_ssl_session *session,
+                               unsigned char *start, const unsigned char *end, size_t *tlen,
+                               uint32_t *lifetime) {
+  dtls_context_t *ctx      = p_ticket;
+  dtls_context_t *source   = ctx->ticket_source;
+  sc_tls_arena_t *previous = sc_tls_arena_enter(NULL);
+  pthread_mutex_lock(&source->ticket_lock);
+  int ret = mbedtls_ssl_ticket_write(&source->ticket_ctx, session, start, end, tlen, lifetime);
+  if (ret == 0) {
+    ctx->ticket_stats.issued++;
+  }
+  pthread_mutex_unlock(&source->ticket_lock);
+  sc_tls_arena_leave(previous);
+  return ret;
+}
+
+static int locked_ticket_parse(void *p_ticket, mbedtls_ssl_session *session, unsigned char *buf,
+                               size_t len) {
+  dtls_context_t *ctx      = p_ticket;
+  dtls_context_t *source   = ctx->ticket_source;
+  sc_tls_arena_t *previous = sc_tls_arena_enter(NULL);
+  pthread_mutex_lock(&source->ticket_lock);
+  int ret = mbedtls_ssl_ticket_parse(&source->ticket_ctx, session, buf, len);
+  if (ret == 0) {
+    ctx->ticket_stats.resumed++;
+  } else {
+    ctx->ticket_stats.rejected++;
+  }
+  pthread_mutex_unlock(&source->ticket_lock);
+  sc_tls_arena_leave(previous);
+  return ret;
+}
+
+static size_t rsa_key_len(void *key) {
+  const dtls_context_t *ctx = key;
+  return mbedtls_rsa_get_len(mbedtls_pk_rsa(ctx->pkey));
+}
+
+// Big-endian field readers and writers for record parsing
+static size_t read_u16(const uint8_t *p) {
+  return (size_t) p[0] << 8 | p[1];
+}
+
+static size_t read_u24(const uint8_t *p) {
+  return (size_t) p[0] << 16 | (size_t) p[1] << 8 | p[2];
+}
+
+static void write_u16(uint8_t *p, size_t value) {
+  p[0] = (uint8_t) (value >> 8);
+  p[1] = (uint8_t) value;
+}
+
+static void write_u24(uint8_t *p, size_t value) {
+  p[0] = (uint8_t) (value >> 16);
+  p[1] = (uint8_t) (value >> 8);
+  p[2] = (uint8_t) value;
+}
+
+// Locate the cookie in a datagram holding an epoch 0, unfragmented ClientHello
+// Returns: true if the datagram is such a ClientHello, false otherwise
+static bool parse_client_hello(const uint8_t *buf, size_t len, const uint8_t **cookie,
+                               size_t *cookie_len) {
+  if (len < DTLS_RECORD_HEADER_LEN + DTLS_HANDSHAKE_HEADER_LEN) {
+    return false;
+  }
+
+  // Record header: content type, version (0xfe, minor), epoch, sequence number, length
+  size_t record_len = read_u16(buf + 11);
+  if (buf[0] != DTLS_CONTENT_HANDSHAKE || buf[1] != 0xfe || buf[3] != 0 || buf[4] != 0 ||
+      record_len < DTLS_HANDSHAKE_HEADER_LEN || record_len > len - DTLS_RECORD_HEADER_LEN) {
+    return false;
+  }
+
+  // Handshake header: type, length, message_seq, fragment offset, fragment length
+  const uint8_t *hs = buf + DTLS_RECORD_HEADER_LEN;
+  size_t msg_len    = read_u24(hs + 1);
+  if (hs[0] != DTLS_HS_CLIENT_HELLO || read_u24(hs + 6) != 0 || read_u24(hs + 9) != msg_len ||
+      msg_len > record_len - DTLS_HANDSHAKE_HEADER_LEN) {
+    return false;
+  }
+
+  // Body: client_version, random, session_id, cookie, ...
+  const uint8_t *body = hs + DTLS_HANDSHAKE_HEADER_LEN;
+  size_t pos          = 2 + DTLS_RANDOM_LEN;
+  if (pos + 1 > msg_len || body[pos] > DTLS_MAX_SESSION_ID_LEN) {
+    return false;
+  }
+  pos += 1 + body[pos];
+  if (pos + 1 > msg_len || pos + 1 + body[pos] > msg_len) {
+    return false;
+  }
+
+  *cookie_len = body[pos];
+  *cookie     = body + pos + 1;
+  return true;
+}
+
+// Build a HelloVerifyRequest answering a ClientHello (RFC 6347 section 4.2.1)
+// The record sequence number and message_seq mirror the ClientHello's, so no
+// per-peer state is needed to answer.
+// Returns: Length of the record written to out, or 0 on failure
+static size_t write_hello_verify(dtls_context_t *ctx, const uint8_t *hello,
+                                 const struct sockaddr *addr, socklen_t addr_len, uint8_t *out,
+                                 size_t out_size) {
+  size_t header_len = DTLS_RECORD_HEADER_LEN + DTLS_HANDSHAKE_HEADER_LEN;
+  if (out_size < header_len + 3) {
+    return 0;
+  }
+
+  memcpy(out, hello, DTLS_RECORD_HEADER_LEN);
+
+  uint8_t *hs = out + DTLS_RECORD_HEADER_LEN;
+  memset(hs, 0, DTLS_HANDSHAKE_HEADER_LEN);
+  hs[0] = DTLS_HS_HELLO_VERIFY;
+  memcpy(hs + 4, hello + DTLS_RECORD_HEADER_LEN + 4, 2);
+
+  // server_version is DTLS 1.0 whatever the negotiated version, as the RFC advises
+  uint8_t *body = hs + DTLS_HANDSHAKE_HEADER_LEN;
+  body[0]       = 0xfe;
+  body[1]       = 0xff;
+
+  unsigned char *cookie = body + 3;
+  unsigned char *end    = cookie;
+  if (locked_cookie_write(ctx, &end, out + out_size, (const unsigned char *) addr, addr_len) !=
+      0) {
+    return 0;
+  }
+
+  size_t cookie_len = (size_t) (end - cookie);
+  size_t body_len   = 3 + cookie_len;
+  body[2]           = (uint8_t) cookie_len;
+  write_u24(hs + 1, body_len);
+  write_u24(hs + 9, body_len);
+  write_u16(out + 11, DTLS_HANDSHAKE_HEADER_LEN + body_len);
+  return header_len + body_len;
+}
+
+// Plaintext transport
+// Sessions of a plain context never reach mbedTLS. The functions below stand
+// in for its record layer and handshake, keeping the record header, the
+// connection ID placement and the replay window, but not the cryptography.
+
+static uint64_t read_u48(const uint8_t *p) {
+  return (uint64_t) read_u16(p) << 32 | (uint64_t) read_u16(p + 2) << 16 | read_u16(p + 4);
+}
+
+static void write_u48(uint8_t *p, uint64_t value) {
+  write_u16(p, (size_t) (value >> 32) & 0xffff);
+  write_u16(p + 2, (size_t) (value >> 16) & 0xffff);
+  write_u16(p + 4, (size_t) value & 0xffff);
+}
+
+// The first record of a plaintext datagram, pointing into the datagram
+typedef struct {
+  uint8_t type; // Content type; for records with a connection ID, the inner one
+  size_t epoch;
+  uint64_t seq;
+  const uint8_t *cid; // DTLS_CID_LEN bytes, or NULL for a record without one
+  const uint8_t *payload;
+  size_t len;
+} plain_record_t;
+
+// Split the first record of a datagram into its fields. As in DTLS, a record
+// with a connection ID ends its payload with the real content type.
+// Returns: true if the datagram starts with a well-formed record
+static bool plain_parse(const uint8_t *buf, size_t len, plain_record_t *record) {
+  if (len < DTLS_RECORD_HEADER_LEN || buf[1] != 0xfe || buf[2] != 0xfd) {
+    return false;
+  }
+
+  size_t header_len = DTLS_RECORD_HEADER_LEN;
+  record->cid       = NULL;
+  if (buf[0] == DTLS_CID_CONTENT_TYPE) {
+    header_len += DTLS_CID_LEN;
+    if (len < header_len) {
+      return false;
+    }
+    record->cid = buf + DTLS_CID_OFFSET;
+  }
+
+  record->type    = buf[0];
+  record->epoch   = read_u16(buf + 3);
+  record->seq     = read_u48(buf + 5);
+  record->payload = buf + header_len;
+  record->len     = read_u16(buf + header_len - 2);
+  if (record->len > len - header_len) {
+    return false;
+  }
+
+  if (record->cid) {
+    if (record->len == 0) {
+      return false;
+    }
+    record->len--;
+    record->type = record->payload[record->len];
+  }
+  return true;
+}
+
+// Frame a payload of at most DTLS_MAX_FRAG_LEN bytes as one record
+// Returns: Length of the record written to out, which holds PLAIN_RECORD_MAX_LEN bytes
+static size_t plain_frame(uint8_t *out, uint8_t type, size_t epoch, uint64_t seq,
+                          const uint8_t *cid, const uint8_t *payload, size_t len) {
+  size_t header_len = DTLS_RECORD_HEADER_LEN;
+  size_t inner_len  = len;
+
+  out[0] = cid ? DTLS_CID_CONTENT_TYPE : type;
+  out[1] = 0xfe;
+  out[2] = 0xfd;
+  write_u16(out + 3, epoch);
+  write_u48(out + 5, seq);
+  if (cid) {
+    memcpy(out + DTLS_CID_OFFSET, cid, DTLS_CID_LEN);
+    header_len += DTLS_CID_LEN;
+    out[header_len + len] = type;
+    inner_len++;
+  }
+  write_u16(out + header_len - 2, inner_len);
+  memcpy(out + header_len, payload, len);
+  return header_len + inner_len;
+}
+
+// Frame a payload of at most DTLS_MAX_FRAG_LEN bytes as one record and send it
+// Returns: DTLS_OK once sent, DTLS_ERROR_WOULD_BLOCK if the socket is full,
+//          DTLS_ERROR_WRITE on other send failures
+static dtls_result_t plain_send(dtls_session_t *session, uint8_t type, size_t epoch, uint64_t seq,
+                                const uint8_t *cid, const uint8_t *payload, size_t len) {
+  uint8_t record[PLAIN_RECORD_MAX_LEN];
+  size_t record_len = plain_frame(record, type, epoch, seq, cid, payload, len);
+  if (session_send(session, record, record_len) < 0) {
+    return errno == EAGAIN || errno == EWOULDBLOCK ? DTLS_ERROR_WOULD_BLOCK : DTLS_ERROR_WRITE;
+  }
+  return DTLS_OK;
+}
+
+// Take the datagram fed to a plaintext session, or for a client that reads
+// its own socket, the next one waiting there
+// Returns: true with *record set if a well-formed record arrived
+static bool plain_receive(dtls_session_t *session, uint8_t *scratch, size_t scratch_len,
+                          plain_record_t *record) {
+  const uint8_t *buf = session->pending;
+  size_t len         = session->pending_len;
+  drop_pending(session);
+
+  if (!session->memory_bio) {
+    ssize_t ret = recv(session->fd, scratch, scratch_len, MSG_DONTWAIT);
+    if (ret <= 0) {
+      return false;
+    }
+    buf = scratch;
+    len = (size_t) ret;
+  }
+
+  return buf && plain_parse(buf, len, record);
+}
+
+// Accept each data record's sequence number once, within DTLS's sliding window
+// Returns: false for a number already seen or too old to tell
+static bool plain_check_replay(plain_state_t *plain, uint64_t seq) {
+  if (seq > plain->in_top) {
+    uint64_t shift   = seq - plain->in_top;
+    plain->in_window = shift >= PLAIN_REPLAY_WINDOW ? 0 : plain->in_window << shift;
+    plain->in_window |= 1;
+    plain->in_top = seq;
+    return true;
+  }
+
+  uint64_t age = plain->in_top - seq;
+  if (age >= PLAIN_REPLAY_WINDOW || ((plain->in_window >> age) & 1) != 0) {
+    return false;
+  }
+  plain->in_window |= (uint64_t) 1 << age;
+  return true;
+}
+
+// Find the field that follows a marker in an epoch 0 handshake record: a
+// length byte and that many bytes
+// Returns: true if the record is marker followed by such a field
+static bool plain_marked_field(const plain_record_t *record, const char *marker,
+                               size_t marker_len, const uint8_t **field, size_t *field_len) {
+  if (record->type != DTLS_CONTENT_HANDSHAKE || record->cid || record->epoch != 0 ||
+      record->len <= marker_len || memcmp(record->payload, marker, marker_len) != 0 ||
+      record->len != marker_len + 1 + record->payload[marker_len]) {
+    return false;
+  }
+  *field_len = record->payload[marker_len];
+  *field     = record->payload + marker_len + 1;
+  return true;
+}
+
+// Parse a client's hello
+// Returns: true if the record is a hello, with or without a cookie
+static bool plain_parse_hello(const plain_record_t *record, const uint8_t **cookie,
+                              size_t *cookie_len) {
+  return plain_marked_field(record, PLAIN_HELLO, PLAIN_HELLO_LEN, cookie, cookie_len);
+}
+
+static bool plain_is_hello(const plain_record_t *record) {
+  const uint8_t *cookie;
+  size_t cookie_len;
+  return plain_parse_hello(record, &cookie, &cookie_len);
+}
+
+// Client: send a hello echoing the last cookie the server challenged with
+static dtls_result_t plain_send_hello(dtls_session_t *session) {
+  uint8_t hello[PLAIN_HELLO_LEN + 1 + PLAIN_MAX_COOKIE_LEN];
+  size_t cookie_len = session->plain.cookie_len;
+  memcpy(hello, PLAIN_HELLO, PLAIN_HELLO_LEN);
+  hello[PLAIN_HELLO_LEN] = (uint8_t) cookie_len;
+  memcpy(hello + PLAIN_HELLO_LEN + 1, session->plain.cookie, cookie_len);
+  return plain_send(session, DTLS_CONTENT_HANDSHAKE, 0, 0, NULL, hello,
+                    PLAIN_HELLO_LEN + 1 + cookie_len);
+}
+
+// Client: keep the cookie from a server's challenge
+// Returns: true if the record is such a challenge
+static bool plain_take_challenge(dtls_session_t *session, const plain_record_t *record) {
+  const uint8_t *cookie;
+  size_t cookie_len;
+  if (!plain_marked_field(record, PLAIN_VERIFY, PLAIN_VERIFY_LEN, &cookie, &cookie_len) ||
+      cookie_len == 0 || cookie_len > PLAIN_MAX_COOKIE_LEN) {
+    return false;
+  }
+  memcpy(session->plain.cookie, cookie, cookie_len);
+  session->plain.cookie_len = cookie_len;
+  return true;
+}
+
+// Server: answer a hello with the connection ID the client is to use
+static dtls_result_t plain_answer_hello(dtls_session_t *session) {
+  uint8_t answer[PLAIN_HELLO_LEN + 1 + DTLS_CID_LEN];
+  size_t cid_len = session->plain.has_cid ? DTLS_CID_LEN : 0;
+  memcpy(answer, PLAIN_HELLO, PLAIN_HELLO_LEN);
+  answer[PLAIN_HELLO_LEN] = (uint8_t) cid_len;
+  memcpy(answer + PLAIN_HELLO_LEN + 1, session->plain.cid, cid_len);
+  return plain_send(session, DTLS_CONTENT_HANDSHAKE, 0, 0, NULL, answer,
+                    PLAIN_HELLO_LEN + 1 + cid_len);
+}
+
+// Client: take the connection ID from the server's answer to its hello
+// Returns: true if the record is such an answer
+static bool plain_take_answer(dtls_session_t *session, const plain_record_t *record) {
+  const uint8_t *cid;
+  size_t cid_len;
+  if (!plain_marked_field(record, PLAIN_HELLO, PLAIN_HELLO_LEN, &cid, &cid_len) ||
+      (cid_len != 0 && cid_len != DTLS_CID_LEN)) {
+    return false;
+  }
+
+  memcpy(session->plain.cid, cid, cid_len);
+  session->plain.has_cid = cid_len > 0;
+  return true;
+}
+
+// sc_dtls_handshake() for plaintext sessions
+static dtls_result_t plain_handshake(dtls_session_t *session) {
+  uint8_t scratch[PLAIN_RECORD_MAX_LEN];
+  plain_record_t record;
+  bool received = plain_receive(session, scratch, sizeof(scratch), &record);
+  if (session->handshake_complete) {
+    return DTLS_OK;
+  }
+
   if (session->ctx->role == DTLS_ROLE_SERVER) {
-    if (addr_len != session->addr_len || memcmp(&addr, &session->client_addr, addr_len) != 0) {
-      // Packet from wrong client, ignore
-      return MBEDTLS_ERR_SSL_WANT_READ;
+    if (!received || !plain_is_hello(&record)) {
+      return DTLS_ERROR_WOULD_BLOCK;
     }
+    // An answer lost to a full socket is sent again when the hello is
+    dtls_result_t result = plain_answer_hello(session);
+    if (result == DTLS_OK) {
+      session->handshake_complete = true;
+    }
+    return result;
   }
 
-  return (int) ret;
+  plain_state_t *plain = &session->plain;
+  if (received && plain->timeout_ms > 0 && plain_take_answer(session, &record)) {
+    session->handshake_complete = true;
+    session->timer_int_ms       = 0;
+    session->timer_fin_ms       = 0;
+    return DTLS_OK;
+  }
+
+  // Send the hello, at once with the cookie of a challenge, and again each
+  // time the timer runs out with the timeout doubled, within the bounds
+  // mbedTLS uses for DTLS flights
+  uint64_t now = monotonic_ms();
+  if (received && plain->timeout_ms > 0 && plain_take_challenge(session, &record)) {
+    plain->timeout_ms = (uint32_t) MBEDTLS_SSL_DTLS_TIMEOUT_DFL_MIN;
+  } else if (plain->timeout_ms == 0) {
+    plain->timeout_ms = (uint32_t) MBEDTLS_SSL_DTLS_TIMEOUT_DFL_MIN;
+  } else if (now < session->timer_fin_ms) {
+    return DTLS_ERROR_WOULD_BLOCK;
+  } else if (plain->timeout_ms >= (uint32_t) MBEDTLS_SSL_DTLS_TIMEOUT_DFL_MAX) {
+    return DTLS_ERROR_HANDSHAKE_TIMEOUT;
+  } else {
+    plain->timeout_ms *= 2;
+  }
+  session->timer_int_ms = now + plain->timeout_ms;
+  session->timer_fin_ms = session->timer_int_ms;
+
+  dtls_result_t result = plain_send_hello(session);
+  return result == DTLS_OK ? DTLS_ERROR_WOULD_BLOCK : result;
 }
 
-// UDP receive timeout callback for mbedtls
-static int udp_recv_timeout(void *ctx, unsigned char *buf, size_t len, uint32_t timeout) {
-  dtls_session_t *session = (dtls_session_t *) ctx;
+// Remember the epoch and sequence number of a record whose data a read returns
+// Replayed records are discarded before this, so only the same record, read
+// in parts, can carry a number equal to the newest.
+static void note_record(dtls_session_t *session, uint64_t epoch, uint64_t seq) {
+  session->last_record = epoch << RECORD_SEQ_BITS | (seq & RECORD_SEQ_MASK);
+  if (session->last_record >= session->newest_record) {
+    session->newest_record = session->last_record;
+  }
+}
 
-  struct timeval tv;
-  tv.tv_sec  = timeout / 1000;
-  tv.tv_usec = (timeout % 1000) * 1000;
+// sc_dtls_read() for plaintext sessions
+static dtls_result_t plain_read(dtls_session_t *session, uint8_t *buf, size_t len,
+                                size_t *bytes_read) {
+  uint8_t scratch[PLAIN_RECORD_MAX_LEN];
+  plain_record_t record;
+  if (!plain_receive(session, scratch, sizeof(scratch), &record)) {
+    return DTLS_ERROR_WOULD_BLOCK;
+  }
 
-  fd_set read_fds;
-  FD_ZERO(&read_fds);
-  FD_SET(session->fd, &read_fds);
+  // A client that missed the server's answer sends its hello again
+  if (plain_is_hello(&record)) {
+    if (session->ctx->role == DTLS_ROLE_SERVER && session->handshake_complete) {
+      (void) plain_answer_hello(session);
+    }
+    return DTLS_ERROR_WOULD_BLOCK;
+  }
+  if (!session->handshake_complete || record.epoch != PLAIN_DATA_EPOCH) {
+    return DTLS_ERROR_WOULD_BLOCK;
+  }
 
-  int ret = select(session->fd + 1, &read_fds, NULL, NULL, &tv);
-  if (ret < 0) {
-    return MBEDTLS_ERR_NET_RECV_FAILED;
+  // Once the server has given out an ID, its client's records must carry it
+  plain_state_t *plain = &session->plain;
+  if (session->ctx->role == DTLS_ROLE_SERVER && plain->has_cid) {
+    if (!record.cid || memcmp(record.cid, plain->cid, DTLS_CID_LEN) != 0) {
+      return DTLS_ERROR_WOULD_BLOCK;
+    }
+  } else if (record.cid) {
+    return DTLS_ERROR_WOULD_BLOCK;
+  }
+  if (!plain_check_replay(plain, record.seq)) {
+    return DTLS_ERROR_WOULD_BLOCK;
   }
 
-  if (ret == 0) {
-    return MBEDTLS_ERR_SSL_TIMEOUT;
+  if (record.type == DTLS_CONTENT_ALERT) {
+    return DTLS_ERROR_PEER_CLOSED;
+  }
+  if (record.type != DTLS_CONTENT_APPLICATION) {
+    return DTLS_ERROR_WOULD_BLOCK;
   }
 
-  return udp_recv(ctx, buf, len);
+  size_t copy_len = record.len < len ? record.len : len;
+  memcpy(buf, record.payload, copy_len);
+  *bytes_read = copy_len;
+  note_record(session, record.epoch, record.seq);
+  return DTLS_OK;
+}
+
+// Send one data record, or an alert, from a plaintext session. Clients put
+// the connection ID they were given in every record.
+static dtls_result_t plain_send_data(dtls_session_t *session, uint8_t type, const uint8_t *buf,
+                                     size_t len) {
+  plain_state_t *plain = &session->plain;
+  const uint8_t *cid   = NULL;
+  if (session->ctx->role == DTLS_ROLE_CLIENT && plain->has_cid) {
+    cid = plain->cid;
+  }
+  return plain_send(session, type, PLAIN_DATA_EPOCH, ++plain->out_seq, cid, buf, len);
 }
 
 // Certificate verification callback
@@ -198,19 +1061,169 @@ static int cert_verify_callback(void *ctx, mbedtls_x509_crt *crt, int depth, uin
   return 0;
 }
 
+// Counter the cipher self-benchmark is timed with: the TSC on x86_64, which
+// counts cycles at the nominal clock rate, and CLOCK_MONOTONIC elsewhere, as
+// aarch64 does not let user space read its cycle counter by default
+#if defined(__x86_64__)
+#define CIPHER_BENCH_UNIT "cycle"
+static uint64_t cipher_bench_ticks(void) {
+  return __rdtsc();
+}
+#else
+#define CIPHER_BENCH_UNIT "ns"
+static uint64_t cipher_bench_ticks(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+#endif
+
+// Seal records with one AEAD cipher the way a DTLS record is sealed
+// Returns: Bytes sealed per tick in the fastest round, or a negative value if
+//          mbedTLS cannot run the cipher
+static double measure_cipher(mbedtls_cipher_type_t type) {
+  const mbedtls_cipher_info_t *info = mbedtls_cipher_info_from_type(type);
+  if (!info) {
+    return -1;
+  }
+
+  mbedtls_cipher_context_t cipher;
+  mbedtls_cipher_init(&cipher);
+  static const uint8_t key[32];
+  if (mbedtls_cipher_setup(&cipher, info) != 0 ||
+      mbedtls_cipher_setkey(&cipher, key, mbedtls_cipher_get_key_bitlen(&cipher),
+                            MBEDTLS_ENCRYPT) != 0) {
+    mbedtls_cipher_free(&cipher);
+    return -1;
+  }
+
+  static uint8_t input[CIPHER_BENCH_RECORD_LEN];
+  static uint8_t output[CIPHER_BENCH_RECORD_LEN + CIPHER_BENCH_TAG_LEN];
+  uint8_t header[DTLS_RECORD_HEADER_LEN] = {0};
+  uint8_t iv[CIPHER_BENCH_IV_LEN]        = {0};
+  uint64_t best                          = UINT64_MAX;
+  for (int round = 0; round < CIPHER_BENCH_ROUNDS; round++) {
+    uint64_t start = cipher_bench_ticks();
+    for (size_t i = 0; i < CIPHER_BENCH_RECORDS; i++) {
+      // A fresh nonce per record, as the record sequence number gives DTLS
+      iv[CIPHER_BENCH_IV_LEN - 1] = (uint8_t) i;
+      size_t olen                 = 0;
+      if (mbedtls_cipher_auth_encrypt_ext(&cipher, iv, sizeof(iv), header, sizeof(header), input,
+                                          sizeof(input), output, sizeof(output), &olen,
+                                          CIPHER_BENCH_TAG_LEN) != 0) {
+        mbedtls_cipher_free(&cipher);
+        return -1;
+      }
+    }
+    uint64_t elapsed = cipher_bench_ticks() - start;
+    best             = elapsed < best ? elapsed : best;
+  }
+
+  mbedtls_cipher_free(&cipher);
+  // Guard against a counter too coarse to see the round
+  return (double) (CIPHER_BENCH_RECORD_LEN * CIPHER_BENCH_RECORDS) / (double) (best ? best : 1);
+}
+
+dtls_result_t sc_dtls_rank_ciphers(void) {
+  double rates[DTLS_CIPHER_COUNT];
+  size_t order[DTLS_CIPHER_COUNT];
+  for (size_t i = 0; i < DTLS_CIPHER_COUNT; i++) {
+    rates[i] = measure_cipher(g_cipher_choices[i].type);
+    if (rates[i] < 0) {
+      log_error("Cannot run %s for the cipher self-benchmark", g_cipher_choices[i].name);
+      return DTLS_ERROR_INIT;
+    }
+
+    // Insert in order of throughput, fastest first
+    size_t j = i;
+    while (j > 0 && rates[order[j - 1]] < rates[i]) {
+      order[j] = order[j - 1];
+      j--;
+    }
+    order[j] = i;
+  }
+
+  for (size_t i = 0; i < DTLS_CIPHER_COUNT; i++) {
+    const cipher_choice_t *choice            = &g_cipher_choices[order[i]];
+    g_ciphersuites[2 * i]                    = choice->ecdsa_suite;
+    g_ciphersuites[2 * i + 1]                = choice->rsa_suite;
+    g_cipher_ranking.rates[i].name           = choice->name;
+    g_cipher_ranking.rates[i].bytes_per_tick = rates[order[i]];
+  }
+  g_cipher_ranking.unit            = CIPHER_BENCH_UNIT;
+  g_cipher_ranking.preferred_suite = mbedtls_ssl_get_ciphersuite_name(g_ciphersuites[0]);
+  g_ciphers_ranked                 = true;
+  return DTLS_OK;
+}
+
+const dtls_cipher_ranking_t *sc_dtls_cipher_ranking(void) {
+  return g_ciphers_ranked ? &g_cipher_ranking : NULL;
+}
+
 dtls_result_t sc_dtls_init(void) {
   if (g_dtls_initialized) {
     return DTLS_OK;
   }
 
+  mbedtls_entropy_init(&g_entropy);
+  if (pthread_key_create(&g_rng_key, free_thread_rng) != 0) {
+    log_error("%s", "Failed to create random number generator key");
+    mbedtls_entropy_free(&g_entropy);
+    return DTLS_ERROR_INIT;
+  }
+
+  // Seed this thread's DRBG now, so a broken entropy source fails startup
+  if (!thread_rng()) {
+    pthread_key_delete(g_rng_key);
+    mbedtls_entropy_free(&g_entropy);
+    return DTLS_ERROR_INIT;
+  }
+
+  if (!g_allocator_installed) {
+    mbedtls_platform_set_calloc_free(sc_tls_arena_calloc, sc_tls_arena_free);
+    g_allocator_installed = true;
+  }
+
   g_dtls_initialized = true;
   return DTLS_OK;
 }
 
 void sc_dtls_cleanup(void) {
+  if (!g_dtls_initialized) {
+    return;
+  }
+
+  // Other threads' DRBGs went with them; only the caller's is left
+  if (t_rng) {
+    pthread_setspecific(g_rng_key, NULL);
+    free_thread_rng(t_rng);
+    t_rng = NULL;
+  }
+  pthread_key_delete(g_rng_key);
+  mbedtls_entropy_free(&g_entropy);
   g_dtls_initialized = false;
 }
 
+// Initialize a new context's locks and the saved session freed with them
+// Returns: true on success; on failure nothing is left to destroy
+static bool init_locks(dtls_context_t *ctx) {
+  if (pthread_mutex_init(&ctx->cookie_lock, NULL) != 0) {
+    return false;
+  }
+  if (pthread_mutex_init(&ctx->key_lock, NULL) != 0) {
+    pthread_mutex_destroy(&ctx->cookie_lock);
+    return false;
+  }
+  if (pthread_mutex_init(&ctx->ticket_lock, NULL) != 0) {
+    pthread_mutex_destroy(&ctx->key_lock);
+    pthread_mutex_destroy(&ctx->cookie_lock);
+    return false;
+  }
+  ctx->locks_initialized = true;
+  mbedtls_ssl_session_init(&ctx->saved_session);
+  return true;
+}
+
 dtls_context_t *sc_dtls_context_create(dtls_role_t role, const char *cert_path,
                                        const char *key_path, const uint8_t *pinned_cert_hash,
                                        size_t pinned_cert_hash_len) {
@@ -228,18 +1241,11 @@ dtls_context_t *sc_dtls_context_create(dtls_role_t role, const char *cert_path,
   ctx->role = role;
   int ret;
 
-  // Initialize RNG
-  mbedtls_entropy_init(&ctx->entropy);
-  mbedtls_ctr_drbg_init(&ctx->ctr_drbg);
-  ctx->rng_initialized = true;
-
-  const char *pers = "space_captain_dtls";
-  ret              = mbedtls_ctr_drbg_seed(&ctx->ctr_drbg, mbedtls_entropy_func, &ctx->entropy,
-                                           (const unsigned char *) pers, strlen(pers));
-  if (ret != 0) {
-    log_error("Failed to seed random number generator: %d", ret);
-    goto error;
+  if (!init_locks(ctx)) {
+    free(ctx);
+    return NULL;
   }
+  ctx->ticket_source = ctx;
 
   // Initialize SSL config
   mbedtls_ssl_config_init(&ctx->conf);
@@ -253,7 +1259,7 @@ dtls_context_t *sc_dtls_context_create(dtls_role_t role, const char *cert_path,
     goto error;
   }
 
-  mbedtls_ssl_conf_rng(&ctx->conf, mbedtls_ctr_drbg_random, &ctx->ctr_drbg);
+  mbedtls_ssl_conf_rng(&ctx->conf, thread_random, NULL);
   mbedtls_ssl_conf_dbg(&ctx->conf, debug_callback, NULL);
 
   // Set up certificates for server
@@ -280,7 +1286,40 @@ dtls_context_t *sc_dtls_context_create(dtls_role_t role, const char *cert_path,
       goto error;
     }
 
-    ret = mbedtls_ssl_conf_own_cert(&ctx->conf, &ctx->cert, &ctx->pkey);
+    ret = mbedtls_pk_check_pair(&ctx->cert.pk, &ctx->pkey);
+    if (ret != 0) {
+      log_error("Private key %s does not match certificate %s: %d", key_path, cert_path, ret);
+      goto error;
+    }
+
+    // Handshakes may run on several threads at once. ECDSA signing only reads
+    // the key, so ECDSA keys are shared as they are; RSA keys are wrapped so
+    // their private operations are serialized.
+    mbedtls_pk_context *own_key = &ctx->pkey;
+    if (mbedtls_pk_can_do(&ctx->pkey, MBEDTLS_PK_ECDSA)) {
+      mbedtls_ecp_group_id curve = mbedtls_pk_ec(ctx->pkey)->grp.id;
+      if (curve != MBEDTLS_ECP_DP_SECP256R1) {
+        const mbedtls_ecp_curve_info *info = mbedtls_ecp_curve_info_from_grp_id(curve);
+        log_error("ECDSA key in %s uses %s; clients only accept secp256r1", key_path,
+                  info ? info->name : "an unknown curve");
+        goto error;
+      }
+      log_info("Server identity: ECDSA secp256r1 key from %s", key_path);
+    } else if (mbedtls_pk_get_type(&ctx->pkey) == MBEDTLS_PK_RSA) {
+      log_info("Server identity: RSA-%zu key from %s", mbedtls_pk_get_bitlen(&ctx->pkey),
+               key_path);
+      mbedtls_pk_init(&ctx->signer);
+      ctx->signer_initialized = true;
+      ret = mbedtls_pk_setup_rsa_alt(&ctx->signer, ctx, locked_rsa_decrypt, locked_rsa_sign,
+                                     rsa_key_len);
+      if (ret != 0) {
+        log_error("Failed to wrap RSA private key: %d", ret);
+        goto error;
+      }
+      own_key = &ctx->signer;
+    }
+
+    ret = mbedtls_ssl_conf_own_cert(&ctx->conf, &ctx->cert, own_key);
     if (ret != 0) {
       log_error("Failed to configure certificate: %d", ret);
       goto error;
@@ -289,14 +1328,28 @@ dtls_context_t *sc_dtls_context_create(dtls_role_t role, const char *cert_path,
     // Initialize cookie for DoS protection
     mbedtls_ssl_cookie_init(&ctx->cookie_ctx);
     ctx->cookie_initialized = true;
-    ret = mbedtls_ssl_cookie_setup(&ctx->cookie_ctx, mbedtls_ctr_drbg_random, &ctx->ctr_drbg);
+    ret = mbedtls_ssl_cookie_setup(&ctx->cookie_ctx, thread_random, NULL);
     if (ret != 0) {
       log_error("Failed to setup cookie context: %d", ret);
       goto error;
     }
 
-    mbedtls_ssl_conf_dtls_cookies(&ctx->conf, mbedtls_ssl_cookie_write, mbedtls_ssl_cookie_check,
-                                  &ctx->cookie_ctx);
+    mbedtls_ssl_conf_dtls_cookies(&ctx->conf, locked_cookie_write, locked_cookie_check, ctx);
+
+    // Session tickets let returning clients skip the key exchange. mbedTLS
+    // replaces the sealing key every lifetime and keeps the previous one, so
+    // a ticket stays usable until it expires whichever key sealed it.
+    mbedtls_ssl_ticket_init(&ctx->ticket_ctx);
+    ctx->ticket_initialized = true;
+    ret = mbedtls_ssl_ticket_setup(&ctx->ticket_ctx, thread_random, NULL,
+                                   MBEDTLS_CIPHER_AES_256_GCM, TICKET_LIFETIME_SECONDS);
+    if (ret != 0) {
+      log_error("Failed to setup session ticket keys: %d", ret);
+      goto error;
+    }
+
+    mbedtls_ssl_conf_session_tickets_cb(&ctx->conf, locked_ticket_write, locked_ticket_parse,
+                                        ctx);
   }
 
   // Store pinned cert hash for client
@@ -316,15 +1369,32 @@ dtls_context_t *sc_dtls_context_create(dtls_role_t role, const char *cert_path,
     mbedtls_ssl_conf_authmode(&ctx->conf, MBEDTLS_SSL_VERIFY_NONE);
   }
 
-  // Configure cipher suites for performance (prefer AES-GCM)
-  static const int ciphersuites[] = {MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
-                                     MBEDTLS_TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384,
-                                     MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
-                                     MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384, 0};
-  mbedtls_ssl_conf_ciphersuites(&ctx->conf, ciphersuites);
+  // Clients ask for a ticket on every full handshake and offer it on the next
+  if (role == DTLS_ROLE_CLIENT) {
+    mbedtls_ssl_conf_session_tickets(&ctx->conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+  }
 
-  // Set timeouts
-  mbedtls_ssl_conf_read_timeout(&ctx->conf, 30000); // 30 seconds
+  // AEAD suites only, in the order sc_dtls_rank_ciphers() measured as fastest
+  mbedtls_ssl_conf_ciphersuites(&ctx->conf, g_ciphersuites);
+  mbedtls_ssl_conf_curves(&ctx->conf, g_curves);
+
+  // Clients ask for small records through max_fragment_length; servers use the
+  // same limit for what they send. Either way a record fits the small buffers.
+  ret = mbedtls_ssl_conf_max_frag_len(&ctx->conf, DTLS_MAX_FRAG_LEN_CODE);
+  if (ret != 0) {
+    log_error("Failed to set maximum fragment length: %d", ret);
+    goto error;
+  }
+
+  // Servers give every session a connection ID that its client's records
+  // carry (sc_dtls_session_set_cid()). Clients want one but need none of their
+  // own: records to a client are told apart by the socket they arrive on.
+  ret = mbedtls_ssl_conf_cid(&ctx->conf, role == DTLS_ROLE_SERVER ? DTLS_CID_LEN : 0,
+                             MBEDTLS_SSL_UNEXPECTED_CID_IGNORE);
+  if (ret != 0) {
+    log_error("Failed to configure connection IDs: %d", ret);
+    goto error;
+  }
 
   ctx->initialized = true;
   return ctx;
@@ -334,10 +1404,62 @@ error:
   return NULL;
 }
 
+dtls_context_t *sc_dtls_context_create_plain(dtls_role_t role) {
+  if (!g_dtls_initialized) {
+    log_error("%s", "DTLS not initialized");
+    return NULL;
+  }
+
+  dtls_context_t *ctx = calloc(1, sizeof(dtls_context_t));
+  if (!ctx) {
+    log_error("%s", "Failed to allocate DTLS context");
+    return NULL;
+  }
+
+  ctx->role          = role;
+  ctx->plain         = true;
+  ctx->ticket_source = ctx;
+  if (!init_locks(ctx)) {
+    free(ctx);
+    return NULL;
+  }
+
+  // Hellos are screened with cookies as in DTLS, so a flood of spoofed
+  // sources cannot fill the session pool
+  if (role == DTLS_ROLE_SERVER) {
+    mbedtls_ssl_cookie_init(&ctx->cookie_ctx);
+    ctx->cookie_initialized = true;
+    int ret = mbedtls_ssl_cookie_setup(&ctx->cookie_ctx, thread_random, NULL);
+    if (ret != 0) {
+      log_error("Failed to setup cookie context: %d", ret);
+      sc_dtls_context_destroy(ctx);
+      return NULL;
+    }
+  }
+
+  ctx->initialized = true;
+  return ctx;
+}
+
+bool sc_dtls_context_is_plain(const dtls_context_t *ctx) {
+  return ctx && ctx->plain;
+}
+
 void sc_dtls_context_destroy(dtls_context_t *ctx) {
   if (!ctx)
     return;
 
+  // Release pooled sessions; any still handed out become invalid
+  if (ctx->session_pool) {
+    for (size_t i = 0; i < ctx->session_pool->capacity; i++) {
+      dtls_session_t *session = sc_slab_slot(ctx->session_pool, i);
+      if (session->ssl_ready) {
+        free_ssl(session);
+      }
+    }
+    sc_slab_nuke(ctx->session_pool);
+  }
+
   // Free SSL config if initialized
   if (ctx->config_initialized) {
     mbedtls_ssl_config_free(&ctx->conf);
@@ -347,106 +1469,446 @@ void sc_dtls_context_destroy(dtls_context_t *ctx) {
   if (ctx->cert_initialized) {
     mbedtls_x509_crt_free(&ctx->cert);
   }
+  if (ctx->signer_initialized) {
+    mbedtls_pk_free(&ctx->signer);
+  }
   if (ctx->pkey_initialized) {
     mbedtls_pk_free(&ctx->pkey);
   }
   if (ctx->cookie_initialized) {
     mbedtls_ssl_cookie_free(&ctx->cookie_ctx);
   }
+  if (ctx->ticket_initialized) {
+    mbedtls_ssl_ticket_free(&ctx->ticket_ctx);
+  }
 
-  // Free RNG resources
-  if (ctx->rng_initialized) {
-    mbedtls_ctr_drbg_free(&ctx->ctr_drbg);
-    mbedtls_entropy_free(&ctx->entropy);
+  if (ctx->locks_initialized) {
+    mbedtls_ssl_session_free(&ctx->saved_session);
+    pthread_mutex_destroy(&ctx->ticket_lock);
+    pthread_mutex_destroy(&ctx->key_lock);
+    pthread_mutex_destroy(&ctx->cookie_lock);
   }
 
   free(ctx->pinned_cert_hash);
   free(ctx);
 }
 
-dtls_session_t *sc_dtls_session_create(dtls_context_t *ctx, int fd,
-                                       const struct sockaddr *client_addr, socklen_t addr_len) {
-  if (!ctx || fd < 0) {
-    return NULL;
+dtls_result_t sc_dtls_context_reserve_sessions(dtls_context_t *ctx, size_t capacity) {
+  if (!ctx || capacity == 0 || ctx->session_pool)
+    return DTLS_ERROR_INVALID_PARAMS;
+
+  sc_slab_t *pool = sc_slab_init(sizeof(dtls_session_t), capacity);
+  if (!pool) {
+    return DTLS_ERROR_MEMORY;
   }
 
-  dtls_session_t *session = calloc(1, sizeof(dtls_session_t));
-  if (!session) {
-    log_error("%s", "Failed to allocate DTLS session");
-    return NULL;
+  // Run the expensive setup (record buffers, handshake state) for every
+  // session now so that accepting a client does not allocate
+  for (size_t i = 0; i < capacity; i++) {
+    dtls_session_t *session = sc_slab_slot(pool, i);
+    session->ctx            = ctx;
+    if (ctx->plain) {
+      continue;
+    }
+
+    int ret = setup_ssl(session);
+    if (ret != 0) {
+      log_error("Failed to setup pooled SSL context %zu of %zu: %d", i + 1, capacity, ret);
+      for (size_t j = 0; j < i; j++) {
+        free_ssl(sc_slab_slot(pool, j));
+      }
+      sc_slab_nuke(pool);
+      return DTLS_ERROR_MEMORY;
+    }
+  }
+
+  ctx->session_pool = pool;
+  if (ctx->plain) {
+    log_info("Preallocated %zu plaintext sessions", capacity);
+  } else {
+    log_info("Preallocated %zu DTLS sessions (%d/%d byte record buffers)", capacity,
+             MBEDTLS_SSL_IN_CONTENT_LEN, MBEDTLS_SSL_OUT_CONTENT_LEN);
   }
+  return DTLS_OK;
+}
 
-  session->ctx = ctx;
-  session->fd  = fd;
+size_t sc_dtls_context_sessions_in_use(const dtls_context_t *ctx) {
+  return ctx ? sc_slab_in_use(ctx->session_pool) : 0;
+}
 
-  // Store client address
-  if (client_addr && addr_len > 0) {
-    memcpy(&session->client_addr, client_addr, addr_len);
-    session->addr_len = addr_len;
+void sc_dtls_context_set_send(dtls_context_t *ctx, dtls_send_fn fn, void *user_data) {
+  if (!ctx)
+    return;
+
+  ctx->send_fn        = fn;
+  ctx->send_user_data = user_data;
+}
+
+// sc_dtls_check_hello() for plaintext contexts: the same cookie exchange, in
+// plain hello records
+static dtls_hello_result_t plain_check_hello(dtls_context_t *ctx, int fd,
+                                             const struct sockaddr *addr, socklen_t addr_len,
+                                             const uint8_t *buf, size_t len) {
+  plain_record_t record;
+  const uint8_t *cookie;
+  size_t cookie_len;
+  if (!plain_parse(buf, len, &record) || !plain_parse_hello(&record, &cookie, &cookie_len)) {
+    ctx->hello_stats.dropped++;
+    return DTLS_HELLO_DROPPED;
   }
 
-  // Initialize SSL context
-  mbedtls_ssl_init(&session->ssl);
-  // mbedtls_timing_delay_context doesn't need explicit init
+  if (cookie_len > 0 &&
+      locked_cookie_check(ctx, cookie, cookie_len, (const unsigned char *) addr, addr_len) == 0) {
+    ctx->hello_stats.verified++;
+    return DTLS_HELLO_VERIFIED;
+  }
 
-  int ret = mbedtls_ssl_setup(&session->ssl, &ctx->conf);
-  if (ret != 0) {
-    log_error("Failed to setup SSL context: %d", ret);
-    sc_dtls_session_destroy(session);
-    return NULL;
+  uint8_t challenge[PLAIN_VERIFY_LEN + 1 + PLAIN_MAX_COOKIE_LEN];
+  unsigned char *end = challenge + PLAIN_VERIFY_LEN + 1;
+  memcpy(challenge, PLAIN_VERIFY, PLAIN_VERIFY_LEN);
+  if (locked_cookie_write(ctx, &end, challenge + sizeof(challenge),
+                          (const unsigned char *) addr, addr_len) != 0) {
+    ctx->hello_stats.dropped++;
+    return DTLS_HELLO_DROPPED;
+  }
+  size_t challenge_len        = (size_t) (end - challenge);
+  challenge[PLAIN_VERIFY_LEN] = (uint8_t) (challenge_len - PLAIN_VERIFY_LEN - 1);
+
+  uint8_t reply[PLAIN_RECORD_MAX_LEN];
+  size_t reply_len =
+    plain_frame(reply, DTLS_CONTENT_HANDSHAKE, 0, 0, NULL, challenge, challenge_len);
+  transmit(ctx, fd, addr, addr_len, reply, reply_len);
+  ctx->hello_stats.challenged++;
+  return DTLS_HELLO_CHALLENGED;
+}
+
+dtls_hello_result_t sc_dtls_check_hello(dtls_context_t *ctx, int fd, const struct sockaddr *addr,
+                                        socklen_t addr_len, const uint8_t *buf, size_t len) {
+  if (!ctx || !ctx->cookie_initialized || !addr || !buf) {
+    return DTLS_HELLO_DROPPED;
+  }
+  if (ctx->plain) {
+    return plain_check_hello(ctx, fd, addr, addr_len, buf, len);
+  }
+
+  const uint8_t *cookie;
+  size_t cookie_len;
+  if (!parse_client_hello(buf, len, &cookie, &cookie_len)) {
+    ctx->hello_stats.dropped++;
+    return DTLS_HELLO_DROPPED;
+  }
+
+  if (cookie_len > 0 &&
+      locked_cookie_check(ctx, cookie, cookie_len, (const unsigned char *) addr, addr_len) == 0) {
+    ctx->hello_stats.verified++;
+    return DTLS_HELLO_VERIFIED;
+  }
+
+  // No cookie, or one issued to another address or expired: challenge again
+  uint8_t reply[DTLS_RECORD_HEADER_LEN + DTLS_HANDSHAKE_HEADER_LEN + 3 + DTLS_MAX_COOKIE_LEN];
+  size_t reply_len = write_hello_verify(ctx, buf, addr, addr_len, reply, sizeof(reply));
+  if (reply_len == 0) {
+    ctx->hello_stats.dropped++;
+    return DTLS_HELLO_DROPPED;
+  }
+
+  transmit(ctx, fd, addr, addr_len, reply, reply_len);
+  ctx->hello_stats.challenged++;
+  return DTLS_HELLO_CHALLENGED;
+}
+
+const dtls_hello_stats_t *sc_dtls_context_hello_stats(const dtls_context_t *ctx) {
+  return ctx ? &ctx->hello_stats : NULL;
+}
+
+dtls_result_t sc_dtls_context_share_tickets(dtls_context_t *ctx, dtls_context_t *source) {
+  if (ctx && source && ctx->plain && source->plain && ctx->role == DTLS_ROLE_SERVER &&
+      source->role == DTLS_ROLE_SERVER)
+    return DTLS_OK;
+
+  if (!ctx || !source || !ctx->ticket_initialized || !source->ticket_initialized)
+    return DTLS_ERROR_INVALID_PARAMS;
+
+  ctx->ticket_source = source;
+  return DTLS_OK;
+}
+
+dtls_ticket_stats_t sc_dtls_context_ticket_stats(dtls_context_t *ctx) {
+  dtls_ticket_stats_t stats = {0};
+  if (!ctx || ctx->plain)
+    return stats;
+
+  pthread_mutex_lock(&ctx->ticket_source->ticket_lock);
+  stats = ctx->ticket_stats;
+  pthread_mutex_unlock(&ctx->ticket_source->ticket_lock);
+  return stats;
+}
+
+bool sc_dtls_context_has_saved_session(const dtls_context_t *ctx) {
+  return ctx && ctx->session_saved;
+}
+
+void sc_dtls_context_forget_session(dtls_context_t *ctx) {
+  if (!ctx || !ctx->session_saved)
+    return;
+
+  mbedtls_ssl_session_free(&ctx->saved_session);
+  mbedtls_ssl_session_init(&ctx->saved_session);
+  ctx->session_saved = false;
+}
+
+// Set up a session's SSL context for a new peer, reusing the one a pooled
+// session kept from its last use
+// Returns: true on success, false after logging the failure
+static bool prepare_ssl(dtls_session_t *session, const struct sockaddr *client_addr,
+                        socklen_t addr_len) {
+  const dtls_context_t *ctx = session->ctx;
+
+  // Initialize SSL context unless a pooled session kept it from its last use
+  int ret;
+  if (!session->ssl_ready) {
+    ret = setup_ssl(session);
+    if (ret != 0) {
+      log_error("Failed to setup SSL context: %d", ret);
+      return false;
+    }
   }
 
-  // Set bio callbacks
-  mbedtls_ssl_set_bio(&session->ssl, session, udp_send, udp_recv, udp_recv_timeout);
+  // Set bio callbacks; every read is non-blocking, so there is no timed receive
+  mbedtls_ssl_set_bio(&session->ssl, session, udp_send, udp_recv, NULL);
 
   // Set timer callbacks
-  mbedtls_ssl_set_timer_cb(&session->ssl, &session->timer, mbedtls_timing_set_delay,
-                           mbedtls_timing_get_delay);
+  mbedtls_ssl_set_timer_cb(&session->ssl, session, set_timer, get_timer);
 
   // Set verification callback for certificate pinning
   if (ctx->role == DTLS_ROLE_CLIENT && ctx->pinned_cert_hash) {
     mbedtls_ssl_set_verify(&session->ssl, cert_verify_callback, session);
   }
 
+  // Offer the last session's ticket. The server certificate was verified
+  // when that session was established; a resumed handshake does not send it.
+  if (ctx->role == DTLS_ROLE_CLIENT && ctx->session_saved) {
+    ret = mbedtls_ssl_set_session(&session->ssl, &ctx->saved_session);
+    if (ret != 0) {
+      log_warn("Failed to offer saved session, using a full handshake: %d", ret);
+    }
+  }
+
+  // Ask the server for a connection ID, offering an empty one in return
+  if (ctx->role == DTLS_ROLE_CLIENT) {
+    ret = mbedtls_ssl_set_cid(&session->ssl, MBEDTLS_SSL_CID_ENABLED, NULL, 0);
+    if (ret != 0) {
+      log_error("Failed to enable connection IDs: %d", ret);
+      return false;
+    }
+  }
+
   // For server, set client address for cookie verification
   if (ctx->role == DTLS_ROLE_SERVER && client_addr) {
     ret = mbedtls_ssl_set_client_transport_id(&session->ssl, (const unsigned char *) client_addr,
                                               addr_len);
     if (ret != 0) {
       log_error("Failed to set client transport ID: %d", ret);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+dtls_session_t *sc_dtls_session_create(dtls_context_t *ctx, int fd,
+                                       const struct sockaddr *client_addr, socklen_t addr_len) {
+  if (!ctx || fd < 0) {
+    return NULL;
+  }
+
+  dtls_session_t *session;
+  if (ctx->session_pool) {
+    session = sc_slab_alloc(ctx->session_pool);
+    if (!session) {
+      log_error("DTLS session pool exhausted (%zu sessions)", ctx->session_pool->capacity);
+      return NULL;
+    }
+  } else {
+    session = calloc(1, sizeof(dtls_session_t));
+    if (!session) {
+      log_error("%s", "Failed to allocate DTLS session");
+      return NULL;
+    }
+  }
+
+  session->ctx           = ctx;
+  session->fd            = fd;
+  session->last_record   = 0;
+  session->newest_record = 0;
+
+  // Server sessions share one socket, so they only ever receive what the
+  // caller feeds them; the socket is used for sending alone
+  session->memory_bio = (ctx->role == DTLS_ROLE_SERVER);
+
+  // Store client address
+  if (client_addr && addr_len > 0) {
+    memcpy(&session->client_addr, client_addr, addr_len);
+    session->addr_len = addr_len;
+  }
+
+  session->timer_int_ms = 0;
+  session->timer_fin_ms = 0;
+  memset(&session->plain, 0, sizeof(session->plain));
+  if (!ctx->plain) {
+    sc_tls_arena_t *previous = sc_tls_arena_enter(&session->arena);
+    bool prepared            = prepare_ssl(session, client_addr, addr_len);
+    sc_tls_arena_leave(previous);
+    if (!prepared) {
       sc_dtls_session_destroy(session);
       return NULL;
     }
   }
 
-  // Make socket non-blocking
-  int flags = fcntl(fd, F_GETFL, 0);
-  if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
-    log_error("%s", "Failed to set socket non-blocking");
-    sc_dtls_session_destroy(session);
-    return NULL;
+  // Make socket non-blocking. Server sessions send with MSG_DONTWAIT and never
+  // read the shared socket, so accepting a client costs no extra system calls.
+  if (ctx->role == DTLS_ROLE_CLIENT) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+      log_error("%s", "Failed to set socket non-blocking");
+      sc_dtls_session_destroy(session);
+      return NULL;
+    }
   }
 
   return session;
 }
 
+void sc_dtls_session_set_send(dtls_session_t *session, dtls_send_fn fn, void *user_data) {
+  if (!session)
+    return;
+
+  session->send_fn        = fn;
+  session->send_user_data = user_data;
+}
+
 void sc_dtls_session_destroy(dtls_session_t *session) {
   if (!session)
     return;
 
-  mbedtls_ssl_free(&session->ssl);
-  free(session);
+  sc_slab_t *pool = session->ctx ? session->ctx->session_pool : NULL;
+  if (!sc_slab_contains(pool, session)) {
+    if (session->ssl_ready) {
+      free_ssl(session);
+    }
+    free(session);
+    return;
+  }
+
+  // Keep the set-up SSL context (and its record buffers) for the next client.
+  // The reset frees the old session's state and allocates the next client's
+  // handshake state, which counts as that handshake's. If the reset fails the
+  // context is released and set up again on reuse.
+  if (session->ssl_ready) {
+    sc_tls_arena_t *previous = sc_tls_arena_enter(&session->arena);
+    sc_tls_arena_begin_handshake(&session->arena);
+    int ret = mbedtls_ssl_session_reset(&session->ssl);
+    sc_tls_arena_leave(previous);
+    sc_tls_arena_release(&session->arena);
+    if (ret != 0) {
+      free_ssl(session);
+    }
+  }
+
+  // The next client only gets a connection ID if it is given one of its own
+  if (session->ssl_ready) {
+    (void) mbedtls_ssl_set_cid(&session->ssl, MBEDTLS_SSL_CID_DISABLED, NULL, 0);
+  }
+
+  session->fd                 = -1;
+  session->addr_len           = 0;
+  session->handshake_complete = false;
+  session->memory_bio         = false;
+  session->send_fn            = NULL;
+  session->send_user_data     = NULL;
+  memset(&session->client_addr, 0, sizeof(session->client_addr));
+  drop_pending(session);
+
+  sc_slab_free(pool, session);
+}
+
+dtls_result_t sc_dtls_session_set_cid(dtls_session_t *session, const uint8_t *cid) {
+  if (!session || !cid || session->ctx->role != DTLS_ROLE_SERVER)
+    return DTLS_ERROR_INVALID_PARAMS;
+
+  if (session->ctx->plain) {
+    memcpy(session->plain.cid, cid, DTLS_CID_LEN);
+    session->plain.has_cid = true;
+    return DTLS_OK;
+  }
+
+  int ret = mbedtls_ssl_set_cid(&session->ssl, MBEDTLS_SSL_CID_ENABLED, cid, DTLS_CID_LEN);
+  if (ret != 0) {
+    log_error("Failed to set connection ID: %d", ret);
+    return DTLS_ERROR_INVALID_PARAMS;
+  }
+  return DTLS_OK;
+}
+
+bool sc_dtls_session_uses_cid(dtls_session_t *session) {
+  if (!session || !session->handshake_complete)
+    return false;
+
+  if (session->ctx->plain)
+    return session->plain.has_cid;
+
+  int enabled = MBEDTLS_SSL_CID_DISABLED;
+  return mbedtls_ssl_get_peer_cid(&session->ssl, &enabled, NULL, NULL) == 0 &&
+         enabled == MBEDTLS_SSL_CID_ENABLED;
+}
+
+const uint8_t *sc_dtls_record_cid(const uint8_t *buf, size_t len) {
+  // Content type, version, epoch and sequence number come first, then the ID
+  // and the record length
+  if (!buf || len < DTLS_CID_OFFSET + DTLS_CID_LEN + 2 || buf[0] != DTLS_CID_CONTENT_TYPE)
+    return NULL;
+
+  return buf + DTLS_CID_OFFSET;
+}
+
+uint64_t sc_dtls_session_last_record(const dtls_session_t *session) {
+  return session ? session->last_record : 0;
+}
+
+bool sc_dtls_session_last_record_is_newest(const dtls_session_t *session) {
+  return session && session->last_record != 0 && session->last_record == session->newest_record;
+}
+
+void sc_dtls_session_set_peer(dtls_session_t *session, const struct sockaddr *addr,
+                              socklen_t addr_len) {
+  if (!session || !addr || addr_len == 0 || addr_len > sizeof(session->client_addr))
+    return;
+
+  memcpy(&session->client_addr, addr, addr_len);
+  session->addr_len = addr_len;
 }
 
 dtls_result_t sc_dtls_handshake(dtls_session_t *session) {
   if (!session)
     return DTLS_ERROR_INVALID_PARAMS;
 
-  int ret = mbedtls_ssl_handshake(&session->ssl);
+  if (session->ctx->plain)
+    return plain_handshake(session);
+
+  sc_tls_arena_t *previous = sc_tls_arena_enter(&session->arena);
+  int ret                  = mbedtls_ssl_handshake(&session->ssl);
+  if (ret == 0 && !session->handshake_complete) {
+    sc_tls_arena_end_handshake(&session->arena);
+  }
+  sc_tls_arena_leave(previous);
+  drop_pending(session);
 
   if (ret == 0) {
     session->handshake_complete = true;
-    log_info("%s", "DTLS handshake completed");
+    log_debug("%s", "DTLS handshake completed");
+    if (session->ctx->role == DTLS_ROLE_CLIENT) {
+      save_session(session);
+    }
     return DTLS_OK;
   }
 
@@ -469,15 +1931,46 @@ dtls_result_t sc_dtls_handshake(dtls_session_t *session) {
   return DTLS_ERROR_HANDSHAKE;
 }
 
+dtls_result_t sc_dtls_feed(dtls_session_t *session, const uint8_t *buf, size_t len) {
+  if (!session || !buf || len == 0)
+    return DTLS_ERROR_INVALID_PARAMS;
+
+  session->pending     = buf;
+  session->pending_len = len;
+  session->memory_bio  = true;
+  return DTLS_OK;
+}
+
 dtls_result_t sc_dtls_read(dtls_session_t *session, uint8_t *buf, size_t len, size_t *bytes_read) {
   if (!session || !buf || !bytes_read)
     return DTLS_ERROR_INVALID_PARAMS;
 
   *bytes_read = 0;
 
-  int ret = mbedtls_ssl_read(&session->ssl, buf, len);
+  if (session->ctx->plain)
+    return plain_read(session, buf, len, bytes_read);
+
+  sc_tls_arena_t *previous = sc_tls_arena_enter(&session->arena);
+  int ret                  = mbedtls_ssl_read(&session->ssl, buf, len);
+  sc_tls_arena_leave(previous);
+  drop_pending(session);
+
+  // The side that sent a handshake's last flight keeps the handshake state
+  // to resend it until the peer's first record arrives; release it then
+  if (session->arena.cached_bytes > 0 && session->handshake_complete) {
+    sc_tls_arena_release(&session->arena);
+  }
 
   if (ret > 0) {
+    // in_ctr still holds the header's epoch and sequence number of the
+    // record the data came from
+    const unsigned char *ctr = session->ssl.in_ctr;
+    uint64_t epoch           = (uint64_t) ctr[0] << 8 | ctr[1];
+    uint64_t seq             = 0;
+    for (size_t i = 2; i < 8; i++) {
+      seq = seq << 8 | ctr[i];
+    }
+    note_record(session, epoch, seq);
     *bytes_read = (size_t) ret;
     return DTLS_OK;
   }
@@ -504,7 +1997,21 @@ dtls_result_t sc_dtls_write(dtls_session_t *session, const uint8_t *buf, size_t
 
   *bytes_written = 0;
 
-  int ret = mbedtls_ssl_write(&session->ssl, buf, len);
+  if (session->ctx->plain) {
+    // Like mbedtls_ssl_write(), send at most one record's worth
+    if (!session->handshake_complete)
+      return DTLS_ERROR_WOULD_BLOCK;
+    size_t record_len    = len < DTLS_MAX_FRAG_LEN ? len : DTLS_MAX_FRAG_LEN;
+    dtls_result_t result = plain_send_data(session, DTLS_CONTENT_APPLICATION, buf, record_len);
+    if (result == DTLS_OK) {
+      *bytes_written = record_len;
+    }
+    return result;
+  }
+
+  sc_tls_arena_t *previous = sc_tls_arena_enter(&session->arena);
+  int ret                  = mbedtls_ssl_write(&session->ssl, buf, len);
+  sc_tls_arena_leave(previous);
 
   if (ret > 0) {
     *bytes_written = (size_t) ret;
@@ -522,12 +2029,38 @@ dtls_result_t sc_dtls_write(dtls_session_t *session, const uint8_t *buf, size_t
   return DTLS_ERROR_WRITE;
 }
 
+uint64_t sc_dtls_session_timeout_ms(const dtls_session_t *session) {
+  return session ? session->timer_fin_ms : 0;
+}
+
+dtls_result_t sc_dtls_handle_timeout(dtls_session_t *session) {
+  if (!session)
+    return DTLS_ERROR_INVALID_PARAMS;
+
+  if (session->handshake_complete)
+    return DTLS_OK;
+
+  // With nothing fed, the handshake only checks the timer: once it has
+  // expired the last flight is resent and the timeout doubled, until the
+  // handshake timeout's upper bound gives up with MBEDTLS_ERR_SSL_TIMEOUT
+  return sc_dtls_handshake(session);
+}
+
 void sc_dtls_close(dtls_session_t *session) {
   if (!session)
     return;
 
   // Send close notify
+  if (session->ctx->plain) {
+    static const uint8_t close_notify[] = {1, 0}; // Warning level, close_notify
+    if (session->handshake_complete) {
+      (void) plain_send_data(session, DTLS_CONTENT_ALERT, close_notify, sizeof(close_notify));
+    }
+    return;
+  }
+  sc_tls_arena_t *previous = sc_tls_arena_enter(&session->arena);
   mbedtls_ssl_close_notify(&session->ssl);
+  sc_tls_arena_leave(previous);
 }
 
 int sc_dtls_get_fd(const dtls_session_t *session) {
@@ -546,6 +2079,17 @@ bool sc_dtls_is_handshake_complete(const dtls_session_t *session) {
   return session ? session->handshake_complete : false;
 }
 
+dtls_memory_stats_t sc_dtls_session_memory(const dtls_session_t *session) {
+  dtls_memory_stats_t stats = {0};
+  if (!session || session->ctx->plain)
+    return stats;
+
+  stats.handshake_bytes   = session->arena.handshake_bytes;
+  stats.handshake_peak    = session->arena.handshake_peak;
+  stats.established_bytes = session->arena.established_bytes;
+  return stats;
+}
+
 dtls_result_t sc_dtls_cert_hash(const char *cert_path, uint8_t (*hash)[32]) {
   if (!cert_path || !hash)
     return DTLS_ERROR_INVALID_PARAMS;
@@ -6,6 +6,12 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 
+// Connection IDs server sessions hand out, and where they sit in the records
+// clients send once one is negotiated
+#define DTLS_CID_LEN          8  // Bytes in a server session's connection ID
+#define DTLS_CID_CONTENT_TYPE 25 // Content type of records that carry a connection ID
+#define DTLS_CID_OFFSET       11 // Offset of the connection ID in such a record
+
 // Forward declaration to hide implementation details
 typedef struct dtls_context dtls_context_t;
 typedef struct dtls_session dtls_session_t;
@@ -28,14 +34,96 @@ typedef enum {
   DTLS_ERROR_CERT_VERIFY       = -10
 } dtls_result_t;
 
+// Outcome of screening a datagram from a peer that has no session
+typedef enum {
+  DTLS_HELLO_VERIFIED,   // ClientHello with a valid cookie; create a session and feed it
+  DTLS_HELLO_CHALLENGED, // HelloVerifyRequest sent in reply; nothing was kept
+  DTLS_HELLO_DROPPED     // Not a well-formed ClientHello; ignore it
+} dtls_hello_result_t;
+
+// Counters kept by sc_dtls_check_hello()
+typedef struct {
+  uint64_t challenged; // HelloVerifyRequests sent instead of creating a session
+  uint64_t verified;   // ClientHellos that returned a valid cookie
+  uint64_t dropped;    // Datagrams from unknown peers that were not a ClientHello
+} dtls_hello_stats_t;
+
+// Counters kept by a server context's session ticket callbacks
+typedef struct {
+  uint64_t issued;   // Tickets sent to clients at the end of a full handshake
+  uint64_t resumed;  // Handshakes abbreviated by a valid ticket
+  uint64_t rejected; // Tickets that had expired or were sealed with a retired key
+} dtls_ticket_stats_t;
+
+// Heap one session's mbedTLS state holds (see sc_dtls_session_memory())
+typedef struct {
+  size_t handshake_bytes;   // Allocated since its handshake began, still held
+  size_t handshake_peak;    // Most handshake_bytes held during the current or last handshake
+  size_t established_bytes; // Held from before the handshake, or left by a completed one
+} dtls_memory_stats_t;
+
+// Record ciphers sc_dtls_rank_ciphers() compares
+#define DTLS_CIPHER_COUNT 3
+
+// How fast one record cipher ran in sc_dtls_rank_ciphers()
+typedef struct {
+  const char *name;      // AEAD cipher, such as "AES-128-GCM"
+  double bytes_per_tick; // Record bytes sealed per tick of the ranking's unit
+} dtls_cipher_rate_t;
+
+// Outcome of sc_dtls_rank_ciphers()
+typedef struct {
+  dtls_cipher_rate_t rates[DTLS_CIPHER_COUNT]; // Fastest first
+  const char *unit;                            // "cycle" (x86_64 TSC) or "ns" elsewhere
+  const char *preferred_suite;                 // First suite contexts offer (mbedTLS name)
+} dtls_cipher_ranking_t;
+
+// Transmit function that replaces sendto(2) for a context's sessions
+// Returns: Bytes accepted, or -1 with errno set (EAGAIN/EWOULDBLOCK to retry later)
+typedef ssize_t (*dtls_send_fn)(void *user_data, const struct sockaddr *addr, socklen_t addr_len,
+                                const uint8_t *buf, size_t len);
+
 // Initialize DTLS library (call once at startup)
-// Returns: DTLS_OK on success, error code on failure
+// Sets up the entropy pool. Every thread that runs DTLS gets a random number
+// generator of its own, seeded from the pool on first use and freed when the
+// thread exits; the calling thread's is seeded here. The first call also
+// routes mbedTLS's allocations to the size-classed pool in tls_arena.h, where
+// each session allocates from an arena of its own; call it before anything
+// else in mbedTLS allocates.
+// Returns: DTLS_OK on success, DTLS_ERROR_INIT if no entropy is available
 dtls_result_t sc_dtls_init(void);
 
-// Cleanup DTLS library (call once at shutdown)
+// Cleanup DTLS library (call once at shutdown, after other DTLS threads exit)
 void sc_dtls_cleanup(void);
 
+// Order cipher suites by how fast this machine seals records
+// Times each AEAD cipher DTLS can negotiate (AES-128-GCM, AES-256-GCM and
+// ChaCha20-Poly1305) on game-sized records for a few milliseconds, then makes
+// contexts created afterwards offer the fastest first. Servers choose by their
+// own order, so the winner is what their clients get. Without a ranking,
+// contexts prefer AES-128-GCM. Call after sc_dtls_init() and before creating
+// any context; it is not safe to call while contexts exist.
+// Returns: DTLS_OK on success, DTLS_ERROR_INIT if a cipher could not be run
+dtls_result_t sc_dtls_rank_ciphers(void);
+
+// The last ranking, or NULL if sc_dtls_rank_ciphers() has not succeeded
+const dtls_cipher_ranking_t *sc_dtls_cipher_ranking(void);
+
 // Create a DTLS context for server or client
+// Sessions of one context may run on different threads, as long as each
+// session is used by one thread at a time; the cookie key, ticket keys and RSA
+// private key they share are locked internally, and each thread draws from its
+// own random number generator.
+// Servers take an ECDSA key on P-256 (what `make certs` generates) or an RSA
+// key, which must match the certificate. ECDSA signs a handshake in a fraction
+// of RSA's time and needs no lock. Both roles prefer X25519 for the key
+// exchange, with P-256 as the fallback.
+// Session resumption is enabled for both roles. Server contexts issue session
+// tickets (RFC 5077) sealed with keys that rotate every TICKET_LIFETIME_SECONDS
+// (config.h); the previous key is still accepted, and a ticket expires one
+// lifetime after its full handshake. Client contexts keep the session of their
+// last completed handshake and offer its ticket from the next session they
+// create, so a reconnect costs an abbreviated handshake.
 // Parameters:
 //   role: DTLS_ROLE_SERVER or DTLS_ROLE_CLIENT
 //   cert_path: Path to certificate file (server only, can be NULL for client)
@@ -47,26 +135,191 @@ dtls_context_t *sc_dtls_context_create(dtls_role_t role, const char *cert_path,
                                        const char *key_path, const uint8_t *pinned_cert_hash,
                                        size_t pinned_cert_hash_len);
 
+// Create a plaintext context for trusted links and benchmarks
+// Its sessions work through every function below exactly like DTLS sessions,
+// so callers run unchanged, but nothing is encrypted or authenticated. Records
+// keep DTLS's header layout, connection IDs included, so routing by
+// sc_dtls_record_cid() still works. The handshake is a hello from the client,
+// answered with the server session's connection ID and resent on the usual
+// retransmission timer. sc_dtls_check_hello() challenges a hello without a
+// valid cookie just as it does a ClientHello, so spoofed sources cannot fill
+// the session pool. There are no tickets or certificates, and a duplicate or
+// replayed record is dropped by sequence number only. Plain and DTLS peers
+// cannot talk to each other.
+// Parameters:
+//   role: DTLS_ROLE_SERVER or DTLS_ROLE_CLIENT
+// Returns: Context pointer on success, NULL on failure
+dtls_context_t *sc_dtls_context_create_plain(dtls_role_t role);
+
+// Whether a context was created by sc_dtls_context_create_plain()
+bool sc_dtls_context_is_plain(const dtls_context_t *ctx);
+
 // Destroy a DTLS context
 void sc_dtls_context_destroy(dtls_context_t *ctx);
 
+// Preallocate a fixed pool of sessions for a context
+// Every pooled session is set up once here, including its mbedTLS record buffers.
+// Afterwards sc_dtls_session_create() takes sessions from the pool and fails when
+// it is exhausted, and sc_dtls_session_destroy() resets them and puts them back.
+// Parameters:
+//   ctx: DTLS context that does not have a pool yet
+//   capacity: Number of sessions to preallocate
+// Returns: DTLS_OK on success, DTLS_ERROR_MEMORY on allocation failure,
+//          DTLS_ERROR_INVALID_PARAMS on bad arguments or if a pool already exists
+dtls_result_t sc_dtls_context_reserve_sessions(dtls_context_t *ctx, size_t capacity);
+
+// Number of pooled sessions currently handed out (0 if the context has no pool)
+size_t sc_dtls_context_sessions_in_use(const dtls_context_t *ctx);
+
+// Route every datagram the context's sessions send through fn instead of sendto(2)
+// Lets the caller batch or queue records, for example on an io_uring.
+// Parameters:
+//   ctx: DTLS context
+//   fn: Transmit function, or NULL to send directly on each session's socket
+//   user_data: Opaque pointer passed to fn
+void sc_dtls_context_set_send(dtls_context_t *ctx, dtls_send_fn fn, void *user_data);
+
+// Screen a datagram from a peer without a session, before committing any state
+// A ClientHello without a valid cookie is answered statelessly with a
+// HelloVerifyRequest whose cookie is bound to the peer's address, so a session
+// is only worth creating once the peer has proved it receives at that address.
+// The reply goes through the context's transmit function if one is set.
+// Parameters:
+//   ctx: Server DTLS context
+//   fd: Socket to reply on when the context has no transmit function
+//   addr: Peer address, exactly as later passed to sc_dtls_session_create()
+//   addr_len: Length of addr
+//   buf: Datagram contents
+//   len: Datagram length
+// Returns: DTLS_HELLO_VERIFIED if a session should be created and fed the datagram,
+//          DTLS_HELLO_CHALLENGED or DTLS_HELLO_DROPPED otherwise
+dtls_hello_result_t sc_dtls_check_hello(dtls_context_t *ctx, int fd, const struct sockaddr *addr,
+                                        socklen_t addr_len, const uint8_t *buf, size_t len);
+
+// Counters for sc_dtls_check_hello() on a context
+const dtls_hello_stats_t *sc_dtls_context_hello_stats(const dtls_context_t *ctx);
+
+// Issue and accept session tickets with another server context's keys
+// Contexts that serve the same clients (one per socket, say) must share keys,
+// or a client reconnecting through another socket falls back to a full
+// handshake. Call before the context's first handshake.
+// Parameters:
+//   ctx: Server DTLS context
+//   source: Server DTLS context whose keys to use; must outlive ctx
+// Plaintext contexts have no tickets; sharing between two of them does nothing.
+// Returns: DTLS_OK on success, DTLS_ERROR_INVALID_PARAMS if either context is
+//          not a server context
+dtls_result_t sc_dtls_context_share_tickets(dtls_context_t *ctx, dtls_context_t *source);
+
+// Snapshot of a server context's ticket counters
+// Safe to call while handshakes run on other threads.
+// Returns: Counters for tickets handled by this context's sessions
+dtls_ticket_stats_t sc_dtls_context_ticket_stats(dtls_context_t *ctx);
+
+// Whether a client context holds a session to resume on its next connection
+bool sc_dtls_context_has_saved_session(const dtls_context_t *ctx);
+
+// Drop a client context's saved session, so the next handshake is a full one
+void sc_dtls_context_forget_session(dtls_context_t *ctx);
+
 // Create a new DTLS session
 // Parameters:
 //   ctx: DTLS context
-//   fd: Socket file descriptor
+//   fd: Socket file descriptor (server sessions only send on it; see sc_dtls_feed)
 //   client_addr: Client address (for server role)
 //   addr_len: Length of client address
-// Returns: Session pointer on success, NULL on failure
+// Returns: Session pointer on success, NULL on failure or when the session pool is exhausted
 dtls_session_t *sc_dtls_session_create(dtls_context_t *ctx, int fd,
                                        const struct sockaddr *client_addr, socklen_t addr_len);
 
-// Destroy a DTLS session
+// Destroy a DTLS session, returning it to its context's pool if it came from one
 void sc_dtls_session_destroy(dtls_session_t *session);
 
+// Route one session's datagrams through fn instead of the context's transmit function
+// Lets a thread that runs a session on the I/O thread's behalf capture what it
+// sends and leave putting it on the wire to the I/O thread.
+// Parameters:
+//   session: DTLS session
+//   fn: Transmit function, or NULL to use the context's again
+//   user_data: Opaque pointer passed to fn
+void sc_dtls_session_set_send(dtls_session_t *session, dtls_send_fn fn, void *user_data);
+
+// Give a server session the connection ID its client puts in every record
+// Client contexts always ask for one, and once the handshake has agreed on it
+// the client's records can be matched to this session by the ID alone, even
+// after its address or port changes. Call before the handshake starts.
+// Parameters:
+//   session: Server DTLS session
+//   cid: DTLS_CID_LEN-byte connection ID, unique among the sessions reachable
+//        through the socket
+// Returns: DTLS_OK on success, DTLS_ERROR_INVALID_PARAMS on bad arguments or
+//          for a client session
+dtls_result_t sc_dtls_session_set_cid(dtls_session_t *session, const uint8_t *cid);
+
+// Whether the completed handshake agreed to use connection IDs
+bool sc_dtls_session_uses_cid(dtls_session_t *session);
+
+// Connection ID in the first record of a datagram, read without decrypting it
+// The ID is only a claim until a record of the datagram decrypts in the
+// session that owns it.
+// Returns: Pointer to the DTLS_CID_LEN bytes of the ID inside buf, or NULL if
+//          the datagram does not start with a record that carries one
+const uint8_t *sc_dtls_record_cid(const uint8_t *buf, size_t len);
+
+// Epoch (top 16 bits) and sequence number (low 48 bits) of the record whose
+// data the last successful sc_dtls_read() returned; 0 before any
+uint64_t sc_dtls_session_last_record(const dtls_session_t *session);
+
+// Whether that record is the newest the session has accepted: no record read
+// before it carried a higher epoch and sequence number
+// Only the newest record may move a client to its source address (RFC 9146,
+// section 6). An older one that is still unseen, such as a datagram delayed
+// from before a NAT rebinding, decrypts and passes the replay window too.
+bool sc_dtls_session_last_record_is_newest(const dtls_session_t *session);
+
+// Send to a new peer address from now on
+// For a client that moved: a record carrying the session's connection ID
+// decrypted after arriving from another address, and was the newest yet.
+void sc_dtls_session_set_peer(dtls_session_t *session, const struct sockaddr *addr,
+                              socklen_t addr_len);
+
 // Perform DTLS handshake (non-blocking)
 // Returns: DTLS_OK on completion, DTLS_ERROR_WOULD_BLOCK if in progress, error code on failure
 dtls_result_t sc_dtls_handshake(dtls_session_t *session);
 
+// Deadline of the session's DTLS retransmission timer
+// Sessions never block waiting for a reply. While a handshake flight is
+// unanswered, the caller's event loop waits until this deadline (alongside
+// its sockets, with epoll, a timerfd or a timer wheel) and then calls
+// sc_dtls_handle_timeout().
+// Returns: Absolute deadline in milliseconds on CLOCK_MONOTONIC, or 0 if no
+//          timer is running
+uint64_t sc_dtls_session_timeout_ms(const dtls_session_t *session);
+
+// Act on the retransmission timer once its deadline has passed
+// The last flight is resent with the timeout doubled; before the deadline
+// nothing happens. Sends go through the session's transmit function, so call
+// this from the thread that owns the session.
+// Returns: DTLS_ERROR_WOULD_BLOCK while the handshake is still in progress,
+//          DTLS_ERROR_HANDSHAKE_TIMEOUT once the peer has not answered within
+//          the maximum handshake timeout, DTLS_OK if the handshake is complete,
+//          other error codes on failure
+dtls_result_t sc_dtls_handle_timeout(dtls_session_t *session);
+
+// Hand a datagram that was already received from the socket to a session
+// Server sessions receive exclusively through this call and never read the socket,
+// so a datagram is read from the kernel exactly once and only reaches the session
+// that owns its source address. Client sessions switch to this mode on first use.
+// The next sc_dtls_handshake() or sc_dtls_read() consumes the datagram; the buffer
+// is not copied and must remain valid until that call returns, after which any
+// unconsumed part is discarded.
+// Parameters:
+//   session: DTLS session that owns the datagram's source address
+//   buf: Datagram contents
+//   len: Datagram length
+// Returns: DTLS_OK on success, DTLS_ERROR_INVALID_PARAMS on bad arguments
+dtls_result_t sc_dtls_feed(dtls_session_t *session, const uint8_t *buf, size_t len);
+
 // Read data from DTLS session (non-blocking)
 // Parameters:
 //   session: DTLS session
@@ -101,6 +354,12 @@ socklen_t sc_dtls_get_client_addr_len(const dtls_session_t *session);
 // Check if handshake is complete
 bool sc_dtls_is_handshake_complete(const dtls_session_t *session);
 
+// Heap the session's SSL context holds, by state. A handshake's temporary
+// memory goes back to the pool in bulk when sc_dtls_handshake() completes it,
+// or, on the side that sent the last flight, with the peer's first record.
+// Returns: The session's counters; all zero for NULL or a plaintext session
+dtls_memory_stats_t sc_dtls_session_memory(const dtls_session_t *session);
+
 // Get last error string for debugging
 const char *sc_dtls_error_string(dtls_result_t result);
 
@@ -0,0 +1,307 @@
+#define _GNU_SOURCE // sendmmsg(2) and struct mmsghdr
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+
+#include "egress.h"
+#include "log.h"
+#include "portability.h"
+
+// Room for one UDP_SEGMENT control message
+#define EGRESS_CONTROL_SIZE CMSG_SPACE(sizeof(uint16_t))
+
+// ============================================================================
+// Lifecycle Functions
+// ============================================================================
+
+// Creates an egress with a preallocated send vector
+// @param fd UDP socket the datagrams are sent on
+// @param capacity Maximum number of datagrams queued between flushes (must be > 0)
+// @param slot_size Largest datagram queued, in bytes (must be > 0 and fit a GSO message)
+// @return Pointer to the newly created egress, or NULL on failure
+sc_egress_t *sc_egress_init(int fd, size_t capacity, size_t slot_size) {
+  if (fd < 0 || capacity == 0 || slot_size == 0 || slot_size > SC_EGRESS_MAX_GSO_BYTES) {
+    log_error("Invalid egress dimensions: fd=%d capacity=%zu slot_size=%zu", fd, capacity,
+              slot_size);
+    return NULL;
+  }
+
+  size_t storage_size;
+  size_t controls_size;
+  if (SC_MUL_OVERFLOW(capacity, slot_size, &storage_size) ||
+      SC_MUL_OVERFLOW(capacity, EGRESS_CONTROL_SIZE, &controls_size)) {
+    log_error("Integer overflow sizing egress storage (%zu x %zu)", capacity, slot_size);
+    return NULL;
+  }
+
+  sc_egress_t *egress = calloc(1, sizeof(sc_egress_t));
+  if (!egress) {
+    log_error("%s", "Failed to allocate egress");
+    return NULL;
+  }
+
+  egress->fd             = fd;
+  egress->capacity       = capacity;
+  egress->slot_size      = slot_size;
+  egress->storage        = malloc(storage_size);
+  egress->msgs           = calloc(capacity, sizeof(struct mmsghdr));
+  egress->iovecs         = calloc(capacity, sizeof(struct iovec));
+  egress->addrs          = calloc(capacity, sizeof(struct sockaddr_in));
+  egress->controls       = calloc(1, controls_size);
+  egress->segment_sizes  = calloc(capacity, sizeof(uint16_t));
+  egress->segment_counts = calloc(capacity, sizeof(uint16_t));
+  egress->sealed         = calloc(capacity, sizeof(bool));
+
+  if (!egress->storage || !egress->msgs || !egress->iovecs || !egress->addrs ||
+      !egress->controls || !egress->segment_sizes || !egress->segment_counts || !egress->sealed) {
+    log_error("%s", "Failed to allocate egress buffers");
+    sc_egress_nuke(egress);
+    return NULL;
+  }
+
+  // Wire each message header to its iovec and destination once; only the
+  // control message changes between flushes
+  for (size_t i = 0; i < capacity; i++) {
+    egress->msgs[i].msg_hdr.msg_iov     = &egress->iovecs[i];
+    egress->msgs[i].msg_hdr.msg_iovlen  = 1;
+    egress->msgs[i].msg_hdr.msg_name    = &egress->addrs[i];
+    egress->msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+  }
+
+  // Kernels without UDP GSO (before 4.18) reject the option outright
+  int zero    = 0;
+  egress->gso = setsockopt(fd, IPPROTO_UDP, UDP_SEGMENT, &zero, sizeof(zero)) == 0;
+
+  return egress;
+}
+
+// Destroys an egress and frees its buffers
+// @param egress Pointer to the egress to destroy (may be NULL)
+void sc_egress_nuke(sc_egress_t *egress) {
+  if (!egress) {
+    return;
+  }
+
+  free(egress->sealed);
+  free(egress->segment_counts);
+  free(egress->segment_sizes);
+  free(egress->controls);
+  free(egress->addrs);
+  free(egress->iovecs);
+  free(egress->msgs);
+  free(egress->storage);
+  free(egress);
+}
+
+// ============================================================================
+// Internal Helper Functions
+// ============================================================================
+
+// Checks whether a datagram can join the last queued message as another GSO segment
+// Every segment but the last must have the same size, so a shorter datagram
+// may join but seals the message.
+// @param egress Egress
+// @param dest Datagram destination
+// @param len Datagram length
+// @return true if the datagram can be appended to the last message
+static bool can_coalesce(const sc_egress_t *egress, const struct sockaddr_in *dest, size_t len) {
+  if (!egress->gso || egress->message_count == 0) {
+    return false;
+  }
+
+  size_t last                  = egress->message_count - 1;
+  const struct sockaddr_in *to = &egress->addrs[last];
+  return !egress->sealed[last] && egress->segment_counts[last] < SC_EGRESS_MAX_SEGMENTS &&
+         len <= egress->segment_sizes[last] &&
+         egress->iovecs[last].iov_len + len <= SC_EGRESS_MAX_GSO_BYTES &&
+         to->sin_addr.s_addr == dest->sin_addr.s_addr && to->sin_port == dest->sin_port;
+}
+
+// Sends the segments of a GSO message one at a time
+// Used when the kernel refuses the coalesced message, e.g. because a segment
+// exceeds the path MTU or the device cannot checksum segments.
+// @param egress Egress
+// @param index Message to split
+// @return Number of datagrams sent
+static size_t send_segments(sc_egress_t *egress, size_t index) {
+  const struct iovec *iov     = &egress->iovecs[index];
+  const struct sockaddr *addr = (const struct sockaddr *) &egress->addrs[index];
+  const uint8_t *data         = iov->iov_base;
+  size_t segment              = egress->segment_sizes[index];
+  size_t remaining            = iov->iov_len;
+  size_t sent                 = 0;
+
+  while (remaining > 0) {
+    size_t len = remaining < segment ? remaining : segment;
+    egress->calls++;
+    if (sendto(egress->fd, data, len, MSG_DONTWAIT, addr, sizeof(struct sockaddr_in)) < 0) {
+      egress->errors++;
+    } else {
+      egress->messages++;
+      sent++;
+    }
+    data += len;
+    remaining -= len;
+  }
+  return sent;
+}
+
+// ============================================================================
+// Operations
+// ============================================================================
+
+// Queues a datagram for the next flush
+// @param egress Pointer to the egress (must not be NULL)
+// @param addr AF_INET destination address
+// @param addr_len Length of addr
+// @param buf Datagram payload
+// @param len Payload length in bytes
+// @return len on success, or -1 on invalid arguments
+ssize_t sc_egress_queue(sc_egress_t *egress, const struct sockaddr *addr, socklen_t addr_len,
+                        const uint8_t *buf, size_t len) {
+  if (!egress || !addr || addr_len != sizeof(struct sockaddr_in) || addr->sa_family != AF_INET ||
+      !buf || len == 0) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  // Oversized datagrams skip the queue, after everything queued ahead of them
+  if (len > egress->slot_size) {
+    sc_egress_flush(egress);
+    egress->calls++;
+    if (sendto(egress->fd, buf, len, MSG_DONTWAIT, addr, addr_len) < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+        egress->dropped++;
+      } else {
+        egress->errors++;
+      }
+    } else {
+      egress->datagrams++;
+      egress->messages++;
+    }
+    return (ssize_t) len;
+  }
+
+  if (egress->queued == egress->capacity) {
+    sc_egress_flush(egress);
+  }
+
+  struct sockaddr_in dest;
+  memcpy(&dest, addr, sizeof(dest));
+
+  // Datagrams are packed back to back, so the last message always ends where
+  // this one starts
+  uint8_t *data = egress->storage + egress->used;
+  memcpy(data, buf, len);
+  egress->used += len;
+  egress->queued++;
+
+  if (can_coalesce(egress, &dest, len)) {
+    size_t last = egress->message_count - 1;
+    egress->iovecs[last].iov_len += len;
+    egress->segment_counts[last]++;
+    egress->sealed[last] = len < egress->segment_sizes[last];
+    return (ssize_t) len;
+  }
+
+  size_t index                   = egress->message_count++;
+  egress->addrs[index]           = dest;
+  egress->iovecs[index].iov_base = data;
+  egress->iovecs[index].iov_len  = len;
+  egress->segment_sizes[index]   = (uint16_t) len;
+  egress->segment_counts[index]  = 1;
+  egress->sealed[index]          = false;
+  return (ssize_t) len;
+}
+
+// Sends every queued datagram with as few sendmmsg calls as the kernel allows
+// @param egress Pointer to the egress (may be NULL)
+// @return Number of datagrams sent
+size_t sc_egress_flush(sc_egress_t *egress) {
+  if (!egress || egress->message_count == 0) {
+    return 0;
+  }
+
+  // Only messages carrying several datagrams need a segment size
+  for (size_t i = 0; i < egress->message_count; i++) {
+    struct msghdr *hdr = &egress->msgs[i].msg_hdr;
+    if (egress->segment_counts[i] < 2) {
+      hdr->msg_control    = NULL;
+      hdr->msg_controllen = 0;
+      continue;
+    }
+
+    hdr->msg_control     = egress->controls + i * EGRESS_CONTROL_SIZE;
+    hdr->msg_controllen  = EGRESS_CONTROL_SIZE;
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(hdr);
+    cmsg->cmsg_level     = IPPROTO_UDP;
+    cmsg->cmsg_type      = UDP_SEGMENT;
+    cmsg->cmsg_len       = CMSG_LEN(sizeof(uint16_t));
+    memcpy(CMSG_DATA(cmsg), &egress->segment_sizes[i], sizeof(uint16_t));
+  }
+
+  size_t sent = 0;
+  size_t next = 0;
+  while (next < egress->message_count) {
+    egress->calls++;
+    int count = sendmmsg(egress->fd, &egress->msgs[next],
+                         (unsigned int) (egress->message_count - next), MSG_DONTWAIT);
+    if (count > 0) {
+      for (size_t i = next; i < next + (size_t) count; i++) {
+        sent += egress->segment_counts[i];
+        egress->messages++;
+        if (egress->segment_counts[i] > 1) {
+          egress->gso_messages++;
+        }
+      }
+      next += (size_t) count;
+      continue;
+    }
+
+    if (errno == EINTR) {
+      continue;
+    }
+
+    // A full socket buffer would drop the rest anyway; UDP gives no guarantee
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+      for (size_t i = next; i < egress->message_count; i++) {
+        egress->dropped += egress->segment_counts[i];
+      }
+      break;
+    }
+
+    // Only the first remaining message failed; retry a coalesced one datagram
+    // by datagram and move past it
+    if (egress->segment_counts[next] > 1) {
+      if (errno == EIO) {
+        log_warn("%s", "Device cannot segment UDP GSO messages, disabling GSO");
+        egress->gso = false;
+      }
+      sent += send_segments(egress, next);
+    } else {
+      egress->errors++;
+    }
+    next++;
+  }
+
+  egress->datagrams += sent;
+
+  egress->message_count = 0;
+  egress->queued        = 0;
+  egress->used          = 0;
+  return sent;
+}
+
+// Computes the average number of datagrams sent per system call
+// @param egress Pointer to the egress
+// @return Average batch size, or 0 when nothing has been sent
+double sc_egress_avg_batch_size(const sc_egress_t *egress) {
+  if (!egress || egress->calls == 0) {
+    return 0.0;
+  }
+  return (double) egress->datagrams / (double) egress->calls;
+}
@@ -0,0 +1,97 @@
+#ifndef EGRESS_H
+#define EGRESS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+// Batched datagram egress built on sendmmsg(2). Outbound datagrams are copied
+// into storage allocated once at init time and leave with a single system call
+// per sc_egress_flush(). Runs of equal-size datagrams to the same peer are
+// coalesced into one UDP_SEGMENT (GSO) message, so the kernel walks the
+// routing and socket layers once for the whole run and splits it at the end;
+// when the kernel lacks GSO every datagram gets its own message instead.
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+#define SC_EGRESS_MAX_SEGMENTS  64    // Datagrams per GSO message (kernel UDP_MAX_SEGMENTS)
+#define SC_EGRESS_MAX_GSO_BYTES 65507 // Largest IPv4 UDP payload, the GSO message limit
+
+// ============================================================================
+// Type Definitions
+// ============================================================================
+
+// Preallocated send vector. Datagrams are packed back to back in storage, so a
+// coalesced run is one contiguous iovec.
+typedef struct {
+  int fd;                    // UDP socket the datagrams leave on
+  size_t capacity;           // Maximum datagrams queued between flushes
+  size_t slot_size;          // Largest datagram that is queued rather than sent at once
+  bool gso;                  // Kernel accepts UDP_SEGMENT on fd
+  uint8_t *storage;          // capacity * slot_size bytes of datagram payloads
+  size_t used;               // Bytes of storage holding queued datagrams
+  size_t queued;             // Datagrams queued
+  struct mmsghdr *msgs;      // sendmmsg message headers, one per queued message
+  struct iovec *iovecs;      // One iovec per message
+  struct sockaddr_in *addrs; // Destination per message
+  uint8_t *controls;         // UDP_SEGMENT control message buffer per message
+  uint16_t *segment_sizes;   // Size of every segment but the last, per message
+  uint16_t *segment_counts;  // Datagrams per message
+  bool *sealed;              // Message ended with a short segment and takes no more
+  size_t message_count;      // Messages queued
+  uint64_t datagrams;        // Datagrams handed to the kernel
+  uint64_t messages;         // Messages handed to the kernel
+  uint64_t gso_messages;     // Messages carrying more than one datagram
+  uint64_t calls;            // sendmmsg/sendto system calls
+  uint64_t errors;           // Datagrams the kernel refused
+  uint64_t dropped;          // Datagrams dropped because the socket buffer was full
+} sc_egress_t;
+
+// ============================================================================
+// Lifecycle Functions
+// ============================================================================
+
+// Create an egress for a UDP socket
+// Parameters:
+//   fd: UDP socket to send on
+//   capacity: Datagrams that may be queued before a flush is forced
+//   slot_size: Largest datagram, in bytes, that is queued; larger ones are sent directly
+// Returns: Pointer to the egress, or NULL on invalid parameters or allocation failure
+sc_egress_t *sc_egress_init(int fd, size_t capacity, size_t slot_size);
+
+// Destroy an egress; anything still queued is discarded
+void sc_egress_nuke(sc_egress_t *egress);
+
+// ============================================================================
+// Operations
+// ============================================================================
+
+// Queue a datagram for the next flush; it is copied, so buf may be reused
+// immediately. A full queue is flushed first, and datagrams larger than
+// slot_size are sent at once after flushing, so datagrams always leave in order.
+// Parameters:
+//   egress: Egress to queue on
+//   addr: AF_INET destination
+//   addr_len: Length of addr
+//   buf: Datagram payload
+//   len: Payload length in bytes (must be > 0)
+// Returns: len on success, or -1 with errno EINVAL for a bad address or length
+ssize_t sc_egress_queue(sc_egress_t *egress, const struct sockaddr *addr, socklen_t addr_len,
+                        const uint8_t *buf, size_t len);
+
+// Send everything queued. Datagrams the kernel refuses are counted in
+// egress->errors, or egress->dropped when the socket buffer is full, and are
+// not retried; the queue is always empty afterwards.
+// Returns: Number of datagrams sent
+size_t sc_egress_flush(sc_egress_t *egress);
+
+// Average number of datagrams per system call since init
+// Returns: Average, or 0 if nothing has been sent
+double sc_egress_avg_batch_size(const sc_egress_t *egress);
+
+#endif // EGRESS_H
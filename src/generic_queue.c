@@ -1,13 +1,18 @@
 #include <stdlib.h>
-#include <time.h>
-#include <errno.h>
+#include <string.h>
 #include <stdbool.h>
+#include <errno.h>
 #include <threads.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
 
 #include "generic_queue.h"
 #include "log.h"
 #include "portability.h"
 
+// Items sc_generic_queue_drain() takes out per compare-and-swap
+#define DRAIN_BATCH 64
+
 // ============================================================================
 // Error Handling
 // ============================================================================
@@ -58,34 +63,283 @@ const char *sc_generic_queue_strerror(sc_generic_queue_ret_val_t err) {
 // Internal Helper Functions
 // ============================================================================
 
-// Calculates an absolute timeout from a relative timeout in seconds
-// @param abs_timeout Pointer to timespec structure to store the absolute timeout
-// @param timeout_seconds Number of seconds from now for the timeout
-static void get_absolute_timeout(struct timespec *abs_timeout, int timeout_seconds) {
-  clock_gettime(CLOCK_REALTIME, abs_timeout);
-  abs_timeout->tv_sec += timeout_seconds;
+// Signed distance between two ring positions, correct across wrap-around
+// @param to Later position
+// @param from Earlier position
+// @return to - from, negative if to is actually behind from
+static inline intptr_t distance(size_t to, size_t from) {
+  return (intptr_t) (to - from);
+}
+
+// Claims the slot at tail and stores an item in it
+// @param q Pointer to the queue
+// @param item Item to store
+// @return true if the item was added, false if the queue is full
+static bool enqueue(sc_generic_queue_t *q, void *item) {
+  size_t pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+  for (;;) {
+    sc_generic_queue_slot_t *slot = &q->slots[pos & q->mask];
+    size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    intptr_t lag    = distance(sequence, pos);
+
+    if (lag == 0) {
+      // The slot is free, but a ring rounded up past capacity must still
+      // stop at capacity
+      if (q->capacity <= q->mask &&
+          distance(pos, atomic_load_explicit(&q->head, memory_order_relaxed)) >=
+              (intptr_t) q->capacity) {
+        return false;
+      }
+      if (atomic_compare_exchange_weak_explicit(&q->tail, &pos, pos + 1, memory_order_relaxed,
+                                                memory_order_relaxed)) {
+        slot->item = item;
+        atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+        return true;
+      }
+      // Another producer took pos; the failed exchange loaded the new tail
+    } else if (lag < 0) {
+      // The slot still holds the item added one lap ago
+      return false;
+    } else {
+      pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    }
+  }
+}
+
+// Claims the slot at head and takes its item
+// @param q Pointer to the queue
+// @param item Pointer to store the item
+// @return true if an item was removed, false if the queue is empty
+static bool dequeue(sc_generic_queue_t *q, void **item) {
+  size_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+  for (;;) {
+    sc_generic_queue_slot_t *slot = &q->slots[pos & q->mask];
+    size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    intptr_t lag    = distance(sequence, pos + 1);
+
+    if (lag == 0) {
+      if (atomic_compare_exchange_weak_explicit(&q->head, &pos, pos + 1, memory_order_relaxed,
+                                                memory_order_relaxed)) {
+        *item = slot->item;
+        // Hand the slot to the producer one lap ahead
+        atomic_store_explicit(&slot->sequence, pos + q->mask + 1, memory_order_release);
+        return true;
+      }
+    } else if (lag < 0) {
+      // Nothing has been published at pos yet
+      return false;
+    } else {
+      pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+    }
+  }
+}
+
+// Claims up to count free slots at tail with one compare-and-swap and stores
+// items in them
+// Free slots stay free until a producer moves tail past them, so the run of
+// free slots counted before the exchange is still free if it succeeds.
+// @param q Pointer to the queue
+// @param items Items to store, oldest first
+// @param count Number of items (must be > 0)
+// @return Number of items added, 0 if the queue is full
+static size_t enqueue_n(sc_generic_queue_t *q, void *const *items, size_t count) {
+  size_t pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+  for (;;) {
+    sc_generic_queue_slot_t *slot = &q->slots[pos & q->mask];
+    size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    intptr_t lag    = distance(sequence, pos);
+
+    if (lag < 0) {
+      // The slot still holds the item added one lap ago
+      return 0;
+    }
+    if (lag > 0) {
+      pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+      continue;
+    }
+
+    // The slot is free, but a ring rounded up past capacity must still stop
+    // at capacity
+    size_t room = count;
+    if (q->capacity <= q->mask) {
+      intptr_t used = distance(pos, atomic_load_explicit(&q->head, memory_order_relaxed));
+      if (used < 0) {
+        // Consumers passed pos, so tail has moved on too
+        pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+        continue;
+      }
+      if ((size_t) used >= q->capacity) {
+        return 0;
+      }
+      if (room > q->capacity - (size_t) used) {
+        room = q->capacity - (size_t) used;
+      }
+    }
+
+    size_t claimed = 1;
+    while (claimed < room &&
+           atomic_load_explicit(&q->slots[(pos + claimed) & q->mask].sequence,
+                                memory_order_acquire) == pos + claimed) {
+      claimed++;
+    }
+
+    if (atomic_compare_exchange_weak_explicit(&q->tail, &pos, pos + claimed,
+                                              memory_order_relaxed, memory_order_relaxed)) {
+      for (size_t i = 0; i < claimed; i++) {
+        slot       = &q->slots[(pos + i) & q->mask];
+        slot->item = items[i];
+        atomic_store_explicit(&slot->sequence, pos + i + 1, memory_order_release);
+      }
+      return claimed;
+    }
+    // Another producer took pos; the failed exchange loaded the new tail
+  }
+}
+
+// Claims up to max published slots at head with one compare-and-swap and
+// takes their items
+// Published slots stay published until a consumer moves head past them, so
+// the run counted before the exchange is still there if it succeeds.
+// @param q Pointer to the queue
+// @param items Array receiving the items, oldest first
+// @param max Capacity of items (must be > 0)
+// @return Number of items removed, 0 if the queue is empty
+static size_t dequeue_n(sc_generic_queue_t *q, void **items, size_t max) {
+  size_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+  for (;;) {
+    sc_generic_queue_slot_t *slot = &q->slots[pos & q->mask];
+    size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    intptr_t lag    = distance(sequence, pos + 1);
+
+    if (lag < 0) {
+      // Nothing has been published at pos yet
+      return 0;
+    }
+    if (lag > 0) {
+      pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+      continue;
+    }
+
+    size_t claimed = 1;
+    while (claimed < max &&
+           atomic_load_explicit(&q->slots[(pos + claimed) & q->mask].sequence,
+                                memory_order_acquire) == pos + claimed + 1) {
+      claimed++;
+    }
+
+    if (atomic_compare_exchange_weak_explicit(&q->head, &pos, pos + claimed,
+                                              memory_order_relaxed, memory_order_relaxed)) {
+      for (size_t i = 0; i < claimed; i++) {
+        slot     = &q->slots[(pos + i) & q->mask];
+        items[i] = slot->item;
+        // Hand the slot to the producer one lap ahead
+        atomic_store_explicit(&slot->sequence, pos + i + q->mask + 1, memory_order_release);
+      }
+      return claimed;
+    }
+  }
 }
 
-// Const-correct wrapper for pthread_rwlock_rdlock
-// @param rwlock Pointer to the read-write lock (const-correct)
-// @return Same as pthread_rwlock_rdlock
-static inline int pthread_rwlock_rdlock_const(const pthread_rwlock_t *rwlock) {
-  union {
-    const pthread_rwlock_t *c;
-    pthread_rwlock_t *nc;
-  } u = {.c = rwlock};
-  return pthread_rwlock_rdlock(u.nc);
+// Context of a blocked add or pop, for retrying it in sc_queue_wait()
+typedef struct {
+  sc_generic_queue_t *q;
+  void *item;
+  void **out;
+} retry_t;
+
+// Retries a blocked add
+// @param ctx retry_t of the add
+// @return true once the item was added
+static bool retry_add(void *ctx) {
+  retry_t *retry = ctx;
+  return enqueue(retry->q, retry->item);
 }
 
-// Const-correct wrapper for pthread_rwlock_unlock
-// @param rwlock Pointer to the read-write lock (const-correct)
-// @return Same as pthread_rwlock_unlock
-static inline int pthread_rwlock_unlock_const(const pthread_rwlock_t *rwlock) {
-  union {
-    const pthread_rwlock_t *c;
-    pthread_rwlock_t *nc;
-  } u = {.c = rwlock};
-  return pthread_rwlock_unlock(u.nc);
+// Retries a blocked pop
+// @param ctx retry_t of the pop
+// @return true once an item was removed
+static bool retry_pop(void *ctx) {
+  retry_t *retry = ctx;
+  return dequeue(retry->q, retry->out);
+}
+
+// Blocks until an item fits in a full queue and adds it
+// @return true once the item was added, false if the deadline passed first
+static bool wait_add(sc_generic_queue_t *q, void *item, uint64_t deadline_ns) {
+  retry_t retry = {.q = q, .item = item};
+  return sc_queue_wait(&q->not_full, retry_add, &retry, deadline_ns);
+}
+
+// Blocks until an empty queue has an item and removes it
+// @return true once an item was removed, false if the deadline passed first
+static bool wait_pop(sc_generic_queue_t *q, void **item, uint64_t deadline_ns) {
+  retry_t retry = {.q = q, .out = item};
+  return sc_queue_wait(&q->not_empty, retry_pop, &retry, deadline_ns);
+}
+
+// Counts the items in the queue, as of some moment during the call
+// @param q Pointer to the queue
+// @return Number of claimed slots, at most capacity
+static size_t count(const sc_generic_queue_t *q) {
+  // Head first: tail read afterwards can only be further ahead of it
+  size_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+  size_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+  size_t size = tail - head;
+  return size > q->capacity ? q->capacity : size;
+}
+
+// Makes the queue's eventfd readable
+// @param q Pointer to the queue, with an eventfd attached
+static void signal_event(sc_generic_queue_t *q) {
+  uint64_t one = 1;
+  if (write(q->event_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+    log_error("Failed to signal queue eventfd: %s", strerror(errno));
+  }
+}
+
+// Wakes consumers after an add: those blocked in a pop and, if the queue was
+// found empty since it was last written, the one watching the eventfd
+// The fence in sc_queue_wake() orders the add before the flag is read, and
+// pairs with the one in rearm_event(): either the re-arming consumer sees the
+// item, or this sees the flag cleared and writes the eventfd again.
+// @param q Pointer to the queue
+// @param all Wake every blocked consumer rather than one
+static void wake_consumers(sc_generic_queue_t *q, bool all) {
+  if (all) {
+    sc_queue_wake_all(&q->not_empty);
+  } else {
+    sc_queue_wake(&q->not_empty);
+  }
+
+  // Checked before the exchange so that, under steady load, producers only
+  // read the flag's line
+  if (q->event_fd >= 0 && !atomic_load_explicit(&q->signalled, memory_order_relaxed) &&
+      !atomic_exchange(&q->signalled, true)) {
+    signal_event(q);
+  }
+}
+
+// Clears the eventfd once a pop of any kind leaves the queue empty
+// Nothing is done while items are left or the eventfd was not written, so
+// only the pop that empties a queue pays the read.
+// @param q Pointer to the queue
+static void rearm_event(sc_generic_queue_t *q) {
+  if (q->event_fd < 0 || !atomic_load_explicit(&q->signalled, memory_order_relaxed) ||
+      count(q) > 0) {
+    return;
+  }
+
+  uint64_t value;
+  if (read(q->event_fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+    log_error("Failed to clear queue eventfd: %s", strerror(errno));
+  }
+  atomic_store_explicit(&q->signalled, false, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+
+  // An add that read the flag before it was cleared did not write the eventfd
+  if (count(q) > 0 && !atomic_exchange(&q->signalled, true)) {
+    signal_event(q);
+  }
 }
 
 // ============================================================================
@@ -93,6 +347,8 @@ static inline int pthread_rwlock_unlock_const(const pthread_rwlock_t *rwlock) {
 // ============================================================================
 
 // Creates a new thread-safe message queue with the specified capacity
+// The ring is capacity rounded up to a power of two, so positions map to
+// slots with a mask; the queue still holds at most capacity items.
 // @param capacity Maximum number of messages the queue can hold (must be > 0)
 // @return Pointer to the newly created queue, or NULL on failure
 sc_generic_queue_t *sc_generic_queue_init(size_t capacity) {
@@ -104,72 +360,50 @@ sc_generic_queue_t *sc_generic_queue_init(size_t capacity) {
     return NULL;
   }
 
-  sc_generic_queue_t *q = calloc(1, sizeof(sc_generic_queue_t));
-  if (!q) {
-    queue_errno = SC_GENERIC_QUEUE_ERR_MEMORY;
-    log_error("%s", "Failed to allocate memory for queue");
-    return NULL;
+  // At least two slots: with one, a published slot and a freed slot would
+  // carry the same sequence number
+  size_t ring = 2;
+  while (ring < capacity) {
+    ring <<= 1;
   }
-  // Check for overflow before allocating buffer
-  size_t buffer_size;
-  if (SC_MUL_OVERFLOW(capacity, sizeof(void *), &buffer_size)) {
+  // Check for overflow before allocating the ring
+  size_t ring_size;
+  if (SC_MUL_OVERFLOW(ring, sizeof(sc_generic_queue_slot_t), &ring_size)) {
     queue_errno = SC_GENERIC_QUEUE_ERR_OVERFLOW;
-    log_error("Integer overflow calculating buffer size for capacity %zu", capacity);
-    free(q);
+    log_error("Integer overflow calculating ring size for capacity %zu", capacity);
     return NULL;
   }
 
-  q->buffer = calloc(capacity, sizeof(void *));
-  if (!q->buffer) {
+  // sizeof is a multiple of the alignment, as aligned_alloc requires
+  sc_generic_queue_t *q = aligned_alloc(alignof(sc_generic_queue_t), sizeof(sc_generic_queue_t));
+  if (!q) {
     queue_errno = SC_GENERIC_QUEUE_ERR_MEMORY;
-    log_error("%s", "Failed to allocate memory for queue buffer");
-    free(q);
+    log_error("%s", "Failed to allocate memory for queue");
     return NULL;
   }
+  memset(q, 0, sizeof(*q));
 
-  q->capacity = capacity;
-  q->size     = 0;
-  q->head     = 0;
-  q->tail     = 0;
-
-  // Initialize synchronization primitives
-  if (pthread_rwlock_init(&q->rwlock, NULL) != 0) {
-    queue_errno = SC_GENERIC_QUEUE_ERR_THREAD;
-    log_error("%s", "Failed to initialize queue rwlock");
-    free(q->buffer);
+  q->slots = calloc(ring, sizeof(sc_generic_queue_slot_t));
+  if (!q->slots) {
+    queue_errno = SC_GENERIC_QUEUE_ERR_MEMORY;
+    log_error("%s", "Failed to allocate memory for queue ring");
     free(q);
     return NULL;
   }
 
-  if (pthread_mutex_init(&q->cond_mutex, NULL) != 0) {
-    queue_errno = SC_GENERIC_QUEUE_ERR_THREAD;
-    log_error("%s", "Failed to initialize condition mutex");
-    pthread_rwlock_destroy(&q->rwlock);
-    free(q->buffer);
-    free(q);
-    return NULL;
-  }
-
-  if (pthread_cond_init(&q->cond_not_empty, NULL) != 0) {
-    queue_errno = SC_GENERIC_QUEUE_ERR_THREAD;
-    log_error("%s", "Failed to initialize cond_not_empty");
-    pthread_mutex_destroy(&q->cond_mutex);
-    pthread_rwlock_destroy(&q->rwlock);
-    free(q->buffer);
-    free(q);
-    return NULL;
+  // Each slot starts out ready for the first lap's producer
+  for (size_t i = 0; i < ring; i++) {
+    atomic_init(&q->slots[i].sequence, i);
   }
+  atomic_init(&q->tail, 0);
+  atomic_init(&q->head, 0);
+  q->mask     = ring - 1;
+  q->capacity = capacity;
+  q->event_fd = -1;
+  atomic_init(&q->signalled, false);
 
-  if (pthread_cond_init(&q->cond_not_full, NULL) != 0) {
-    queue_errno = SC_GENERIC_QUEUE_ERR_THREAD;
-    log_error("%s", "Failed to initialize cond_not_full");
-    pthread_cond_destroy(&q->cond_not_empty);
-    pthread_mutex_destroy(&q->cond_mutex);
-    pthread_rwlock_destroy(&q->rwlock);
-    free(q->buffer);
-    free(q);
-    return NULL;
-  }
+  sc_queue_wait_init(&q->not_empty);
+  sc_queue_wait_init(&q->not_full);
 
   return q;
 }
@@ -188,23 +422,17 @@ sc_generic_queue_ret_val_t sc_generic_queue_nuke(sc_generic_queue_t *q) {
   // Note: This does not free the items themselves,
   // as ownership is transferred out of the queue on pop.
   // The caller is responsible for freeing items.
-  int err = pthread_rwlock_destroy(&q->rwlock);
-  if (err != 0) {
-    queue_errno = SC_GENERIC_QUEUE_ERR_THREAD;
-    log_error("Failed to destroy rwlock: %d", err);
+  if (q->event_fd >= 0) {
+    close(q->event_fd);
   }
-
-  pthread_mutex_destroy(&q->cond_mutex);
-
-  free(q->buffer);
-  pthread_cond_destroy(&q->cond_not_empty);
-  pthread_cond_destroy(&q->cond_not_full);
+  free(q->slots);
   free(q);
 
-  return queue_errno;
+  return SC_GENERIC_QUEUE_SUCCESS;
 }
 
 // Destroys a queue and applies a cleanup function to all remaining items
+// No other thread may use the queue once this is called.
 // @param q Pointer to the queue to destroy (must not be NULL)
 // @param cleanup_fn Optional callback to process each remaining item (can be NULL)
 // @param user_data Optional user data passed to the cleanup function
@@ -214,30 +442,21 @@ void sc_generic_queue_nuke_with_cleanup(sc_generic_queue_t *q,
     queue_errno = SC_GENERIC_QUEUE_ERR_NULL;
     return;
   }
-  // Lock the queue to prevent any new operations
-  pthread_rwlock_wrlock(&q->rwlock);
 
   // Drain all remaining items
-  while (q->size > 0) {
-    void *item = q->buffer[q->head];
-    q->head    = (q->head + 1) % q->capacity;
-    q->size--;
-
+  void *item;
+  while (dequeue(q, &item)) {
     // Apply cleanup callback if provided
     if (cleanup_fn != NULL) {
       cleanup_fn(item, user_data);
     }
   }
 
-  // Unlock before destroying synchronization primitives
-  pthread_rwlock_unlock(&q->rwlock);
-
   // Clean up queue structure
-  free(q->buffer);
-  pthread_rwlock_destroy(&q->rwlock);
-  pthread_mutex_destroy(&q->cond_mutex);
-  pthread_cond_destroy(&q->cond_not_empty);
-  pthread_cond_destroy(&q->cond_not_full);
+  if (q->event_fd >= 0) {
+    close(q->event_fd);
+  }
+  free(q->slots);
   free(q);
 }
 
@@ -246,7 +465,7 @@ void sc_generic_queue_nuke_with_cleanup(sc_generic_queue_t *q,
 // ============================================================================
 
 // Adds an item to the queue, blocking if the queue is full
-// Will timeout after SC_GENERIC_QUEUE_ADD_TIMEOUT seconds if the queue remains full
+// Will timeout after SC_GENERIC_QUEUE_ADD_TIMEOUT_NS if the queue remains full
 // @param q Pointer to the queue (must not be NULL)
 // @param item Pointer to the item to add (must not be NULL)
 // @return QUEUE_SUCCESS on success, or an error code on failure
@@ -258,51 +477,23 @@ sc_generic_queue_ret_val_t sc_generic_queue_add(sc_generic_queue_t *q, void *ite
     return SC_GENERIC_QUEUE_ERR_NULL;
   }
 
-  pthread_rwlock_wrlock(&q->rwlock);
-
-  while (q->size == q->capacity) {
-    // Queue is full, must unlock rwlock before waiting on condition
-    pthread_rwlock_unlock(&q->rwlock);
-
-    // Use condition mutex for waiting
-    pthread_mutex_lock(&q->cond_mutex);
-
-    struct timespec timeout;
-    get_absolute_timeout(&timeout, SC_GENERIC_QUEUE_ADD_TIMEOUT);
-
-    int result = pthread_cond_timedwait(&q->cond_not_full, &q->cond_mutex, &timeout);
-    pthread_mutex_unlock(&q->cond_mutex);
-
-    if (result == ETIMEDOUT) {
-      log_error("sc_generic_queue_add timed out after %d seconds", SC_GENERIC_QUEUE_ADD_TIMEOUT);
-      queue_errno = SC_GENERIC_QUEUE_ERR_TIMEOUT;
-      return SC_GENERIC_QUEUE_ERR_TIMEOUT;
-    }
-    if (result != 0) {
-      log_error("sc_generic_queue_add pthread_cond_timedwait failed: %d", result);
-      queue_errno = SC_GENERIC_QUEUE_ERR_THREAD;
-      return SC_GENERIC_QUEUE_ERR_THREAD;
-    }
-    // Re-acquire write lock and check condition again
-    pthread_rwlock_wrlock(&q->rwlock);
+  // The deadline is only worked out once the queue turns out to be full
+  if (!enqueue(q, item) &&
+      !wait_add(q, item, sc_queue_deadline(SC_GENERIC_QUEUE_ADD_TIMEOUT_NS))) {
+    log_error("sc_generic_queue_add timed out after %llu ms",
+              SC_GENERIC_QUEUE_ADD_TIMEOUT_NS / SC_QUEUE_NS_PER_MS);
+    queue_errno = SC_GENERIC_QUEUE_ERR_TIMEOUT;
+    return SC_GENERIC_QUEUE_ERR_TIMEOUT;
   }
 
-  q->buffer[q->tail] = item;
-  q->tail            = (q->tail + 1) % q->capacity;
-  q->size++;
-
-  pthread_rwlock_unlock(&q->rwlock);
-
   // Signal a waiting consumer that there's a new item
-  pthread_mutex_lock(&q->cond_mutex);
-  pthread_cond_signal(&q->cond_not_empty);
-  pthread_mutex_unlock(&q->cond_mutex);
+  wake_consumers(q, false);
 
   return SC_GENERIC_QUEUE_SUCCESS;
 }
 
 // Removes and returns an item from the queue, blocking if empty
-// Will timeout after SC_GENERIC_QUEUE_POP_TIMEOUT seconds if the queue remains empty
+// Will timeout after SC_GENERIC_QUEUE_POP_TIMEOUT_NS if the queue remains empty
 // @param q Pointer to the queue (must not be NULL)
 // @param item Pointer to store the removed item (must not be NULL)
 // @return QUEUE_SUCCESS on success, or an error code on failure
@@ -316,45 +507,70 @@ sc_generic_queue_ret_val_t sc_generic_queue_pop(sc_generic_queue_t *q, void **it
 
   *item = NULL;
 
-  pthread_rwlock_wrlock(&q->rwlock);
+  if (!dequeue(q, item) &&
+      !wait_pop(q, item, sc_queue_deadline(SC_GENERIC_QUEUE_POP_TIMEOUT_NS))) {
+    log_error("sc_generic_queue_pop timed out after %llu ms",
+              SC_GENERIC_QUEUE_POP_TIMEOUT_NS / SC_QUEUE_NS_PER_MS);
+    queue_errno = SC_GENERIC_QUEUE_ERR_TIMEOUT;
+    return SC_GENERIC_QUEUE_ERR_TIMEOUT;
+  }
+  rearm_event(q);
 
-  while (q->size == 0) {
-    // Queue is empty, must unlock rwlock before waiting on condition
-    pthread_rwlock_unlock(&q->rwlock);
+  // Signal a waiting producer that there's new space
+  sc_queue_wake(&q->not_full);
 
-    // Use condition mutex for waiting
-    pthread_mutex_lock(&q->cond_mutex);
+  return SC_GENERIC_QUEUE_SUCCESS;
+}
 
-    struct timespec timeout;
-    get_absolute_timeout(&timeout, SC_GENERIC_QUEUE_POP_TIMEOUT);
+// Adds an item to the queue, blocking until a deadline if the queue is full
+// Timing out is not logged; callers waiting out a tick expect it.
+// @param q Pointer to the queue (must not be NULL)
+// @param item Pointer to the item to add (must not be NULL)
+// @param deadline_ns Absolute CLOCK_MONOTONIC time in nanoseconds to give up at
+// @return QUEUE_SUCCESS on success, QUEUE_ERR_TIMEOUT, or an error code
+sc_generic_queue_ret_val_t sc_generic_queue_add_until(sc_generic_queue_t *q, void *item,
+                                                      uint64_t deadline_ns) {
+  queue_errno = SC_GENERIC_QUEUE_SUCCESS;
 
-    int result = pthread_cond_timedwait(&q->cond_not_empty, &q->cond_mutex, &timeout);
-    pthread_mutex_unlock(&q->cond_mutex);
+  if (q == NULL || item == NULL) {
+    queue_errno = SC_GENERIC_QUEUE_ERR_NULL;
+    return SC_GENERIC_QUEUE_ERR_NULL;
+  }
 
-    if (result == ETIMEDOUT) {
-      log_error("sc_generic_queue_pop timed out after %d seconds", SC_GENERIC_QUEUE_POP_TIMEOUT);
-      queue_errno = SC_GENERIC_QUEUE_ERR_TIMEOUT;
-      return SC_GENERIC_QUEUE_ERR_TIMEOUT;
-    }
-    if (result != 0) {
-      log_error("sc_generic_queue_pop pthread_cond_timedwait failed: %d", result);
-      queue_errno = SC_GENERIC_QUEUE_ERR_THREAD;
-      return SC_GENERIC_QUEUE_ERR_THREAD;
-    }
-    // Re-acquire write lock and check condition again
-    pthread_rwlock_wrlock(&q->rwlock);
+  if (!enqueue(q, item) && !wait_add(q, item, deadline_ns)) {
+    queue_errno = SC_GENERIC_QUEUE_ERR_TIMEOUT;
+    return SC_GENERIC_QUEUE_ERR_TIMEOUT;
   }
 
-  *item   = q->buffer[q->head];
-  q->head = (q->head + 1) % q->capacity;
-  q->size--;
+  wake_consumers(q, false);
 
-  pthread_rwlock_unlock(&q->rwlock);
+  return SC_GENERIC_QUEUE_SUCCESS;
+}
 
-  // Signal a waiting producer that there's new space
-  pthread_mutex_lock(&q->cond_mutex);
-  pthread_cond_signal(&q->cond_not_full);
-  pthread_mutex_unlock(&q->cond_mutex);
+// Removes and returns an item from the queue, blocking until a deadline if empty
+// Timing out is not logged; callers waiting out a tick expect it.
+// @param q Pointer to the queue (must not be NULL)
+// @param item Pointer to store the removed item (must not be NULL)
+// @param deadline_ns Absolute CLOCK_MONOTONIC time in nanoseconds to give up at
+// @return QUEUE_SUCCESS on success, QUEUE_ERR_TIMEOUT, or an error code
+sc_generic_queue_ret_val_t sc_generic_queue_pop_until(sc_generic_queue_t *q, void **item,
+                                                      uint64_t deadline_ns) {
+  queue_errno = SC_GENERIC_QUEUE_SUCCESS;
+
+  if (q == NULL || item == NULL) {
+    queue_errno = SC_GENERIC_QUEUE_ERR_NULL;
+    return SC_GENERIC_QUEUE_ERR_NULL;
+  }
+
+  *item = NULL;
+
+  if (!dequeue(q, item) && !wait_pop(q, item, deadline_ns)) {
+    queue_errno = SC_GENERIC_QUEUE_ERR_TIMEOUT;
+    return SC_GENERIC_QUEUE_ERR_TIMEOUT;
+  }
+  rearm_event(q);
+
+  sc_queue_wake(&q->not_full);
 
   return SC_GENERIC_QUEUE_SUCCESS;
 }
@@ -375,25 +591,14 @@ sc_generic_queue_ret_val_t sc_generic_queue_try_add(sc_generic_queue_t *q, void
     return SC_GENERIC_QUEUE_ERR_NULL;
   }
 
-  pthread_rwlock_wrlock(&q->rwlock);
-
-  if (q->size == q->capacity) {
+  if (!enqueue(q, item)) {
     // Queue is full, return error immediately
-    pthread_rwlock_unlock(&q->rwlock);
     queue_errno = SC_GENERIC_QUEUE_ERR_FULL;
     return SC_GENERIC_QUEUE_ERR_FULL;
   }
 
-  q->buffer[q->tail] = item;
-  q->tail            = (q->tail + 1) % q->capacity;
-  q->size++;
-
-  pthread_rwlock_unlock(&q->rwlock);
-
   // Signal a waiting consumer that there's a new item.
-  pthread_mutex_lock(&q->cond_mutex);
-  pthread_cond_signal(&q->cond_not_empty);
-  pthread_mutex_unlock(&q->cond_mutex);
+  wake_consumers(q, false);
 
   return SC_GENERIC_QUEUE_SUCCESS;
 }
@@ -412,29 +617,171 @@ sc_generic_queue_ret_val_t sc_generic_queue_try_pop(sc_generic_queue_t *q, void
 
   *item = NULL;
 
-  pthread_rwlock_wrlock(&q->rwlock);
-
-  if (q->size == 0) {
+  bool taken = dequeue(q, item);
+  rearm_event(q);
+  if (!taken) {
     // Queue is empty, return error immediately
-    pthread_rwlock_unlock(&q->rwlock);
     queue_errno = SC_GENERIC_QUEUE_ERR_EMPTY;
     return SC_GENERIC_QUEUE_ERR_EMPTY;
   }
 
-  *item   = q->buffer[q->head];
-  q->head = (q->head + 1) % q->capacity;
-  q->size--;
-
-  pthread_rwlock_unlock(&q->rwlock);
-
   // Signal a waiting producer that there's new space.
-  pthread_mutex_lock(&q->cond_mutex);
-  pthread_cond_signal(&q->cond_not_full);
-  pthread_mutex_unlock(&q->cond_mutex);
+  sc_queue_wake(&q->not_full);
 
   return SC_GENERIC_QUEUE_SUCCESS;
 }
 
+// ============================================================================
+// Queue Operations - Batch
+// ============================================================================
+
+// Adds as many items as fit without blocking
+// Normally one compare-and-swap claims room for all of them; another is only
+// needed where a slot was still being handed back by a consumer.
+// @param q Pointer to the queue (must not be NULL)
+// @param items Items to add, oldest first (none may be NULL)
+// @param count Number of items
+// @return Number of items added, from the start of items; 0 on error
+size_t sc_generic_queue_add_n(sc_generic_queue_t *q, void *const *items, size_t count) {
+  queue_errno = SC_GENERIC_QUEUE_SUCCESS;
+
+  if (q == NULL || (items == NULL && count > 0)) {
+    queue_errno = SC_GENERIC_QUEUE_ERR_NULL;
+    return 0;
+  }
+  for (size_t i = 0; i < count; i++) {
+    if (items[i] == NULL) {
+      queue_errno = SC_GENERIC_QUEUE_ERR_NULL;
+      return 0;
+    }
+  }
+
+  size_t added = 0;
+  while (added < count) {
+    size_t claimed = enqueue_n(q, items + added, count - added);
+    if (claimed == 0) {
+      break;
+    }
+    added += claimed;
+  }
+
+  if (added == 0) {
+    queue_errno = count > 0 ? SC_GENERIC_QUEUE_ERR_FULL : SC_GENERIC_QUEUE_SUCCESS;
+    return 0;
+  }
+
+  // Signal every waiting consumer; there may be an item for each
+  wake_consumers(q, true);
+  return added;
+}
+
+// Removes up to max items without blocking
+// @param q Pointer to the queue (must not be NULL)
+// @param items Array receiving the items, oldest first (must not be NULL)
+// @param max Capacity of items
+// @return Number of items removed; 0 on error
+size_t sc_generic_queue_pop_n(sc_generic_queue_t *q, void **items, size_t max) {
+  queue_errno = SC_GENERIC_QUEUE_SUCCESS;
+
+  if (q == NULL || (items == NULL && max > 0)) {
+    queue_errno = SC_GENERIC_QUEUE_ERR_NULL;
+    return 0;
+  }
+
+  size_t removed = 0;
+  while (removed < max) {
+    size_t claimed = dequeue_n(q, items + removed, max - removed);
+    if (claimed == 0) {
+      break;
+    }
+    removed += claimed;
+  }
+  rearm_event(q);
+
+  if (removed == 0) {
+    queue_errno = max > 0 ? SC_GENERIC_QUEUE_ERR_EMPTY : SC_GENERIC_QUEUE_SUCCESS;
+    return 0;
+  }
+
+  // Signal every waiting producer; there may be room for each
+  sc_queue_wake_all(&q->not_full);
+  return removed;
+}
+
+// Removes the items in the queue at the time of the call and passes each to fn
+// Items are taken DRAIN_BATCH at a time, and their slots handed back to
+// producers before fn sees them. Items added while the drain runs are left
+// for the next one, so a busy producer cannot keep it going.
+// @param q Pointer to the queue (must not be NULL)
+// @param fn Callback taking ownership of each item (must not be NULL)
+// @param user_data Optional user data passed to fn
+// @return Number of items passed to fn; 0 on error
+size_t sc_generic_queue_drain(sc_generic_queue_t *q, sc_generic_queue_item_fn fn,
+                              void *user_data) {
+  queue_errno = SC_GENERIC_QUEUE_SUCCESS;
+
+  if (q == NULL || fn == NULL) {
+    queue_errno = SC_GENERIC_QUEUE_ERR_NULL;
+    return 0;
+  }
+
+  size_t limit   = count(q);
+  size_t drained = 0;
+  while (drained < limit) {
+    void *batch[DRAIN_BATCH];
+    size_t want    = limit - drained < DRAIN_BATCH ? limit - drained : DRAIN_BATCH;
+    size_t claimed = dequeue_n(q, batch, want);
+    if (claimed == 0) {
+      break;
+    }
+    sc_queue_wake_all(&q->not_full);
+
+    for (size_t i = 0; i < claimed; i++) {
+      fn(batch[i], user_data);
+    }
+    drained += claimed;
+  }
+  rearm_event(q);
+
+  if (drained == 0) {
+    queue_errno = SC_GENERIC_QUEUE_ERR_EMPTY;
+  }
+  return drained;
+}
+
+// ============================================================================
+// Readiness Notification
+// ============================================================================
+
+// Attaches an eventfd that is readable while items wait
+// @param q Pointer to the queue (must not be NULL or shared yet)
+// @return The eventfd, or -1 on error
+int sc_generic_queue_attach_eventfd(sc_generic_queue_t *q) {
+  queue_errno = SC_GENERIC_QUEUE_SUCCESS;
+
+  if (q == NULL) {
+    queue_errno = SC_GENERIC_QUEUE_ERR_NULL;
+    return -1;
+  }
+  if (q->event_fd >= 0) {
+    queue_errno = SC_GENERIC_QUEUE_ERR_INVALID;
+    return -1;
+  }
+
+  q->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (q->event_fd < 0) {
+    queue_errno = SC_GENERIC_QUEUE_ERR_MEMORY;
+    log_error("Failed to create queue eventfd: %s", strerror(errno));
+    return -1;
+  }
+  // Items added before the eventfd existed still have to be announced
+  if (count(q) > 0) {
+    atomic_store(&q->signalled, true);
+    signal_event(q);
+  }
+  return q->event_fd;
+}
+
 // ============================================================================
 // Queue Status Functions
 // ============================================================================
@@ -450,10 +797,7 @@ bool sc_generic_queue_is_empty(const sc_generic_queue_t *q) {
     return false;
   }
 
-  pthread_rwlock_rdlock_const(&q->rwlock);
-  bool is_empty = (q->size == 0);
-  pthread_rwlock_unlock_const(&q->rwlock);
-  return is_empty;
+  return count(q) == 0;
 }
 
 // Checks if the queue is full (thread-safe)
@@ -467,13 +811,11 @@ bool sc_generic_queue_is_full(const sc_generic_queue_t *q) {
     return false;
   }
 
-  pthread_rwlock_rdlock_const(&q->rwlock);
-  bool is_full = (q->size == q->capacity);
-  pthread_rwlock_unlock_const(&q->rwlock);
-  return is_full;
+  return count(q) == q->capacity;
 }
 
 // Gets the current number of items in the queue (thread-safe)
+// Items a producer has claimed a slot for but not yet published are counted.
 // @param q Pointer to the queue
 // @return Number of items currently in the queue, 0 on error
 size_t sc_generic_queue_get_size(const sc_generic_queue_t *q) {
@@ -484,8 +826,5 @@ size_t sc_generic_queue_get_size(const sc_generic_queue_t *q) {
     return 0;
   }
 
-  pthread_rwlock_rdlock_const(&q->rwlock);
-  size_t size = q->size;
-  pthread_rwlock_unlock_const(&q->rwlock);
-  return size;
+  return count(q);
 }
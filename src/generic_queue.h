@@ -1,12 +1,29 @@
 #ifndef GENERIC_QUEUE_H
 #define GENERIC_QUEUE_H
 
-#include <pthread.h>
+#include <stdalign.h>
+#include <stdatomic.h>
 #include <stddef.h>
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "queue_wait.h"
+
 // No specific type dependencies - this is a generic queue
+//
+// A bounded lock-free multi-producer multi-consumer ring (Vyukov's
+// sequence-numbered design). Every slot carries a sequence number that says
+// whose turn it is: producers claim a slot by advancing tail with a single
+// compare-and-swap and publish it by bumping its sequence, consumers do the
+// same with head. No lock is ever taken; an operation that has to block
+// because the queue is empty or full spins, then parks on a futex (see
+// queue_wait.h).
+//
+// A thread that sleeps in epoll, poll(2) or io_uring instead can attach an
+// eventfd that is readable while items wait, and watch it beside its sockets.
+//
+// spsc_queue.h and mpsc_queue.h hold cheaper variants for channels with a
+// single producer or a single consumer.
 
 // ============================================================================
 // Constants and Error Codes
@@ -25,33 +42,47 @@ typedef enum {
   SC_GENERIC_QUEUE_SUCCESS      = 0   // Operation completed successfully
 } sc_generic_queue_ret_val_t;
 
-// Timeout values in seconds for blocking operations
-#define SC_GENERIC_QUEUE_POP_TIMEOUT 2 // Timeout for pop operations
-#define SC_GENERIC_QUEUE_ADD_TIMEOUT 2 // Timeout for add operations
+// Timeouts for blocking operations without a deadline of their own
+#define SC_GENERIC_QUEUE_POP_TIMEOUT_NS (2 * SC_QUEUE_NS_PER_SEC) // Timeout for pop operations
+#define SC_GENERIC_QUEUE_ADD_TIMEOUT_NS (2 * SC_QUEUE_NS_PER_SEC) // Timeout for add operations
 
 // Maximum safe capacity to prevent excessive allocations
 #define SC_GENERIC_QUEUE_MAX_CAPACITY (SIZE_MAX / sizeof(void *) / 2)
 
+// Cache line size; head and tail each get one so producers and consumers do
+// not invalidate each other's line
+#define SC_GENERIC_QUEUE_CACHE_LINE 64
+
 // ============================================================================
 // Type Definitions
 // ============================================================================
 
+// One ring slot
+typedef struct {
+  _Atomic size_t sequence; // Position the slot is ready for: pos to fill, pos + 1 to empty
+  void *item;
+} sc_generic_queue_slot_t;
+
 // Thread-safe generic queue structure
 typedef struct {
-  void **buffer;                 // Circular buffer of void pointers
-  size_t capacity;               // Maximum number of items
-  size_t size;                   // Current number of items
-  size_t head;                   // Index of next item to remove
-  size_t tail;                   // Index where next item will be added
-  pthread_rwlock_t rwlock;       // Reader-writer lock for data access
-  pthread_mutex_t cond_mutex;    // Separate mutex for condition variables
-  pthread_cond_t cond_not_empty; // Signaled when queue becomes non-empty
-  pthread_cond_t cond_not_full;  // Signaled when queue becomes non-full
+  alignas(SC_GENERIC_QUEUE_CACHE_LINE) _Atomic size_t tail; // Next position to add at
+  alignas(SC_GENERIC_QUEUE_CACHE_LINE) _Atomic size_t head; // Next position to remove from
+  alignas(SC_GENERIC_QUEUE_CACHE_LINE) sc_generic_queue_slot_t *slots; // Ring, mask + 1 slots
+  size_t mask;               // Ring size - 1; the ring size is capacity rounded up to a
+                             // power of two
+  size_t capacity;           // Maximum number of items
+  int event_fd;              // Readable while items wait; -1 unless attached
+  sc_queue_wait_t not_empty; // Consumers blocked in sc_generic_queue_pop()
+  sc_queue_wait_t not_full;  // Producers blocked in sc_generic_queue_add()
+  atomic_bool signalled;     // event_fd was written since the queue was last found empty
 } sc_generic_queue_t;
 
 // Cleanup callback function type for sc_generic_queue_nuke_with_cleanup
 typedef void (*sc_generic_queue_cleanup_fn)(void *item, void *user_data);
 
+// Callback function type for sc_generic_queue_drain; takes ownership of item
+typedef void (*sc_generic_queue_item_fn)(void *item, void *user_data);
+
 // ============================================================================
 // Queue Lifecycle Functions
 // ============================================================================
@@ -69,10 +100,44 @@ void sc_generic_queue_nuke_with_cleanup(sc_generic_queue_t *q,
 sc_generic_queue_ret_val_t sc_generic_queue_add(sc_generic_queue_t *q, void *item);
 sc_generic_queue_ret_val_t sc_generic_queue_pop(sc_generic_queue_t *q, void **item);
 
+// Blocking operations with a deadline: an absolute CLOCK_MONOTONIC time in
+// nanoseconds (see sc_queue_deadline()), or SC_QUEUE_WAIT_FOREVER. They fail
+// with ERR_TIMEOUT, unlogged, once it passes.
+sc_generic_queue_ret_val_t sc_generic_queue_add_until(sc_generic_queue_t *q, void *item,
+                                                      uint64_t deadline_ns);
+sc_generic_queue_ret_val_t sc_generic_queue_pop_until(sc_generic_queue_t *q, void **item,
+                                                      uint64_t deadline_ns);
+
 // Non-blocking operations
 sc_generic_queue_ret_val_t sc_generic_queue_try_add(sc_generic_queue_t *q, void *item);
 sc_generic_queue_ret_val_t sc_generic_queue_try_pop(sc_generic_queue_t *q, void **item);
 
+// Non-blocking batch operations: each claims a run of slots with one
+// compare-and-swap and wakes blocked threads once. They return the number of
+// items moved; the error is ERR_FULL/ERR_EMPTY when none could be.
+size_t sc_generic_queue_add_n(sc_generic_queue_t *q, void *const *items, size_t count);
+size_t sc_generic_queue_pop_n(sc_generic_queue_t *q, void **items, size_t max);
+// Passes every item in the queue at the time of the call to fn, oldest first
+size_t sc_generic_queue_drain(sc_generic_queue_t *q, sc_generic_queue_item_fn fn,
+                              void *user_data);
+
+// ============================================================================
+// Readiness Notification
+// ============================================================================
+
+// Attach an eventfd that is readable while items wait
+// Only the first add after the queue was last found empty writes it, and any
+// pop, pop_n or drain that leaves the queue empty reads it, so a queue that
+// never runs dry costs no system calls at all. Watch it
+// level-triggered and never read it directly; a consumer that takes a bounded
+// number of items per wakeup is woken again for the rest. Must be called
+// before the queue is shared; nuke closes it.
+// Parameters:
+//   q: Queue
+// Returns: The eventfd, or -1 with ERR_INVALID if one is already attached or
+//          ERR_MEMORY if it could not be created
+int sc_generic_queue_attach_eventfd(sc_generic_queue_t *q);
+
 // ============================================================================
 // Queue Status Functions
 // ============================================================================
@@ -0,0 +1,335 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include "handshake_pool.h"
+#include "log.h"
+
+// ============================================================================
+// Internal Helper Functions
+// ============================================================================
+
+// Reads the monotonic clock
+// @return Current time in nanoseconds
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+// Makes a port's eventfd readable
+// @param port Completion port
+static void signal_port(sc_handshake_port_t *port) {
+  uint64_t one = 1;
+  if (write(port->event_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+    log_error("Failed to signal handshake completion: %s", strerror(errno));
+  }
+}
+
+// Hands a finished job back to its port
+// Only the first job after a collect writes the eventfd, so a burst of
+// completions costs the pool threads one system call.
+// @param job Finished job
+static void complete_job(sc_handshake_job_t *job) {
+  sc_handshake_port_t *port = job->port;
+  job->next                 = NULL;
+
+  pthread_mutex_lock(&port->lock);
+  if (port->tail) {
+    port->tail->next = job;
+  } else {
+    port->head = job;
+  }
+  port->tail       = job;
+  bool need_signal = !port->signalled;
+  port->signalled  = true;
+  pthread_mutex_unlock(&port->lock);
+
+  if (need_signal) {
+    signal_port(port);
+  }
+}
+
+// Pool thread: run queued jobs until the pool stops
+// @param arg The pool
+// @return NULL
+static void *pool_thread(void *arg) {
+  sc_handshake_pool_t *pool = arg;
+
+  pthread_mutex_lock(&pool->lock);
+  while (true) {
+    while (!pool->head && !pool->stopping) {
+      pthread_cond_wait(&pool->ready, &pool->lock);
+    }
+    if (pool->stopping) {
+      break;
+    }
+
+    sc_handshake_job_t *job = pool->head;
+    pool->head              = job->next;
+    if (!pool->head) {
+      pool->tail = NULL;
+    }
+    pool->depth--;
+    pthread_mutex_unlock(&pool->lock);
+
+    job->started_ns = now_ns();
+    job->fn(job);
+    job->finished_ns = now_ns();
+    complete_job(job);
+
+    pthread_mutex_lock(&pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return NULL;
+}
+
+// ============================================================================
+// Lifecycle Functions
+// ============================================================================
+
+// Creates a pool and starts its threads
+// @param thread_count Number of threads (must be > 0)
+// @return Pointer to the newly created pool, or NULL on failure
+sc_handshake_pool_t *sc_handshake_pool_init(size_t thread_count) {
+  if (thread_count == 0) {
+    log_error("%s", "Handshake pool needs at least one thread");
+    return NULL;
+  }
+
+  sc_handshake_pool_t *pool = calloc(1, sizeof(sc_handshake_pool_t));
+  if (!pool) {
+    log_error("%s", "Failed to allocate handshake pool");
+    return NULL;
+  }
+
+  pool->threads = calloc(thread_count, sizeof(pthread_t));
+  if (!pool->threads) {
+    log_error("%s", "Failed to allocate handshake pool threads");
+    free(pool);
+    return NULL;
+  }
+
+  if (pthread_mutex_init(&pool->lock, NULL) != 0) {
+    free(pool->threads);
+    free(pool);
+    return NULL;
+  }
+  if (pthread_cond_init(&pool->ready, NULL) != 0) {
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->threads);
+    free(pool);
+    return NULL;
+  }
+
+  // On failure the threads already running are stopped by nuke
+  for (size_t i = 0; i < thread_count; i++) {
+    int err = pthread_create(&pool->threads[i], NULL, pool_thread, pool);
+    if (err != 0) {
+      log_error("Failed to start handshake thread %zu: %s", i, strerror(err));
+      sc_handshake_pool_nuke(pool);
+      return NULL;
+    }
+    pool->thread_count++;
+  }
+
+  return pool;
+}
+
+// Stops the pool's threads, returns unstarted jobs and frees the pool
+// @param pool Pointer to the pool to destroy (may be NULL)
+void sc_handshake_pool_nuke(sc_handshake_pool_t *pool) {
+  if (!pool) {
+    return;
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  pool->stopping = true;
+  pthread_cond_broadcast(&pool->ready);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (size_t i = 0; i < pool->thread_count; i++) {
+    pthread_join(pool->threads[i], NULL);
+  }
+
+  // Hand back what no thread got to, so submitters can release it
+  while (pool->head) {
+    sc_handshake_job_t *job = pool->head;
+    pool->head              = job->next;
+    complete_job(job);
+  }
+
+  pthread_cond_destroy(&pool->ready);
+  pthread_mutex_destroy(&pool->lock);
+  free(pool->threads);
+  free(pool);
+}
+
+// Creates a completion port
+// @return Pointer to the newly created port, or NULL on failure
+sc_handshake_port_t *sc_handshake_port_init(void) {
+  sc_handshake_port_t *port = calloc(1, sizeof(sc_handshake_port_t));
+  if (!port) {
+    log_error("%s", "Failed to allocate handshake completion port");
+    return NULL;
+  }
+
+  port->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (port->event_fd < 0) {
+    log_error("Failed to create handshake completion eventfd: %s", strerror(errno));
+    free(port);
+    return NULL;
+  }
+
+  if (pthread_mutex_init(&port->lock, NULL) != 0) {
+    close(port->event_fd);
+    free(port);
+    return NULL;
+  }
+
+  return port;
+}
+
+// Destroys a completion port
+// @param port Pointer to the port to destroy (may be NULL)
+void sc_handshake_port_nuke(sc_handshake_port_t *port) {
+  if (!port) {
+    return;
+  }
+
+  pthread_mutex_destroy(&port->lock);
+  close(port->event_fd);
+  free(port);
+}
+
+// ============================================================================
+// Operations
+// ============================================================================
+
+// Queues a job for the next free pool thread
+// @param pool Pool
+// @param port Completion port owned by the calling thread
+// @param job Job with fn set
+// @return 0 on success, -1 on invalid arguments
+int sc_handshake_pool_submit(sc_handshake_pool_t *pool, sc_handshake_port_t *port,
+                             sc_handshake_job_t *job) {
+  if (!pool || !port || !job || !job->fn) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  job->port         = port;
+  job->next         = NULL;
+  job->submitted_ns = now_ns();
+  job->started_ns   = 0;
+  job->finished_ns  = 0;
+
+  port->stats.submitted++;
+  port->stats.in_flight++;
+  if (port->stats.in_flight > port->stats.peak_in_flight) {
+    port->stats.peak_in_flight = port->stats.in_flight;
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  if (pool->tail) {
+    pool->tail->next = job;
+  } else {
+    pool->head = job;
+  }
+  pool->tail = job;
+  pool->depth++;
+  if (pool->depth > pool->peak_depth) {
+    pool->peak_depth = pool->depth;
+  }
+  pthread_cond_signal(&pool->ready);
+  pthread_mutex_unlock(&pool->lock);
+  return 0;
+}
+
+// Counts jobs waiting for a pool thread
+// @param pool Pool
+// @return Number of queued jobs
+size_t sc_handshake_pool_depth(sc_handshake_pool_t *pool) {
+  if (!pool) {
+    return 0;
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  size_t depth = pool->depth;
+  pthread_mutex_unlock(&pool->lock);
+  return depth;
+}
+
+// Reports the deepest the pool's queue has been
+// @param pool Pool
+// @return Peak number of queued jobs
+size_t sc_handshake_pool_peak_depth(sc_handshake_pool_t *pool) {
+  if (!pool) {
+    return 0;
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  size_t peak = pool->peak_depth;
+  pthread_mutex_unlock(&pool->lock);
+  return peak;
+}
+
+// Takes finished jobs off a port
+// The eventfd is cleared under the lock before the list is read, so a job
+// finishing afterwards always signals it again and no wakeup is lost.
+// @param port Completion port owned by the calling thread
+// @param jobs Array receiving the jobs
+// @param max Capacity of jobs
+// @return Number of jobs taken
+size_t sc_handshake_port_collect(sc_handshake_port_t *port, sc_handshake_job_t **jobs,
+                                 size_t max) {
+  if (!port || !jobs) {
+    return 0;
+  }
+
+  size_t count = 0;
+  uint64_t value;
+
+  pthread_mutex_lock(&port->lock);
+  if (read(port->event_fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+    log_error("Failed to clear handshake completion eventfd: %s", strerror(errno));
+  }
+  while (count < max && port->head) {
+    jobs[count++] = port->head;
+    port->head    = port->head->next;
+  }
+  if (!port->head) {
+    port->tail = NULL;
+  }
+  port->signalled = port->head != NULL;
+  if (port->signalled) {
+    signal_port(port);
+  }
+  pthread_mutex_unlock(&port->lock);
+
+  uint64_t now = now_ns();
+  for (size_t i = 0; i < count; i++) {
+    uint64_t latency = now - jobs[i]->submitted_ns;
+    port->stats.latency_ns += latency;
+    port->stats.work_ns += jobs[i]->finished_ns - jobs[i]->started_ns;
+    if (latency > port->stats.max_latency_ns) {
+      port->stats.max_latency_ns = latency;
+    }
+  }
+  port->stats.completed += count;
+  port->stats.in_flight -= count;
+  return count;
+}
+
+// Computes the average submit-to-collect time
+// @param port Completion port
+// @return Average latency in microseconds, or 0 when nothing was collected
+double sc_handshake_port_avg_latency_us(const sc_handshake_port_t *port) {
+  if (!port || port->stats.completed == 0) {
+    return 0.0;
+  }
+  return (double) port->stats.latency_ns / (double) port->stats.completed / 1000.0;
+}
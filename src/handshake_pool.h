@@ -0,0 +1,126 @@
+#ifndef HANDSHAKE_POOL_H
+#define HANDSHAKE_POOL_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Crypto thread pool for DTLS handshakes. A handshake step costs an ECDHE key
+// exchange and a signature, milliseconds of CPU that would otherwise stall
+// every established client on the I/O thread that runs it. An I/O thread
+// submits a job, a pool thread runs it, and the finished job comes back
+// through the submitter's completion port, whose eventfd wakes the I/O loop.
+// Jobs are allocated by the submitter and linked intrusively, so submitting
+// and completing never allocate.
+
+// ============================================================================
+// Type Definitions
+// ============================================================================
+
+typedef struct sc_handshake_job sc_handshake_job_t;
+
+// Work function, run on a pool thread
+typedef void (*sc_handshake_fn)(sc_handshake_job_t *job);
+
+// Completion port counters, kept by the thread that owns the port
+typedef struct {
+  uint64_t submitted;      // Jobs submitted through the port
+  uint64_t completed;      // Finished jobs collected
+  size_t in_flight;        // Jobs submitted and not yet collected
+  size_t peak_in_flight;   // Most jobs ever in flight at once
+  uint64_t latency_ns;     // Total submit-to-collect time of collected jobs
+  uint64_t max_latency_ns; // Longest submit-to-collect time
+  uint64_t work_ns;        // Total time collected jobs spent running
+} sc_handshake_port_stats_t;
+
+// Where finished jobs return to; one per submitting I/O thread
+typedef struct {
+  int event_fd;             // Readable while finished jobs wait to be collected
+  pthread_mutex_t lock;     // Guards head, tail and signalled
+  sc_handshake_job_t *head; // Finished jobs, oldest first
+  sc_handshake_job_t *tail; // Last finished job
+  bool signalled;           // event_fd was written since the last collect
+  sc_handshake_port_stats_t stats;
+} sc_handshake_port_t;
+
+// A unit of work; embed it as the first member of the caller's job type
+struct sc_handshake_job {
+  sc_handshake_fn fn;        // Work to run, set by the caller
+  sc_handshake_port_t *port; // Port the job returns to
+  sc_handshake_job_t *next;  // Queue link, owned by the pool while submitted
+  uint64_t submitted_ns;     // Monotonic submission time
+  uint64_t started_ns;       // When a pool thread picked the job up
+  uint64_t finished_ns;      // When fn returned
+};
+
+typedef struct {
+  pthread_t *threads;
+  size_t thread_count;
+  pthread_mutex_t lock;     // Guards the queue and stopping
+  pthread_cond_t ready;     // Signalled when a job is queued or the pool stops
+  sc_handshake_job_t *head; // Submitted jobs waiting for a thread, oldest first
+  sc_handshake_job_t *tail; // Last submitted job
+  size_t depth;             // Jobs waiting for a thread
+  size_t peak_depth;        // Most jobs ever waiting at once
+  bool stopping;
+} sc_handshake_pool_t;
+
+// ============================================================================
+// Lifecycle Functions
+// ============================================================================
+
+// Create a pool and start its threads
+// Parameters:
+//   thread_count: Number of crypto threads (must be > 0)
+// Returns: Pointer to the pool, or NULL on invalid parameters or failure to
+//          allocate or start the threads
+sc_handshake_pool_t *sc_handshake_pool_init(size_t thread_count);
+
+// Stop and join the threads, each after its current job; jobs still waiting
+// are returned to their ports without being run (started_ns stays 0)
+void sc_handshake_pool_nuke(sc_handshake_pool_t *pool);
+
+// Create a completion port
+// Returns: Pointer to the port, or NULL on allocation or eventfd failure
+sc_handshake_port_t *sc_handshake_port_init(void);
+
+// Destroy a completion port; finished jobs still on it are not touched
+void sc_handshake_port_nuke(sc_handshake_port_t *port);
+
+// ============================================================================
+// Operations
+// ============================================================================
+
+// Queue a job for the next free thread; it returns through port when done
+// Must be called from the thread that owns port.
+// Parameters:
+//   pool: Pool to run the job on
+//   port: Completion port the job returns to
+//   job: Job with fn set; the pool owns it until it is collected
+// Returns: 0 on success, -1 with errno EINVAL on bad arguments
+int sc_handshake_pool_submit(sc_handshake_pool_t *pool, sc_handshake_port_t *port,
+                             sc_handshake_job_t *job);
+
+// Number of submitted jobs not yet picked up by a thread, across all ports
+size_t sc_handshake_pool_depth(sc_handshake_pool_t *pool);
+
+// Most submitted jobs ever waiting for a thread at once, across all ports
+size_t sc_handshake_pool_peak_depth(sc_handshake_pool_t *pool);
+
+// Take up to max finished jobs, oldest first, and clear the port's eventfd
+// If more are left the eventfd is made readable again, so a caller that
+// collects a bounded number per loop iteration is woken for the rest.
+// Must be called from the thread that owns port.
+// Parameters:
+//   port: Completion port
+//   jobs: Array receiving the finished jobs
+//   max: Capacity of jobs
+// Returns: Number of jobs stored in jobs
+size_t sc_handshake_port_collect(sc_handshake_port_t *port, sc_handshake_job_t **jobs, size_t max);
+
+// Average submit-to-collect time of collected jobs, in microseconds
+// Returns: Average, or 0 if no job has been collected
+double sc_handshake_port_avg_latency_us(const sc_handshake_port_t *port);
+
+#endif // HANDSHAKE_POOL_H
@@ -0,0 +1,244 @@
+#define _GNU_SOURCE // recvmmsg(2) and struct mmsghdr
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+
+#include "ingress.h"
+#include "log.h"
+#include "portability.h"
+
+// Room for one UDP_GRO control message
+#define INGRESS_CONTROL_SIZE CMSG_SPACE(sizeof(int))
+
+// ============================================================================
+// Lifecycle Functions
+// ============================================================================
+
+// Creates an ingress with a preallocated receive vector
+// @param batch_size Maximum number of datagrams returned per sc_ingress_recv call (must be > 0)
+// @param slot_size Size in bytes of each datagram buffer (must be > 0)
+// @return Pointer to the newly created ingress, or NULL on failure
+sc_ingress_t *sc_ingress_init(size_t batch_size, size_t slot_size) {
+  if (batch_size == 0 || slot_size == 0) {
+    log_error("Invalid ingress dimensions: batch_size=%zu slot_size=%zu", batch_size, slot_size);
+    return NULL;
+  }
+
+  size_t storage_size;
+  if (SC_MUL_OVERFLOW(batch_size, slot_size, &storage_size)) {
+    log_error("Integer overflow sizing ingress storage (%zu x %zu)", batch_size, slot_size);
+    return NULL;
+  }
+
+  sc_ingress_t *ingress = calloc(1, sizeof(sc_ingress_t));
+  if (!ingress) {
+    log_error("%s", "Failed to allocate ingress");
+    return NULL;
+  }
+
+  ingress->batch_size = batch_size;
+  ingress->slot_size  = slot_size;
+  ingress->storage    = malloc(storage_size);
+  ingress->msgs       = calloc(batch_size, sizeof(struct mmsghdr));
+  ingress->iovecs     = calloc(batch_size, sizeof(struct iovec));
+  ingress->addrs      = calloc(batch_size, sizeof(struct sockaddr_in));
+  ingress->packets    = calloc(batch_size, sizeof(sc_ingress_packet_t));
+
+  if (!ingress->storage || !ingress->msgs || !ingress->iovecs || !ingress->addrs ||
+      !ingress->packets) {
+    log_error("%s", "Failed to allocate ingress buffers");
+    sc_ingress_nuke(ingress);
+    return NULL;
+  }
+
+  // Wire each message header to its slot once; recvmmsg only rewrites the
+  // lengths, so the per-call setup is limited to resetting those.
+  for (size_t i = 0; i < batch_size; i++) {
+    ingress->iovecs[i].iov_base          = ingress->storage + i * slot_size;
+    ingress->iovecs[i].iov_len           = slot_size;
+    ingress->msgs[i].msg_hdr.msg_iov     = &ingress->iovecs[i];
+    ingress->msgs[i].msg_hdr.msg_iovlen  = 1;
+    ingress->msgs[i].msg_hdr.msg_name    = &ingress->addrs[i];
+    ingress->msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+  }
+
+  return ingress;
+}
+
+// Destroys an ingress and frees its buffers
+// @param ingress Pointer to the ingress to destroy (may be NULL)
+void sc_ingress_nuke(sc_ingress_t *ingress) {
+  if (!ingress) {
+    return;
+  }
+
+  free(ingress->controls);
+  free(ingress->packets);
+  free(ingress->addrs);
+  free(ingress->iovecs);
+  free(ingress->msgs);
+  free(ingress->storage);
+  free(ingress);
+}
+
+// Enables UDP_GRO on a socket drained by the ingress
+// The packet array grows so every slot can be split into its full segment count.
+// @param ingress Pointer to the ingress (must not be NULL)
+// @param fd UDP socket the ingress drains
+// @return 0 on success, -1 on failure with errno set
+int sc_ingress_enable_gro(sc_ingress_t *ingress, int fd) {
+  if (!ingress) {
+    errno = EINVAL;
+    return -1;
+  }
+  if (ingress->gro) {
+    return 0;
+  }
+
+  size_t packet_count;
+  size_t controls_size;
+  if (SC_MUL_OVERFLOW(ingress->batch_size, SC_INGRESS_GRO_MAX_SEGMENTS, &packet_count) ||
+      SC_MUL_OVERFLOW(ingress->batch_size, INGRESS_CONTROL_SIZE, &controls_size)) {
+    errno = EOVERFLOW;
+    return -1;
+  }
+
+  sc_ingress_packet_t *packets = calloc(packet_count, sizeof(sc_ingress_packet_t));
+  uint8_t *controls            = calloc(1, controls_size);
+  if (!packets || !controls) {
+    free(packets);
+    free(controls);
+    errno = ENOMEM;
+    return -1;
+  }
+
+  // Kernels without UDP GRO (before 5.0) reject the option
+  int one = 1;
+  if (setsockopt(fd, IPPROTO_UDP, UDP_GRO, &one, sizeof(one)) < 0) {
+    int saved = errno;
+    free(packets);
+    free(controls);
+    errno = saved;
+    return -1;
+  }
+
+  free(ingress->packets);
+  ingress->packets  = packets;
+  ingress->controls = controls;
+  for (size_t i = 0; i < ingress->batch_size; i++) {
+    ingress->msgs[i].msg_hdr.msg_control = controls + i * INGRESS_CONTROL_SIZE;
+  }
+  ingress->gro = true;
+  return 0;
+}
+
+// ============================================================================
+// Internal Helper Functions
+// ============================================================================
+
+// Reads the segment size the kernel reports for a coalesced slot
+// @param hdr Received message header
+// @return Size of every segment but the last, or 0 if the slot holds one datagram
+static size_t gro_segment_size(struct msghdr *hdr) {
+  for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(hdr); cmsg; cmsg = CMSG_NXTHDR(hdr, cmsg)) {
+    if (cmsg->cmsg_level == IPPROTO_UDP && cmsg->cmsg_type == UDP_GRO) {
+      int segment;
+      memcpy(&segment, CMSG_DATA(cmsg), sizeof(segment));
+      return segment > 0 ? (size_t) segment : 0;
+    }
+  }
+  return 0;
+}
+
+// ============================================================================
+// Operations
+// ============================================================================
+
+// Receives a batch of datagrams with a single recvmmsg call
+// Datagrams larger than slot_size are dropped and counted in ingress->truncated.
+// @param ingress Pointer to the ingress (must not be NULL)
+// @param fd Non-blocking UDP socket to drain
+// @return Number of datagrams in ingress->packets, or -1 on error
+int sc_ingress_recv(sc_ingress_t *ingress, int fd) {
+  if (!ingress) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  for (size_t i = 0; i < ingress->batch_size; i++) {
+    ingress->msgs[i].msg_hdr.msg_namelen    = sizeof(struct sockaddr_in);
+    ingress->msgs[i].msg_hdr.msg_flags      = 0;
+    ingress->msgs[i].msg_hdr.msg_controllen = ingress->gro ? INGRESS_CONTROL_SIZE : 0;
+  }
+
+  ingress->drained = true;
+
+  int received = recvmmsg(fd, ingress->msgs, (unsigned int) ingress->batch_size, MSG_DONTWAIT,
+                          NULL);
+  if (received < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      return 0;
+    }
+    return -1;
+  }
+
+  // A full batch means more datagrams may be queued behind it
+  ingress->drained = (size_t) received < ingress->batch_size;
+
+  int count = 0;
+  for (int i = 0; i < received; i++) {
+    struct msghdr *hdr = &ingress->msgs[i].msg_hdr;
+    if (hdr->msg_flags & MSG_TRUNC) {
+      ingress->truncated++;
+      continue;
+    }
+
+    // A coalesced slot is split back into its datagrams, which all share the
+    // source address; without GRO every slot is a single segment
+    const uint8_t *data = ingress->iovecs[i].iov_base;
+    size_t remaining    = ingress->msgs[i].msg_len;
+    size_t segment      = ingress->gro ? gro_segment_size(hdr) : 0;
+    size_t segments     = 0;
+    do {
+      size_t len = segment && segment < remaining ? segment : remaining;
+
+      sc_ingress_packet_t *packet = &ingress->packets[count++];
+      packet->data                = data;
+      packet->len                 = len;
+      packet->addr                = ingress->addrs[i];
+      packet->addr_len            = hdr->msg_namelen;
+
+      data += len;
+      remaining -= len;
+      segments++;
+    } while (remaining > 0 && segments < SC_INGRESS_GRO_MAX_SEGMENTS);
+
+    if (remaining > 0) {
+      ingress->truncated++;
+    }
+    if (segments > 1) {
+      ingress->coalesced += segments;
+    }
+  }
+
+  if (received > 0) {
+    ingress->batches++;
+    ingress->datagrams += (uint64_t) count;
+  }
+
+  return count;
+}
+
+// Computes the average number of datagrams delivered per batch
+// @param ingress Pointer to the ingress
+// @return Average batch size, or 0 when nothing has been received
+double sc_ingress_avg_batch_size(const sc_ingress_t *ingress) {
+  if (!ingress || ingress->batches == 0) {
+    return 0.0;
+  }
+  return (double) ingress->datagrams / (double) ingress->batches;
+}
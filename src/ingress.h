@@ -0,0 +1,91 @@
+#ifndef INGRESS_H
+#define INGRESS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+// Batched datagram ingress built on recvmmsg(2). All packet buffers are
+// allocated once at init time; each call to sc_ingress_recv() drains up to
+// batch_size datagrams from the socket with a single system call. With UDP_GRO
+// enabled each slot may instead receive a run of datagrams from one peer that
+// the kernel coalesced, which sc_ingress_recv() splits back into packets.
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+#define SC_INGRESS_GRO_MAX_SEGMENTS 64 // Datagrams per coalesced slot (kernel UDP_GRO_CNT_MAX)
+
+// ============================================================================
+// Type Definitions
+// ============================================================================
+
+// A single received datagram. The data pointer refers to storage owned by the
+// ingress and is only valid until the next call to sc_ingress_recv().
+typedef struct {
+  const uint8_t *data;     // Datagram payload
+  size_t len;              // Payload length in bytes
+  struct sockaddr_in addr; // Source address
+  socklen_t addr_len;      // Source address length
+} sc_ingress_packet_t;
+
+// Preallocated receive vector
+typedef struct {
+  size_t batch_size;            // Maximum datagrams per recvmmsg call
+  size_t slot_size;             // Bytes reserved per datagram
+  uint8_t *storage;             // batch_size * slot_size bytes of packet buffers
+  struct mmsghdr *msgs;         // recvmmsg message headers
+  struct iovec *iovecs;         // One iovec per slot
+  struct sockaddr_in *addrs;    // Source address per slot
+  sc_ingress_packet_t *packets; // Results of the most recent batch
+  uint8_t *controls;            // UDP_GRO control message buffer per slot (GRO only)
+  bool gro;                     // Slots may hold coalesced datagrams
+  uint64_t batches;             // Number of non-empty batches received
+  uint64_t datagrams;           // Number of datagrams delivered
+  uint64_t coalesced;           // Datagrams that arrived coalesced with others by GRO
+  uint64_t truncated;           // Datagrams dropped because they exceeded slot_size
+  bool drained;                 // True when the last receive left the socket empty
+} sc_ingress_t;
+
+// ============================================================================
+// Lifecycle Functions
+// ============================================================================
+
+// Create an ingress with batch_size slots of slot_size bytes each
+// Returns: Pointer to the ingress, or NULL on invalid parameters or allocation failure
+sc_ingress_t *sc_ingress_init(size_t batch_size, size_t slot_size);
+
+// Destroy an ingress and free its buffers
+void sc_ingress_nuke(sc_ingress_t *ingress);
+
+// Enable UDP_GRO on the socket and let the ingress split coalesced slots
+// A coalesced run can be up to 64 KiB, so slot_size should be at least that;
+// longer runs are truncated by the kernel and dropped.
+// Parameters:
+//   ingress: Ingress that will drain fd
+//   fd: UDP socket
+// Returns: 0 on success, -1 with errno set if the kernel lacks UDP_GRO or
+//          allocation fails; the ingress keeps working without GRO either way
+int sc_ingress_enable_gro(sc_ingress_t *ingress, int fd);
+
+// ============================================================================
+// Operations
+// ============================================================================
+
+// Receive up to batch_size datagrams from a non-blocking socket
+// Parameters:
+//   ingress: Ingress to fill
+//   fd: Non-blocking UDP socket
+// Returns: Number of datagrams placed in ingress->packets (up to
+//          batch_size * SC_INGRESS_GRO_MAX_SEGMENTS with GRO), or -1 on error with errno set.
+//          ingress->drained reports whether another call is needed to empty the socket.
+int sc_ingress_recv(sc_ingress_t *ingress, int fd);
+
+// Average number of datagrams per non-empty batch since init
+// Returns: Average batch size, or 0 if no batches have been received
+double sc_ingress_avg_batch_size(const sc_ingress_t *ingress);
+
+#endif // INGRESS_H
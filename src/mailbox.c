@@ -0,0 +1,133 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include "mailbox.h"
+#include "log.h"
+
+// ============================================================================
+// Internal Helper Functions
+// ============================================================================
+
+// Makes a mailbox's eventfd readable
+// @param mailbox Mailbox
+static void signal_mailbox(sc_mailbox_t *mailbox) {
+  uint64_t one = 1;
+  if (write(mailbox->event_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+    log_error("Failed to signal mailbox: %s", strerror(errno));
+  }
+}
+
+// ============================================================================
+// Lifecycle Functions
+// ============================================================================
+
+// Creates a mailbox
+// @param capacity Maximum number of waiting messages (must be > 0)
+// @return Pointer to the newly created mailbox, or NULL on failure
+sc_mailbox_t *sc_mailbox_init(size_t capacity) {
+  if (capacity == 0) {
+    log_error("%s", "Mailbox capacity must be greater than 0");
+    return NULL;
+  }
+
+  sc_mailbox_t *mailbox = calloc(1, sizeof(sc_mailbox_t));
+  if (!mailbox) {
+    log_error("%s", "Failed to allocate mailbox");
+    return NULL;
+  }
+
+  mailbox->queue = sc_message_mpsc_queue_init(capacity);
+  if (!mailbox->queue) {
+    free(mailbox);
+    return NULL;
+  }
+
+  mailbox->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (mailbox->event_fd < 0) {
+    log_error("Failed to create mailbox eventfd: %s", strerror(errno));
+    sc_message_mpsc_queue_nuke(mailbox->queue);
+    free(mailbox);
+    return NULL;
+  }
+
+  atomic_init(&mailbox->signalled, false);
+  atomic_init(&mailbox->posted, 0);
+  atomic_init(&mailbox->refused, 0);
+  return mailbox;
+}
+
+// Destroys a mailbox
+// @param mailbox Pointer to the mailbox to destroy (may be NULL)
+void sc_mailbox_nuke(sc_mailbox_t *mailbox) {
+  if (!mailbox) {
+    return;
+  }
+
+  sc_message_mpsc_queue_nuke(mailbox->queue);
+  close(mailbox->event_fd);
+  free(mailbox);
+}
+
+// ============================================================================
+// Operations
+// ============================================================================
+
+// Queues a message and wakes the consumer if it has not been woken yet
+// @param mailbox Mailbox
+// @param msg Message to queue
+// @return 0 on success, -1 if full or on invalid arguments
+int sc_mailbox_post(sc_mailbox_t *mailbox, message_t *msg) {
+  if (!mailbox || !msg) {
+    return -1;
+  }
+
+  if (sc_message_mpsc_queue_try_add(mailbox->queue, msg) != SC_MESSAGE_QUEUE_SUCCESS) {
+    atomic_fetch_add(&mailbox->refused, 1);
+    return -1;
+  }
+  atomic_fetch_add(&mailbox->posted, 1);
+
+  if (!atomic_exchange(&mailbox->signalled, true)) {
+    signal_mailbox(mailbox);
+  }
+  return 0;
+}
+
+// Takes waiting messages out of a mailbox
+// The eventfd is only read once a drain leaves the mailbox empty; one stopped
+// by max leaves it readable, so the consumer comes back for the rest without
+// a system call on either side. The flag is cleared before the queue is
+// looked at again, so a message posted meanwhile signals the eventfd anew.
+// @param mailbox Mailbox
+// @param msgs Array receiving the messages
+// @param max Capacity of msgs
+// @return Number of messages taken
+size_t sc_mailbox_drain(sc_mailbox_t *mailbox, message_t **msgs, size_t max) {
+  if (!mailbox || !msgs) {
+    return 0;
+  }
+
+  size_t count = sc_message_mpsc_queue_pop_n(mailbox->queue, msgs, max);
+  mailbox->drained += count;
+
+  if (count == max || !atomic_load_explicit(&mailbox->signalled, memory_order_relaxed)) {
+    return count;
+  }
+
+  uint64_t value;
+  if (read(mailbox->event_fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+    log_error("Failed to clear mailbox eventfd: %s", strerror(errno));
+  }
+  atomic_store_explicit(&mailbox->signalled, false, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+
+  // A post that found the flag still set did not write the eventfd
+  if (!sc_message_mpsc_queue_is_empty(mailbox->queue) &&
+      !atomic_exchange(&mailbox->signalled, true)) {
+    signal_mailbox(mailbox);
+  }
+  return count;
+}
@@ -0,0 +1,70 @@
+#ifndef MAILBOX_H
+#define MAILBOX_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "message.h"
+#include "message_queue.h"
+
+// Hands messages to a thread that sleeps in poll(2), epoll or io_uring rather
+// than on the queue's futex. The messages travel through an
+// sc_message_mpsc_queue_t; an eventfd beside it is readable while messages wait.
+// Only the first post after a drain empties the mailbox writes the eventfd,
+// and only such a drain reads it, so a burst of posts costs the producers one
+// system call and the consumer one wakeup. Any number of threads may post; one
+// thread drains.
+
+// ============================================================================
+// Type Definitions
+// ============================================================================
+
+typedef struct {
+  sc_message_mpsc_queue_t *queue;
+  int event_fd;             // Readable while messages wait to be drained
+  atomic_bool signalled;    // event_fd was written since a drain last emptied the mailbox
+  _Atomic uint64_t posted;  // Messages accepted, across all producers
+  _Atomic uint64_t refused; // Posts turned away because the queue was full
+  uint64_t drained;         // Messages taken, kept by the consumer
+} sc_mailbox_t;
+
+// ============================================================================
+// Lifecycle Functions
+// ============================================================================
+
+// Create a mailbox
+// Parameters:
+//   capacity: Most messages that can wait at once (must be > 0)
+// Returns: Pointer to the mailbox, or NULL on invalid parameters or failure
+//          to allocate the queue or eventfd
+sc_mailbox_t *sc_mailbox_init(size_t capacity);
+
+// Destroy a mailbox; messages still in it are not touched
+void sc_mailbox_nuke(sc_mailbox_t *mailbox);
+
+// ============================================================================
+// Operations
+// ============================================================================
+
+// Queue a message for the consumer without blocking
+// Parameters:
+//   mailbox: Mailbox
+//   msg: Message to hand over; the consumer owns it once posted
+// Returns: 0 on success, -1 if the mailbox is full or the arguments are NULL
+int sc_mailbox_post(sc_mailbox_t *mailbox, message_t *msg);
+
+// Take up to max messages, oldest first, clearing the eventfd if none are left
+// If more are left the eventfd stays readable, so a consumer that drains a
+// bounded number per loop iteration is woken for the rest; under steady load
+// neither side makes a system call.
+// Must only be called from the consuming thread.
+// Parameters:
+//   mailbox: Mailbox
+//   msgs: Array receiving the messages
+//   max: Capacity of msgs
+// Returns: Number of messages stored in msgs
+size_t sc_mailbox_drain(sc_mailbox_t *mailbox, message_t **msgs, size_t max);
+
+#endif // MAILBOX_H
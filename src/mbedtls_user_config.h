@@ -0,0 +1,66 @@
+#ifndef MBEDTLS_USER_CONFIG_H
+#define MBEDTLS_USER_CONFIG_H
+
+// Options layered over mbedTLS's default config.h through
+// MBEDTLS_USER_CONFIG_FILE. The Makefile passes it both to the vendored
+// library build and to our own sources, so the two always agree; editing this
+// file rebuilds mbedTLS on the next make.
+
+// Record buffers
+// Every SSL context allocates one input and one output record buffer in
+// mbedtls_ssl_setup() and keeps them until it is freed, including sessions
+// parked in the server's pool. The defaults size both for 16 KB TLS records,
+// about 33 KB per session, although no game message exceeds SOCKET_BUFFER_SIZE.
+// Records are capped at 4 KB instead, and peers agree on the limit with the
+// max_fragment_length extension (see sc_dtls_context_create()).
+#define MBEDTLS_SSL_MAX_FRAGMENT_LENGTH
+#define MBEDTLS_SSL_IN_CONTENT_LEN  4096
+#define MBEDTLS_SSL_OUT_CONTENT_LEN 4096
+
+// Connection IDs
+// Server sessions give their clients an 8-byte connection ID to put in every
+// record, so a client whose address or port changes keeps its session (see
+// sc_dtls_session_set_cid()). Clients use an empty ID of their own. mbedTLS
+// 2.28 implements draft-ietf-tls-dtls-connection-id-05, the draft behind
+// RFC 9146: the extension number differs from the RFC's, so both peers must
+// run this build.
+#define MBEDTLS_SSL_DTLS_CONNECTION_ID
+#define MBEDTLS_SSL_CID_IN_LEN_MAX  8
+#define MBEDTLS_SSL_CID_OUT_LEN_MAX 8
+
+// Record ciphers
+// Both AEAD families DTLS can negotiate are built, and sc_dtls_rank_ciphers()
+// puts whichever this machine runs faster first. AES-GCM uses AES-NI and
+// PCLMULQDQ on x86_64 CPUs that have them, detected at run time. mbedTLS 2.28
+// has no code for the ARMv8 crypto extensions, so on aarch64 AES runs from
+// tables and ChaCha20-Poly1305 is usually the faster one. These match the
+// defaults and are spelled out so a trimmed config cannot drop them.
+#define MBEDTLS_HAVE_ASM
+#define MBEDTLS_AESNI_C
+#define MBEDTLS_GCM_C
+#define MBEDTLS_CHACHA20_C
+#define MBEDTLS_POLY1305_C
+#define MBEDTLS_CHACHAPOLY_C
+
+// Server identity and key exchange
+// Servers sign handshakes with ECDSA on P-256 and agree keys over X25519 (see
+// sc_dtls_context_create()); RSA keys still work through the ECDHE-RSA suites.
+// NIST_OPTIM adds the fast P-256 reduction. Also defaults, spelled out for the
+// same reason.
+#define MBEDTLS_ECDSA_C
+#define MBEDTLS_ECDH_C
+#define MBEDTLS_ECP_DP_SECP256R1_ENABLED
+#define MBEDTLS_ECP_DP_CURVE25519_ENABLED
+#define MBEDTLS_ECP_NIST_OPTIM
+#define MBEDTLS_KEY_EXCHANGE_ECDHE_ECDSA_ENABLED
+#define MBEDTLS_KEY_EXCHANGE_ECDHE_RSA_ENABLED
+
+// Memory
+// mbedTLS calls mbedtls_calloc()/mbedtls_free(), which sc_dtls_init() points
+// at the size-classed pool in src/tls_arena.c, so TLS state stays out of the
+// general heap and each session's allocations are counted (see
+// sc_dtls_session_memory()). Until then they are calloc(3) and free(3).
+#define MBEDTLS_PLATFORM_C
+#define MBEDTLS_PLATFORM_MEMORY
+
+#endif // MBEDTLS_USER_CONFIG_H
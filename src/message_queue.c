@@ -1,5 +1,19 @@
 #include "message_queue.h"
 
+// Typed callback of a drain, passed through the generic item callback
+typedef struct {
+  sc_message_queue_drain_fn fn;
+  void *user_data;
+} drain_t;
+
+// Hands one drained item to the typed callback
+// @param item Message taken from the queue
+// @param ctx drain_t of the drain
+static void drain_message(void *item, void *ctx) {
+  drain_t *drain = ctx;
+  drain->fn(item, drain->user_data);
+}
+
 // Creates a new thread-safe message queue with the specified capacity.
 // @param capacity Maximum number of messages the queue can hold (must be > 0).
 // @return Pointer to the newly created queue, or NULL on failure.
@@ -52,6 +66,60 @@ sc_message_queue_ret_val_t sc_message_queue_try_pop(sc_message_queue_t *queue, m
   return (sc_message_queue_ret_val_t) sc_generic_queue_try_pop(queue, (void **) msg);
 }
 
+// Adds a message, blocking until a deadline while the queue is full.
+// @param queue Pointer to the queue (must not be NULL).
+// @param msg Pointer to the message to add (must not be NULL).
+// @param deadline_ns Absolute CLOCK_MONOTONIC time in nanoseconds to give up at.
+// @return SC_MESSAGE_QUEUE_SUCCESS on success, SC_MESSAGE_QUEUE_ERR_TIMEOUT once the
+//         deadline passes, or another error code on failure.
+sc_message_queue_ret_val_t sc_message_queue_add_until(sc_message_queue_t *queue,
+                                                      message_t *msg, uint64_t deadline_ns) {
+  return (sc_message_queue_ret_val_t) sc_generic_queue_add_until(queue, (void *) msg, deadline_ns);
+}
+
+// Removes the oldest message, blocking until a deadline while the queue is empty.
+// @param queue Pointer to the queue (must not be NULL).
+// @param msg Pointer to store the removed message (must not be NULL).
+// @param deadline_ns Absolute CLOCK_MONOTONIC time in nanoseconds to give up at.
+// @return SC_MESSAGE_QUEUE_SUCCESS on success, SC_MESSAGE_QUEUE_ERR_TIMEOUT once the
+//         deadline passes, or another error code on failure.
+sc_message_queue_ret_val_t sc_message_queue_pop_until(sc_message_queue_t *queue,
+                                                      message_t **msg, uint64_t deadline_ns) {
+  return (sc_message_queue_ret_val_t) sc_generic_queue_pop_until(queue, (void **) msg, deadline_ns);
+}
+
+// Adds as many of count messages as fit, without blocking.
+// @param queue Pointer to the queue (must not be NULL).
+// @param msgs Messages to add, oldest first (none may be NULL).
+// @param count Number of messages.
+// @return Number of messages added, from the start of msgs.
+size_t sc_message_queue_add_n(sc_message_queue_t *queue, message_t *const *msgs, size_t count) {
+  return sc_generic_queue_add_n(queue, (void *const *) msgs, count);
+}
+
+// Removes up to max messages, oldest first, without blocking.
+// @param queue Pointer to the queue (must not be NULL).
+// @param msgs Array receiving the messages (must not be NULL).
+// @param max Capacity of msgs.
+// @return Number of messages stored in msgs.
+size_t sc_message_queue_pop_n(sc_message_queue_t *queue, message_t **msgs, size_t max) {
+  return sc_generic_queue_pop_n(queue, (void **) msgs, max);
+}
+
+// Passes every message in the queue at the time of the call to fn.
+// @param queue Pointer to the queue (must not be NULL).
+// @param fn Callback taking ownership of each message (must not be NULL).
+// @param user_data Optional user data passed to fn.
+// @return Number of messages passed to fn.
+size_t sc_message_queue_drain(sc_message_queue_t *queue, sc_message_queue_drain_fn fn,
+                              void *user_data) {
+  if (fn == NULL) {
+    return sc_generic_queue_drain(queue, NULL, NULL);
+  }
+  drain_t drain = {.fn = fn, .user_data = user_data};
+  return sc_generic_queue_drain(queue, drain_message, &drain);
+}
+
 // Checks if the queue is empty (thread-safe).
 // @param queue Pointer to the queue.
 // @return true if the queue is empty, false otherwise.
@@ -72,3 +140,267 @@ bool sc_message_queue_is_full(const sc_message_queue_t *queue) {
 size_t sc_message_queue_size(const sc_message_queue_t *queue) {
   return sc_generic_queue_get_size(queue);
 }
+
+// ============================================================================
+// Single-Producer Single-Consumer Message Queue
+// ============================================================================
+
+// Creates a spsc message queue; see sc_message_queue_init().
+// @param capacity Maximum number of messages the queue can hold (must be > 0).
+// @return Pointer to the newly created queue, or NULL on failure.
+sc_message_spsc_queue_t *sc_message_spsc_queue_init(size_t capacity) {
+  return sc_spsc_queue_init(capacity);
+}
+
+// Destroys a spsc message queue; messages still in it are not freed.
+// @param queue Pointer to the queue to destroy.
+// @return SC_GENERIC_QUEUE_SUCCESS on success, or an error code on failure.
+sc_generic_queue_ret_val_t sc_message_spsc_queue_nuke(sc_message_spsc_queue_t *queue) {
+  return sc_spsc_queue_nuke(queue);
+}
+
+// Adds a message, blocking while the queue is full.
+// @param queue Pointer to the queue (must not be NULL).
+// @param msg Pointer to the message to add (must not be NULL).
+// @return SC_MESSAGE_QUEUE_SUCCESS on success, or an error code on failure.
+sc_message_queue_ret_val_t sc_message_spsc_queue_add(sc_message_spsc_queue_t *queue,
+                                                     message_t *msg) {
+  return (sc_message_queue_ret_val_t) sc_spsc_queue_add(queue, (void *) msg);
+}
+
+// Attempts to add a message without blocking.
+// @param queue Pointer to the queue (must not be NULL).
+// @param msg Pointer to the message to add (must not be NULL).
+// @return SC_MESSAGE_QUEUE_SUCCESS on success, SC_MESSAGE_QUEUE_ERR_FULL if full,
+//         or another error code on failure.
+sc_message_queue_ret_val_t sc_message_spsc_queue_try_add(sc_message_spsc_queue_t *queue,
+                                                        message_t *msg) {
+  return (sc_message_queue_ret_val_t) sc_spsc_queue_try_add(queue, (void *) msg);
+}
+
+// Removes the oldest message, blocking while the queue is empty.
+// @param queue Pointer to the queue (must not be NULL).
+// @param msg Pointer to store the removed message (must not be NULL).
+// @return SC_MESSAGE_QUEUE_SUCCESS on success, or an error code on failure.
+sc_message_queue_ret_val_t sc_message_spsc_queue_pop(sc_message_spsc_queue_t *queue,
+                                                     message_t **msg) {
+  return (sc_message_queue_ret_val_t) sc_spsc_queue_pop(queue, (void **) msg);
+}
+
+// Attempts to remove the oldest message without blocking.
+// @param queue Pointer to the queue (must not be NULL).
+// @param msg Pointer to store the removed message (must not be NULL).
+// @return SC_MESSAGE_QUEUE_SUCCESS on success, SC_MESSAGE_QUEUE_ERR_EMPTY if empty,
+//         or another error code on failure.
+sc_message_queue_ret_val_t sc_message_spsc_queue_try_pop(sc_message_spsc_queue_t *queue,
+                                                        message_t **msg) {
+  return (sc_message_queue_ret_val_t) sc_spsc_queue_try_pop(queue, (void **) msg);
+}
+
+// Adds a message, blocking until a deadline while the queue is full.
+// @param queue Pointer to the queue (must not be NULL).
+// @param msg Pointer to the message to add (must not be NULL).
+// @param deadline_ns Absolute CLOCK_MONOTONIC time in nanoseconds to give up at.
+// @return SC_MESSAGE_QUEUE_SUCCESS on success, SC_MESSAGE_QUEUE_ERR_TIMEOUT once the
+//         deadline passes, or another error code on failure.
+sc_message_queue_ret_val_t sc_message_spsc_queue_add_until(sc_message_spsc_queue_t *queue,
+                                                           message_t *msg, uint64_t deadline_ns) {
+  return (sc_message_queue_ret_val_t) sc_spsc_queue_add_until(queue, (void *) msg, deadline_ns);
+}
+
+// Removes the oldest message, blocking until a deadline while the queue is empty.
+// @param queue Pointer to the queue (must not be NULL).
+// @param msg Pointer to store the removed message (must not be NULL).
+// @param deadline_ns Absolute CLOCK_MONOTONIC time in nanoseconds to give up at.
+// @return SC_MESSAGE_QUEUE_SUCCESS on success, SC_MESSAGE_QUEUE_ERR_TIMEOUT once the
+//         deadline passes, or another error code on failure.
+sc_message_queue_ret_val_t sc_message_spsc_queue_pop_until(sc_message_spsc_queue_t *queue,
+                                                           message_t **msg, uint64_t deadline_ns) {
+  return (sc_message_queue_ret_val_t) sc_spsc_queue_pop_until(queue, (void **) msg, deadline_ns);
+}
+
+// Adds as many of count messages as fit, without blocking.
+// @param queue Pointer to the queue (must not be NULL).
+// @param msgs Messages to add, oldest first (none may be NULL).
+// @param count Number of messages.
+// @return Number of messages added, from the start of msgs.
+size_t sc_message_spsc_queue_add_n(sc_message_spsc_queue_t *queue, message_t *const *msgs,
+                                   size_t count) {
+  return sc_spsc_queue_add_n(queue, (void *const *) msgs, count);
+}
+
+// Removes up to max messages, oldest first, without blocking.
+// @param queue Pointer to the queue (must not be NULL).
+// @param msgs Array receiving the messages (must not be NULL).
+// @param max Capacity of msgs.
+// @return Number of messages stored in msgs.
+size_t sc_message_spsc_queue_pop_n(sc_message_spsc_queue_t *queue, message_t **msgs, size_t max) {
+  return sc_spsc_queue_pop_n(queue, (void **) msgs, max);
+}
+
+// Passes every message in the queue at the time of the call to fn.
+// @param queue Pointer to the queue (must not be NULL).
+// @param fn Callback taking ownership of each message (must not be NULL).
+// @param user_data Optional user data passed to fn.
+// @return Number of messages passed to fn.
+size_t sc_message_spsc_queue_drain(sc_message_spsc_queue_t *queue, sc_message_queue_drain_fn fn,
+                                   void *user_data) {
+  if (fn == NULL) {
+    return sc_spsc_queue_drain(queue, NULL, NULL);
+  }
+  drain_t drain = {.fn = fn, .user_data = user_data};
+  return sc_spsc_queue_drain(queue, drain_message, &drain);
+}
+
+// Checks if the queue is empty (thread-safe).
+// @param queue Pointer to the queue.
+// @return true if the queue is empty, false otherwise.
+bool sc_message_spsc_queue_is_empty(const sc_message_spsc_queue_t *queue) {
+  return sc_spsc_queue_is_empty(queue);
+}
+
+// Checks if the queue is full (thread-safe).
+// @param queue Pointer to the queue.
+// @return true if the queue is full, false otherwise.
+bool sc_message_spsc_queue_is_full(const sc_message_spsc_queue_t *queue) {
+  return sc_spsc_queue_is_full(queue);
+}
+
+// Gets the current number of messages in the queue (thread-safe).
+// @param queue Pointer to the queue.
+// @return Number of messages currently in the queue, or 0 on error.
+size_t sc_message_spsc_queue_size(const sc_message_spsc_queue_t *queue) {
+  return sc_spsc_queue_get_size(queue);
+}
+
+// ============================================================================
+// Multi-Producer Single-Consumer Message Queue
+// ============================================================================
+
+// Creates a mpsc message queue; see sc_message_queue_init().
+// @param capacity Maximum number of messages the queue can hold (must be > 0).
+// @return Pointer to the newly created queue, or NULL on failure.
+sc_message_mpsc_queue_t *sc_message_mpsc_queue_init(size_t capacity) {
+  return sc_mpsc_queue_init(capacity);
+}
+
+// Destroys a mpsc message queue; messages still in it are not freed.
+// @param queue Pointer to the queue to destroy.
+// @return SC_GENERIC_QUEUE_SUCCESS on success, or an error code on failure.
+sc_generic_queue_ret_val_t sc_message_mpsc_queue_nuke(sc_message_mpsc_queue_t *queue) {
+  return sc_mpsc_queue_nuke(queue);
+}
+
+// Adds a message, blocking while the queue is full.
+// @param queue Pointer to the queue (must not be NULL).
+// @param msg Pointer to the message to add (must not be NULL).
+// @return SC_MESSAGE_QUEUE_SUCCESS on success, or an error code on failure.
+sc_message_queue_ret_val_t sc_message_mpsc_queue_add(sc_message_mpsc_queue_t *queue,
+                                                     message_t *msg) {
+  return (sc_message_queue_ret_val_t) sc_mpsc_queue_add(queue, (void *) msg);
+}
+
+// Attempts to add a message without blocking.
+// @param queue Pointer to the queue (must not be NULL).
+// @param msg Pointer to the message to add (must not be NULL).
+// @return SC_MESSAGE_QUEUE_SUCCESS on success, SC_MESSAGE_QUEUE_ERR_FULL if full,
+//         or another error code on failure.
+sc_message_queue_ret_val_t sc_message_mpsc_queue_try_add(sc_message_mpsc_queue_t *queue,
+                                                        message_t *msg) {
+  return (sc_message_queue_ret_val_t) sc_mpsc_queue_try_add(queue, (void *) msg);
+}
+
+// Removes the oldest message, blocking while the queue is empty.
+// @param queue Pointer to the queue (must not be NULL).
+// @param msg Pointer to store the removed message (must not be NULL).
+// @return SC_MESSAGE_QUEUE_SUCCESS on success, or an error code on failure.
+sc_message_queue_ret_val_t sc_message_mpsc_queue_pop(sc_message_mpsc_queue_t *queue,
+                                                     message_t **msg) {
+  return (sc_message_queue_ret_val_t) sc_mpsc_queue_pop(queue, (void **) msg);
+}
+
+// Attempts to remove the oldest message without blocking.
+// @param queue Pointer to the queue (must not be NULL).
+// @param msg Pointer to store the removed message (must not be NULL).
+// @return SC_MESSAGE_QUEUE_SUCCESS on success, SC_MESSAGE_QUEUE_ERR_EMPTY if empty,
+//         or another error code on failure.
+sc_message_queue_ret_val_t sc_message_mpsc_queue_try_pop(sc_message_mpsc_queue_t *queue,
+                                                        message_t **msg) {
+  return (sc_message_queue_ret_val_t) sc_mpsc_queue_try_pop(queue, (void **) msg);
+}
+
+// Adds a message, blocking until a deadline while the queue is full.
+// @param queue Pointer to the queue (must not be NULL).
+// @param msg Pointer to the message to add (must not be NULL).
+// @param deadline_ns Absolute CLOCK_MONOTONIC time in nanoseconds to give up at.
+// @return SC_MESSAGE_QUEUE_SUCCESS on success, SC_MESSAGE_QUEUE_ERR_TIMEOUT once the
+//         deadline passes, or another error code on failure.
+sc_message_queue_ret_val_t sc_message_mpsc_queue_add_until(sc_message_mpsc_queue_t *queue,
+                                                           message_t *msg, uint64_t deadline_ns) {
+  return (sc_message_queue_ret_val_t) sc_mpsc_queue_add_until(queue, (void *) msg, deadline_ns);
+}
+
+// Removes the oldest message, blocking until a deadline while the queue is empty.
+// @param queue Pointer to the queue (must not be NULL).
+// @param msg Pointer to store the removed message (must not be NULL).
+// @param deadline_ns Absolute CLOCK_MONOTONIC time in nanoseconds to give up at.
+// @return SC_MESSAGE_QUEUE_SUCCESS on success, SC_MESSAGE_QUEUE_ERR_TIMEOUT once the
+//         deadline passes, or another error code on failure.
+sc_message_queue_ret_val_t sc_message_mpsc_queue_pop_until(sc_message_mpsc_queue_t *queue,
+                                                           message_t **msg, uint64_t deadline_ns) {
+  return (sc_message_queue_ret_val_t) sc_mpsc_queue_pop_until(queue, (void **) msg, deadline_ns);
+}
+
+// Adds as many of count messages as fit, without blocking.
+// @param queue Pointer to the queue (must not be NULL).
+// @param msgs Messages to add, oldest first (none may be NULL).
+// @param count Number of messages.
+// @return Number of messages added, from the start of msgs.
+size_t sc_message_mpsc_queue_add_n(sc_message_mpsc_queue_t *queue, message_t *const *msgs,
+                                   size_t count) {
+  return sc_mpsc_queue_add_n(queue, (void *const *) msgs, count);
+}
+
+// Removes up to max messages, oldest first, without blocking.
+// @param queue Pointer to the queue (must not be NULL).
+// @param msgs Array receiving the messages (must not be NULL).
+// @param max Capacity of msgs.
+// @return Number of messages stored in msgs.
+size_t sc_message_mpsc_queue_pop_n(sc_message_mpsc_queue_t *queue, message_t **msgs, size_t max) {
+  return sc_mpsc_queue_pop_n(queue, (void **) msgs, max);
+}
+
+// Passes every message in the queue at the time of the call to fn.
+// @param queue Pointer to the queue (must not be NULL).
+// @param fn Callback taking ownership of each message (must not be NULL).
+// @param user_data Optional user data passed to fn.
+// @return Number of messages passed to fn.
+size_t sc_message_mpsc_queue_drain(sc_message_mpsc_queue_t *queue, sc_message_queue_drain_fn fn,
+                                   void *user_data) {
+  if (fn == NULL) {
+    return sc_mpsc_queue_drain(queue, NULL, NULL);
+  }
+  drain_t drain = {.fn = fn, .user_data = user_data};
+  return sc_mpsc_queue_drain(queue, drain_message, &drain);
+}
+
+// Checks if the queue is empty (thread-safe).
+// @param queue Pointer to the queue.
+// @return true if the queue is empty, false otherwise.
+bool sc_message_mpsc_queue_is_empty(const sc_message_mpsc_queue_t *queue) {
+  return sc_mpsc_queue_is_empty(queue);
+}
+
+// Checks if the queue is full (thread-safe).
+// @param queue Pointer to the queue.
+// @return true if the queue is full, false otherwise.
+bool sc_message_mpsc_queue_is_full(const sc_message_mpsc_queue_t *queue) {
+  return sc_mpsc_queue_is_full(queue);
+}
+
+// Gets the current number of messages in the queue (thread-safe).
+// @param queue Pointer to the queue.
+// @return Number of messages currently in the queue, or 0 on error.
+size_t sc_message_mpsc_queue_size(const sc_message_mpsc_queue_t *queue) {
+  return sc_mpsc_queue_get_size(queue);
+}
@@ -3,8 +3,11 @@
 
 #include "generic_queue.h"
 #include "message.h" // Include message.h for the Message type
+#include "mpsc_queue.h"
+#include "spsc_queue.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 // Return codes for message queue operations (matches sc_generic_queue_ret_val_t)
 typedef enum {
@@ -22,6 +25,15 @@ typedef enum {
 // Type alias for message queue (using generic queue internally)
 typedef sc_generic_queue_t sc_message_queue_t;
 
+// Message queue for one producer and one consumer (using spsc queue internally)
+typedef sc_spsc_queue_t sc_message_spsc_queue_t;
+
+// Message queue for any number of producers and one consumer (using mpsc queue internally)
+typedef sc_mpsc_queue_t sc_message_mpsc_queue_t;
+
+// Callback for the drain functions; takes ownership of msg
+typedef void (*sc_message_queue_drain_fn)(message_t *msg, void *user_data);
+
 // ============================================================================
 // Queue Lifecycle Functions
 // ============================================================================
@@ -56,6 +68,30 @@ sc_message_queue_ret_val_t sc_message_queue_pop(sc_message_queue_t *queue, messa
 // The message pointer is set in the msg output parameter
 sc_message_queue_ret_val_t sc_message_queue_try_pop(sc_message_queue_t *queue, message_t **msg);
 
+// Add a message, blocking while full until deadline_ns, an absolute
+// CLOCK_MONOTONIC time in nanoseconds (see sc_queue_deadline())
+// Returns: SC_MESSAGE_QUEUE_SUCCESS, or SC_MESSAGE_QUEUE_ERR_TIMEOUT once it passes
+sc_message_queue_ret_val_t sc_message_queue_add_until(sc_message_queue_t *queue, message_t *msg,
+                                                      uint64_t deadline_ns);
+
+// Remove a message, blocking while empty until deadline_ns
+// Returns: SC_MESSAGE_QUEUE_SUCCESS, or SC_MESSAGE_QUEUE_ERR_TIMEOUT once it passes
+sc_message_queue_ret_val_t sc_message_queue_pop_until(sc_message_queue_t *queue, message_t **msg,
+                                                      uint64_t deadline_ns);
+
+// Add as many of count messages as fit (non-blocking, one synchronization step)
+// Returns: Number of messages added, from the start of msgs
+size_t sc_message_queue_add_n(sc_message_queue_t *queue, message_t *const *msgs, size_t count);
+
+// Remove up to max messages, oldest first (non-blocking, one synchronization step)
+// Returns: Number of messages stored in msgs
+size_t sc_message_queue_pop_n(sc_message_queue_t *queue, message_t **msgs, size_t max);
+
+// Pass every message in the queue at the time of the call to fn, oldest first
+// Returns: Number of messages passed to fn
+size_t sc_message_queue_drain(sc_message_queue_t *queue, sc_message_queue_drain_fn fn,
+                              void *user_data);
+
 // ============================================================================
 // Queue Status Functions
 // ============================================================================
@@ -72,4 +108,61 @@ bool sc_message_queue_is_full(const sc_message_queue_t *queue);
 // Returns: Number of messages currently in the queue
 size_t sc_message_queue_size(const sc_message_queue_t *queue);
 
+// ============================================================================
+// Single-Producer Single-Consumer Message Queue
+// ============================================================================
+// Same operations as sc_message_queue_*; only one thread may add and
+// one thread may pop
+
+sc_message_spsc_queue_t *sc_message_spsc_queue_init(size_t capacity);
+sc_generic_queue_ret_val_t sc_message_spsc_queue_nuke(sc_message_spsc_queue_t *queue);
+sc_message_queue_ret_val_t sc_message_spsc_queue_add(sc_message_spsc_queue_t *queue,
+                                                     message_t *msg);
+sc_message_queue_ret_val_t sc_message_spsc_queue_try_add(sc_message_spsc_queue_t *queue,
+                                                         message_t *msg);
+sc_message_queue_ret_val_t sc_message_spsc_queue_pop(sc_message_spsc_queue_t *queue,
+                                                     message_t **msg);
+sc_message_queue_ret_val_t sc_message_spsc_queue_try_pop(sc_message_spsc_queue_t *queue,
+                                                         message_t **msg);
+sc_message_queue_ret_val_t sc_message_spsc_queue_add_until(sc_message_spsc_queue_t *queue,
+                                                           message_t *msg, uint64_t deadline_ns);
+sc_message_queue_ret_val_t sc_message_spsc_queue_pop_until(sc_message_spsc_queue_t *queue,
+                                                           message_t **msg, uint64_t deadline_ns);
+size_t sc_message_spsc_queue_add_n(sc_message_spsc_queue_t *queue, message_t *const *msgs,
+                                 size_t count);
+size_t sc_message_spsc_queue_pop_n(sc_message_spsc_queue_t *queue, message_t **msgs, size_t max);
+size_t sc_message_spsc_queue_drain(sc_message_spsc_queue_t *queue, sc_message_queue_drain_fn fn,
+                                 void *user_data);
+bool sc_message_spsc_queue_is_empty(const sc_message_spsc_queue_t *queue);
+bool sc_message_spsc_queue_is_full(const sc_message_spsc_queue_t *queue);
+size_t sc_message_spsc_queue_size(const sc_message_spsc_queue_t *queue);
+
+// ============================================================================
+// Multi-Producer Single-Consumer Message Queue
+// ============================================================================
+// Same operations as sc_message_queue_*; only one thread may pop
+
+sc_message_mpsc_queue_t *sc_message_mpsc_queue_init(size_t capacity);
+sc_generic_queue_ret_val_t sc_message_mpsc_queue_nuke(sc_message_mpsc_queue_t *queue);
+sc_message_queue_ret_val_t sc_message_mpsc_queue_add(sc_message_mpsc_queue_t *queue,
+                                                     message_t *msg);
+sc_message_queue_ret_val_t sc_message_mpsc_queue_try_add(sc_message_mpsc_queue_t *queue,
+                                                         message_t *msg);
+sc_message_queue_ret_val_t sc_message_mpsc_queue_pop(sc_message_mpsc_queue_t *queue,
+                                                     message_t **msg);
+sc_message_queue_ret_val_t sc_message_mpsc_queue_try_pop(sc_message_mpsc_queue_t *queue,
+                                                         message_t **msg);
+sc_message_queue_ret_val_t sc_message_mpsc_queue_add_until(sc_message_mpsc_queue_t *queue,
+                                                           message_t *msg, uint64_t deadline_ns);
+sc_message_queue_ret_val_t sc_message_mpsc_queue_pop_until(sc_message_mpsc_queue_t *queue,
+                                                           message_t **msg, uint64_t deadline_ns);
+size_t sc_message_mpsc_queue_add_n(sc_message_mpsc_queue_t *queue, message_t *const *msgs,
+                                 size_t count);
+size_t sc_message_mpsc_queue_pop_n(sc_message_mpsc_queue_t *queue, message_t **msgs, size_t max);
+size_t sc_message_mpsc_queue_drain(sc_message_mpsc_queue_t *queue, sc_message_queue_drain_fn fn,
+                                 void *user_data);
+bool sc_message_mpsc_queue_is_empty(const sc_message_mpsc_queue_t *queue);
+bool sc_message_mpsc_queue_is_full(const sc_message_mpsc_queue_t *queue);
+size_t sc_message_mpsc_queue_size(const sc_message_mpsc_queue_t *queue);
+
 #endif // MESSAGE_QUEUE_H
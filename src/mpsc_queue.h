@@ -0,0 +1,104 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "generic_queue.h"
+#include "queue_wait.h"
+
+// Bounded multi-producer single-consumer queue of void pointers. Any number
+// of threads add; exactly one thread removes; any thread may query the status.
+// Producers claim slots exactly as in generic_queue.h (a compare-and-swap on
+// tail, then a release store of the slot's sequence), so adding is lock-free.
+// The lone consumer never contends for head: a pop checks the slot's
+// sequence, takes the item and stores the new head, with no compare-and-swap.
+//
+// Return codes, timeouts and the capacity limit are those of generic_queue.h;
+// blocking adds and pops wait as described in queue_wait.h.
+
+// ============================================================================
+// Type Definitions
+// ============================================================================
+
+typedef struct {
+  alignas(SC_GENERIC_QUEUE_CACHE_LINE) _Atomic size_t tail; // Next position to add at
+  alignas(SC_GENERIC_QUEUE_CACHE_LINE) _Atomic size_t head; // Next position to remove from
+  alignas(SC_GENERIC_QUEUE_CACHE_LINE) sc_generic_queue_slot_t *slots; // Ring, mask + 1 slots
+  size_t mask;               // Ring size - 1; capacity rounded up to a power of two
+  size_t capacity;           // Maximum number of items
+  sc_queue_wait_t not_empty; // Consumer blocked in sc_mpsc_queue_pop()
+  sc_queue_wait_t not_full;  // Producers blocked in sc_mpsc_queue_add()
+} sc_mpsc_queue_t;
+
+// ============================================================================
+// Lifecycle Functions
+// ============================================================================
+
+// Create a queue
+// Parameters:
+//   capacity: Most items the queue holds (1 to SC_GENERIC_QUEUE_MAX_CAPACITY)
+// Returns: Pointer to the queue, or NULL on invalid capacity or allocation failure
+sc_mpsc_queue_t *sc_mpsc_queue_init(size_t capacity);
+
+// Destroy a queue; items still in it are not touched
+// Returns: SC_GENERIC_QUEUE_SUCCESS, or SC_GENERIC_QUEUE_ERR_NULL for a NULL queue
+sc_generic_queue_ret_val_t sc_mpsc_queue_nuke(sc_mpsc_queue_t *q);
+
+// Destroy a queue, passing each item still in it to cleanup_fn (may be NULL)
+void sc_mpsc_queue_nuke_with_cleanup(sc_mpsc_queue_t *q, sc_generic_queue_cleanup_fn cleanup_fn,
+                                     void *user_data);
+
+// ============================================================================
+// Queue Operations
+// ============================================================================
+
+// Add an item, blocking up to SC_GENERIC_QUEUE_ADD_TIMEOUT_NS while full
+sc_generic_queue_ret_val_t sc_mpsc_queue_add(sc_mpsc_queue_t *q, void *item);
+
+// Consumer only: remove the oldest item, blocking up to SC_GENERIC_QUEUE_POP_TIMEOUT_NS
+// while empty
+sc_generic_queue_ret_val_t sc_mpsc_queue_pop(sc_mpsc_queue_t *q, void **item);
+
+// Add an item, blocking while full until deadline_ns, an absolute
+// CLOCK_MONOTONIC time (see sc_queue_deadline())
+// Returns: SC_GENERIC_QUEUE_SUCCESS, or SC_GENERIC_QUEUE_ERR_TIMEOUT once it passes
+sc_generic_queue_ret_val_t sc_mpsc_queue_add_until(sc_mpsc_queue_t *q, void *item,
+                                                  uint64_t deadline_ns);
+
+// Consumer only: remove the oldest item, blocking while empty until deadline_ns
+// Returns: SC_GENERIC_QUEUE_SUCCESS, or SC_GENERIC_QUEUE_ERR_TIMEOUT once it passes
+sc_generic_queue_ret_val_t sc_mpsc_queue_pop_until(sc_mpsc_queue_t *q, void **item,
+                                                  uint64_t deadline_ns);
+
+// Add an item, or fail with SC_GENERIC_QUEUE_ERR_FULL
+sc_generic_queue_ret_val_t sc_mpsc_queue_try_add(sc_mpsc_queue_t *q, void *item);
+
+// Consumer only: remove the oldest item, or fail with SC_GENERIC_QUEUE_ERR_EMPTY
+sc_generic_queue_ret_val_t sc_mpsc_queue_try_pop(sc_mpsc_queue_t *q, void **item);
+
+// Add as many of count items as fit, without blocking
+// Returns: Number of items added, from the start of items
+size_t sc_mpsc_queue_add_n(sc_mpsc_queue_t *q, void *const *items, size_t count);
+
+// Consumer only: remove up to max items, oldest first, without blocking
+// Returns: Number of items stored in items
+size_t sc_mpsc_queue_pop_n(sc_mpsc_queue_t *q, void **items, size_t max);
+
+// Consumer only: pass every item in the queue at the time of the call to fn,
+// oldest first
+// Returns: Number of items passed to fn
+size_t sc_mpsc_queue_drain(sc_mpsc_queue_t *q, sc_generic_queue_item_fn fn, void *user_data);
+
+// ============================================================================
+// Queue Status Functions
+// ============================================================================
+
+bool sc_mpsc_queue_is_empty(const sc_mpsc_queue_t *q);
+bool sc_mpsc_queue_is_full(const sc_mpsc_queue_t *q);
+size_t sc_mpsc_queue_get_size(const sc_mpsc_queue_t *q);
+
+#endif // MPSC_QUEUE_H
@@ -108,4 +108,14 @@ static inline bool sc_sub_overflow_size_t(size_t a, size_t b, size_t *result) {
 #define SC_CONST_FUNC
 #endif
 
+// Busy-wait hint: lets the core know it is spinning, which saves power and
+// frees the sibling hyperthread
+#if defined(__x86_64__) || defined(__i386__)
+#define SC_CPU_RELAX() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define SC_CPU_RELAX() __asm__ __volatile__("yield" ::: "memory")
+#else
+#define SC_CPU_RELAX() ((void) 0)
+#endif
+
 #endif // PORTABILITY_H
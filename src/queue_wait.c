@@ -0,0 +1,164 @@
+#include <errno.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "queue_wait.h"
+#include "portability.h"
+
+// Retries every wait spins through, however short recent spins were
+#define SPIN_MIN 16
+
+// Retries no wait spins past; a few microseconds, well under a futex round trip
+#define SPIN_MAX 1024
+
+// ============================================================================
+// Internal Helper Functions
+// ============================================================================
+
+// Parks the calling thread while *word still holds expected
+// @param word Futex word
+// @param expected Value *word held when the caller last looked
+// @param deadline_ns Absolute CLOCK_MONOTONIC time to give up at
+// @return 0 when woken, or -1 with errno ETIMEDOUT, EAGAIN (word changed) or EINTR
+static long futex_wait(_Atomic uint32_t *word, uint32_t expected, uint64_t deadline_ns) {
+  // FUTEX_WAIT_BITSET takes an absolute CLOCK_MONOTONIC timeout, unlike FUTEX_WAIT
+  struct timespec deadline;
+  struct timespec *timeout = NULL;
+  if (deadline_ns != SC_QUEUE_WAIT_FOREVER) {
+    deadline.tv_sec  = (time_t) (deadline_ns / SC_QUEUE_NS_PER_SEC);
+    deadline.tv_nsec = (long) (deadline_ns % SC_QUEUE_NS_PER_SEC);
+    timeout          = &deadline;
+  }
+  return syscall(SYS_futex, word, FUTEX_WAIT_BITSET_PRIVATE, expected, timeout, NULL,
+                 FUTEX_BITSET_MATCH_ANY);
+}
+
+// Wakes up to count threads parked on word
+static void futex_wake(_Atomic uint32_t *word, int count) {
+  syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, count);
+}
+
+// Retries an operation a bounded number of times before the caller parks
+// The bound adapts like an adaptive mutex: twice what recent successful spins
+// needed, so a queue whose waits end quickly keeps spinning and one whose
+// waits end in the futex soon spins only SPIN_MIN times.
+// @param wait Wait whose history bounds the spin
+// @param attempt Non-blocking form of the operation
+// @param ctx Passed to attempt
+// @return true if attempt succeeded
+static bool spin(sc_queue_wait_t *wait, sc_queue_attempt_fn attempt, void *ctx) {
+  if (wait->spin_limit == 0) {
+    return false;
+  }
+
+  uint32_t estimate = atomic_load_explicit(&wait->spin, memory_order_relaxed);
+  uint32_t limit    = estimate * 2 + SPIN_MIN;
+  if (limit > wait->spin_limit) {
+    limit = wait->spin_limit;
+  }
+
+  for (uint32_t i = 0; i < limit; i++) {
+    SC_CPU_RELAX();
+    if (attempt(ctx)) {
+      // Move an eighth of the way towards what this spin needed
+      int32_t step = ((int32_t) i - (int32_t) estimate) / 8;
+      atomic_store_explicit(&wait->spin, (uint32_t) ((int32_t) estimate + step),
+                            memory_order_relaxed);
+      return true;
+    }
+  }
+  atomic_store_explicit(&wait->spin, estimate / 2, memory_order_relaxed);
+  return false;
+}
+
+// ============================================================================
+// Lifecycle Functions
+// ============================================================================
+
+// Initializes a wait in place
+// Spinning is left off on a single CPU, where the thread that would end the
+// spin cannot run until the spinner gives up its time slice.
+// @param wait Wait to initialize
+void sc_queue_wait_init(sc_queue_wait_t *wait) {
+  atomic_init(&wait->epoch, 0);
+  atomic_init(&wait->waiters, 0);
+  atomic_init(&wait->spin, 0);
+  wait->spin_limit = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? SPIN_MAX : 0;
+}
+
+// ============================================================================
+// Operations
+// ============================================================================
+
+// Computes a deadline
+// @param timeout_ns Nanoseconds from now
+// @return Absolute CLOCK_MONOTONIC time in nanoseconds, saturated to SC_QUEUE_WAIT_FOREVER
+uint64_t sc_queue_deadline(uint64_t timeout_ns) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  uint64_t now = (uint64_t) ts.tv_sec * SC_QUEUE_NS_PER_SEC + (uint64_t) ts.tv_nsec;
+  return timeout_ns > SC_QUEUE_WAIT_FOREVER - now ? SC_QUEUE_WAIT_FOREVER : now + timeout_ns;
+}
+
+// Blocks until an operation succeeds or a deadline passes
+// The waiter is counted before its first retry, and the fence after counting
+// pairs with the one in sc_queue_wake(): either the retry sees what the waking
+// thread's operation changed, or the waking thread sees the waiter and bumps
+// the epoch. The epoch is read before each retry, so a bump that lands after
+// the read makes the futex wait return at once instead of sleeping through it.
+// @param wait Wait to block in
+// @param attempt Non-blocking form of the operation
+// @param ctx Passed to attempt
+// @param deadline_ns Absolute CLOCK_MONOTONIC time to give up at
+// @return true once attempt succeeded, false if the deadline passed first
+bool sc_queue_wait(sc_queue_wait_t *wait, sc_queue_attempt_fn attempt, void *ctx,
+                   uint64_t deadline_ns) {
+  if (spin(wait, attempt, ctx)) {
+    return true;
+  }
+
+  atomic_fetch_add_explicit(&wait->waiters, 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+
+  bool done = false;
+  for (;;) {
+    uint32_t epoch = atomic_load_explicit(&wait->epoch, memory_order_acquire);
+    if (attempt(ctx)) {
+      done = true;
+      break;
+    }
+    if (futex_wait(&wait->epoch, epoch, deadline_ns) != 0 && errno == ETIMEDOUT) {
+      // One last look, so an item that arrived with the deadline is not missed
+      done = attempt(ctx);
+      break;
+    }
+  }
+
+  atomic_fetch_sub_explicit(&wait->waiters, 1, memory_order_relaxed);
+  return done;
+}
+
+// Wakes one parked thread, if any thread is parked at all
+// @param wait Wait to wake
+void sc_queue_wake(sc_queue_wait_t *wait) {
+  atomic_thread_fence(memory_order_seq_cst);
+  if (atomic_load_explicit(&wait->waiters, memory_order_relaxed) == 0) {
+    return;
+  }
+  atomic_fetch_add_explicit(&wait->epoch, 1, memory_order_release);
+  futex_wake(&wait->epoch, 1);
+}
+
+// Wakes every parked thread, if any thread is parked at all
+// @param wait Wait to wake
+void sc_queue_wake_all(sc_queue_wait_t *wait) {
+  atomic_thread_fence(memory_order_seq_cst);
+  if (atomic_load_explicit(&wait->waiters, memory_order_relaxed) == 0) {
+    return;
+  }
+  atomic_fetch_add_explicit(&wait->epoch, 1, memory_order_release);
+  futex_wake(&wait->epoch, INT_MAX);
+}
@@ -0,0 +1,77 @@
+#ifndef QUEUE_WAIT_H
+#define QUEUE_WAIT_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Blocking for the lock-free queues (generic_queue, spsc_queue, mpsc_queue).
+// The queues never lock to add or remove; a thread only comes here once a
+// non-blocking attempt found its queue full or empty. It first spins,
+// retrying, for about as long as recent waits on the same queue needed, so a
+// handoff between two busy threads never enters the kernel. If that fails it
+// counts itself as a waiter and parks on a futex until another thread's
+// operation wakes it or its deadline passes.
+//
+// Deadlines are absolute CLOCK_MONOTONIC times in nanoseconds, so a caller
+// can wait until the end of its tick and wall-clock changes neither stretch
+// nor cut a wait short. Waking is a fence and a load while nobody is parked;
+// no lock is taken on either side.
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+#define SC_QUEUE_WAIT_FOREVER UINT64_MAX    // Deadline that never passes
+#define SC_QUEUE_NS_PER_MS    1000000ull    // For building deadlines
+#define SC_QUEUE_NS_PER_SEC   1000000000ull // For building deadlines
+
+// ============================================================================
+// Type Definitions
+// ============================================================================
+
+typedef struct {
+  _Atomic uint32_t epoch;   // Futex word; bumped by every wake that finds a waiter
+  _Atomic uint32_t waiters; // Threads parked in sc_queue_wait()
+  _Atomic uint32_t spin;    // Retries recent successful spins needed, averaged
+  uint32_t spin_limit;      // Most retries to spin through; 0 on a single CPU
+} sc_queue_wait_t;
+
+// Retries a queue operation; true once it has succeeded
+typedef bool (*sc_queue_attempt_fn)(void *ctx);
+
+// ============================================================================
+// Lifecycle Functions
+// ============================================================================
+
+// Initialize a wait in place; there is nothing to destroy
+void sc_queue_wait_init(sc_queue_wait_t *wait);
+
+// ============================================================================
+// Operations
+// ============================================================================
+
+// Deadline timeout_ns nanoseconds from now
+// Returns: Absolute CLOCK_MONOTONIC time in nanoseconds, or
+//          SC_QUEUE_WAIT_FOREVER if that is out of range
+uint64_t sc_queue_deadline(uint64_t timeout_ns);
+
+// Block until attempt(ctx) succeeds or the deadline passes
+// Parameters:
+//   wait: Wait the operation that lets attempt succeed will wake
+//   attempt: Non-blocking form of the operation
+//   ctx: Passed to attempt
+//   deadline_ns: Absolute CLOCK_MONOTONIC time, see sc_queue_deadline()
+// Returns: true once attempt succeeded, false if the deadline passed first
+bool sc_queue_wait(sc_queue_wait_t *wait, sc_queue_attempt_fn attempt, void *ctx,
+                   uint64_t deadline_ns);
+
+// Wake one thread parked in sc_queue_wait(), if any; call after every
+// operation that may let a blocked thread's attempt succeed
+void sc_queue_wake(sc_queue_wait_t *wait);
+
+// Wake every thread parked in sc_queue_wait(), if any; call instead of
+// sc_queue_wake() after an operation that may let several attempts succeed
+void sc_queue_wake_all(sc_queue_wait_t *wait);
+
+#endif // QUEUE_WAIT_H
@@ -3,13 +3,19 @@
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
+#include <endian.h>
 #include <signal.h>
+#include <pthread.h>
+#include <poll.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <linux/filter.h>
 #include <fcntl.h>
+#include <inttypes.h>
 #include <time.h>
 
 #include "config.h"
@@ -17,114 +23,948 @@
 #include "message.h"
 #include "server.h"
 #include "dtls.h"
+#include "egress.h"
+#include "handshake_pool.h"
+#include "ingress.h"
+#include "mailbox.h"
+#include "session_table.h"
+#include "slab.h"
+#include "timer_wheel.h"
+#ifdef SC_HAVE_IO_URING
+#include "uring.h"
+#endif
 
 // Implementation files now compiled separately
 
+// Always bind to all interfaces
+#define SERVER_BIND_ADDRESS "0.0.0.0"
+
+// Room a handshake step has for the datagrams DTLS sends while handling it; a
+// server flight with its certificate chain fits comfortably
+#define HANDSHAKE_OUTBOX_SIZE      (16 * 1024)
+#define HANDSHAKE_OUTBOX_DATAGRAMS 16
+
+// A client's id is its slot index above a per-shard generation, so a reused
+// slot never answers to an old id. The id, after the shard's, is the client's
+// DTLS connection ID.
+#define CLIENT_GENERATION_BITS  24
+#define CLIENT_GENERATION_LIMIT ((1u << CLIENT_GENERATION_BITS) - 1)
+
+#if SERVER_MAX_SHARDS > 256
+#error "Shard ids must fit the first byte of a connection ID"
+#endif
+
+// I/O engine driving each shard's socket
+typedef enum {
+  SERVER_IO_EPOLL, // Edge-triggered epoll with recvmmsg batches and sendmmsg flushes
+  SERVER_IO_URING  // Multishot io_uring receives and batched io_uring sends
+} server_io_t;
+
+// A game worker runs game logic on decoded messages. It knows nothing of
+// sockets or DTLS: messages arrive in its inbox from the shards and replies go
+// back to the shard that owns the client.
+typedef struct {
+  size_t id;
+  pthread_t thread;
+  bool running;
+  sc_mailbox_t *inbox; // Messages from every shard
+  int shutdown_fd;     // Readable once the server stops
+  uint64_t handled;    // Messages processed, read after the thread is joined
+  bool failed;         // Stopped on an error, read after the thread is joined
+} game_worker_t;
+
+// A shard owns one SO_REUSEPORT socket, the I/O loop and thread that drain
+// it, and every piece of state for the clients the kernel steers to it. It is
+// the network worker for those clients: their DTLS sessions are decrypted and
+// encrypted only here. Shards share nothing, so no locking is needed on the
+// datagram path.
+typedef struct server_shard {
+  size_t id;
+  int sock;
+  pthread_t thread;
+  void *(*run)(void *); // Thread function for the shard's I/O engine
+  dtls_context_t *dtls_ctx;
+  int epoll_fd;          // SERVER_IO_EPOLL only
+  sc_ingress_t *ingress; // SERVER_IO_EPOLL only
+  sc_egress_t *egress;   // SERVER_IO_EPOLL only
+#ifdef SC_HAVE_IO_URING
+  sc_uring_t *uring; // SERVER_IO_URING only
+#endif
+  sc_session_table_t *clients;         // Client sessions keyed by address and port
+  sc_timer_wheel_t *timers;            // Per-client deadlines
+  sc_slab_t *client_pool;              // Storage for this shard's client sessions
+  uint32_t generation;                 // Generation of the last client id handed out
+  uint64_t migrations;                 // Clients that moved to a new address
+  uint64_t stale_moves;                // Older records from another address, not moved for
+  sc_handshake_pool_t *handshakes;     // Crypto threads shared by all shards, NULL for inline
+  sc_handshake_port_t *handshake_port; // Where this shard's handshake steps come back
+  sc_slab_t *handshake_steps;          // Storage for handshake steps queued or running
+  game_worker_t *game_workers;         // Game workers shared by all shards, NULL for inline
+  size_t game_worker_count;
+  sc_slab_t *messages;                 // Storage for messages out with the game workers
+  sc_mailbox_t *replies;               // Where game workers return processed messages
+  uint64_t messages_routed;            // Messages handed to a game worker
+  uint64_t messages_dropped;           // Messages lost to a full inbox or message slab
+} server_shard_t;
+
+typedef struct handshake_step handshake_step_t;
+
 // Client session structure
 typedef struct client_session {
+  server_shard_t *shard; // Shard the client's datagrams arrive on
+  uint64_t id;           // Slot index and generation, 0 while the slot is free
   struct sockaddr_in addr;
   socklen_t addr_len;
   dtls_session_t *dtls_session;
-  time_t last_activity;
+  sc_timer_t idle_timer;       // Fires after CLIENT_TIMEOUT_SECONDS without traffic
+  sc_timer_t retransmit_timer; // Fires when DTLS wants its last handshake flight resent
   bool handshake_complete;
-  struct client_session *next;
+  handshake_step_t *handshake_step;  // Step on the crypto pool, which owns dtls_session meanwhile
+  handshake_step_t *handshake_queue; // Datagrams that arrived while that step ran
+  bool closing;                      // Removed while a step ran; destroyed when it returns
 } client_session_t;
 
-// Global variables
-static volatile sig_atomic_t g_running = 1;
-static client_session_t *g_clients     = NULL;
-static dtls_context_t *g_dtls_ctx      = NULL;
+// A handshake datagram on its way through the crypto pool, and the datagrams
+// DTLS sent while handling it, which the shard puts on the wire
+struct handshake_step {
+  sc_handshake_job_t job; // Must be first; the pool hands back this pointer
+  client_session_t *client;
+  handshake_step_t *next; // Next datagram in the client's queue
+  bool fed;               // The session accepted the datagram
+  dtls_result_t result;   // What sc_dtls_handshake() returned
+  size_t len;
+  uint8_t datagram[SOCKET_BUFFER_SIZE];
+  size_t outbox_count;
+  size_t outbox_used;
+  size_t outbox_lens[HANDSHAKE_OUTBOX_DATAGRAMS];
+  uint8_t outbox[HANDSHAKE_OUTBOX_SIZE];
+};
+
+// A decoded application message on its way from the shard that owns the
+// client to a game worker, and back as the reply the shard encrypts
+typedef struct {
+  message_t msg;         // Must be first; mailboxes carry this pointer
+  server_shard_t *shard; // Shard owning the client's DTLS session
+  uint64_t client_id;    // Id of the client, which survives an address change
+  size_t len;            // Bytes in data, header included
+  uint8_t data[SOCKET_BUFFER_SIZE];
+} net_message_t;
+
+static void remove_client(client_session_t *client);
+static bool handshake_result(client_session_t *client, dtls_result_t result);
+
+// Timer callback: drop a client that has been silent for too long
+static void client_idle_expired(sc_timer_t *timer, void *data) {
+  (void) timer;
+  log_warn("%s", "Client timeout - removing inactive client");
+  remove_client(data);
+}
+
+// Timer callback: resend a handshake flight the client has not answered
+static void client_retransmit_expired(sc_timer_t *timer, void *data) {
+  (void) timer;
+  client_session_t *client = data;
+  // A step on the crypto pool owns the session; its result re-arms the timer
+  if (client->handshake_step) {
+    return;
+  }
+  handshake_result(client, sc_dtls_handle_timeout(client->dtls_session));
+}
+
+// Arm the client's retransmission timer at the deadline DTLS asked for, or
+// disarm it when no handshake flight is waiting for an answer
+static void schedule_retransmit(client_session_t *client) {
+  uint64_t deadline = 0;
+  if (!client->handshake_complete) {
+    deadline = sc_dtls_session_timeout_ms(client->dtls_session);
+  }
+
+  if (deadline == 0) {
+    sc_timer_wheel_cancel(client->shard->timers, &client->retransmit_timer);
+  } else {
+    sc_timer_wheel_schedule(client->shard->timers, &client->retransmit_timer, deadline);
+  }
+}
 
-// Signal handler for graceful shutdown
-static void handle_shutdown(int sig) {
-  (void) sig;
-  g_running = 0;
+// Push a client's inactivity deadline out after it was heard from
+static void touch_client(client_session_t *client, uint64_t now_ms) {
+  sc_timer_wheel_schedule(client->shard->timers, &client->idle_timer,
+                          now_ms + (uint64_t) CLIENT_TIMEOUT_SECONDS * 1000);
 }
 
 // Find client session by address
-static client_session_t *find_client(const struct sockaddr_in *addr) {
-  client_session_t *client = g_clients;
-  while (client) {
-    if (client->addr.sin_addr.s_addr == addr->sin_addr.s_addr &&
-        client->addr.sin_port == addr->sin_port) {
-      return client;
-    }
-    client = client->next;
+static client_session_t *find_client(server_shard_t *shard, const struct sockaddr_in *addr) {
+  return sc_session_table_get(shard->clients, sc_session_table_key(addr));
+}
+
+// Find a connected client by the id add_client() gave it
+static client_session_t *find_client_by_id(server_shard_t *shard, uint64_t id) {
+  client_session_t *client =
+    sc_slab_slot(shard->client_pool, (size_t) (id >> CLIENT_GENERATION_BITS));
+  return client && client->id == id && !client->closing ? client : NULL;
+}
+
+// Find the established client named by the connection ID a datagram carries
+// The ID is unauthenticated; the caller must not trust it until a record of
+// the datagram decrypts in the client's session.
+static client_session_t *find_client_by_cid(server_shard_t *shard,
+                                            const sc_ingress_packet_t *packet) {
+  const uint8_t *cid = sc_dtls_record_cid(packet->data, packet->len);
+  if (!cid || cid[0] != shard->id) {
+    return NULL;
   }
-  return NULL;
+
+  uint64_t id = 0;
+  for (size_t i = 1; i < DTLS_CID_LEN; i++) {
+    id = id << 8 | cid[i];
+  }
+  client_session_t *client = find_client_by_id(shard, id);
+  return client && client->handshake_complete ? client : NULL;
+}
+
+// Give a new client its id and the connection ID built from it
+// Returns: 0 on success, -1 if the DTLS session refused the connection ID
+static int assign_client_id(client_session_t *client) {
+  server_shard_t *shard = client->shard;
+  shard->generation     = shard->generation % CLIENT_GENERATION_LIMIT + 1;
+  client->id = (uint64_t) sc_slab_index(shard->client_pool, client) << CLIENT_GENERATION_BITS |
+               shard->generation;
+
+  uint8_t cid[DTLS_CID_LEN];
+  cid[0] = (uint8_t) shard->id;
+  for (size_t i = 1; i < DTLS_CID_LEN; i++) {
+    cid[i] = (uint8_t) (client->id >> (8 * (DTLS_CID_LEN - 1 - i)));
+  }
+  return sc_dtls_session_set_cid(client->dtls_session, cid) == DTLS_OK ? 0 : -1;
 }
 
 // Add new client session
-static client_session_t *add_client(const struct sockaddr_in *addr, socklen_t addr_len, int sock) {
-  client_session_t *client = calloc(1, sizeof(client_session_t));
+static client_session_t *add_client(server_shard_t *shard, const struct sockaddr_in *addr,
+                                    socklen_t addr_len) {
+  client_session_t *client = sc_slab_alloc(shard->client_pool);
   if (!client) {
-    log_error("%s", "Failed to allocate client session");
+    log_warn("Shard %zu client limit of %zu reached, ignoring new client", shard->id,
+             shard->client_pool->capacity);
     return NULL;
   }
+  memset(client, 0, sizeof(client_session_t));
 
+  client->shard = shard;
   memcpy(&client->addr, addr, addr_len);
   client->addr_len           = addr_len;
-  client->last_activity      = time(NULL);
   client->handshake_complete = false;
+  sc_timer_init(&client->idle_timer, client_idle_expired, client);
+  sc_timer_init(&client->retransmit_timer, client_retransmit_expired, client);
 
   // Create DTLS session
   client->dtls_session =
-    sc_dtls_session_create(g_dtls_ctx, sock, (const struct sockaddr *) addr, addr_len);
+    sc_dtls_session_create(shard->dtls_ctx, shard->sock, (const struct sockaddr *) addr, addr_len);
   if (!client->dtls_session) {
     log_error("%s", "Failed to create DTLS session");
-    free(client);
+    sc_slab_free(shard->client_pool, client);
     return NULL;
   }
 
-  // Add to list
-  client->next = g_clients;
-  g_clients    = client;
+  if (assign_client_id(client) < 0) {
+    log_error("%s", "Failed to set DTLS connection ID");
+    client->id = 0;
+    sc_dtls_session_destroy(client->dtls_session);
+    sc_slab_free(shard->client_pool, client);
+    return NULL;
+  }
+
+  if (sc_session_table_put(shard->clients, sc_session_table_key(addr), client) < 0) {
+    log_error("Failed to track client session: %s", strerror(errno));
+    client->id = 0;
+    sc_dtls_session_destroy(client->dtls_session);
+    sc_slab_free(shard->client_pool, client);
+    return NULL;
+  }
 
   char addr_str[INET_ADDRSTRLEN];
   inet_ntop(AF_INET, &addr->sin_addr, addr_str, sizeof(addr_str));
-  log_info("New client connected from %s:%d", addr_str, ntohs(addr->sin_port));
+  log_info("New client connected from %s:%d (shard %zu)", addr_str, ntohs(addr->sin_port),
+           shard->id);
 
   return client;
 }
 
-// Remove client session
-static void remove_client(client_session_t *client) {
+// Free a client session that is no longer in the session table
+static void destroy_client(client_session_t *client) {
+  server_shard_t *shard = client->shard;
+  sc_timer_wheel_cancel(shard->timers, &client->idle_timer);
+  sc_timer_wheel_cancel(shard->timers, &client->retransmit_timer);
+
   char addr_str[INET_ADDRSTRLEN];
   inet_ntop(AF_INET, &client->addr.sin_addr, addr_str, sizeof(addr_str));
   log_info("Client disconnected: %s:%d", addr_str, ntohs(client->addr.sin_port));
 
-  // Remove from list
-  client_session_t **pp = &g_clients;
-  while (*pp && *pp != client) {
-    pp = &(*pp)->next;
-  }
-  if (*pp) {
-    *pp = client->next;
-  }
-
   // Clean up DTLS session
   if (client->dtls_session) {
     sc_dtls_close(client->dtls_session);
     sc_dtls_session_destroy(client->dtls_session);
   }
 
-  free(client);
+  // Replies and connection IDs still naming the client no longer find it
+  client->id = 0;
+  sc_slab_free(shard->client_pool, client);
 }
 
-// Check for inactive clients
-static void check_client_timeouts(void) {
-  time_t now               = time(NULL);
-  client_session_t *client = g_clients;
-  client_session_t *next;
+// Free the handshake datagrams a client still had waiting
+static void release_handshake_queue(client_session_t *client) {
+  while (client->handshake_queue) {
+    handshake_step_t *step  = client->handshake_queue;
+    client->handshake_queue = step->next;
+    sc_slab_free(client->shard->handshake_steps, step);
+  }
+}
+
+// Remove client session
+static void remove_client(client_session_t *client) {
+  sc_session_table_remove(client->shard->clients, sc_session_table_key(&client->addr));
+  release_handshake_queue(client);
+
+  if (client->handshake_step) {
+    // A crypto thread still holds the DTLS session; finish when its step returns
+    sc_timer_wheel_cancel(client->shard->timers, &client->idle_timer);
+    sc_timer_wheel_cancel(client->shard->timers, &client->retransmit_timer);
+    client->closing = true;
+    return;
+  }
+  destroy_client(client);
+}
+
+// Sweep callback: destroy every client during shutdown
+static bool evict_client(uint64_t key, void *value, void *user_data) {
+  (void) key;
+  (void) user_data;
+  destroy_client(value);
+  return true;
+}
+
+// Log ingress and egress batching statistics
+static void log_ingress_stats(const server_shard_t *shard) {
+#ifdef SC_HAVE_IO_URING
+  if (shard->uring) {
+    const sc_uring_stats_t *stats = sc_uring_stats(shard->uring);
+    log_info("Shard %zu io_uring: %" PRIu64 " datagrams in %" PRIu64 " batches (%" PRIu64
+             " truncated, %" PRIu64 " buffer stalls), %" PRIu64 " sent (%" PRIu64
+             " failed, %" PRIu64 " dropped), %" PRIu64 " system calls",
+             shard->id, stats->datagrams, stats->batches, stats->truncated, stats->no_buffers,
+             stats->sends, stats->send_errors, stats->send_dropped, stats->enters);
+    return;
+  }
+#endif
+  const sc_ingress_t *ingress = shard->ingress;
+  if (ingress) {
+    log_info("Shard %zu ingress: %" PRIu64 " datagrams in %" PRIu64
+             " batches (avg batch size %.2f, %" PRIu64 " coalesced by GRO, %" PRIu64
+             " truncated)",
+             shard->id, ingress->datagrams, ingress->batches, sc_ingress_avg_batch_size(ingress),
+             ingress->coalesced, ingress->truncated);
+  }
+
+  const sc_egress_t *egress = shard->egress;
+  if (egress) {
+    log_info("Shard %zu egress: %" PRIu64 " datagrams in %" PRIu64 " messages (%" PRIu64
+             " GSO) over %" PRIu64 " system calls (avg batch size %.2f, %" PRIu64
+             " failed, %" PRIu64 " dropped)",
+             shard->id, egress->datagrams, egress->messages, egress->gso_messages, egress->calls,
+             sc_egress_avg_batch_size(egress), egress->errors, egress->dropped);
+  }
+}
+
+// Log client slot usage
+static void log_client_stats(const server_shard_t *shard) {
+  const sc_slab_t *pool = shard->client_pool;
+  log_info("Shard %zu clients: %zu of %zu slots in use (peak %zu, %" PRIu64 " refused), %" PRIu64
+           " moved to a new address (%" PRIu64 " stale records ignored)",
+           shard->id, sc_slab_in_use(pool), pool->capacity, pool->high_water, pool->exhausted,
+           shard->migrations, shard->stale_moves);
+
+  const dtls_hello_stats_t *hellos = sc_dtls_context_hello_stats(shard->dtls_ctx);
+  log_info("Shard %zu hellos: %" PRIu64 " challenged, %" PRIu64 " verified, %" PRIu64 " dropped",
+           shard->id, hellos->challenged, hellos->verified, hellos->dropped);
+
+  dtls_ticket_stats_t tickets = sc_dtls_context_ticket_stats(shard->dtls_ctx);
+  log_info("Shard %zu tickets: %" PRIu64 " issued, %" PRIu64 " resumed, %" PRIu64 " rejected",
+           shard->id, tickets.issued, tickets.resumed, tickets.rejected);
+
+  // Sessions on the crypto pool belong to their step and are not counted
+  size_t handshaking       = 0;
+  size_t handshake_bytes   = 0;
+  size_t established       = 0;
+  size_t established_bytes = 0;
+  for (size_t i = 0; i < pool->capacity; i++) {
+    const client_session_t *client = sc_slab_slot(pool, i);
+    if (client->id == 0 || !client->dtls_session || client->handshake_step) {
+      continue;
+    }
+    dtls_memory_stats_t memory = sc_dtls_session_memory(client->dtls_session);
+    if (client->handshake_complete) {
+      established++;
+    } else {
+      handshaking++;
+    }
+    handshake_bytes += memory.handshake_bytes;
+    established_bytes += memory.established_bytes;
+  }
+  log_info("Shard %zu TLS memory: %zu handshaking and %zu established sessions hold %zu KiB of "
+           "handshake state and %zu KiB established",
+           shard->id, handshaking, established, handshake_bytes / 1024, established_bytes / 1024);
+
+  const dtls_cipher_ranking_t *ciphers = sc_dtls_cipher_ranking();
+  if (ciphers) {
+    log_info("Shard %zu cipher: %s (%.2f bytes/%s)", shard->id, ciphers->preferred_suite,
+             ciphers->rates[0].bytes_per_tick, ciphers->unit);
+  }
+}
+
+// Measure the record ciphers and log the order DTLS contexts will offer them in
+static void rank_ciphers(void) {
+  if (sc_dtls_rank_ciphers() != DTLS_OK) {
+    log_warn("%s", "Cipher self-benchmark failed, keeping the default cipher suite order");
+    return;
+  }
+
+  const dtls_cipher_ranking_t *ciphers = sc_dtls_cipher_ranking();
+  char rates[256];
+  size_t used = 0;
+  for (size_t i = 0; i < DTLS_CIPHER_COUNT && used < sizeof(rates); i++) {
+    int n = snprintf(rates + used, sizeof(rates) - used, "%s%s %.2f", i > 0 ? ", " : "",
+                     ciphers->rates[i].name, ciphers->rates[i].bytes_per_tick);
+    used += n > 0 ? (size_t) n : 0;
+  }
+  log_info("Record ciphers by throughput: %s bytes/%s", rates, ciphers->unit);
+  log_info("Preferred DTLS cipher suite: %s", ciphers->preferred_suite);
+}
+
+// Log crypto pool usage: queueing, latency from submit to collect, and CPU spent
+static void log_handshake_stats(const server_shard_t *shard) {
+  const sc_handshake_port_t *port = shard->handshake_port;
+  if (!port) {
+    return;
+  }
+
+  const sc_handshake_port_stats_t *stats = &port->stats;
+  log_info("Shard %zu handshakes: %" PRIu64 " steps, %zu in flight (peak %zu, %" PRIu64
+           " dropped), latency avg %.0f us max %" PRIu64 " us, %" PRIu64
+           " ms on crypto threads, pool queue %zu (peak %zu)",
+           shard->id, stats->completed, stats->in_flight, stats->peak_in_flight,
+           shard->handshake_steps->exhausted, sc_handshake_port_avg_latency_us(port),
+           stats->max_latency_ns / 1000, stats->work_ns / 1000000,
+           sc_handshake_pool_depth(shard->handshakes),
+           sc_handshake_pool_peak_depth(shard->handshakes));
+}
+
+// Log traffic between the shard and the game workers
+static void log_message_stats(const server_shard_t *shard) {
+  if (!shard->replies) {
+    return;
+  }
+
+  const sc_slab_t *messages = shard->messages;
+  log_info("Shard %zu messages: %" PRIu64 " routed to game workers, %" PRIu64
+           " replies, %zu in flight (peak %zu, %" PRIu64 " dropped)",
+           shard->id, shard->messages_routed, shard->replies->drained, sc_slab_in_use(messages),
+           messages->high_water, shard->messages_dropped);
+}
+
+// Write a reply to a client, removing the client on unrecoverable errors
+// Returns: true if the client is still connected, false if it was removed
+static bool client_write(client_session_t *client, const uint8_t *buf, size_t len) {
+  size_t bytes_written = 0;
+  dtls_result_t result = sc_dtls_write(client->dtls_session, buf, len, &bytes_written);
+  if (result != DTLS_OK && result != DTLS_ERROR_WOULD_BLOCK) {
+    log_error("DTLS write failed: %s", sc_dtls_error_string(result));
+    remove_client(client);
+    return false;
+  }
+  return true;
+}
+
+// Game logic for one protocol message, rewriting data in place as the reply
+// A PING becomes its PONG; other message types are echoed (for now).
+static void process_message(const message_t *msg, uint8_t *data) {
+  if (msg->header.message_type == MSG_PING) {
+    // Respond with PONG
+    message_header_t response;
+    response.protocol_version = htons(0x0001);
+    response.message_type     = htons(MSG_PONG);
+    response.sequence_number  = htonl(msg->header.sequence_number); // Keep same sequence
+    response.timestamp        = htobe64(msg->header.timestamp);     // Keep same timestamp
+    response.payload_length   = htons(msg->header.payload_length);  // Keep same payload length
+
+    // The payload stays as it is behind the new header
+    memcpy(data, &response, sizeof(message_header_t));
+  }
+}
+
+// Hand a decoded message to the game worker that serves the client
+// Every message of a client goes to the same worker, so they are processed in
+// the order they arrived. When no message slot or inbox room is left the
+// message is dropped, as the network would have.
+static void route_message(client_session_t *client, const message_t *msg, const uint8_t *buffer,
+                          size_t len) {
+  server_shard_t *shard = client->shard;
+  net_message_t *entry  = sc_slab_alloc(shard->messages);
+  if (!entry) {
+    log_debug("Shard %zu has no room for another message, dropping it", shard->id);
+    shard->messages_dropped++;
+    return;
+  }
+
+  entry->msg         = *msg;
+  entry->msg.payload = entry->data + sizeof(message_header_t);
+  entry->shard       = shard;
+  entry->client_id   = client->id;
+  entry->len         = len;
+  memcpy(entry->data, buffer, len);
+
+  game_worker_t *worker = &shard->game_workers[entry->client_id % shard->game_worker_count];
+  if (sc_mailbox_post(worker->inbox, &entry->msg) < 0) {
+    log_debug("Game worker %zu inbox full, dropping message", worker->id);
+    sc_slab_free(shard->messages, entry);
+    shard->messages_dropped++;
+    return;
+  }
+  shard->messages_routed++;
+}
+
+// Handle one decrypted application message
+// Returns: true if the client is still connected, false if it was removed
+static bool handle_message(client_session_t *client, uint8_t *buffer, size_t bytes_read) {
+  // Log received data
+  char addr_str[INET_ADDRSTRLEN];
+  inet_ntop(AF_INET, &client->addr.sin_addr, addr_str, sizeof(addr_str));
+  log_debug("Received %zu bytes from %s:%d (DTLS)", bytes_read, addr_str,
+            ntohs(client->addr.sin_port));
+
+  // Message too small for protocol header - just echo it back
+  if (bytes_read < sizeof(message_header_t)) {
+    log_debug("Received raw data (%zu bytes), echoing back", bytes_read);
+    return client_write(client, buffer, bytes_read);
+  }
+
+  message_header_t *header = (message_header_t *) buffer;
+
+  // Convert header fields from network byte order
+  uint16_t msg_type         = ntohs(header->message_type);
+  uint16_t protocol_version = ntohs(header->protocol_version);
+  uint16_t payload_len      = ntohs(header->payload_length);
+
+#if LOG_LEVEL >= 5
+  uint32_t sequence = ntohl(header->sequence_number);
+  log_debug("Received message: type=%s (%d), seq=%u, payload_len=%u",
+            message_type_to_string(msg_type), msg_type, sequence, payload_len);
+#else
+  log_debug("Received message: type=%s (%d), payload_len=%u", message_type_to_string(msg_type),
+            msg_type, payload_len);
+#endif
+
+  // Validate protocol version - if invalid, just echo back
+  if (protocol_version != 0x0001) {
+    log_debug("Non-protocol message (version 0x%04x), echoing back", protocol_version);
+    return client_write(client, buffer, bytes_read);
+  }
+
+  // Validate payload length is reasonable
+  if (payload_len > SOCKET_BUFFER_SIZE - sizeof(message_header_t)) {
+    log_debug("Invalid payload length (%u), echoing back", payload_len);
+    return client_write(client, buffer, bytes_read);
+  }
+
+  message_t msg;
+  msg.header.protocol_version = protocol_version;
+  msg.header.message_type     = msg_type;
+  msg.header.sequence_number  = ntohl(header->sequence_number);
+  msg.header.timestamp        = be64toh(header->timestamp);
+  msg.header.payload_length   = payload_len;
+  msg.payload                 = buffer + sizeof(message_header_t);
+
+  // Game logic runs on the game workers when there are any
+  if (client->shard->game_workers) {
+    route_message(client, &msg, buffer, bytes_read);
+    return true;
+  }
+
+  process_message(&msg, buffer);
+  return client_write(client, buffer, bytes_read);
+}
+
+// Act on what sc_dtls_handshake() returned
+// Returns: true if the client is still connected, false if it was removed
+static bool handshake_result(client_session_t *client, dtls_result_t result) {
+  if (result == DTLS_OK) {
+    client->handshake_complete = true;
+    char addr_str[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &client->addr.sin_addr, addr_str, sizeof(addr_str));
+    log_info("DTLS handshake completed for %s:%d", addr_str, ntohs(client->addr.sin_port));
+  } else if (result != DTLS_ERROR_WOULD_BLOCK) {
+    // Handshake failed
+    log_error("DTLS handshake failed: %s", sc_dtls_error_string(result));
+    remove_client(client);
+    return false;
+  }
 
-  while (client) {
-    next = client->next;
-    if (now - client->last_activity > CLIENT_TIMEOUT_SECONDS) {
-      log_warn("%s", "Client timeout - removing inactive client");
+  // Until the peer answers, the timer wheel resends the flight just sent
+  schedule_retransmit(client);
+  return true;
+}
+
+// Read every application record in the datagram last fed to the session
+// Returns: true if the client is still connected, false if it was removed
+static bool read_records(client_session_t *client) {
+  uint8_t buffer[SOCKET_BUFFER_SIZE];
+  while (1) {
+    size_t bytes_read = 0;
+    dtls_result_t result =
+      sc_dtls_read(client->dtls_session, buffer, sizeof(buffer), &bytes_read);
+
+    if (result == DTLS_OK && bytes_read > 0) {
+      if (!handle_message(client, buffer, bytes_read)) {
+        return false; // Client was removed
+      }
+    } else if (result == DTLS_OK || result == DTLS_ERROR_WOULD_BLOCK) {
+      return true; // Datagram fully consumed
+    } else if (result == DTLS_ERROR_PEER_CLOSED) {
+      // Client closed connection
       remove_client(client);
+      return false;
+    } else {
+      // Read error
+      log_error("DTLS read failed: %s", sc_dtls_error_string(result));
+      remove_client(client);
+      return false;
+    }
+  }
+}
+
+// Send a datagram to a client through the shard's I/O engine
+static void shard_send(server_shard_t *shard, const client_session_t *client, const uint8_t *buf,
+                       size_t len) {
+  const struct sockaddr *addr = (const struct sockaddr *) &client->addr;
+#ifdef SC_HAVE_IO_URING
+  if (shard->uring) {
+    (void) sc_uring_send(shard->uring, addr, client->addr_len, buf, len);
+    return;
+  }
+#endif
+  (void) sc_egress_queue(shard->egress, addr, client->addr_len, buf, len);
+}
+
+// DTLS transmit hook on a crypto thread: keep the datagram for the shard,
+// whose I/O engine is not safe to touch from here
+static ssize_t capture_send(void *user_data, const struct sockaddr *addr, socklen_t addr_len,
+                            const uint8_t *buf, size_t len) {
+  (void) addr;
+  (void) addr_len;
+  handshake_step_t *step = user_data;
+  if (step->outbox_count == HANDSHAKE_OUTBOX_DATAGRAMS ||
+      len > HANDSHAKE_OUTBOX_SIZE - step->outbox_used) {
+    errno = EAGAIN;
+    return -1;
+  }
+
+  memcpy(step->outbox + step->outbox_used, buf, len);
+  step->outbox_lens[step->outbox_count++] = len;
+  step->outbox_used += len;
+  return (ssize_t) len;
+}
+
+// Crypto thread: feed one datagram to the session and advance the handshake
+static void run_handshake_step(sc_handshake_job_t *job) {
+  handshake_step_t *step  = (handshake_step_t *) job;
+  dtls_session_t *session = step->client->dtls_session;
+
+  sc_dtls_session_set_send(session, capture_send, step);
+  step->fed = sc_dtls_feed(session, step->datagram, step->len) == DTLS_OK;
+  if (step->fed) {
+    step->result = sc_dtls_handshake(session);
+  }
+  sc_dtls_session_set_send(session, NULL, NULL);
+}
+
+// Give a client's handshake datagram to the crypto pool
+static void start_handshake_step(client_session_t *client, handshake_step_t *step) {
+  server_shard_t *shard  = client->shard;
+  client->handshake_step = step;
+  // Cannot fail; every argument is valid
+  sc_handshake_pool_submit(shard->handshakes, shard->handshake_port, &step->job);
+}
+
+// Queue a handshake datagram for the crypto pool
+// A client has at most one step running, so its datagrams reach the session in
+// order; later ones wait on the client until the running step comes back.
+static void queue_handshake_step(client_session_t *client, const sc_ingress_packet_t *packet) {
+  server_shard_t *shard = client->shard;
+  if (packet->len > SOCKET_BUFFER_SIZE) {
+    log_debug("Dropping %zu byte handshake datagram", packet->len);
+    return;
+  }
+
+  // Dropping is safe; the peer retransmits its flight
+  handshake_step_t *step = sc_slab_alloc(shard->handshake_steps);
+  if (!step) {
+    log_warn("Shard %zu handshake queue full, dropping datagram", shard->id);
+    return;
+  }
+  step->job.fn       = run_handshake_step;
+  step->client       = client;
+  step->next         = NULL;
+  step->len          = packet->len;
+  step->outbox_count = 0;
+  step->outbox_used  = 0;
+  memcpy(step->datagram, packet->data, packet->len);
+
+  if (!client->handshake_step) {
+    start_handshake_step(client, step);
+    return;
+  }
+
+  handshake_step_t **tail = &client->handshake_queue;
+  while (*tail) {
+    tail = &(*tail)->next;
+  }
+  *tail = step;
+}
+
+// Finish a step the crypto pool handed back: send what DTLS wrote, act on the
+// handshake result, and move on to the client's next queued datagram
+static void finish_handshake_step(handshake_step_t *step) {
+  client_session_t *client = step->client;
+  server_shard_t *shard    = client->shard;
+  client->handshake_step   = NULL;
+
+  if (client->closing) {
+    sc_slab_free(shard->handshake_steps, step);
+    destroy_client(client);
+    return;
+  }
+
+  const uint8_t *data = step->outbox;
+  for (size_t i = 0; i < step->outbox_count; i++) {
+    shard_send(shard, client, data, step->outbox_lens[i]);
+    data += step->outbox_lens[i];
+  }
+
+  bool connected = !step->fed || handshake_result(client, step->result);
+  sc_slab_free(shard->handshake_steps, step);
+
+  while (connected && client->handshake_queue) {
+    handshake_step_t *next  = client->handshake_queue;
+    client->handshake_queue = next->next;
+    if (!client->handshake_complete) {
+      start_handshake_step(client, next);
+      return;
+    }
+
+    // Once the handshake is done, what queued up behind it is application data
+    bool fed = sc_dtls_feed(client->dtls_session, next->datagram, next->len) == DTLS_OK;
+    sc_slab_free(shard->handshake_steps, next);
+    connected = !fed || read_records(client);
+  }
+}
+
+// Finish up to HANDSHAKE_BUDGET steps the crypto pool has handed back
+// The rest stay on the port, whose eventfd remains readable, so a burst of
+// completed handshakes is spread over iterations instead of delaying the
+// datagrams of established clients.
+static void collect_handshakes(server_shard_t *shard) {
+  if (!shard->handshake_port || shard->handshake_port->stats.in_flight == 0) {
+    return;
+  }
+
+  sc_handshake_job_t *jobs[HANDSHAKE_BUDGET];
+  size_t count = sc_handshake_port_collect(shard->handshake_port, jobs, HANDSHAKE_BUDGET);
+  for (size_t i = 0; i < count; i++) {
+    finish_handshake_step((handshake_step_t *) jobs[i]);
+  }
+}
+
+// Encrypt and send up to REPLY_BUDGET replies game workers returned
+// The rest stay in the mailbox, whose eventfd remains readable, so a burst of
+// replies is spread over iterations instead of overrunning the I/O engine's
+// send batch. A reply for a client that left meanwhile is dropped.
+static void collect_replies(server_shard_t *shard) {
+  if (!shard->replies) {
+    return;
+  }
+
+  message_t *msgs[REPLY_BUDGET];
+  size_t count = sc_mailbox_drain(shard->replies, msgs, REPLY_BUDGET);
+  for (size_t i = 0; i < count; i++) {
+    net_message_t *entry     = (net_message_t *) msgs[i];
+    client_session_t *client = find_client_by_id(shard, entry->client_id);
+    if (client && client->handshake_complete) {
+      client_write(client, entry->data, entry->len);
+    }
+    sc_slab_free(shard->messages, entry);
+  }
+}
+
+// Game worker thread: process the messages in the inbox as they arrive until
+// the shutdown eventfd is signalled
+// A worker that cannot wait for its inbox stops the whole server: shards keep
+// routing its clients' messages to it, and the message slots those hold would
+// never come back, starving every shard of slots for healthy workers too.
+static void *game_worker_run(void *arg) {
+  game_worker_t *worker = arg;
+  struct pollfd fds[2]  = {
+    {.fd = worker->inbox->event_fd, .events = POLLIN},
+    {.fd = worker->shutdown_fd, .events = POLLIN},
+  };
+  message_t *msgs[GAME_BATCH_SIZE];
+
+  while (true) {
+    if (poll(fds, 2, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      // Retrying a broken descriptor would only spin. The main thread waits
+      // for SIGTERM and shuts the server down from there.
+      log_error("Game worker %zu poll failed, stopping the server: %s", worker->id,
+                strerror(errno));
+      worker->failed = true;
+      kill(getpid(), SIGTERM);
+      break;
+    }
+    if (fds[1].revents & POLLIN) {
+      break;
+    }
+
+    size_t count = sc_mailbox_drain(worker->inbox, msgs, GAME_BATCH_SIZE);
+    for (size_t i = 0; i < count; i++) {
+      net_message_t *entry = (net_message_t *) msgs[i];
+      process_message(&entry->msg, entry->data);
+
+      // The reply mailbox holds every message slot of its shard, so it has room
+      if (sc_mailbox_post(entry->shard->replies, &entry->msg) < 0) {
+        log_error("Shard %zu reply mailbox full, losing message", entry->shard->id);
+      }
+    }
+    worker->handled += count;
+  }
+
+  return NULL;
+}
+
+// Point a client, its session table entry and its DTLS session at the
+// address a datagram came from
+// Returns: false if the client could not be tracked and was removed
+static bool move_client(client_session_t *client, const sc_ingress_packet_t *packet) {
+  server_shard_t *shard = client->shard;
+  char old_str[INET_ADDRSTRLEN];
+  char new_str[INET_ADDRSTRLEN];
+  inet_ntop(AF_INET, &client->addr.sin_addr, old_str, sizeof(old_str));
+  inet_ntop(AF_INET, &packet->addr.sin_addr, new_str, sizeof(new_str));
+  log_info("Client %s:%d moved to %s:%d (shard %zu)", old_str, ntohs(client->addr.sin_port),
+           new_str, ntohs(packet->addr.sin_port), shard->id);
+
+  sc_session_table_remove(shard->clients, sc_session_table_key(&client->addr));
+  memcpy(&client->addr, &packet->addr, packet->addr_len);
+  client->addr_len = packet->addr_len;
+  sc_dtls_session_set_peer(client->dtls_session, (const struct sockaddr *) &client->addr,
+                           client->addr_len);
+  // The old key's entry was just freed, so there is room for the new one
+  if (sc_session_table_put(shard->clients, sc_session_table_key(&client->addr), client) < 0) {
+    log_error("Failed to track moved client session: %s", strerror(errno));
+    remove_client(client);
+    return false;
+  }
+  shard->migrations++;
+  return true;
+}
+
+// Hand a client a datagram that arrived from a new address carrying its
+// connection ID, and move the client there once a record of it decrypts
+// Forged datagrams fail to decrypt and replayed ones are discarded by DTLS,
+// so neither moves the client; a NAT rebinding costs a table update instead
+// of a new handshake. Only a record newer than any before it moves the
+// client: a late one from the old address, or a captured one re-sent from
+// elsewhere before the original arrives, is delivered where the client is.
+static void migrate_client(client_session_t *client, const sc_ingress_packet_t *packet,
+                           uint64_t now_ms) {
+  server_shard_t *shard = client->shard;
+  if (sc_dtls_feed(client->dtls_session, packet->data, packet->len) != DTLS_OK) {
+    return;
+  }
+
+  uint8_t buffer[SOCKET_BUFFER_SIZE];
+  size_t bytes_read    = 0;
+  dtls_result_t result = sc_dtls_read(client->dtls_session, buffer, sizeof(buffer), &bytes_read);
+  if (result == DTLS_ERROR_PEER_CLOSED) {
+    remove_client(client);
+    return;
+  }
+  if (result != DTLS_OK || bytes_read == 0) {
+    return;
+  }
+  if (!sc_dtls_session_last_record_is_newest(client->dtls_session)) {
+    shard->stale_moves++;
+  } else if (!move_client(client, packet)) {
+    return;
+  }
+
+  // Then carry on as for any datagram from the client
+  touch_client(client, now_ms);
+  if (handle_message(client, buffer, bytes_read)) {
+    read_records(client);
+  }
+}
+
+// Process one datagram from an ingress batch
+// The datagram is handed to the owning session's DTLS state, so the socket is
+// read exactly once per datagram.
+static void handle_datagram(server_shard_t *shard, const sc_ingress_packet_t *packet,
+                            uint64_t now_ms) {
+  // Find or create client session
+  client_session_t *client = find_client(shard, &packet->addr);
+  if (!client) {
+    // A known connection ID from an unknown address: the client has moved
+    client = find_client_by_cid(shard, packet);
+    if (client) {
+      migrate_client(client, packet, now_ms);
+      return;
+    }
+
+    // Unknown peers are answered statelessly until they echo a valid cookie,
+    // so spoofed ClientHellos never cost a session
+    if (sc_dtls_check_hello(shard->dtls_ctx, shard->sock, (const struct sockaddr *) &packet->addr,
+                            packet->addr_len, packet->data, packet->len) != DTLS_HELLO_VERIFIED) {
+      return;
+    }
+
+    // New client - create session; on failure the datagram is discarded
+    client = add_client(shard, &packet->addr, packet->addr_len);
+    if (!client) {
+      return;
     }
-    client = next;
   }
+
+  // Update last activity
+  touch_client(client, now_ms);
+
+  // Handshakes run on the crypto pool when there is one, so their key
+  // exchange and signature never stall this shard's established clients
+  if (!client->handshake_complete && shard->handshakes) {
+    queue_handshake_step(client, packet);
+    return;
+  }
+
+  if (sc_dtls_feed(client->dtls_session, packet->data, packet->len) != DTLS_OK) {
+    return;
+  }
+
+  // Handle DTLS handshake or data
+  if (!client->handshake_complete) {
+    // Try to complete handshake
+    handshake_result(client, sc_dtls_handshake(client->dtls_session));
+    return;
+  }
+
+  // Handshake complete - read every application record in the datagram
+  read_records(client);
 }
 
 // Set socket to non-blocking mode
@@ -137,7 +977,9 @@ static int set_nonblocking(int fd) {
 }
 
 // Create and bind a UDP socket
-static int create_udp_socket(const char *address) {
+// With reuse_port several sockets can bind the same port, and the kernel
+// spreads clients across them by a hash of the source address and port.
+static int create_udp_socket(const char *address, bool reuse_port) {
   int sock = socket(AF_INET, SOCK_DGRAM, 0);
   if (sock < 0) {
     log_error("Failed to create socket: %s", strerror(errno));
@@ -151,9 +993,14 @@ static int create_udp_socket(const char *address) {
     close(sock);
     return -1;
   }
+  if (reuse_port && setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+    log_error("Failed to set SO_REUSEPORT: %s", strerror(errno));
+    close(sock);
+    return -1;
+  }
 
   // Set socket buffer sizes
-  int bufsize = SOCKET_BUFFER_SIZE;
+  int bufsize = SOCKET_KERNEL_BUFFER_SIZE;
   if (setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &bufsize, sizeof(bufsize)) < 0) {
     log_warn("Failed to set receive buffer size: %s", strerror(errno));
   }
@@ -189,102 +1036,201 @@ static int create_udp_socket(const char *address) {
   return sock;
 }
 
-int main(void) {
-  log_info("%s", "Space Captain Server starting...");
+// Steer datagrams that carry a connection ID to the shard named by its first
+// byte, whichever address they come from, so a client that moved still reaches
+// the shard holding its session. Everything else, handshakes included, is left
+// to the kernel's hash. The program serves the whole SO_REUSEPORT group, whose
+// sockets are numbered in the order the shards bound them.
+// Returns: 0 on success, -1 on failure
+static int steer_by_cid(int sock) {
+  struct sock_filter code[] = {
+    BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 0), // Record content type
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, DTLS_CID_CONTENT_TYPE, 0, 2),
+    BPF_STMT(BPF_LD | BPF_B | BPF_ABS, DTLS_CID_OFFSET), // Shard id
+    BPF_STMT(BPF_RET | BPF_A, 0),
+    BPF_STMT(BPF_RET | BPF_K, 0xffffffff), // No such socket, so the hash decides
+  };
+  struct sock_fprog prog = {.len = sizeof(code) / sizeof(code[0]), .filter = code};
+  return setsockopt(sock, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog));
+}
 
-  // Initialize DTLS
-  if (sc_dtls_init() != DTLS_OK) {
-    log_error("%s", "Failed to initialize DTLS");
+// Number of shards to run, from the SC_SERVER_SHARDS environment variable
+// Unset means a single shard; 0 means one shard per online CPU.
+static size_t shard_count(void) {
+  const char *value = getenv("SC_SERVER_SHARDS");
+  if (!value || *value == '\0') {
     return 1;
   }
 
-  // Determine certificate paths - check environment variables first
-  const char *cert_path = getenv("SC_SERVER_CRT");
-  const char *key_path  = getenv("SC_SERVER_KEY");
-
-  // Fall back to /etc/space-captain if env vars not set
-  if (!cert_path || !key_path) {
-    cert_path = cert_path ? cert_path : "/etc/space-captain/server.crt";
-    key_path  = key_path ? key_path : "/etc/space-captain/server.key";
+  char *end;
+  errno           = 0;
+  unsigned long n = strtoul(value, &end, 10);
+  if (errno != 0 || *end != '\0') {
+    log_warn("Ignoring invalid SC_SERVER_SHARDS value: %s", value);
+    return 1;
+  }
 
-    // Check if /etc/space-captain files exist, otherwise try local .secrets/certs/
-    struct stat st;
-    if (stat(cert_path, &st) != 0 || stat(key_path, &st) != 0) {
-      cert_path = ".secrets/certs/server.crt";
-      key_path  = ".secrets/certs/server.key";
-    }
+  if (n == 0) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    n         = cpus > 0 ? (unsigned long) cpus : 1;
   }
+  if (n > SERVER_MAX_SHARDS) {
+    log_warn("Limiting %lu shards to %d", n, SERVER_MAX_SHARDS);
+    n = SERVER_MAX_SHARDS;
+  }
+  return (size_t) n;
+}
 
-  log_info("Using certificate: %s", cert_path);
-  log_info("Using private key: %s", key_path);
+// I/O engine to run, from the SC_SERVER_IO environment variable ("epoll" or "uring")
+static server_io_t io_engine(void) {
+  const char *value = getenv("SC_SERVER_IO");
+  if (!value || *value == '\0' || strcmp(value, "epoll") == 0) {
+    return SERVER_IO_EPOLL;
+  }
+  if (strcmp(value, "uring") == 0) {
+#ifdef SC_HAVE_IO_URING
+    return SERVER_IO_URING;
+#else
+    log_warn("%s", "Built without io_uring support (IO_URING=0), using epoll");
+    return SERVER_IO_EPOLL;
+#endif
+  }
+  log_warn("Ignoring invalid SC_SERVER_IO value: %s", value);
+  return SERVER_IO_EPOLL;
+}
 
-  // Create DTLS context for server
-  g_dtls_ctx = sc_dtls_context_create(DTLS_ROLE_SERVER, cert_path, key_path, NULL, 0);
-  if (!g_dtls_ctx) {
-    log_error("%s", "Failed to create DTLS context");
-    sc_dtls_cleanup();
-    return 1;
+// Whether to run without encryption, from the SC_SERVER_TRANSPORT environment
+// variable ("dtls" or "plain"); plain is for benchmarks and trusted links
+static bool plain_transport(void) {
+  const char *value = getenv("SC_SERVER_TRANSPORT");
+  if (!value || *value == '\0' || strcmp(value, "dtls") == 0) {
+    return false;
+  }
+  if (strcmp(value, "plain") == 0) {
+    return true;
   }
+  log_warn("Ignoring invalid SC_SERVER_TRANSPORT value: %s", value);
+  return false;
+}
 
-  // Set up signal handlers
-  struct sigaction sa;
-  memset(&sa, 0, sizeof(sa));
-  sa.sa_handler = handle_shutdown;
-  sigemptyset(&sa.sa_mask);
-  sa.sa_flags = 0;
+// Count from an environment variable, or fallback when it is unset
+static size_t count_from_env(const char *name, size_t fallback) {
+  const char *value = getenv(name);
+  if (!value || *value == '\0') {
+    return fallback;
+  }
 
-  if (sigaction(SIGINT, &sa, NULL) < 0 || sigaction(SIGTERM, &sa, NULL) < 0) {
-    log_error("Failed to set signal handlers: %s", strerror(errno));
-    sc_dtls_context_destroy(g_dtls_ctx);
-    sc_dtls_cleanup();
-    return 1;
+  char *end;
+  errno           = 0;
+  unsigned long n = strtoul(value, &end, 10);
+  if (errno != 0 || *end != '\0') {
+    log_warn("Ignoring invalid %s value: %s", name, value);
+    return fallback;
   }
+  return (size_t) n;
+}
 
-  // Always bind to all interfaces
-  const char *bind_address = "0.0.0.0";
-  log_info("Server binding to all interfaces: %s", bind_address);
+// Number of crypto threads, from the SC_SERVER_HANDSHAKE_THREADS environment variable
+// Unset means HANDSHAKE_THREADS; 0 runs handshakes inline on the shard threads.
+static size_t handshake_thread_count(void) {
+  return count_from_env("SC_SERVER_HANDSHAKE_THREADS", HANDSHAKE_THREADS);
+}
 
-  // Create epoll instance
-  int epoll_fd = epoll_create1(0);
-  if (epoll_fd < 0) {
-    log_error("Failed to create epoll: %s", strerror(errno));
-    return 1;
-  }
+// Number of game workers, from the SC_SERVER_GAME_WORKERS environment variable
+// Unset means GAME_WORKERS; 0 runs game logic inline on the shard threads.
+static size_t game_worker_count(void) {
+  return count_from_env("SC_SERVER_GAME_WORKERS", GAME_WORKERS);
+}
 
-  // Create UDP socket
-  int sock = create_udp_socket(bind_address);
-  if (sock < 0) {
-    close(epoll_fd);
-    return 1;
+// Number of client sessions to preallocate, from the SC_SERVER_MAX_CLIENTS
+// environment variable
+// Unset or 0 means SERVER_MAX_CLIENTS.
+static size_t client_limit(void) {
+  size_t n = count_from_env("SC_SERVER_MAX_CLIENTS", SERVER_MAX_CLIENTS);
+  return n > 0 ? n : SERVER_MAX_CLIENTS;
+}
+
+// Client slots each shard preallocates
+// The kernel's SO_REUSEPORT hash does not spread clients evenly, so every
+// shard gets SHARD_CLIENT_HEADROOM percent more than an even share, up to the
+// whole limit, so a shard the hash favours keeps accepting clients long
+// before the server as a whole is full.
+// Returns: Slots per shard, at most max_clients
+static size_t shard_client_slots(size_t max_clients, size_t num_shards) {
+  size_t share    = (max_clients + num_shards - 1) / num_shards;
+  size_t headroom = share * SHARD_CLIENT_HEADROOM / 100;
+  return share + headroom < max_clients ? share + headroom : max_clients;
+}
+
+// Create the game workers' inboxes; their threads are started separately
+// Returns: Array of count workers, or NULL on failure
+static game_worker_t *game_workers_init(size_t count, int shutdown_fd) {
+  game_worker_t *workers = calloc(count, sizeof(game_worker_t));
+  if (!workers) {
+    log_error("%s", "Failed to allocate game workers");
+    return NULL;
   }
 
-  log_info("Server listening on %s:%d", bind_address, SERVER_PORT);
+  for (size_t i = 0; i < count; i++) {
+    workers[i].id          = i;
+    workers[i].shutdown_fd = shutdown_fd;
+    workers[i].inbox       = sc_mailbox_init(GAME_INBOX_CAPACITY);
+    if (!workers[i].inbox) {
+      while (i-- > 0) {
+        sc_mailbox_nuke(workers[i].inbox);
+      }
+      free(workers);
+      return NULL;
+    }
+  }
+  return workers;
+}
 
-  // Add socket to epoll
-  struct epoll_event ev;
-  ev.events  = EPOLLIN | EPOLLET; // Edge-triggered
-  ev.data.fd = sock;
-  if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, sock, &ev) < 0) {
-    log_error("Failed to add socket to epoll: %s", strerror(errno));
-    close(sock);
-    close(epoll_fd);
-    return 1;
+// Join the game workers that were started and free them all
+// The shutdown eventfd must already be signalled.
+// Returns: false if a worker stopped on an error, true otherwise
+static bool game_workers_nuke(game_worker_t *workers, size_t count) {
+  if (!workers) {
+    return true;
   }
 
-  int num_sockets = 1;
-  int sockets[1]  = {sock};
+  bool ok = true;
+  for (size_t i = 0; i < count; i++) {
+    game_worker_t *worker = &workers[i];
+    if (worker->running) {
+      pthread_join(worker->thread, NULL);
+    }
+    ok = ok && !worker->failed;
+    log_info("Game worker %zu: %" PRIu64 " messages handled, %" PRIu64 " refused (inbox full)",
+             worker->id, worker->handled, (uint64_t) atomic_load(&worker->inbox->refused));
+    sc_mailbox_nuke(worker->inbox);
+  }
+  free(workers);
+  return ok;
+}
 
-  log_info("%s", "Server initialized successfully");
+// How long the I/O loop may sleep before the shard's next timer is due
+// Capped at a second so the periodic statistics still get logged when idle.
+static int loop_timeout_ms(const server_shard_t *shard) {
+  uint64_t next = sc_timer_wheel_next_expiry(shard->timers);
+  uint64_t now  = sc_timer_wheel_now_ms();
+  if (next <= now) {
+    return 0;
+  }
+  return next - now < 1000 ? (int) (next - now) : 1000;
+}
 
-  // Main event loop
+// Shard thread for SERVER_IO_EPOLL: run the event loop until the shutdown
+// eventfd is signalled
+static void *shard_run_epoll(void *arg) {
+  server_shard_t *shard = arg;
   struct epoll_event events[EPOLL_MAX_EVENTS];
-  uint8_t buffer[SOCKET_BUFFER_SIZE];
-  struct sockaddr_in client_addr;
-  socklen_t client_len;
-  time_t last_timeout_check = time(NULL);
+  time_t last_stats_log = time(NULL);
+  bool running          = true;
 
-  while (g_running) {
-    int nfds = epoll_wait(epoll_fd, events, EPOLL_MAX_EVENTS, 1000); // 1 second timeout
+  while (running) {
+    // Wake for the next retransmission or idle deadline, if nothing arrives first
+    int nfds = epoll_wait(shard->epoll_fd, events, EPOLL_MAX_EVENTS, loop_timeout_ms(shard));
 
     if (nfds < 0) {
       if (errno == EINTR) {
@@ -295,199 +1241,532 @@ int main(void) {
       }
     }
 
-    // Check for client timeouts periodically
+    // Expire idle clients; only sessions whose deadline has passed are touched
+    uint64_t now_ms = sc_timer_wheel_now_ms();
+    sc_timer_wheel_advance(shard->timers, now_ms);
+
     time_t now = time(NULL);
-    if (now - last_timeout_check >= 5) { // Check every 5 seconds
-      check_client_timeouts();
-      last_timeout_check = now;
+    if (now - last_stats_log >= STATS_LOG_INTERVAL_SECONDS) {
+      log_ingress_stats(shard);
+      log_client_stats(shard);
+      log_handshake_stats(shard);
+      log_message_stats(shard);
+      last_stats_log = now;
     }
 
     // Process events
     for (int i = 0; i < nfds; i++) {
-      int event_fd = events[i].data.fd;
+      // Finished handshakes and game replies are collected below, after the socket
+      if (shard->handshake_port && events[i].data.fd == shard->handshake_port->event_fd) {
+        continue;
+      }
+      if (shard->replies && events[i].data.fd == shard->replies->event_fd) {
+        continue;
+      }
+      // The only other registered descriptor is the shutdown eventfd
+      if (events[i].data.fd != shard->sock) {
+        running = false;
+        continue;
+      }
 
-      // Read all available datagrams (edge-triggered mode)
+      // Drain the socket one batch at a time (edge-triggered mode)
       while (1) {
-        client_len = sizeof(client_addr);
-
-        // Peek at the packet to see which client it's from
-        ssize_t peek_len = recvfrom(event_fd, buffer, sizeof(buffer), MSG_PEEK,
-                                    (struct sockaddr *) &client_addr, &client_len);
-
-        if (peek_len < 0) {
-          if (errno == EAGAIN || errno == EWOULDBLOCK) {
-            break; // No more data
-          }
-          log_error("recvfrom peek failed: %s", strerror(errno));
+        int count = sc_ingress_recv(shard->ingress, shard->sock);
+        if (count < 0) {
+          log_error("recvmmsg failed: %s", strerror(errno));
           break;
         }
 
-        // Find or create client session
-        client_session_t *client = find_client(&client_addr);
-        if (!client) {
-          // New client - create session
-          client = add_client(&client_addr, client_len, event_fd);
-          if (!client) {
-            // Failed to create session, discard packet
-            recvfrom(event_fd, buffer, sizeof(buffer), 0, NULL, NULL);
-            continue;
-          }
+        for (int j = 0; j < count; j++) {
+          handle_datagram(shard, &shard->ingress->packets[j], now_ms);
         }
 
-        // Update last activity
-        client->last_activity = time(NULL);
-
-        // Handle DTLS handshake or data
-        if (!client->handshake_complete) {
-          // Try to complete handshake
-          dtls_result_t result = sc_dtls_handshake(client->dtls_session);
-
-          if (result == DTLS_OK) {
-            client->handshake_complete = true;
-            char addr_str[INET_ADDRSTRLEN];
-            inet_ntop(AF_INET, &client_addr.sin_addr, addr_str, sizeof(addr_str));
-            log_info("DTLS handshake completed for %s:%d", addr_str, ntohs(client_addr.sin_port));
-
-            // Consume the packet that triggered handshake completion
-            recvfrom(event_fd, buffer, sizeof(buffer), 0, NULL, NULL);
-          } else if (result == DTLS_ERROR_WOULD_BLOCK) {
-            // Handshake in progress, consume packet
-            recvfrom(event_fd, buffer, sizeof(buffer), 0, NULL, NULL);
-          } else {
-            // Handshake failed
-            log_error("DTLS handshake failed: %s", sc_dtls_error_string(result));
-            recvfrom(event_fd, buffer, sizeof(buffer), 0, NULL, NULL);
-            remove_client(client);
-          }
-        } else {
-          // Handshake complete - read application data
-          size_t bytes_read = 0;
-          dtls_result_t result =
-            sc_dtls_read(client->dtls_session, buffer, sizeof(buffer), &bytes_read);
-
-          if (result == DTLS_OK && bytes_read > 0) {
-            // Log received data
-            char addr_str[INET_ADDRSTRLEN];
-            inet_ntop(AF_INET, &client_addr.sin_addr, addr_str, sizeof(addr_str));
-            log_debug("Received %zu bytes from %s:%d (DTLS)", bytes_read, addr_str,
-                      ntohs(client_addr.sin_port));
-
-            // Parse and handle protocol messages
-            if (bytes_read >= sizeof(message_header_t)) {
-              message_header_t *header = (message_header_t *) buffer;
-
-              // Convert header fields from network byte order
-              uint16_t msg_type         = ntohs(header->message_type);
-              uint16_t protocol_version = ntohs(header->protocol_version);
-              uint16_t payload_len      = ntohs(header->payload_length);
+        if (shard->ingress->drained) {
+          break; // No more data
+        }
+      }
+    }
 
-#if LOG_LEVEL >= 5
-              uint32_t sequence = ntohl(header->sequence_number);
-              log_debug("Received message: type=%s (%d), seq=%u, payload_len=%u",
-                        message_type_to_string(msg_type), msg_type, sequence, payload_len);
+    // Data traffic first, then the game workers' replies and a bounded number
+    // of finished handshakes
+    collect_replies(shard);
+    collect_handshakes(shard);
+
+    // Everything DTLS wrote this iteration, replies and expiry alerts alike,
+    // leaves in one sendmmsg call
+    sc_egress_flush(shard->egress);
+  }
+
+  return NULL;
+}
+
+// DTLS transmit hook: queue records for the shard's next sendmmsg flush
+static ssize_t egress_send(void *user_data, const struct sockaddr *addr, socklen_t addr_len,
+                           const uint8_t *buf, size_t len) {
+  return sc_egress_queue(user_data, addr, addr_len, buf, len);
+}
+
+// Set up the epoll engine for a shard
+// Returns: 0 on success, -1 on failure
+static int shard_init_epoll(server_shard_t *shard, int shutdown_fd) {
+  shard->epoll_fd = epoll_create1(0);
+  if (shard->epoll_fd < 0) {
+    log_error("Failed to create epoll: %s", strerror(errno));
+    return -1;
+  }
+
+  // The socket is edge-triggered; the shutdown eventfd is level-triggered and
+  // never read, so once signalled it wakes every shard
+  struct epoll_event ev;
+  ev.events  = EPOLLIN | EPOLLET;
+  ev.data.fd = shard->sock;
+  if (epoll_ctl(shard->epoll_fd, EPOLL_CTL_ADD, shard->sock, &ev) < 0) {
+    log_error("Failed to add socket to epoll: %s", strerror(errno));
+    return -1;
+  }
+  ev.events  = EPOLLIN;
+  ev.data.fd = shutdown_fd;
+  if (epoll_ctl(shard->epoll_fd, EPOLL_CTL_ADD, shutdown_fd, &ev) < 0) {
+    log_error("Failed to add shutdown event to epoll: %s", strerror(errno));
+    return -1;
+  }
+
+  // The handshake port is level-triggered too, so steps left over by the
+  // per-iteration budget wake the next iteration at once
+  if (shard->handshake_port) {
+    ev.events  = EPOLLIN;
+    ev.data.fd = shard->handshake_port->event_fd;
+    if (epoll_ctl(shard->epoll_fd, EPOLL_CTL_ADD, ev.data.fd, &ev) < 0) {
+      log_error("Failed to add handshake port to epoll: %s", strerror(errno));
+      return -1;
+    }
+  }
+  if (shard->replies) {
+    ev.events  = EPOLLIN;
+    ev.data.fd = shard->replies->event_fd;
+    if (epoll_ctl(shard->epoll_fd, EPOLL_CTL_ADD, ev.data.fd, &ev) < 0) {
+      log_error("Failed to add reply mailbox to epoll: %s", strerror(errno));
+      return -1;
+    }
+  }
+
+  // Preallocate the receive vector used to drain the socket in batches. Slots
+  // are sized for GRO runs; a slot only touches the pages a datagram fills.
+  shard->ingress = sc_ingress_init(INGRESS_BATCH_SIZE, INGRESS_GRO_SLOT_SIZE);
+  if (!shard->ingress) {
+    return -1;
+  }
+  if (sc_ingress_enable_gro(shard->ingress, shard->sock) < 0) {
+    log_warn("UDP GRO unavailable, receiving datagrams singly: %s", strerror(errno));
+  }
+
+  // Queue DTLS records and send them together at the end of each iteration
+  shard->egress = sc_egress_init(shard->sock, EGRESS_BATCH_SIZE, SOCKET_BUFFER_SIZE);
+  if (!shard->egress) {
+    return -1;
+  }
+  if (!shard->egress->gso) {
+    log_warn("%s", "UDP GSO unavailable, sending datagrams singly");
+  }
+  sc_dtls_context_set_send(shard->dtls_ctx, egress_send, shard->egress);
+
+  shard->run = shard_run_epoll;
+  return 0;
+}
+
+#ifdef SC_HAVE_IO_URING
+// DTLS transmit hook: queue records on the shard's ring instead of sendto(2)
+static ssize_t uring_send(void *user_data, const struct sockaddr *addr, socklen_t addr_len,
+                          const uint8_t *buf, size_t len) {
+  return sc_uring_send(user_data, addr, addr_len, buf, len);
+}
+
+// Shard thread for SERVER_IO_URING: one io_uring_enter(2) per iteration
+// submits the replies queued while handling the previous batch and waits for
+// the next datagrams
+static void *shard_run_uring(void *arg) {
+  server_shard_t *shard = arg;
+  time_t last_stats_log = time(NULL);
+
+  while (!sc_uring_woken(shard->uring)) {
+    // Wake for the next retransmission or idle deadline, if nothing arrives first
+    if (sc_uring_wait(shard->uring, loop_timeout_ms(shard)) < 0) {
+      log_error("io_uring wait encountered error: %s", strerror(errno));
+      continue;
+    }
+
+    // Expire idle clients; only sessions whose deadline has passed are touched
+    uint64_t now_ms = sc_timer_wheel_now_ms();
+    sc_timer_wheel_advance(shard->timers, now_ms);
+
+    time_t now = time(NULL);
+    if (now - last_stats_log >= STATS_LOG_INTERVAL_SECONDS) {
+      log_ingress_stats(shard);
+      log_client_stats(shard);
+      log_handshake_stats(shard);
+      log_message_stats(shard);
+      last_stats_log = now;
+    }
+
+    // Drain every completed receive before waiting again
+    const sc_ingress_packet_t *packets;
+    size_t count;
+    while ((count = sc_uring_recv(shard->uring, &packets)) > 0) {
+      for (size_t j = 0; j < count; j++) {
+        handle_datagram(shard, &packets[j], now_ms);
+      }
+    }
+
+    // Data traffic first, then the game workers' replies and a bounded number
+    // of finished handshakes
+    collect_replies(shard);
+    collect_handshakes(shard);
+  }
+
+  return NULL;
+}
+
+// Set up the io_uring engine for a shard
+// Returns: 0 on success, -1 on failure
+static int shard_init_uring(server_shard_t *shard, int shutdown_fd) {
+  shard->uring = sc_uring_init(shard->sock, URING_RECV_BUFFERS, URING_SEND_SLOTS,
+                               SOCKET_BUFFER_SIZE);
+  if (!shard->uring) {
+    log_error("%s", "Failed to set up io_uring (Linux 6.0 or later is required; "
+                    "SC_SERVER_IO=epoll avoids it)");
+    return -1;
+  }
+  if (sc_uring_watch(shard->uring, shutdown_fd) < 0) {
+    log_error("%s", "Failed to watch shutdown event");
+    return -1;
+  }
+  if (shard->handshake_port && sc_uring_notify(shard->uring, shard->handshake_port->event_fd) < 0) {
+    return -1;
+  }
+  if (shard->replies && sc_uring_notify(shard->uring, shard->replies->event_fd) < 0) {
+    return -1;
+  }
+
+  // DTLS records leave through the ring, batched with the rest of the iteration
+  sc_dtls_context_set_send(shard->dtls_ctx, uring_send, shard->uring);
+
+  shard->run = shard_run_uring;
+  return 0;
+}
+#endif
+
+// Set up a shard's socket, DTLS context, client state and I/O engine
+// On failure the shard is left for shard_nuke() to release.
+// Returns: 0 on success, -1 on failure
+static int shard_init(server_shard_t *shard, size_t id, size_t max_clients, bool reuse_port,
+                      server_io_t io, bool plain, const char *cert_path, const char *key_path,
+                      int shutdown_fd, sc_handshake_pool_t *handshakes,
+                      game_worker_t *game_workers, size_t game_worker_count) {
+  memset(shard, 0, sizeof(server_shard_t));
+  shard->id                = id;
+  shard->sock              = -1;
+  shard->epoll_fd          = -1;
+  shard->handshakes        = handshakes;
+  shard->game_workers      = game_workers;
+  shard->game_worker_count = game_worker_count;
+
+  // Shards never share a DTLS context; the crypto threads running its
+  // handshakes share its cookie key and private key, which it locks
+  if (plain) {
+    shard->dtls_ctx = sc_dtls_context_create_plain(DTLS_ROLE_SERVER);
+  } else {
+    shard->dtls_ctx = sc_dtls_context_create(DTLS_ROLE_SERVER, cert_path, key_path, NULL, 0);
+  }
+  if (!shard->dtls_ctx) {
+    log_error("%s", "Failed to create DTLS context");
+    return -1;
+  }
+
+  // Set up every session the shard will ever hold before accepting clients
+  if (sc_dtls_context_reserve_sessions(shard->dtls_ctx, max_clients) != DTLS_OK) {
+    log_error("%s", "Failed to preallocate DTLS sessions");
+    return -1;
+  }
+
+  shard->sock = create_udp_socket(SERVER_BIND_ADDRESS, reuse_port);
+  if (shard->sock < 0) {
+    return -1;
+  }
+
+  shard->client_pool = sc_slab_init(sizeof(client_session_t), max_clients);
+  shard->clients     = sc_session_table_init(max_clients);
+  shard->timers      = sc_timer_wheel_init(TIMER_WHEEL_TICK_MS, sc_timer_wheel_now_ms());
+  if (!shard->client_pool || !shard->clients || !shard->timers) {
+    return -1;
+  }
+
+  if (handshakes) {
+    shard->handshake_port  = sc_handshake_port_init();
+    shard->handshake_steps = sc_slab_init(sizeof(handshake_step_t), HANDSHAKE_JOBS_PER_SHARD);
+    if (!shard->handshake_port || !shard->handshake_steps) {
+      return -1;
+    }
+  }
+
+  // The reply mailbox can hold every message slot, so game workers never
+  // find it full
+  if (game_workers) {
+    shard->messages = sc_slab_init(sizeof(net_message_t), MESSAGES_PER_SHARD);
+    shard->replies  = sc_mailbox_init(MESSAGES_PER_SHARD);
+    if (!shard->messages || !shard->replies) {
+      return -1;
+    }
+  }
+
+#ifdef SC_HAVE_IO_URING
+  if (io == SERVER_IO_URING) {
+    return shard_init_uring(shard, shutdown_fd);
+  }
 #else
-              log_debug("Received message: type=%s (%d), payload_len=%u",
-                        message_type_to_string(msg_type), msg_type, payload_len);
+  (void) io;
 #endif
+  return shard_init_epoll(shard, shutdown_fd);
+}
 
-              // Validate protocol version - if invalid, just echo back
-              if (protocol_version != 0x0001) {
-                log_debug("Non-protocol message (version 0x%04x), echoing back", protocol_version);
-                size_t bytes_written = 0;
-                result = sc_dtls_write(client->dtls_session, buffer, bytes_read, &bytes_written);
-                if (result != DTLS_OK && result != DTLS_ERROR_WOULD_BLOCK) {
-                  log_error("DTLS write failed: %s", sc_dtls_error_string(result));
-                  remove_client(client);
-                }
-                continue;
-              }
-
-              // Validate payload length is reasonable
-              if (payload_len > SOCKET_BUFFER_SIZE - sizeof(message_header_t)) {
-                log_debug("Invalid payload length (%u), echoing back", payload_len);
-                size_t bytes_written = 0;
-                result = sc_dtls_write(client->dtls_session, buffer, bytes_read, &bytes_written);
-                if (result != DTLS_OK && result != DTLS_ERROR_WOULD_BLOCK) {
-                  log_error("DTLS write failed: %s", sc_dtls_error_string(result));
-                  remove_client(client);
-                }
-                continue;
-              }
-
-              // Handle different message types
-              if (msg_type == MSG_PING) {
-                // Respond with PONG
-                message_header_t response;
-                response.protocol_version = htons(0x0001);
-                response.message_type     = htons(MSG_PONG);
-                response.sequence_number  = header->sequence_number; // Keep same sequence
-                response.timestamp        = header->timestamp;       // Keep same timestamp
-                response.payload_length   = header->payload_length;  // Keep same payload length
-
-                // Copy the full message (header + payload)
-                memcpy(buffer, &response, sizeof(message_header_t));
-
-                size_t bytes_written = 0;
-                result = sc_dtls_write(client->dtls_session, buffer, bytes_read, &bytes_written);
-                if (result != DTLS_OK && result != DTLS_ERROR_WOULD_BLOCK) {
-                  log_error("DTLS write failed: %s", sc_dtls_error_string(result));
-                  remove_client(client);
-                }
-              } else {
-                // For other message types, echo back (for now)
-                size_t bytes_written = 0;
-                result = sc_dtls_write(client->dtls_session, buffer, bytes_read, &bytes_written);
-                if (result != DTLS_OK && result != DTLS_ERROR_WOULD_BLOCK) {
-                  log_error("DTLS write failed: %s", sc_dtls_error_string(result));
-                  remove_client(client);
-                }
-              }
-            } else {
-              // Message too small for protocol header - just echo it back
-              log_debug("Received raw data (%zu bytes), echoing back", bytes_read);
-              size_t bytes_written = 0;
-              result = sc_dtls_write(client->dtls_session, buffer, bytes_read, &bytes_written);
-              if (result != DTLS_OK && result != DTLS_ERROR_WOULD_BLOCK) {
-                log_error("DTLS write failed: %s", sc_dtls_error_string(result));
-                remove_client(client);
-              }
-            }
-          } else if (result == DTLS_ERROR_WOULD_BLOCK) {
-            // No data available yet
-            recvfrom(event_fd, buffer, sizeof(buffer), 0, NULL, NULL);
-          } else if (result == DTLS_ERROR_PEER_CLOSED) {
-            // Client closed connection
-            remove_client(client);
-          } else {
-            // Read error
-            log_error("DTLS read failed: %s", sc_dtls_error_string(result));
-            recvfrom(event_fd, buffer, sizeof(buffer), 0, NULL, NULL);
-            remove_client(client);
-          }
+// Release everything a shard owns, disconnecting its clients
+// The crypto pool and game workers must already be stopped.
+static void shard_nuke(server_shard_t *shard) {
+  // Take back every step the pool held, run or not; removed clients waiting
+  // on one are destroyed, the rest go with the sweep below
+  if (shard->handshake_port) {
+    sc_handshake_job_t *jobs[HANDSHAKE_BUDGET];
+    size_t count;
+    while ((count = sc_handshake_port_collect(shard->handshake_port, jobs, HANDSHAKE_BUDGET)) > 0) {
+      for (size_t i = 0; i < count; i++) {
+        handshake_step_t *step       = (handshake_step_t *) jobs[i];
+        step->client->handshake_step = NULL;
+        if (step->client->closing) {
+          destroy_client(step->client);
         }
+        sc_slab_free(shard->handshake_steps, step);
       }
     }
   }
 
+  if (shard->clients) {
+    sc_session_table_sweep(shard->clients, evict_client, NULL);
+    sc_session_table_nuke(shard->clients);
+  }
+  sc_timer_wheel_nuke(shard->timers);
+  sc_handshake_port_nuke(shard->handshake_port);
+  sc_slab_nuke(shard->handshake_steps);
+
+  // Messages still out with the game workers go with their slab
+  log_message_stats(shard);
+  sc_mailbox_nuke(shard->replies);
+  sc_slab_nuke(shard->messages);
+
+  if (shard->client_pool) {
+    log_client_stats(shard);
+    sc_slab_nuke(shard->client_pool);
+  }
+
+  // Send the close alerts queued while evicting clients
+  sc_egress_flush(shard->egress);
+
+  log_ingress_stats(shard);
+  sc_ingress_nuke(shard->ingress);
+  sc_egress_nuke(shard->egress);
+#ifdef SC_HAVE_IO_URING
+  sc_uring_nuke(shard->uring);
+#endif
+
+  if (shard->sock >= 0) {
+    close(shard->sock);
+  }
+  if (shard->epoll_fd >= 0) {
+    close(shard->epoll_fd);
+  }
+  sc_dtls_context_destroy(shard->dtls_ctx);
+}
+
+int main(void) {
+  log_info("%s", "Space Captain Server starting...");
+
+  // Initialize DTLS
+  if (sc_dtls_init() != DTLS_OK) {
+    log_error("%s", "Failed to initialize DTLS");
+    return 1;
+  }
+
+  // Plaintext clients need neither ciphers nor a certificate
+  bool plain = plain_transport();
+  if (plain) {
+    log_warn("%s", "Plaintext transport (SC_SERVER_TRANSPORT=plain): traffic is neither "
+                   "encrypted nor authenticated");
+  } else {
+    // Before any context exists, so every shard offers the fastest cipher first
+    rank_ciphers();
+  }
+
+  // Determine certificate paths - check environment variables first
+  const char *cert_path = getenv("SC_SERVER_CRT");
+  const char *key_path  = getenv("SC_SERVER_KEY");
+
+  // Plaintext shards load none; otherwise fall back to /etc/space-captain if
+  // env vars not set
+  if (plain) {
+    cert_path = NULL;
+    key_path  = NULL;
+  } else if (!cert_path || !key_path) {
+    cert_path = cert_path ? cert_path : "/etc/space-captain/server.crt";
+    key_path  = key_path ? key_path : "/etc/space-captain/server.key";
+
+    // Check if /etc/space-captain files exist, otherwise try local .secrets/certs/
+    struct stat st;
+    if (stat(cert_path, &st) != 0 || stat(key_path, &st) != 0) {
+      cert_path = ".secrets/certs/server.crt";
+      key_path  = ".secrets/certs/server.key";
+    }
+  }
+
+  if (!plain) {
+    log_info("Using certificate: %s", cert_path);
+    log_info("Using private key: %s", key_path);
+  }
+
+  // Take shutdown signals synchronously on this thread; shard threads inherit
+  // the blocked mask and never see them
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  if (pthread_sigmask(SIG_BLOCK, &signals, NULL) != 0) {
+    log_error("%s", "Failed to block shutdown signals");
+    sc_dtls_cleanup();
+    return 1;
+  }
+
+  server_io_t io = io_engine();
+
+  // Shards split the client limit between them, with headroom for an uneven hash
+  size_t num_shards        = shard_count();
+  size_t max_clients       = client_limit();
+  size_t clients_per_shard = shard_client_slots(max_clients, num_shards);
+
+  int shutdown_fd        = eventfd(0, EFD_CLOEXEC);
+  server_shard_t *shards = calloc(num_shards, sizeof(server_shard_t));
+  if (shutdown_fd < 0 || !shards) {
+    log_error("%s", "Failed to allocate server shards");
+    if (shutdown_fd >= 0) {
+      close(shutdown_fd);
+    }
+    free(shards);
+    sc_dtls_cleanup();
+    return 1;
+  }
+
+  log_info("Server binding to all interfaces: %s", SERVER_BIND_ADDRESS);
+
+  // Handshakes run on crypto threads shared by every shard
+  size_t crypto_threads           = handshake_thread_count();
+  sc_handshake_pool_t *handshakes = NULL;
+  if (crypto_threads > 0) {
+    handshakes = sc_handshake_pool_init(crypto_threads);
+  }
+
+  // Game logic runs on game workers shared by every shard
+  size_t game_threads         = game_worker_count();
+  game_worker_t *game_workers = NULL;
+  if (game_threads > 0) {
+    game_workers = game_workers_init(game_threads, shutdown_fd);
+  }
+
+  // Set up every shard before starting any, so a failure aborts cleanly
+  bool ok            = (crypto_threads == 0 || handshakes) && (game_threads == 0 || game_workers);
+  size_t initialized = 0;
+  size_t started     = 0;
+  while (ok && initialized < num_shards) {
+    server_shard_t *shard = &shards[initialized];
+    ok = shard_init(shard, initialized, clients_per_shard, num_shards > 1, io, plain, cert_path,
+                    key_path, shutdown_fd, handshakes, game_workers, game_threads) == 0;
+
+    // Every shard seals session tickets with shard 0's keys: a client that
+    // reconnects from a new port usually lands on a different shard
+    if (ok && initialized > 0) {
+      ok = sc_dtls_context_share_tickets(shard->dtls_ctx, shards[0].dtls_ctx) == DTLS_OK;
+    }
+    initialized++;
+  }
+  if (ok && num_shards > 1 && steer_by_cid(shards[0].sock) < 0) {
+    log_warn("Failed to steer connection IDs to their shards, so clients that change address "
+             "reconnect: %s",
+             strerror(errno));
+  }
+  for (size_t i = 0; ok && game_workers && i < game_threads; i++) {
+    int err = pthread_create(&game_workers[i].thread, NULL, game_worker_run, &game_workers[i]);
+    if (err != 0) {
+      log_error("Failed to start game worker %zu: %s", i, strerror(err));
+      ok = false;
+      break;
+    }
+    game_workers[i].running = true;
+  }
+  while (ok && started < num_shards) {
+    int err = pthread_create(&shards[started].thread, NULL, shards[started].run, &shards[started]);
+    if (err != 0) {
+      log_error("Failed to start shard %zu: %s", started, strerror(err));
+      ok = false;
+      break;
+    }
+    started++;
+  }
+
+  if (ok) {
+    log_info("Server listening on %s:%d with %zu %s shard(s), %zu clients each (%zu in all)",
+             SERVER_BIND_ADDRESS, SERVER_PORT, num_shards,
+             io == SERVER_IO_URING ? "io_uring" : "epoll", clients_per_shard, max_clients);
+    if (handshakes) {
+      log_info("DTLS handshakes run on %zu crypto thread(s)", crypto_threads);
+    } else {
+      log_info("%s", "DTLS handshakes run inline on the shard threads");
+    }
+    if (game_workers) {
+      log_info("Game logic runs on %zu game worker(s)", game_threads);
+    } else {
+      log_info("%s", "Game logic runs inline on the shard threads");
+    }
+
+    int sig = 0;
+    sigwait(&signals, &sig);
+  }
+
   log_info("%s", "Server shutting down...");
 
-  // Clean up all client sessions
-  while (g_clients) {
-    remove_client(g_clients);
+  // Wake every shard and game worker; each finishes its current batch and
+  // exits its loop
+  uint64_t one = 1;
+  if (write(shutdown_fd, &one, sizeof(one)) < 0) {
+    log_error("Failed to signal shutdown: %s", strerror(errno));
+  }
+  for (size_t i = 0; i < started; i++) {
+    pthread_join(shards[i].thread, NULL);
   }
 
-  // Clean up sockets
-  for (int i = 0; i < num_sockets; i++) {
-    close(sockets[i]);
+  // Stop the crypto threads before the sessions they work on are released
+  for (size_t i = 0; i < initialized; i++) {
+    log_handshake_stats(&shards[i]);
   }
-  close(epoll_fd);
+  sc_handshake_pool_nuke(handshakes);
+
+  // Game workers post replies to the shards, so they stop before the shards
+  // are released; one that failed makes the server exit with an error
+  ok = game_workers_nuke(game_workers, game_threads) && ok;
 
-  // Clean up DTLS
-  if (g_dtls_ctx) {
-    sc_dtls_context_destroy(g_dtls_ctx);
+  // Clean up all client sessions, sockets and DTLS contexts; shard 0 goes
+  // last because the others use its ticket keys
+  for (size_t i = initialized; i > 0; i--) {
+    shard_nuke(&shards[i - 1]);
   }
+  free(shards);
+  close(shutdown_fd);
   sc_dtls_cleanup();
 
   log_info("%s", "Server stopped");
-  return 0;
+  return ok ? 0 : 1;
 }
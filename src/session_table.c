@@ -0,0 +1,361 @@
+#include <stdlib.h>
+#include <errno.h>
+
+#include "session_table.h"
+#include "log.h"
+#include "portability.h"
+
+// Returned by array_find when the key is absent
+#define SLOT_NOT_FOUND SIZE_MAX
+
+// ============================================================================
+// Internal Helper Functions
+// ============================================================================
+
+// Mixes all 64 key bits into the slot index (murmur3 fmix64 finalizer)
+// Without this, keys from one subnet differ only in a few high bits and
+// would pile into the same probe runs.
+// @param key Table key
+// @return Well-distributed hash of key
+static inline size_t hash_key(uint64_t key) {
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  key *= 0xc4ceb9fe1a85ec53ULL;
+  key ^= key >> 33;
+  return (size_t) key;
+}
+
+// Allocates an empty slot array
+// @param array Array to initialize
+// @param capacity Number of slots (must be a power of two)
+// @return true on success, false on allocation failure
+static bool array_init(sc_session_table_array_t *array, size_t capacity) {
+  array->slots = calloc(capacity, sizeof(sc_session_table_slot_t));
+  if (!array->slots) {
+    return false;
+  }
+  array->mask  = capacity - 1;
+  array->count = 0;
+  return true;
+}
+
+// Releases a slot array and marks it unused
+// @param array Array to release
+static void array_nuke(sc_session_table_array_t *array) {
+  free(array->slots);
+  array->slots = NULL;
+  array->mask  = 0;
+  array->count = 0;
+}
+
+// Finds the slot holding key
+// @param array Array to search
+// @param key Key to look for
+// @return Slot index, or SLOT_NOT_FOUND
+static size_t array_find(const sc_session_table_array_t *array, uint64_t key) {
+  if (!array->slots) {
+    return SLOT_NOT_FOUND;
+  }
+
+  size_t i = hash_key(key) & array->mask;
+  while (array->slots[i].value) {
+    if (array->slots[i].key == key) {
+      return i;
+    }
+    i = (i + 1) & array->mask;
+  }
+  return SLOT_NOT_FOUND;
+}
+
+// Stores a key known to be absent from the array
+// @param array Array with at least one free slot
+// @param key Key to store
+// @param value Value to store (non-NULL)
+static void array_insert_new(sc_session_table_array_t *array, uint64_t key, void *value) {
+  size_t i = hash_key(key) & array->mask;
+  while (array->slots[i].value) {
+    i = (i + 1) & array->mask;
+  }
+  array->slots[i].key   = key;
+  array->slots[i].value = value;
+  array->count++;
+}
+
+// Empties a slot and shifts the rest of its probe run back to close the gap
+// An entry moves into the hole unless its home slot lies cyclically between
+// the hole and its current position, in which case moving it would put it
+// ahead of its home and make it unreachable.
+// @param array Array to modify
+// @param hole Index of the occupied slot to empty
+static void array_delete(sc_session_table_array_t *array, size_t hole) {
+  size_t i = hole;
+  size_t j = hole;
+
+  while (1) {
+    j = (j + 1) & array->mask;
+    if (!array->slots[j].value) {
+      break;
+    }
+
+    size_t home = hash_key(array->slots[j].key) & array->mask;
+    bool stays  = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+    if (stays) {
+      continue;
+    }
+
+    array->slots[i] = array->slots[j];
+    i               = j;
+  }
+
+  array->slots[i].value = NULL;
+  array->count--;
+}
+
+// Moves retired slots into the active array
+// Migration only pauses on an empty slot, so every probe run left in the
+// retired array starts at or after migrate_pos and lookups there stay correct.
+// @param table Table with a resize in progress
+// @param budget Minimum number of retired slots to visit (SIZE_MAX for all)
+static void migrate(sc_session_table_t *table, size_t budget) {
+  sc_session_table_array_t *retired = &table->retired;
+  if (!retired->slots) {
+    return;
+  }
+
+  while (table->migrate_left > 0 && retired->count > 0) {
+    sc_session_table_slot_t *slot = &retired->slots[table->migrate_pos];
+    if (slot->value) {
+      array_insert_new(&table->active, slot->key, slot->value);
+      slot->value = NULL;
+      retired->count--;
+    } else if (budget == 0) {
+      break;
+    }
+
+    table->migrate_pos = (table->migrate_pos + 1) & retired->mask;
+    table->migrate_left--;
+    if (budget > 0) {
+      budget--;
+    }
+  }
+
+  if (table->migrate_left == 0 || retired->count == 0) {
+    array_nuke(retired);
+    table->migrate_left = 0;
+  }
+}
+
+// Doubles the active array and starts migrating the old one into it
+// @param table Table to grow
+// @return true on success, false on allocation failure
+static bool grow(sc_session_table_t *table) {
+  // A resize that is still running must finish before the next one starts
+  migrate(table, SIZE_MAX);
+
+  size_t capacity;
+  if (SC_MUL_OVERFLOW(table->active.mask + 1, (size_t) 2, &capacity)) {
+    return false;
+  }
+
+  sc_session_table_array_t next;
+  if (!array_init(&next, capacity)) {
+    return false;
+  }
+
+  table->retired = table->active;
+  table->active  = next;
+  table->resizes++;
+
+  // Begin migrating just past an empty slot so no probe run is split
+  size_t empty = 0;
+  while (table->retired.slots[empty].value) {
+    empty++;
+  }
+  table->migrate_pos  = (empty + 1) & table->retired.mask;
+  table->migrate_left = table->retired.mask + 1;
+
+  return true;
+}
+
+// ============================================================================
+// Lifecycle Functions
+// ============================================================================
+
+// Creates a session table
+// @param expected Number of entries the table should hold before its first resize
+// @return Pointer to the newly created table, or NULL on failure
+sc_session_table_t *sc_session_table_init(size_t expected) {
+  if (expected > SIZE_MAX / 8) {
+    log_error("Session table too large: %zu entries", expected);
+    return NULL;
+  }
+
+  // Keep the load factor at or below 3/4
+  size_t capacity = SC_SESSION_TABLE_MIN_CAPACITY;
+  while (capacity * 3 < expected * 4) {
+    capacity *= 2;
+  }
+
+  sc_session_table_t *table = calloc(1, sizeof(sc_session_table_t));
+  if (!table) {
+    log_error("%s", "Failed to allocate session table");
+    return NULL;
+  }
+
+  if (!array_init(&table->active, capacity)) {
+    log_error("%s", "Failed to allocate session table slots");
+    free(table);
+    return NULL;
+  }
+
+  return table;
+}
+
+// Destroys a session table
+// @param table Pointer to the table to destroy (may be NULL)
+void sc_session_table_nuke(sc_session_table_t *table) {
+  if (!table) {
+    return;
+  }
+
+  array_nuke(&table->retired);
+  array_nuke(&table->active);
+  free(table);
+}
+
+// ============================================================================
+// Operations
+// ============================================================================
+
+// Looks up a key
+// @param table Pointer to the table
+// @param key Key to look up
+// @return The stored value, or NULL if the key is not present
+void *sc_session_table_get(const sc_session_table_t *table, uint64_t key) {
+  if (!table) {
+    return NULL;
+  }
+
+  size_t i = array_find(&table->active, key);
+  if (i != SLOT_NOT_FOUND) {
+    return table->active.slots[i].value;
+  }
+
+  i = array_find(&table->retired, key);
+  if (i != SLOT_NOT_FOUND) {
+    return table->retired.slots[i].value;
+  }
+
+  return NULL;
+}
+
+// Inserts or replaces an entry
+// @param table Pointer to the table
+// @param key Key to store
+// @param value Value to store (must not be NULL)
+// @return 0 on success, -1 on error with errno set
+int sc_session_table_put(sc_session_table_t *table, uint64_t key, void *value) {
+  if (!table || !value) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  size_t i = array_find(&table->active, key);
+  if (i != SLOT_NOT_FOUND) {
+    table->active.slots[i].value = value;
+    return 0;
+  }
+
+  i = array_find(&table->retired, key);
+  if (i != SLOT_NOT_FOUND) {
+    table->retired.slots[i].value = value;
+    return 0;
+  }
+
+  size_t count = sc_session_table_count(table);
+  if ((count + 1) * 4 > (table->active.mask + 1) * 3 && !grow(table)) {
+    log_error("Failed to grow session table beyond %zu slots", table->active.mask + 1);
+    errno = ENOMEM;
+    return -1;
+  }
+
+  array_insert_new(&table->active, key, value);
+  migrate(table, SC_SESSION_TABLE_MIGRATE_STEP);
+  return 0;
+}
+
+// Removes an entry
+// @param table Pointer to the table
+// @param key Key to remove
+// @return The removed value, or NULL if the key was not present
+void *sc_session_table_remove(sc_session_table_t *table, uint64_t key) {
+  if (!table) {
+    return NULL;
+  }
+
+  void *value = NULL;
+
+  size_t i = array_find(&table->active, key);
+  if (i != SLOT_NOT_FOUND) {
+    value = table->active.slots[i].value;
+    array_delete(&table->active, i);
+  } else {
+    i = array_find(&table->retired, key);
+    if (i == SLOT_NOT_FOUND) {
+      return NULL;
+    }
+    value = table->retired.slots[i].value;
+    array_delete(&table->retired, i);
+  }
+
+  migrate(table, SC_SESSION_TABLE_MIGRATE_STEP);
+  return value;
+}
+
+// Visits every entry once, removing those the callback asks to remove
+// @param table Pointer to the table
+// @param fn Callback invoked for each entry
+// @param user_data Opaque pointer passed to fn
+void sc_session_table_sweep(sc_session_table_t *table, sc_session_table_sweep_fn fn,
+                            void *user_data) {
+  if (!table || !fn) {
+    return;
+  }
+
+  migrate(table, SIZE_MAX);
+
+  sc_session_table_array_t *array = &table->active;
+  if (array->count == 0) {
+    return;
+  }
+
+  // Start just past an empty slot: a deletion then only ever shifts entries
+  // that have not been visited yet into the slot being examined.
+  size_t i = 0;
+  while (array->slots[i].value) {
+    i++;
+  }
+
+  size_t left = array->mask + 1;
+  i           = (i + 1) & array->mask;
+  while (left > 0) {
+    sc_session_table_slot_t *slot = &array->slots[i];
+    if (slot->value && fn(slot->key, slot->value, user_data)) {
+      array_delete(array, i);
+      continue; // Re-examine whatever shifted into this slot
+    }
+    i = (i + 1) & array->mask;
+    left--;
+  }
+}
+
+// Gets the number of entries
+// @param table Pointer to the table
+// @return Number of entries, or 0 if table is NULL
+size_t sc_session_table_count(const sc_session_table_t *table) {
+  if (!table) {
+    return 0;
+  }
+  return table->active.count + table->retired.count;
+}
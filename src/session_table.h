@@ -0,0 +1,100 @@
+#ifndef SESSION_TABLE_H
+#define SESSION_TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <netinet/in.h>
+
+// Open-addressing hash table mapping 64-bit keys to session pointers.
+// Slots hold the key and value inline and are probed linearly, so a lookup
+// touches one or two cache lines. Deletion shifts the rest of the probe run
+// backwards instead of leaving tombstones, and growth migrates the old slots
+// a few at a time on later inserts and removals rather than all at once.
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+#define SC_SESSION_TABLE_MIN_CAPACITY 16 // Smallest slot array allocated
+#define SC_SESSION_TABLE_MIGRATE_STEP 16 // Retired slots migrated per insert/remove
+
+// ============================================================================
+// Type Definitions
+// ============================================================================
+
+// A single slot; a NULL value marks the slot empty
+typedef struct {
+  uint64_t key;
+  void *value;
+} sc_session_table_slot_t;
+
+// A power-of-two sized slot array
+typedef struct {
+  sc_session_table_slot_t *slots; // Slot storage (mask + 1 entries)
+  size_t mask;                    // Capacity - 1
+  size_t count;                   // Occupied slots
+} sc_session_table_array_t;
+
+// Session table
+typedef struct {
+  sc_session_table_array_t active;  // Receives every insert
+  sc_session_table_array_t retired; // Previous array while a resize is in progress
+  size_t migrate_pos;               // Next retired slot to migrate
+  size_t migrate_left;              // Retired slots not yet visited
+  uint64_t resizes;                 // Number of times the table has grown
+} sc_session_table_t;
+
+// Sweep callback: return true to remove the entry from the table. The table
+// only forgets the entry; the callback stays responsible for the value.
+typedef bool (*sc_session_table_sweep_fn)(uint64_t key, void *value, void *user_data);
+
+// ============================================================================
+// Key Helpers
+// ============================================================================
+
+// Build a table key from an IPv4 address and port (both in network byte order)
+static inline uint64_t sc_session_table_key(const struct sockaddr_in *addr) {
+  return ((uint64_t) addr->sin_addr.s_addr << 16) | (uint64_t) addr->sin_port;
+}
+
+// ============================================================================
+// Lifecycle Functions
+// ============================================================================
+
+// Create a table sized to hold expected entries without growing
+// Returns: Pointer to the table, or NULL on allocation failure
+sc_session_table_t *sc_session_table_init(size_t expected);
+
+// Destroy a table; stored values are not touched
+void sc_session_table_nuke(sc_session_table_t *table);
+
+// ============================================================================
+// Operations
+// ============================================================================
+
+// Look up the value stored under key
+// Returns: The stored value, or NULL if the key is not present
+void *sc_session_table_get(const sc_session_table_t *table, uint64_t key);
+
+// Insert or replace the value stored under key
+// Parameters:
+//   table: Table to modify
+//   key: Lookup key
+//   value: Value to store (must not be NULL)
+// Returns: 0 on success, or -1 on error with errno set (EINVAL or ENOMEM)
+int sc_session_table_put(sc_session_table_t *table, uint64_t key, void *value);
+
+// Remove the entry stored under key
+// Returns: The removed value, or NULL if the key was not present
+void *sc_session_table_remove(sc_session_table_t *table, uint64_t key);
+
+// Visit every entry once, removing those for which fn returns true
+// fn must not call back into the table.
+void sc_session_table_sweep(sc_session_table_t *table, sc_session_table_sweep_fn fn,
+                            void *user_data);
+
+// Number of entries in the table
+size_t sc_session_table_count(const sc_session_table_t *table);
+
+#endif // SESSION_TABLE_H
@@ -0,0 +1,181 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "slab.h"
+#include "log.h"
+#include "portability.h"
+
+// Slots per word of the in-use bitmap
+#define SLAB_BITS_PER_WORD 64
+
+// ============================================================================
+// Lifecycle Functions
+// ============================================================================
+
+// Creates a slab with all of its storage allocated up front
+// @param object_size Size in bytes of each object (must be > 0)
+// @param capacity Number of objects (must be > 0)
+// @return Pointer to the newly created slab, or NULL on failure
+sc_slab_t *sc_slab_init(size_t object_size, size_t capacity) {
+  if (object_size == 0 || capacity == 0) {
+    log_error("Invalid slab dimensions: object_size=%zu capacity=%zu", object_size, capacity);
+    return NULL;
+  }
+
+  size_t stride;
+  size_t storage_size;
+  if (SC_ADD_OVERFLOW(object_size, (size_t) SC_SLAB_ALIGN - 1, &stride)) {
+    log_error("Integer overflow sizing slab object (%zu bytes)", object_size);
+    return NULL;
+  }
+  stride -= stride % SC_SLAB_ALIGN;
+  if (SC_MUL_OVERFLOW(stride, capacity, &storage_size)) {
+    log_error("Integer overflow sizing slab (%zu x %zu)", stride, capacity);
+    return NULL;
+  }
+
+  sc_slab_t *slab = calloc(1, sizeof(sc_slab_t));
+  if (!slab) {
+    log_error("%s", "Failed to allocate slab");
+    return NULL;
+  }
+
+  // storage_size is a multiple of the alignment, as aligned_alloc requires
+  slab->storage    = aligned_alloc(SC_SLAB_ALIGN, storage_size);
+  slab->free_slots = calloc(capacity, sizeof(size_t));
+  slab->taken      = calloc(capacity / SLAB_BITS_PER_WORD + 1, sizeof(uint64_t));
+  if (!slab->storage || !slab->free_slots || !slab->taken) {
+    log_error("Failed to allocate slab storage (%zu bytes)", storage_size);
+    sc_slab_nuke(slab);
+    return NULL;
+  }
+
+  // Touch every page now rather than on first use of each slot
+  memset(slab->storage, 0, storage_size);
+
+  slab->object_size = object_size;
+  slab->stride      = stride;
+  slab->capacity    = capacity;
+
+  // Stack the free slots so the lowest index is handed out first
+  for (size_t i = 0; i < capacity; i++) {
+    slab->free_slots[i] = capacity - 1 - i;
+  }
+  slab->free_count = capacity;
+
+  return slab;
+}
+
+// Destroys a slab
+// @param slab Pointer to the slab to destroy (may be NULL)
+void sc_slab_nuke(sc_slab_t *slab) {
+  if (!slab) {
+    return;
+  }
+
+  free(slab->taken);
+  free(slab->free_slots);
+  free(slab->storage);
+  free(slab);
+}
+
+// ============================================================================
+// Operations
+// ============================================================================
+
+// Takes a free slot
+// The most recently returned slot is reused first, as it is the most likely
+// to still be in cache.
+// @param slab Pointer to the slab
+// @return Pointer to the slot, or NULL if the slab is exhausted
+void *sc_slab_alloc(sc_slab_t *slab) {
+  if (!slab) {
+    return NULL;
+  }
+
+  if (slab->free_count == 0) {
+    slab->exhausted++;
+    return NULL;
+  }
+
+  size_t index = slab->free_slots[--slab->free_count];
+  slab->taken[index / SLAB_BITS_PER_WORD] |= UINT64_C(1) << (index % SLAB_BITS_PER_WORD);
+
+  size_t in_use = slab->capacity - slab->free_count;
+  if (in_use > slab->high_water) {
+    slab->high_water = in_use;
+  }
+
+  return slab->storage + index * slab->stride;
+}
+
+// Returns a slot to the slab
+// @param slab Pointer to the slab
+// @param object Slot previously returned by sc_slab_alloc (may be NULL)
+void sc_slab_free(sc_slab_t *slab, void *object) {
+  if (!slab || !object) {
+    return;
+  }
+
+  size_t index = sc_slab_index(slab, object);
+  if (index == SIZE_MAX) {
+    log_error("%s", "Attempt to free an object that is not a slab slot");
+    return;
+  }
+
+  uint64_t *word = &slab->taken[index / SLAB_BITS_PER_WORD];
+  uint64_t bit   = UINT64_C(1) << (index % SLAB_BITS_PER_WORD);
+  if (!(*word & bit)) {
+    log_error("Attempt to free slab slot %zu, which is not in use", index);
+    return;
+  }
+
+  *word &= ~bit;
+
+  slab->free_slots[slab->free_count++] = index;
+}
+
+// Gets the address of a slot by index
+// @param slab Pointer to the slab
+// @param index Slot index
+// @return Pointer to the slot, or NULL if index is out of range
+void *sc_slab_slot(const sc_slab_t *slab, size_t index) {
+  if (!slab || index >= slab->capacity) {
+    return NULL;
+  }
+  return slab->storage + index * slab->stride;
+}
+
+// Gets the index of a slot by address
+// @param slab Pointer to the slab
+// @param object Pointer to a slot
+// @return Slot index, or SIZE_MAX if object is not a slot of this slab
+size_t sc_slab_index(const sc_slab_t *slab, const void *object) {
+  if (!sc_slab_contains(slab, object)) {
+    return SIZE_MAX;
+  }
+  return (size_t) ((const uint8_t *) object - slab->storage) / slab->stride;
+}
+
+// Checks whether a pointer refers to the start of a slot
+// @param slab Pointer to the slab
+// @param object Pointer to check
+// @return true if object is a slot of this slab
+bool sc_slab_contains(const sc_slab_t *slab, const void *object) {
+  if (!slab || !object) {
+    return false;
+  }
+
+  const uint8_t *p = object;
+  if (p < slab->storage || p >= slab->storage + slab->capacity * slab->stride) {
+    return false;
+  }
+  return (size_t) (p - slab->storage) % slab->stride == 0;
+}
+
+// Gets the number of slots in use
+// @param slab Pointer to the slab
+// @return Slots currently taken, or 0 if slab is NULL
+size_t sc_slab_in_use(const sc_slab_t *slab) {
+  return slab ? slab->capacity - slab->free_count : 0;
+}
@@ -0,0 +1,73 @@
+#ifndef SLAB_H
+#define SLAB_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Fixed-capacity object pool. All slots are carved out of a single allocation
+// made at init time, so taking and returning objects never calls malloc and
+// long-lived servers do not fragment the heap as objects churn. Returned slots
+// keep their contents, which lets owners keep expensive per-object state
+// (such as set-up TLS contexts) across reuse.
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+#define SC_SLAB_ALIGN 64 // Slot alignment; one cache line so slots never share lines
+
+// ============================================================================
+// Type Definitions
+// ============================================================================
+
+typedef struct {
+  uint8_t *storage;   // capacity * stride bytes
+  size_t object_size; // Requested object size
+  size_t stride;      // Distance between slots (object_size rounded up to SC_SLAB_ALIGN)
+  size_t capacity;    // Number of slots
+  size_t *free_slots; // Stack of free slot indexes
+  size_t free_count;  // Entries on the free stack
+  uint64_t *taken;    // Bit per slot, set while the slot is in use
+  size_t high_water;  // Most slots ever in use at once
+  uint64_t exhausted; // Allocations refused because every slot was taken
+} sc_slab_t;
+
+// ============================================================================
+// Lifecycle Functions
+// ============================================================================
+
+// Create a slab of capacity slots of object_size bytes each
+// Returns: Pointer to the slab, or NULL on invalid parameters or allocation failure
+sc_slab_t *sc_slab_init(size_t object_size, size_t capacity);
+
+// Destroy a slab and its storage; objects still in use become invalid
+void sc_slab_nuke(sc_slab_t *slab);
+
+// ============================================================================
+// Operations
+// ============================================================================
+
+// Take a free slot; its contents are whatever the previous owner left there
+// Returns: Pointer to the slot, or NULL if every slot is in use
+void *sc_slab_alloc(sc_slab_t *slab);
+
+// Return a slot taken with sc_slab_alloc
+// A pointer that is not a slot, or a slot that is already free, is logged and
+// ignored, so a double free can never hand one slot to two owners.
+void sc_slab_free(sc_slab_t *slab, void *object);
+
+// Address of slot index (0 <= index < capacity), whether in use or not
+void *sc_slab_slot(const sc_slab_t *slab, size_t index);
+
+// Index of the slot object points at, the inverse of sc_slab_slot()
+// Returns: Slot index, or SIZE_MAX if object is not a slot of this slab
+size_t sc_slab_index(const sc_slab_t *slab, const void *object);
+
+// Whether object points at a slot of this slab
+bool sc_slab_contains(const sc_slab_t *slab, const void *object);
+
+// Number of slots currently in use
+size_t sc_slab_in_use(const sc_slab_t *slab);
+
+#endif // SLAB_H
@@ -0,0 +1,447 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "spsc_queue.h"
+#include "log.h"
+#include "portability.h"
+
+// Items sc_spsc_queue_drain() takes out at a time
+#define DRAIN_BATCH 64
+
+// ============================================================================
+// Internal Helper Functions
+// ============================================================================
+
+// Adds an item if there is room
+// @param q Pointer to the queue
+// @param item Item to add
+// @return true if the item was added, false if the queue is full
+static bool enqueue(sc_spsc_queue_t *q, void *item) {
+  size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+  if (tail - q->head_cache >= q->capacity) {
+    q->head_cache = atomic_load_explicit(&q->head, memory_order_acquire);
+    if (tail - q->head_cache >= q->capacity) {
+      return false;
+    }
+  }
+  q->buffer[tail & q->mask] = item;
+  atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+  return true;
+}
+
+// Removes the oldest item if there is one
+// @param q Pointer to the queue
+// @param item Pointer to store the item
+// @return true if an item was removed, false if the queue is empty
+static bool dequeue(sc_spsc_queue_t *q, void **item) {
+  size_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+  if (head == q->tail_cache) {
+    q->tail_cache = atomic_load_explicit(&q->tail, memory_order_acquire);
+    if (head == q->tail_cache) {
+      return false;
+    }
+  }
+  *item = q->buffer[head & q->mask];
+  atomic_store_explicit(&q->head, head + 1, memory_order_release);
+  return true;
+}
+
+// Adds up to count items, as many as there is room for
+// @param q Pointer to the queue
+// @param items Items to add, oldest first
+// @param count Number of items
+// @return Number of items added, 0 if the queue is full
+static size_t enqueue_n(sc_spsc_queue_t *q, void *const *items, size_t count) {
+  size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+  size_t room = q->capacity - (tail - q->head_cache);
+  if (room < count) {
+    q->head_cache = atomic_load_explicit(&q->head, memory_order_acquire);
+    room          = q->capacity - (tail - q->head_cache);
+  }
+  size_t added = room < count ? room : count;
+  for (size_t i = 0; i < added; i++) {
+    q->buffer[(tail + i) & q->mask] = items[i];
+  }
+  if (added > 0) {
+    atomic_store_explicit(&q->tail, tail + added, memory_order_release);
+  }
+  return added;
+}
+
+// Removes up to max of the oldest items
+// @param q Pointer to the queue
+// @param items Array receiving the items, oldest first
+// @param max Capacity of items
+// @return Number of items removed, 0 if the queue is empty
+static size_t dequeue_n(sc_spsc_queue_t *q, void **items, size_t max) {
+  size_t head      = atomic_load_explicit(&q->head, memory_order_relaxed);
+  size_t available = q->tail_cache - head;
+  if (available < max) {
+    q->tail_cache = atomic_load_explicit(&q->tail, memory_order_acquire);
+    available     = q->tail_cache - head;
+  }
+  size_t removed = available < max ? available : max;
+  for (size_t i = 0; i < removed; i++) {
+    items[i] = q->buffer[(head + i) & q->mask];
+  }
+  if (removed > 0) {
+    atomic_store_explicit(&q->head, head + removed, memory_order_release);
+  }
+  return removed;
+}
+
+// Context of a blocked add or pop, for retrying it in sc_queue_wait()
+typedef struct {
+  sc_spsc_queue_t *q;
+  void *item;
+  void **out;
+} retry_t;
+
+// Retries a blocked add
+// @param ctx retry_t of the add
+// @return true once the item was added
+static bool retry_add(void *ctx) {
+  retry_t *retry = ctx;
+  return enqueue(retry->q, retry->item);
+}
+
+// Retries a blocked pop
+// @param ctx retry_t of the pop
+// @return true once an item was removed
+static bool retry_pop(void *ctx) {
+  retry_t *retry = ctx;
+  return dequeue(retry->q, retry->out);
+}
+
+// Blocks until an item fits in a full queue and adds it
+// @return true once the item was added, false if the deadline passed first
+static bool wait_add(sc_spsc_queue_t *q, void *item, uint64_t deadline_ns) {
+  retry_t retry = {.q = q, .item = item};
+  return sc_queue_wait(&q->not_full, retry_add, &retry, deadline_ns);
+}
+
+// Blocks until an empty queue has an item and removes it
+// @return true once an item was removed, false if the deadline passed first
+static bool wait_pop(sc_spsc_queue_t *q, void **item, uint64_t deadline_ns) {
+  retry_t retry = {.q = q, .out = item};
+  return sc_queue_wait(&q->not_empty, retry_pop, &retry, deadline_ns);
+}
+
+// ============================================================================
+// Queue Lifecycle Functions
+// ============================================================================
+
+// Creates a queue
+// The ring is capacity rounded up to a power of two, so positions map to
+// items with a mask; the queue still holds at most capacity items.
+// @param capacity Maximum number of items (must be > 0)
+// @return Pointer to the newly created queue, or NULL on failure
+sc_spsc_queue_t *sc_spsc_queue_init(size_t capacity) {
+  if (capacity == 0 || capacity > SC_GENERIC_QUEUE_MAX_CAPACITY) {
+    log_error("Invalid capacity: %zu (max: %zu)", capacity, SC_GENERIC_QUEUE_MAX_CAPACITY);
+    return NULL;
+  }
+
+  size_t ring = 1;
+  while (ring < capacity) {
+    ring <<= 1;
+  }
+  size_t ring_size;
+  if (SC_MUL_OVERFLOW(ring, sizeof(void *), &ring_size)) {
+    log_error("Integer overflow calculating ring size for capacity %zu", capacity);
+    return NULL;
+  }
+
+  // sizeof is a multiple of the alignment, as aligned_alloc requires
+  sc_spsc_queue_t *q = aligned_alloc(alignof(sc_spsc_queue_t), sizeof(sc_spsc_queue_t));
+  if (!q) {
+    log_error("%s", "Failed to allocate memory for queue");
+    return NULL;
+  }
+  memset(q, 0, sizeof(*q));
+
+  q->buffer = calloc(ring, sizeof(void *));
+  if (!q->buffer) {
+    log_error("%s", "Failed to allocate memory for queue ring");
+    free(q);
+    return NULL;
+  }
+
+  atomic_init(&q->tail, 0);
+  atomic_init(&q->head, 0);
+  q->mask     = ring - 1;
+  q->capacity = capacity;
+
+  sc_queue_wait_init(&q->not_empty);
+  sc_queue_wait_init(&q->not_full);
+
+  return q;
+}
+
+// Destroys a queue and frees its resources
+// Note: Does not free items still in the queue - caller is responsible
+// @param q Pointer to the queue to destroy
+// @return SC_GENERIC_QUEUE_SUCCESS, or SC_GENERIC_QUEUE_ERR_NULL
+sc_generic_queue_ret_val_t sc_spsc_queue_nuke(sc_spsc_queue_t *q) {
+  if (q == NULL) {
+    return SC_GENERIC_QUEUE_ERR_NULL;
+  }
+
+  free(q->buffer);
+  free(q);
+  return SC_GENERIC_QUEUE_SUCCESS;
+}
+
+// Destroys a queue and applies a cleanup function to all remaining items
+// No other thread may use the queue once this is called.
+// @param q Pointer to the queue to destroy (may be NULL)
+// @param cleanup_fn Optional callback to process each remaining item (can be NULL)
+// @param user_data Optional user data passed to the cleanup function
+void sc_spsc_queue_nuke_with_cleanup(sc_spsc_queue_t *q, sc_generic_queue_cleanup_fn cleanup_fn,
+                                     void *user_data) {
+  if (q == NULL) {
+    return;
+  }
+
+  void *item;
+  while (dequeue(q, &item)) {
+    if (cleanup_fn != NULL) {
+      cleanup_fn(item, user_data);
+    }
+  }
+  sc_spsc_queue_nuke(q);
+}
+
+// ============================================================================
+// Queue Operations
+// ============================================================================
+
+// Adds an item to the queue, blocking if the queue is full
+// @param q Pointer to the queue (must not be NULL)
+// @param item Pointer to the item to add (must not be NULL)
+// @return SC_GENERIC_QUEUE_SUCCESS on success, or an error code on failure
+sc_generic_queue_ret_val_t sc_spsc_queue_add(sc_spsc_queue_t *q, void *item) {
+  if (q == NULL || item == NULL) {
+    return SC_GENERIC_QUEUE_ERR_NULL;
+  }
+
+  if (!enqueue(q, item)) {
+    if (!wait_add(q, item, sc_queue_deadline(SC_GENERIC_QUEUE_ADD_TIMEOUT_NS))) {
+      log_error("sc_spsc_queue_add timed out after %llu ms",
+                SC_GENERIC_QUEUE_ADD_TIMEOUT_NS / SC_QUEUE_NS_PER_MS);
+      return SC_GENERIC_QUEUE_ERR_TIMEOUT;
+    }
+  }
+
+  sc_queue_wake(&q->not_empty);
+  return SC_GENERIC_QUEUE_SUCCESS;
+}
+
+// Removes and returns the oldest item, blocking if the queue is empty
+// @param q Pointer to the queue (must not be NULL)
+// @param item Pointer to store the removed item (must not be NULL)
+// @return SC_GENERIC_QUEUE_SUCCESS on success, or an error code on failure
+sc_generic_queue_ret_val_t sc_spsc_queue_pop(sc_spsc_queue_t *q, void **item) {
+  if (q == NULL || item == NULL) {
+    return SC_GENERIC_QUEUE_ERR_NULL;
+  }
+
+  *item = NULL;
+  if (!dequeue(q, item)) {
+    if (!wait_pop(q, item, sc_queue_deadline(SC_GENERIC_QUEUE_POP_TIMEOUT_NS))) {
+      log_error("sc_spsc_queue_pop timed out after %llu ms",
+                SC_GENERIC_QUEUE_POP_TIMEOUT_NS / SC_QUEUE_NS_PER_MS);
+      return SC_GENERIC_QUEUE_ERR_TIMEOUT;
+    }
+  }
+
+  sc_queue_wake(&q->not_full);
+  return SC_GENERIC_QUEUE_SUCCESS;
+}
+
+// Adds an item to the queue, blocking until a deadline if the queue is full
+// @param q Pointer to the queue (must not be NULL)
+// @param item Pointer to the item to add (must not be NULL)
+// @param deadline_ns Absolute CLOCK_MONOTONIC time in nanoseconds to give up at
+// @return SC_GENERIC_QUEUE_SUCCESS, SC_GENERIC_QUEUE_ERR_TIMEOUT, or an error code
+sc_generic_queue_ret_val_t sc_spsc_queue_add_until(sc_spsc_queue_t *q, void *item,
+                                                  uint64_t deadline_ns) {
+  if (q == NULL || item == NULL) {
+    return SC_GENERIC_QUEUE_ERR_NULL;
+  }
+  if (!enqueue(q, item) && !wait_add(q, item, deadline_ns)) {
+    return SC_GENERIC_QUEUE_ERR_TIMEOUT;
+  }
+
+  sc_queue_wake(&q->not_empty);
+  return SC_GENERIC_QUEUE_SUCCESS;
+}
+
+// Removes and returns the oldest item, blocking until a deadline if the queue is empty
+// @param q Pointer to the queue (must not be NULL)
+// @param item Pointer to store the removed item (must not be NULL)
+// @param deadline_ns Absolute CLOCK_MONOTONIC time in nanoseconds to give up at
+// @return SC_GENERIC_QUEUE_SUCCESS, SC_GENERIC_QUEUE_ERR_TIMEOUT, or an error code
+sc_generic_queue_ret_val_t sc_spsc_queue_pop_until(sc_spsc_queue_t *q, void **item,
+                                                  uint64_t deadline_ns) {
+  if (q == NULL || item == NULL) {
+    return SC_GENERIC_QUEUE_ERR_NULL;
+  }
+
+  *item = NULL;
+  if (!dequeue(q, item) && !wait_pop(q, item, deadline_ns)) {
+    return SC_GENERIC_QUEUE_ERR_TIMEOUT;
+  }
+
+  sc_queue_wake(&q->not_full);
+  return SC_GENERIC_QUEUE_SUCCESS;
+}
+
+// Attempts to add an item to the queue without blocking
+// @param q Pointer to the queue (must not be NULL)
+// @param item Pointer to the item to add (must not be NULL)
+// @return SC_GENERIC_QUEUE_SUCCESS on success, SC_GENERIC_QUEUE_ERR_FULL if full, or error code
+sc_generic_queue_ret_val_t sc_spsc_queue_try_add(sc_spsc_queue_t *q, void *item) {
+  if (q == NULL || item == NULL) {
+    return SC_GENERIC_QUEUE_ERR_NULL;
+  }
+  if (!enqueue(q, item)) {
+    return SC_GENERIC_QUEUE_ERR_FULL;
+  }
+
+  sc_queue_wake(&q->not_empty);
+  return SC_GENERIC_QUEUE_SUCCESS;
+}
+
+// Attempts to remove and return the oldest item without blocking
+// @param q Pointer to the queue (must not be NULL)
+// @param item Pointer to store the removed item (must not be NULL)
+// @return SC_GENERIC_QUEUE_SUCCESS on success, SC_GENERIC_QUEUE_ERR_EMPTY if empty, or error code
+sc_generic_queue_ret_val_t sc_spsc_queue_try_pop(sc_spsc_queue_t *q, void **item) {
+  if (q == NULL || item == NULL) {
+    return SC_GENERIC_QUEUE_ERR_NULL;
+  }
+
+  *item = NULL;
+  if (!dequeue(q, item)) {
+    return SC_GENERIC_QUEUE_ERR_EMPTY;
+  }
+
+  sc_queue_wake(&q->not_full);
+  return SC_GENERIC_QUEUE_SUCCESS;
+}
+
+// ============================================================================
+// Queue Operations - Batch
+// ============================================================================
+
+// Producer only: adds as many items as fit without blocking
+// @param q Pointer to the queue (must not be NULL)
+// @param items Items to add, oldest first (none may be NULL)
+// @param count Number of items
+// @return Number of items added, from the start of items; 0 on error
+size_t sc_spsc_queue_add_n(sc_spsc_queue_t *q, void *const *items, size_t count) {
+  if (q == NULL || items == NULL) {
+    return 0;
+  }
+  for (size_t i = 0; i < count; i++) {
+    if (items[i] == NULL) {
+      return 0;
+    }
+  }
+
+  size_t added = 0;
+  while (added < count) {
+    size_t claimed = enqueue_n(q, items + added, count - added);
+    if (claimed == 0) {
+      break;
+    }
+    added += claimed;
+  }
+
+  if (added > 0) {
+    sc_queue_wake(&q->not_empty);
+  }
+  return added;
+}
+
+// Consumer only: removes up to max items without blocking
+// @param q Pointer to the queue (must not be NULL)
+// @param items Array receiving the items, oldest first (must not be NULL)
+// @param max Capacity of items
+// @return Number of items removed; 0 on error
+size_t sc_spsc_queue_pop_n(sc_spsc_queue_t *q, void **items, size_t max) {
+  if (q == NULL || items == NULL) {
+    return 0;
+  }
+
+  size_t removed = max > 0 ? dequeue_n(q, items, max) : 0;
+  if (removed > 0) {
+    sc_queue_wake(&q->not_full);
+  }
+  return removed;
+}
+
+// Consumer only: removes the items in the queue at the time of the call and
+// passes each to fn
+// Items are taken DRAIN_BATCH at a time, and their slots handed back to the
+// producer before fn sees them.
+// @param q Pointer to the queue (must not be NULL)
+// @param fn Callback taking ownership of each item (must not be NULL)
+// @param user_data Optional user data passed to fn
+// @return Number of items passed to fn; 0 on error
+size_t sc_spsc_queue_drain(sc_spsc_queue_t *q, sc_generic_queue_item_fn fn, void *user_data) {
+  if (q == NULL || fn == NULL) {
+    return 0;
+  }
+
+  size_t limit   = sc_spsc_queue_get_size(q);
+  size_t drained = 0;
+  while (drained < limit) {
+    void *batch[DRAIN_BATCH];
+    size_t want    = limit - drained < DRAIN_BATCH ? limit - drained : DRAIN_BATCH;
+    size_t claimed = dequeue_n(q, batch, want);
+    if (claimed == 0) {
+      break;
+    }
+    sc_queue_wake(&q->not_full);
+
+    for (size_t i = 0; i < claimed; i++) {
+      fn(batch[i], user_data);
+    }
+    drained += claimed;
+  }
+  return drained;
+}
+
+// ============================================================================
+// Queue Status Functions
+// ============================================================================
+
+// Gets the current number of items in the queue (thread-safe)
+// @param q Pointer to the queue
+// @return Number of items, as of some moment during the call; 0 if q is NULL
+size_t sc_spsc_queue_get_size(const sc_spsc_queue_t *q) {
+  if (q == NULL) {
+    return 0;
+  }
+  // Head first: tail read afterwards can only be further ahead of it
+  size_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+  size_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+  size_t size = tail - head;
+  return size > q->capacity ? q->capacity : size;
+}
+
+// Checks if the queue is empty (thread-safe)
+// @param q Pointer to the queue
+// @return true if the queue is empty, false otherwise (including if q is NULL)
+bool sc_spsc_queue_is_empty(const sc_spsc_queue_t *q) {
+  return q != NULL && sc_spsc_queue_get_size(q) == 0;
+}
+
+// Checks if the queue is full (thread-safe)
+// @param q Pointer to the queue
+// @return true if the queue is full, false otherwise (including if q is NULL)
+bool sc_spsc_queue_is_full(const sc_spsc_queue_t *q) {
+  return q != NULL && sc_spsc_queue_get_size(q) == q->capacity;
+}
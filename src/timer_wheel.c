@@ -0,0 +1,257 @@
+#include <stdlib.h>
+#include <time.h>
+
+#include "timer_wheel.h"
+#include "log.h"
+
+#define SLOT_MASK ((uint64_t) SC_TIMER_WHEEL_SLOTS - 1)
+
+// Furthest a timer can be placed ahead of the current tick; timers beyond
+// this are parked in the top level and re-cascaded until they come into range
+#define MAX_DELTA ((uint64_t) 1 << (SC_TIMER_WHEEL_BITS * SC_TIMER_WHEEL_LEVELS))
+
+// ============================================================================
+// Internal Helper Functions
+// ============================================================================
+
+// Number of bits a tick is shifted by to get its slot index on a level
+// @param level Wheel level
+// @return Shift for that level
+static inline unsigned level_shift(size_t level) {
+  return (unsigned) (SC_TIMER_WHEEL_BITS * level);
+}
+
+// Links a timer into the slot matching its expiry tick
+// A timer due in fewer than SLOTS^(n+1) ticks goes on level n, in the slot
+// that will be cascaded (or, on level 0, fired) when its tick comes up.
+// @param wheel Timer wheel
+// @param timer Unlinked timer with expires >= wheel->current
+static void link_timer(sc_timer_wheel_t *wheel, sc_timer_t *timer) {
+  uint64_t expires = timer->expires;
+  if (expires - wheel->current >= MAX_DELTA) {
+    expires = wheel->current + MAX_DELTA - 1;
+  }
+
+  uint64_t delta = expires - wheel->current;
+  size_t level   = 0;
+  while (delta >> level_shift(level + 1)) {
+    level++;
+  }
+
+  sc_timer_t **head = &wheel->slots[level][(expires >> level_shift(level)) & SLOT_MASK];
+  timer->next       = *head;
+  if (*head) {
+    (*head)->pprev = &timer->next;
+  }
+  *head        = timer;
+  timer->pprev = head;
+}
+
+// Unlinks a pending timer from its slot
+// @param timer Pending timer
+static void unlink_timer(sc_timer_t *timer) {
+  *timer->pprev = timer->next;
+  if (timer->next) {
+    timer->next->pprev = timer->pprev;
+  }
+  timer->next  = NULL;
+  timer->pprev = NULL;
+}
+
+// Redistributes the current slot of a level onto the levels below it
+// @param wheel Timer wheel
+// @param level Level to cascade (> 0)
+static void cascade(sc_timer_wheel_t *wheel, size_t level) {
+  sc_timer_t **head = &wheel->slots[level][(wheel->current >> level_shift(level)) & SLOT_MASK];
+  while (*head) {
+    sc_timer_t *timer = *head;
+    unlink_timer(timer);
+    link_timer(wheel, timer);
+  }
+}
+
+// Converts a clock reading to a tick, rounding down
+// @param wheel Timer wheel
+// @param ms Clock reading in milliseconds
+// @return Tick containing ms
+static uint64_t ms_to_tick(const sc_timer_wheel_t *wheel, uint64_t ms) {
+  return ms <= wheel->start_ms ? 0 : (ms - wheel->start_ms) / wheel->tick_ms;
+}
+
+// ============================================================================
+// Lifecycle Functions
+// ============================================================================
+
+// Creates a timer wheel
+// @param tick_ms Resolution in milliseconds (must be > 0)
+// @param now_ms Current clock reading, which becomes tick 0
+// @return Pointer to the newly created wheel, or NULL on failure
+sc_timer_wheel_t *sc_timer_wheel_init(uint64_t tick_ms, uint64_t now_ms) {
+  if (tick_ms == 0) {
+    log_error("%s", "Timer wheel tick must be non-zero");
+    return NULL;
+  }
+
+  sc_timer_wheel_t *wheel = calloc(1, sizeof(sc_timer_wheel_t));
+  if (!wheel) {
+    log_error("%s", "Failed to allocate timer wheel");
+    return NULL;
+  }
+
+  wheel->start_ms = now_ms;
+  wheel->tick_ms  = tick_ms;
+  return wheel;
+}
+
+// Destroys a timer wheel without firing pending timers
+// @param wheel Pointer to the wheel to destroy (may be NULL)
+void sc_timer_wheel_nuke(sc_timer_wheel_t *wheel) {
+  free(wheel);
+}
+
+// ============================================================================
+// Timer Operations
+// ============================================================================
+
+// Initializes a timer
+// @param timer Timer to initialize
+// @param fn Callback run when the timer expires
+// @param data Opaque pointer passed to fn
+void sc_timer_init(sc_timer_t *timer, sc_timer_fn fn, void *data) {
+  timer->next    = NULL;
+  timer->pprev   = NULL;
+  timer->expires = 0;
+  timer->fn      = fn;
+  timer->data    = data;
+}
+
+// Checks whether a timer is scheduled
+// @param timer Timer to check
+// @return true if the timer is linked into a wheel
+bool sc_timer_pending(const sc_timer_t *timer) {
+  return timer->pprev != NULL;
+}
+
+// Arms or re-arms a timer
+// Re-arming to the same tick is free, so callers can re-arm on every event.
+// @param wheel Timer wheel
+// @param timer Initialized timer
+// @param expires_ms Absolute deadline on the wheel's clock
+void sc_timer_wheel_schedule(sc_timer_wheel_t *wheel, sc_timer_t *timer, uint64_t expires_ms) {
+  // Round up so a timer never fires before its deadline, and never into the
+  // tick that has already been processed
+  uint64_t expires = ms_to_tick(wheel, expires_ms);
+  if (expires_ms > wheel->start_ms && (expires_ms - wheel->start_ms) % wheel->tick_ms != 0) {
+    expires++;
+  }
+  if (expires <= wheel->current) {
+    expires = wheel->current + 1;
+  }
+
+  if (sc_timer_pending(timer)) {
+    if (timer->expires == expires) {
+      return;
+    }
+    unlink_timer(timer);
+    wheel->count--;
+  }
+
+  timer->expires = expires;
+  link_timer(wheel, timer);
+  wheel->count++;
+}
+
+// Disarms a timer
+// @param wheel Timer wheel the timer was scheduled on
+// @param timer Timer to cancel
+void sc_timer_wheel_cancel(sc_timer_wheel_t *wheel, sc_timer_t *timer) {
+  if (!sc_timer_pending(timer)) {
+    return;
+  }
+  unlink_timer(timer);
+  wheel->count--;
+}
+
+// ============================================================================
+// Wheel Operations
+// ============================================================================
+
+// Processes every tick up to now_ms, firing the timers that are due
+// @param wheel Timer wheel
+// @param now_ms Current clock reading
+// @return Number of timers fired
+size_t sc_timer_wheel_advance(sc_timer_wheel_t *wheel, uint64_t now_ms) {
+  uint64_t target = ms_to_tick(wheel, now_ms);
+  size_t fired    = 0;
+
+  while (wheel->current < target) {
+    // Nothing to cascade or fire, skip straight to the target tick
+    if (wheel->count == 0) {
+      wheel->current = target;
+      break;
+    }
+
+    wheel->current++;
+
+    // When a level wraps, its parent's next slot comes due. Cascade from the
+    // highest wrapping level down so timers land in slots not yet processed.
+    size_t top = 0;
+    while (top + 1 < SC_TIMER_WHEEL_LEVELS &&
+           ((wheel->current >> level_shift(top)) & SLOT_MASK) == 0) {
+      top++;
+    }
+    for (size_t level = top; level > 0; level--) {
+      cascade(wheel, level);
+    }
+
+    // Pop one timer at a time: callbacks may cancel or re-arm other timers
+    sc_timer_t **head = &wheel->slots[0][wheel->current & SLOT_MASK];
+    while (*head) {
+      sc_timer_t *timer = *head;
+      unlink_timer(timer);
+      wheel->count--;
+      fired++;
+      timer->fn(timer, timer->data);
+    }
+  }
+
+  return fired;
+}
+
+// Finds the earliest time the wheel may need advancing
+// @param wheel Timer wheel
+// @return Absolute time in milliseconds, or UINT64_MAX if nothing is pending
+uint64_t sc_timer_wheel_next_expiry(const sc_timer_wheel_t *wheel) {
+  if (wheel->count == 0) {
+    return UINT64_MAX;
+  }
+
+  uint64_t best = UINT64_MAX;
+  for (size_t level = 0; level < SC_TIMER_WHEEL_LEVELS; level++) {
+    unsigned shift = level_shift(level);
+    uint64_t base  = wheel->current >> shift;
+
+    // The first occupied slot ahead of the current one on this level is due
+    // (level 0) or cascaded (higher levels) at the start of its window
+    for (uint64_t i = 1; i <= SC_TIMER_WHEEL_SLOTS; i++) {
+      uint64_t window = base + i;
+      if (wheel->slots[level][window & SLOT_MASK]) {
+        uint64_t tick = window << shift;
+        if (tick < best) {
+          best = tick;
+        }
+        break;
+      }
+    }
+  }
+
+  return wheel->start_ms + best * wheel->tick_ms;
+}
+
+// Reads the monotonic clock
+// @return Milliseconds since an arbitrary fixed point
+uint64_t sc_timer_wheel_now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000u + (uint64_t) ts.tv_nsec / 1000000u;
+}
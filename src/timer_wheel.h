@@ -0,0 +1,103 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Hierarchical timer wheel. Timers are intrusive (embedded in the object they
+// time out), so arming, re-arming and cancelling are O(1) pointer updates with
+// no allocation. Each level has SC_TIMER_WHEEL_SLOTS slots; level 0 slots are
+// one tick wide and each higher level is SC_TIMER_WHEEL_SLOTS times coarser.
+// Timers on higher levels are cascaded down as their slot comes due, so the
+// work done per tick is proportional to the timers that actually expire.
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+#define SC_TIMER_WHEEL_BITS   6 // log2 of slots per level
+#define SC_TIMER_WHEEL_SLOTS  (1u << SC_TIMER_WHEEL_BITS)
+#define SC_TIMER_WHEEL_LEVELS 4 // Range: SLOTS^LEVELS ticks (16.7M)
+
+// ============================================================================
+// Type Definitions
+// ============================================================================
+
+typedef struct sc_timer sc_timer_t;
+
+// Expiry callback; the timer is no longer pending when this runs and may be
+// re-armed or freed by the callback
+typedef void (*sc_timer_fn)(sc_timer_t *timer, void *data);
+
+// Intrusive timer, embedded in the object it belongs to
+struct sc_timer {
+  sc_timer_t *next;   // Next timer in the same slot
+  sc_timer_t **pprev; // Link pointing at this timer, NULL when not pending
+  uint64_t expires;   // Expiry tick
+  sc_timer_fn fn;     // Expiry callback
+  void *data;         // Opaque pointer passed to fn
+};
+
+// Timer wheel
+typedef struct {
+  sc_timer_t *slots[SC_TIMER_WHEEL_LEVELS][SC_TIMER_WHEEL_SLOTS];
+  uint64_t start_ms; // Clock reading that corresponds to tick 0
+  uint64_t tick_ms;  // Tick length in milliseconds
+  uint64_t current;  // Last tick processed by sc_timer_wheel_advance
+  size_t count;      // Pending timers
+} sc_timer_wheel_t;
+
+// ============================================================================
+// Lifecycle Functions
+// ============================================================================
+
+// Create a timer wheel
+// Parameters:
+//   tick_ms: Resolution in milliseconds (must be > 0)
+//   now_ms: Current reading of the clock later passed to sc_timer_wheel_advance
+// Returns: Pointer to the wheel, or NULL on invalid parameters or allocation failure
+sc_timer_wheel_t *sc_timer_wheel_init(uint64_t tick_ms, uint64_t now_ms);
+
+// Destroy a timer wheel; pending timers are forgotten, not fired
+void sc_timer_wheel_nuke(sc_timer_wheel_t *wheel);
+
+// ============================================================================
+// Timer Operations
+// ============================================================================
+
+// Prepare a timer for use; must be called once before the timer is scheduled
+void sc_timer_init(sc_timer_t *timer, sc_timer_fn fn, void *data);
+
+// Whether the timer is currently scheduled
+bool sc_timer_pending(const sc_timer_t *timer);
+
+// Arm a timer, or move it if it is already pending
+// The timer fires on the first sc_timer_wheel_advance at or after expires_ms,
+// rounded up to the wheel's resolution; deadlines in the past fire on the next advance.
+// Parameters:
+//   wheel: Timer wheel
+//   timer: Initialized timer
+//   expires_ms: Absolute deadline on the wheel's clock
+void sc_timer_wheel_schedule(sc_timer_wheel_t *wheel, sc_timer_t *timer, uint64_t expires_ms);
+
+// Disarm a timer; does nothing if it is not pending
+void sc_timer_wheel_cancel(sc_timer_wheel_t *wheel, sc_timer_t *timer);
+
+// ============================================================================
+// Wheel Operations
+// ============================================================================
+
+// Run every timer whose deadline is at or before now_ms
+// Returns: Number of timers fired
+size_t sc_timer_wheel_advance(sc_timer_wheel_t *wheel, uint64_t now_ms);
+
+// Earliest time at which sc_timer_wheel_advance may have work to do
+// Exact for timers due within SC_TIMER_WHEEL_SLOTS ticks, otherwise a lower bound.
+// Returns: Absolute time in milliseconds, or UINT64_MAX if no timers are pending
+uint64_t sc_timer_wheel_next_expiry(const sc_timer_wheel_t *wheel);
+
+// Read the monotonic clock in milliseconds
+uint64_t sc_timer_wheel_now_ms(void);
+
+#endif // TIMER_WHEEL_H
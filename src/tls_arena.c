@@ -0,0 +1,300 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+#include "tls_arena.h"
+#include "portability.h"
+
+// Smallest size class; every class is a multiple of it, so blocks carved from
+// a malloc'd chunk keep malloc's 16-byte alignment
+#define TLS_ARENA_MIN_BLOCK 32
+
+// Precedes every block handed out; the caller's memory starts right after it
+typedef struct {
+  sc_tls_arena_t *owner; // Arena entered when the block was allocated, NULL for none
+  uint32_t bytes;        // Block size, header included
+  uint32_t phase;        // owner->phase at the time
+} block_header_t;
+
+_Static_assert(sizeof(block_header_t) == 16, "block header must keep 16-byte alignment");
+
+// A block on a free list or in an arena's cache
+typedef struct free_block {
+  struct free_block *next;
+} free_block_t;
+
+// Shared free list of one size class
+typedef struct {
+  pthread_mutex_t lock;
+  free_block_t *free;
+} size_class_t;
+
+static size_class_t g_classes[SC_TLS_ARENA_CLASSES];
+static pthread_once_t g_classes_once = PTHREAD_ONCE_INIT;
+static _Atomic size_t g_chunk_bytes;
+static _Atomic size_t g_in_use_bytes;
+static _Atomic size_t g_large_bytes;
+
+static thread_local sc_tls_arena_t *t_arena = NULL;
+
+// ============================================================================
+// Size Classes
+// ============================================================================
+
+static void init_classes(void) {
+  for (size_t i = 0; i < SC_TLS_ARENA_CLASSES; i++) {
+    pthread_mutex_init(&g_classes[i].lock, NULL);
+    g_classes[i].free = NULL;
+  }
+}
+
+// Block size of a class: powers of two from TLS_ARENA_MIN_BLOCK, with one
+// class half way between each pair, so no block wastes more than a third
+static size_t class_size(size_t index) {
+  return index % 2 ? (size_t) 3 << (index / 2 + 4) : (size_t) 1 << (index / 2 + 5);
+}
+
+// Smallest class whose blocks hold bytes (bytes <= SC_TLS_ARENA_MAX_BLOCK)
+static size_t class_of(size_t bytes) {
+  size_t index = 0;
+  while (class_size(index) < bytes) {
+    index++;
+  }
+  return index;
+}
+
+// Takes a block from a class's shared free list, carving a new chunk into
+// blocks when the list is empty
+// @param index Size class
+// @return The block, or NULL if no chunk could be allocated
+static free_block_t *take_shared(size_t index) {
+  pthread_once(&g_classes_once, init_classes);
+  size_class_t *size_class = &g_classes[index];
+  size_t size              = class_size(index);
+
+  pthread_mutex_lock(&size_class->lock);
+  if (!size_class->free) {
+    uint8_t *chunk = malloc(SC_TLS_ARENA_CHUNK);
+    if (!chunk) {
+      pthread_mutex_unlock(&size_class->lock);
+      return NULL;
+    }
+    // Lowest address on top, so a fresh chunk is handed out in order
+    for (size_t i = SC_TLS_ARENA_CHUNK / size; i-- > 0;) {
+      free_block_t *block = (free_block_t *) (chunk + i * size);
+      block->next         = size_class->free;
+      size_class->free    = block;
+    }
+    atomic_fetch_add_explicit(&g_chunk_bytes, SC_TLS_ARENA_CHUNK, memory_order_relaxed);
+  }
+  free_block_t *block = size_class->free;
+  size_class->free    = block->next;
+  pthread_mutex_unlock(&size_class->lock);
+
+  atomic_fetch_add_explicit(&g_in_use_bytes, size, memory_order_relaxed);
+  return block;
+}
+
+// Puts a list of count blocks, first to last, on a class's shared free list
+static void give_shared(size_t index, free_block_t *first, free_block_t *last, size_t count) {
+  pthread_once(&g_classes_once, init_classes);
+  size_class_t *size_class = &g_classes[index];
+
+  pthread_mutex_lock(&size_class->lock);
+  last->next       = size_class->free;
+  size_class->free = first;
+  pthread_mutex_unlock(&size_class->lock);
+
+  atomic_fetch_sub_explicit(&g_in_use_bytes, count * class_size(index), memory_order_relaxed);
+}
+
+// ============================================================================
+// Lifecycle Functions
+// ============================================================================
+
+// Initializes an arena in place
+// @param arena Arena to initialize
+void sc_tls_arena_init(sc_tls_arena_t *arena) {
+  if (!arena) {
+    return;
+  }
+  memset(arena, 0, sizeof(*arena));
+}
+
+// ============================================================================
+// Allocator
+// ============================================================================
+
+// Allocates zeroed memory
+// The entered arena's cache is tried first, then the shared free list of the
+// size class; blocks above SC_TLS_ARENA_MAX_BLOCK come from malloc.
+// @param count Number of objects
+// @param size Size of each object
+// @return Pointer to the memory, or NULL on failure
+void *sc_tls_arena_calloc(size_t count, size_t size) {
+  size_t requested;
+  size_t bytes;
+  if (SC_MUL_OVERFLOW(count, size, &requested) ||
+      SC_ADD_OVERFLOW(requested, sizeof(block_header_t), &bytes) || bytes > UINT32_MAX) {
+    return NULL;
+  }
+
+  sc_tls_arena_t *arena = t_arena;
+  block_header_t *header;
+  if (bytes > SC_TLS_ARENA_MAX_BLOCK) {
+    header = malloc(bytes);
+    if (!header) {
+      return NULL;
+    }
+    atomic_fetch_add_explicit(&g_large_bytes, bytes, memory_order_relaxed);
+  } else {
+    size_t index        = class_of(bytes);
+    bytes               = class_size(index);
+    free_block_t *block = arena ? arena->cache[index] : NULL;
+    if (block) {
+      arena->cache[index] = block->next;
+      arena->cached_bytes -= bytes;
+    } else {
+      block = take_shared(index);
+      if (!block) {
+        return NULL;
+      }
+    }
+    header = (block_header_t *) block;
+  }
+
+  header->owner = arena;
+  header->bytes = (uint32_t) bytes;
+  header->phase = arena ? arena->phase : 0;
+  if (arena && arena->handshaking) {
+    arena->handshake_bytes += bytes;
+    if (arena->handshake_bytes > arena->handshake_peak) {
+      arena->handshake_peak = arena->handshake_bytes;
+    }
+  } else if (arena) {
+    arena->established_bytes += bytes;
+  }
+
+  memset(header + 1, 0, requested);
+  return header + 1;
+}
+
+// Frees memory from sc_tls_arena_calloc
+// The block is uncounted from the arena it was allocated in, whichever arena
+// is entered now. It stays in that arena's cache if it is the entered one;
+// any other goes back to the shared free list.
+// @param ptr Memory to free (may be NULL)
+void sc_tls_arena_free(void *ptr) {
+  if (!ptr) {
+    return;
+  }
+
+  block_header_t *header = (block_header_t *) ptr - 1;
+  size_t bytes           = header->bytes;
+  sc_tls_arena_t *owner  = header->owner;
+  if (owner && owner->handshaking && header->phase == owner->phase) {
+    owner->handshake_bytes -= bytes;
+  } else if (owner) {
+    owner->established_bytes -= bytes;
+  }
+  sc_tls_arena_t *arena = owner == t_arena ? owner : NULL;
+
+  if (bytes > SC_TLS_ARENA_MAX_BLOCK) {
+    atomic_fetch_sub_explicit(&g_large_bytes, bytes, memory_order_relaxed);
+    free(header);
+    return;
+  }
+
+  size_t index        = class_of(bytes);
+  free_block_t *block = (free_block_t *) header;
+  if (arena) {
+    block->next         = arena->cache[index];
+    arena->cache[index] = block;
+    arena->cached_bytes += bytes;
+    return;
+  }
+  give_shared(index, block, block, 1);
+}
+
+// ============================================================================
+// Operations
+// ============================================================================
+
+// Makes an arena the calling thread's current one
+// @param arena Arena to enter (may be NULL)
+// @return The previously current arena
+sc_tls_arena_t *sc_tls_arena_enter(sc_tls_arena_t *arena) {
+  sc_tls_arena_t *previous = t_arena;
+  t_arena                  = arena;
+  return previous;
+}
+
+// Restores the calling thread's previous arena
+// @param previous Arena returned by sc_tls_arena_enter
+void sc_tls_arena_leave(sc_tls_arena_t *previous) {
+  t_arena = previous;
+}
+
+// Starts a handshake phase
+// Bumping the phase makes blocks allocated so far count as established when
+// they are freed.
+// @param arena Arena of the session starting a handshake
+void sc_tls_arena_begin_handshake(sc_tls_arena_t *arena) {
+  if (!arena) {
+    return;
+  }
+  arena->established_bytes += arena->handshake_bytes;
+  arena->handshake_bytes = 0;
+  arena->handshake_peak  = 0;
+  arena->phase++;
+  arena->handshaking = true;
+}
+
+// Ends a handshake phase and releases what the handshake freed
+// @param arena Arena of the session whose handshake completed
+void sc_tls_arena_end_handshake(sc_tls_arena_t *arena) {
+  if (!arena) {
+    return;
+  }
+  arena->established_bytes += arena->handshake_bytes;
+  arena->handshake_bytes = 0;
+  arena->phase++;
+  arena->handshaking = false;
+  sc_tls_arena_release(arena);
+}
+
+// Returns an arena's cache to the shared free lists, one lock per size class
+// @param arena Arena to empty (may be NULL)
+void sc_tls_arena_release(sc_tls_arena_t *arena) {
+  if (!arena || arena->cached_bytes == 0) {
+    return;
+  }
+
+  for (size_t i = 0; i < SC_TLS_ARENA_CLASSES; i++) {
+    free_block_t *first = arena->cache[i];
+    if (!first) {
+      continue;
+    }
+    free_block_t *last = first;
+    size_t count       = 1;
+    while (last->next) {
+      last = last->next;
+      count++;
+    }
+    give_shared(i, first, last, count);
+    arena->cache[i] = NULL;
+  }
+  arena->cached_bytes = 0;
+}
+
+// Gets the pool's totals
+// @return Bytes taken from malloc and handed out, as of the call
+sc_tls_pool_stats_t sc_tls_arena_pool_stats(void) {
+  sc_tls_pool_stats_t stats;
+  stats.chunk_bytes  = atomic_load_explicit(&g_chunk_bytes, memory_order_relaxed);
+  stats.in_use_bytes = atomic_load_explicit(&g_in_use_bytes, memory_order_relaxed);
+  stats.large_bytes  = atomic_load_explicit(&g_large_bytes, memory_order_relaxed);
+  return stats;
+}
@@ -0,0 +1,97 @@
+#ifndef TLS_ARENA_H
+#define TLS_ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Size-classed pool that serves mbedTLS's heap (MBEDTLS_PLATFORM_MEMORY; see
+// sc_dtls_init()). Blocks are carved from large chunks and recycled through
+// per-class free lists, so handshake buffers, certificates and record buffers
+// never interleave with the server's own allocations and session churn does
+// not fragment the heap. Chunks are kept for the life of the process.
+//
+// A DTLS session allocates through an arena of its own while a thread has
+// entered it. Blocks the session frees stay in its arena's cache and serve
+// its next allocations without locking; the cache goes back to the shared
+// free lists in bulk when the session's handshake completes or it is put
+// away. The arena also counts the bytes its session holds. A session is only
+// used by one thread at a time, and so is its arena. A block freed while
+// another arena, or none, is entered is still uncounted from its own arena,
+// which must then be alive and idle; state shared between sessions is
+// therefore allocated with no arena entered at all.
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+#define SC_TLS_ARENA_CLASSES   19    // Size classes: 32, 48, 64, 96, ... 16384 bytes
+#define SC_TLS_ARENA_MAX_BLOCK 16384 // Blocks bigger than this come from malloc itself
+#define SC_TLS_ARENA_CHUNK     65536 // Bytes a size class takes from malloc at a time
+
+// ============================================================================
+// Type Definitions
+// ============================================================================
+
+typedef struct {
+  void *cache[SC_TLS_ARENA_CLASSES]; // Blocks freed in this arena, per size class
+  size_t cached_bytes;               // Bytes in cache
+  size_t handshake_bytes;   // Held, allocated since the current handshake began
+  size_t established_bytes; // Held, allocated before it or left by a completed handshake
+  size_t handshake_peak;    // Most handshake_bytes held during the current handshake
+  uint32_t phase;           // Tells blocks of the current handshake from older ones
+  bool handshaking;
+} sc_tls_arena_t;
+
+typedef struct {
+  size_t chunk_bytes;  // Taken from malloc for the size classes
+  size_t in_use_bytes; // Handed out of the free lists: allocated, or cached by an arena
+  size_t large_bytes;  // Allocated blocks too big for a size class
+} sc_tls_pool_stats_t;
+
+// ============================================================================
+// Lifecycle Functions
+// ============================================================================
+
+// Initialize an arena in place; it holds nothing and is not handshaking
+void sc_tls_arena_init(sc_tls_arena_t *arena);
+
+// ============================================================================
+// Allocator
+// ============================================================================
+
+// calloc(3) for mbedtls_platform_set_calloc_free(): zeroed memory for count
+// objects of size bytes, from the calling thread's entered arena if any
+// Returns: Pointer to the memory, or NULL on overflow or allocation failure
+void *sc_tls_arena_calloc(size_t count, size_t size);
+
+// free(3) counterpart of sc_tls_arena_calloc(); NULL is ignored
+// The block is uncounted from the arena it was allocated in, and cached only
+// if that arena is the calling thread's entered one.
+void sc_tls_arena_free(void *ptr);
+
+// ============================================================================
+// Operations
+// ============================================================================
+
+// Make arena the calling thread's current arena (NULL for none)
+// Returns: The arena that was current, to pass to sc_tls_arena_leave()
+sc_tls_arena_t *sc_tls_arena_enter(sc_tls_arena_t *arena);
+
+// Restore the arena sc_tls_arena_enter() returned
+void sc_tls_arena_leave(sc_tls_arena_t *previous);
+
+// Start counting allocations as the handshake's; everything the arena holds
+// so far counts as established
+void sc_tls_arena_begin_handshake(sc_tls_arena_t *arena);
+
+// Count everything the handshake left as established and release the cache
+void sc_tls_arena_end_handshake(sc_tls_arena_t *arena);
+
+// Return the arena's cached blocks to the shared free lists
+void sc_tls_arena_release(sc_tls_arena_t *arena);
+
+// Memory the pool has taken and handed out, across all threads
+sc_tls_pool_stats_t sc_tls_arena_pool_stats(void);
+
+#endif // TLS_ARENA_H
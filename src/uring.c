@@ -0,0 +1,589 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include "uring.h"
+#include "log.h"
+#include "portability.h"
+
+#define URING_BUFFER_GROUP 0 // Provided buffer group used for receives
+#define URING_MAX_BUFFERS  32768
+
+// Completion tags; send completions carry their slot index in the low bits
+#define URING_TAG_RECV   ((uint64_t) 1 << 32)
+#define URING_TAG_WATCH  ((uint64_t) 2 << 32)
+#define URING_TAG_SEND   ((uint64_t) 3 << 32)
+#define URING_TAG_NOTIFY ((uint64_t) 4 << 32)
+#define URING_TAG_MASK   ((uint64_t) 0xffffffff << 32)
+
+// Descriptors sc_uring_notify() can poll at once
+#define URING_MAX_NOTIFY 4
+
+// Queue entries beyond one per send slot: the receive, the watch and the notify polls
+#define URING_SPARE_ENTRIES (2 + URING_MAX_NOTIFY)
+
+// A preallocated outbound datagram
+typedef struct {
+  struct msghdr msg;
+  struct iovec iov;
+  struct sockaddr_storage addr;
+  uint8_t *data;
+} uring_send_slot_t;
+
+struct sc_uring {
+  int ring_fd;
+  int fd; // Socket being served
+
+  // Submission queue
+  void *ring_mem; // Shared SQ/CQ ring mapping
+  size_t ring_mem_size;
+  struct io_uring_sqe *sqes;
+  size_t sqes_size;
+  uint32_t *sq_head;
+  uint32_t *sq_tail;
+  uint32_t sq_mask;
+  uint32_t sq_entries;
+  uint32_t sq_local_tail; // Tail including entries not yet published
+
+  // Completion queue
+  uint32_t *cq_head;
+  uint32_t *cq_tail;
+  uint32_t cq_mask;
+  struct io_uring_cqe *cqes;
+
+  // Provided receive buffers: recvmsg_out header, source address, payload
+  struct io_uring_buf_ring *buf_ring;
+  size_t buf_ring_size;
+  uint8_t *buf_storage;
+  size_t buf_size;
+  uint16_t buf_count;
+  uint16_t *consumed; // Buffer IDs to hand back on the next receive
+  size_t consumed_count;
+  struct msghdr recv_msg; // Layout template for the multishot receive
+  bool recv_armed;
+
+  // Send slots
+  uring_send_slot_t *send_slots;
+  uint8_t *send_storage;
+  uint32_t *free_sends; // Stack of idle send slot indexes
+  size_t free_send_count;
+  size_t send_count;
+  size_t slot_size;
+
+  sc_ingress_packet_t *packets;
+  bool woken;
+  int notify_fds[URING_MAX_NOTIFY]; // Descriptors whose readability ends a wait
+  bool notify_armed[URING_MAX_NOTIFY];
+  size_t notify_count;
+  sc_uring_stats_t stats;
+};
+
+// ============================================================================
+// Internal Helper Functions
+// ============================================================================
+
+static int sys_io_uring_setup(uint32_t entries, struct io_uring_params *params) {
+  return (int) syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int sys_io_uring_enter(int ring_fd, uint32_t to_submit, uint32_t min_complete,
+                              uint32_t flags, const void *arg, size_t arg_size) {
+  return (int) syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, arg,
+                       arg_size);
+}
+
+static int sys_io_uring_register(int ring_fd, uint32_t opcode, const void *arg, uint32_t nr_args) {
+  return (int) syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args);
+}
+
+// Gets a cleared submission queue entry
+// @param uring Engine
+// @return Entry to fill in, or NULL if the submission queue is full
+static struct io_uring_sqe *get_sqe(sc_uring_t *uring) {
+  uint32_t head = __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE);
+  if (uring->sq_local_tail - head >= uring->sq_entries) {
+    return NULL;
+  }
+
+  struct io_uring_sqe *sqe = &uring->sqes[uring->sq_local_tail & uring->sq_mask];
+  uring->sq_local_tail++;
+  memset(sqe, 0, sizeof(*sqe));
+  return sqe;
+}
+
+// Queues the multishot receive
+// @param uring Engine
+// @return 0 on success, -1 if the submission queue is full
+static int arm_recv(sc_uring_t *uring) {
+  struct io_uring_sqe *sqe = get_sqe(uring);
+  if (!sqe) {
+    return -1;
+  }
+
+  sqe->opcode    = IORING_OP_RECVMSG;
+  sqe->fd        = uring->fd;
+  sqe->addr      = (uint64_t) (uintptr_t) &uring->recv_msg;
+  sqe->len       = 1;
+  sqe->ioprio    = IORING_RECV_MULTISHOT;
+  sqe->flags     = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = URING_BUFFER_GROUP;
+  sqe->user_data = URING_TAG_RECV;
+
+  uring->recv_armed = true;
+  return 0;
+}
+
+// Queues the one-shot poll on a notify descriptor
+// @param uring Engine
+// @param index Index of the descriptor in notify_fds
+// @return 0 on success, -1 if the submission queue is full
+static int arm_notify(sc_uring_t *uring, size_t index) {
+  struct io_uring_sqe *sqe = get_sqe(uring);
+  if (!sqe) {
+    return -1;
+  }
+
+  sqe->opcode        = IORING_OP_POLL_ADD;
+  sqe->fd            = uring->notify_fds[index];
+  sqe->poll32_events = POLLIN;
+  sqe->user_data     = URING_TAG_NOTIFY | index;
+
+  uring->notify_armed[index] = true;
+  return 0;
+}
+
+// Hands receive buffers back to the kernel
+// @param uring Engine
+static void release_buffers(sc_uring_t *uring) {
+  if (uring->consumed_count == 0) {
+    return;
+  }
+
+  uint16_t tail = uring->buf_ring->tail;
+  uint16_t mask = (uint16_t) (uring->buf_count - 1);
+  for (size_t i = 0; i < uring->consumed_count; i++) {
+    uint16_t bid             = uring->consumed[i];
+    uint8_t *storage         = uring->buf_storage + bid * uring->buf_size;
+    struct io_uring_buf *buf = &uring->buf_ring->bufs[(uint16_t) (tail + i) & mask];
+    buf->addr                = (uint64_t) (uintptr_t) storage;
+    buf->len                 = (uint32_t) uring->buf_size;
+    buf->bid                 = bid;
+  }
+  __atomic_store_n(&uring->buf_ring->tail, (uint16_t) (tail + uring->consumed_count),
+                   __ATOMIC_RELEASE);
+  uring->consumed_count = 0;
+}
+
+// Turns a receive completion into a packet
+// @param uring Engine
+// @param cqe Receive completion
+// @param packet Packet to fill in
+// @return true if packet was filled in
+static bool complete_recv(sc_uring_t *uring, const struct io_uring_cqe *cqe,
+                          sc_ingress_packet_t *packet) {
+  // Without F_MORE the multishot receive has ended and must be re-armed
+  if (!(cqe->flags & IORING_CQE_F_MORE)) {
+    uring->recv_armed = false;
+  }
+
+  if (cqe->res < 0) {
+    if (cqe->res == -ENOBUFS) {
+      uring->stats.no_buffers++;
+    } else {
+      log_error("io_uring receive failed: %s", strerror(-cqe->res));
+    }
+    return false;
+  }
+  if (!(cqe->flags & IORING_CQE_F_BUFFER)) {
+    return false;
+  }
+
+  uint16_t bid = (uint16_t) (cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+  uring->consumed[uring->consumed_count++] = bid;
+
+  const uint8_t *buf = uring->buf_storage + bid * uring->buf_size;
+  struct io_uring_recvmsg_out out;
+  memcpy(&out, buf, sizeof(out));
+
+  if (out.flags & MSG_TRUNC) {
+    uring->stats.truncated++;
+    return false;
+  }
+
+  const uint8_t *name = buf + sizeof(out);
+  memset(&packet->addr, 0, sizeof(packet->addr));
+  memcpy(&packet->addr, name,
+         out.namelen < sizeof(packet->addr) ? out.namelen : sizeof(packet->addr));
+  packet->addr_len = (socklen_t) out.namelen;
+  packet->data     = name + uring->recv_msg.msg_namelen + uring->recv_msg.msg_controllen;
+  packet->len      = out.payloadlen;
+  return true;
+}
+
+// ============================================================================
+// Lifecycle Functions
+// ============================================================================
+
+// Creates an engine and registers its receive buffers
+// @param fd Bound AF_INET UDP socket
+// @param recv_buffers Number of provided receive buffers (power of two, <= 32768)
+// @param send_slots Number of concurrent sends (must be > 0)
+// @param slot_size Largest datagram payload in bytes (must be > 0)
+// @return Pointer to the newly created engine, or NULL on failure
+sc_uring_t *sc_uring_init(int fd, size_t recv_buffers, size_t send_slots, size_t slot_size) {
+  if (fd < 0 || recv_buffers == 0 || recv_buffers > URING_MAX_BUFFERS ||
+      (recv_buffers & (recv_buffers - 1)) != 0 || send_slots == 0 || send_slots > UINT16_MAX ||
+      slot_size == 0) {
+    log_error("Invalid io_uring dimensions: recv_buffers=%zu send_slots=%zu slot_size=%zu",
+              recv_buffers, send_slots, slot_size);
+    return NULL;
+  }
+
+  sc_uring_t *uring = calloc(1, sizeof(sc_uring_t));
+  if (!uring) {
+    log_error("%s", "Failed to allocate io_uring engine");
+    return NULL;
+  }
+  uring->ring_fd   = -1;
+  uring->fd        = fd;
+  uring->buf_count = (uint16_t) recv_buffers;
+  uring->slot_size = slot_size;
+
+  // Every receive buffer is laid out as the kernel writes it for recvmsg:
+  // header, then msg_namelen bytes of address, then the payload
+  uring->recv_msg.msg_namelen = sizeof(struct sockaddr_in);
+  uring->buf_size             = sizeof(struct io_uring_recvmsg_out) + sizeof(struct sockaddr_in);
+  uring->buf_size += slot_size;
+
+  size_t buf_storage_size;
+  size_t send_storage_size;
+  if (SC_MUL_OVERFLOW(uring->buf_size, recv_buffers, &buf_storage_size) ||
+      SC_MUL_OVERFLOW(slot_size, send_slots, &send_storage_size)) {
+    log_error("%s", "Integer overflow sizing io_uring buffers");
+    free(uring);
+    return NULL;
+  }
+
+  // Set up the ring; the queue only ever holds the sends of one loop iteration
+  // plus the receive and watch requests
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  params.flags      = IORING_SETUP_CQSIZE;
+  params.cq_entries = (uint32_t) (2 * (recv_buffers + send_slots));
+  uring->ring_fd    = sys_io_uring_setup((uint32_t) (send_slots + URING_SPARE_ENTRIES), &params);
+  if (uring->ring_fd < 0) {
+    log_error("io_uring_setup failed: %s", strerror(errno));
+    sc_uring_nuke(uring);
+    return NULL;
+  }
+  if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_EXT_ARG)) {
+    log_error("%s", "Kernel io_uring lacks required features");
+    sc_uring_nuke(uring);
+    return NULL;
+  }
+
+  size_t sq_size       = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  size_t cq_size       = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  uring->ring_mem_size = sq_size > cq_size ? sq_size : cq_size;
+  uring->ring_mem      = mmap(NULL, uring->ring_mem_size, PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_POPULATE, uring->ring_fd, IORING_OFF_SQ_RING);
+  uring->sqes_size     = params.sq_entries * sizeof(struct io_uring_sqe);
+  uring->sqes          = mmap(NULL, uring->sqes_size, PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_POPULATE, uring->ring_fd, IORING_OFF_SQES);
+  if (uring->ring_mem == MAP_FAILED || uring->sqes == MAP_FAILED) {
+    log_error("Failed to map io_uring queues: %s", strerror(errno));
+    sc_uring_nuke(uring);
+    return NULL;
+  }
+
+  uint8_t *ring        = uring->ring_mem;
+  uring->sq_head       = (uint32_t *) (ring + params.sq_off.head);
+  uring->sq_tail       = (uint32_t *) (ring + params.sq_off.tail);
+  uring->sq_mask       = *(uint32_t *) (ring + params.sq_off.ring_mask);
+  uring->sq_entries    = params.sq_entries;
+  uring->sq_local_tail = *uring->sq_tail;
+  uring->cq_head       = (uint32_t *) (ring + params.cq_off.head);
+  uring->cq_tail       = (uint32_t *) (ring + params.cq_off.tail);
+  uring->cq_mask       = *(uint32_t *) (ring + params.cq_off.ring_mask);
+  uring->cqes          = (struct io_uring_cqe *) (ring + params.cq_off.cqes);
+
+  // Submission entries are used in order, so the index array is the identity
+  uint32_t *sq_array = (uint32_t *) (ring + params.sq_off.array);
+  for (uint32_t i = 0; i < params.sq_entries; i++) {
+    sq_array[i] = i;
+  }
+
+  // Buffer ring (page aligned, as the kernel requires) and buffer storage
+  uring->buf_ring_size = recv_buffers * sizeof(struct io_uring_buf);
+  uring->buf_ring      = mmap(NULL, uring->buf_ring_size, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+  uring->buf_storage   = malloc(buf_storage_size);
+  uring->consumed      = calloc(recv_buffers, sizeof(uint16_t));
+  uring->packets       = calloc(recv_buffers, sizeof(sc_ingress_packet_t));
+  uring->send_slots    = calloc(send_slots, sizeof(uring_send_slot_t));
+  uring->send_storage  = malloc(send_storage_size);
+  uring->free_sends    = calloc(send_slots, sizeof(uint32_t));
+  if (uring->buf_ring == MAP_FAILED || !uring->buf_storage || !uring->consumed ||
+      !uring->packets || !uring->send_slots || !uring->send_storage || !uring->free_sends) {
+    log_error("%s", "Failed to allocate io_uring buffers");
+    if (uring->buf_ring == MAP_FAILED) {
+      uring->buf_ring = NULL;
+    }
+    sc_uring_nuke(uring);
+    return NULL;
+  }
+
+  struct io_uring_buf_reg reg;
+  memset(&reg, 0, sizeof(reg));
+  reg.ring_addr    = (uint64_t) (uintptr_t) uring->buf_ring;
+  reg.ring_entries = (uint32_t) recv_buffers;
+  reg.bgid         = URING_BUFFER_GROUP;
+  if (sys_io_uring_register(uring->ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+    log_error("Failed to register io_uring receive buffers: %s", strerror(errno));
+    sc_uring_nuke(uring);
+    return NULL;
+  }
+
+  // Hand every receive buffer to the kernel
+  for (size_t i = 0; i < recv_buffers; i++) {
+    uring->consumed[i] = (uint16_t) i;
+  }
+  uring->consumed_count = recv_buffers;
+  release_buffers(uring);
+
+  // Wire each send slot to its storage once
+  for (size_t i = 0; i < send_slots; i++) {
+    uring_send_slot_t *slot = &uring->send_slots[i];
+    slot->data              = uring->send_storage + i * slot_size;
+    slot->iov.iov_base      = slot->data;
+    slot->msg.msg_iov       = &slot->iov;
+    slot->msg.msg_iovlen    = 1;
+    slot->msg.msg_name      = &slot->addr;
+    uring->free_sends[i]    = (uint32_t) (send_slots - 1 - i);
+  }
+  uring->send_count      = send_slots;
+  uring->free_send_count = send_slots;
+
+  if (arm_recv(uring) < 0) {
+    sc_uring_nuke(uring);
+    return NULL;
+  }
+
+  return uring;
+}
+
+// Destroys an engine
+// @param uring Pointer to the engine to destroy (may be NULL)
+void sc_uring_nuke(sc_uring_t *uring) {
+  if (!uring) {
+    return;
+  }
+
+  // Closing the ring cancels outstanding requests before the memory they
+  // refer to is released
+  if (uring->ring_fd >= 0) {
+    close(uring->ring_fd);
+  }
+  if (uring->sqes && uring->sqes != MAP_FAILED) {
+    munmap(uring->sqes, uring->sqes_size);
+  }
+  if (uring->ring_mem && uring->ring_mem != MAP_FAILED) {
+    munmap(uring->ring_mem, uring->ring_mem_size);
+  }
+  if (uring->buf_ring) {
+    munmap(uring->buf_ring, uring->buf_ring_size);
+  }
+
+  free(uring->free_sends);
+  free(uring->send_storage);
+  free(uring->send_slots);
+  free(uring->packets);
+  free(uring->consumed);
+  free(uring->buf_storage);
+  free(uring);
+}
+
+// ============================================================================
+// Operations
+// ============================================================================
+
+// Queues a one-shot readability watch on a descriptor
+// @param uring Engine
+// @param fd Descriptor to watch
+// @return 0 on success, -1 if the submission queue is full
+int sc_uring_watch(sc_uring_t *uring, int fd) {
+  struct io_uring_sqe *sqe = get_sqe(uring);
+  if (!sqe) {
+    errno = EBUSY;
+    return -1;
+  }
+
+  sqe->opcode        = IORING_OP_POLL_ADD;
+  sqe->fd            = fd;
+  sqe->poll32_events = POLLIN;
+  sqe->user_data     = URING_TAG_WATCH;
+  return 0;
+}
+
+// Makes a descriptor's readability end sc_uring_wait()
+// @param uring Engine
+// @param fd Descriptor to poll
+// @return 0 on success, -1 if URING_MAX_NOTIFY descriptors are already polled
+int sc_uring_notify(sc_uring_t *uring, int fd) {
+  if (uring->notify_count == URING_MAX_NOTIFY) {
+    return -1;
+  }
+  uring->notify_fds[uring->notify_count++] = fd;
+  return 0;
+}
+
+// Submits every queued request and waits for a completion
+// One system call covers both, so a loop iteration's sends cost no extra calls.
+// @param uring Engine
+// @param timeout_ms Longest wait in milliseconds, or -1 for no limit
+// @return 0 on success or timeout, -1 on error
+int sc_uring_wait(sc_uring_t *uring, int timeout_ms) {
+  if (!uring->recv_armed && arm_recv(uring) < 0) {
+    log_warn("%s", "io_uring submission queue full, receive not re-armed");
+  }
+  // The poll is one-shot and the descriptor level-triggered, so re-arming it
+  // before every wait returns at once while the caller has left it readable
+  for (size_t i = 0; i < uring->notify_count; i++) {
+    if (!uring->notify_armed[i] && arm_notify(uring, i) < 0) {
+      log_warn("%s", "io_uring submission queue full, notify poll not re-armed");
+    }
+  }
+
+  __atomic_store_n(uring->sq_tail, uring->sq_local_tail, __ATOMIC_RELEASE);
+  uint32_t to_submit = uring->sq_local_tail - __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE);
+
+  // Completions already queued only need the submission
+  uint32_t ready = __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE) - *uring->cq_head;
+
+  struct __kernel_timespec ts;
+  struct io_uring_getevents_arg arg;
+  memset(&arg, 0, sizeof(arg));
+  if (timeout_ms >= 0) {
+    ts.tv_sec  = timeout_ms / 1000;
+    ts.tv_nsec = (long long) (timeout_ms % 1000) * 1000000;
+    arg.ts     = (uint64_t) (uintptr_t) &ts;
+  }
+
+  uring->stats.enters++;
+  int ret = sys_io_uring_enter(uring->ring_fd, to_submit, ready ? 0 : 1,
+                               IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+  if (ret < 0 && errno != ETIME && errno != EINTR) {
+    return -1;
+  }
+  return 0;
+}
+
+// Collects completed receives and sends
+// @param uring Engine
+// @param packets Set to the datagrams received
+// @return Number of datagrams received
+size_t sc_uring_recv(sc_uring_t *uring, const sc_ingress_packet_t **packets) {
+  release_buffers(uring);
+
+  uint32_t head = *uring->cq_head;
+  uint32_t tail = __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE);
+  size_t count  = 0;
+
+  // Each buffered receive holds a buffer until the next call, so at most
+  // buf_count of them can be pending and the packet array cannot overflow
+  for (; head != tail; head++) {
+    const struct io_uring_cqe *cqe = &uring->cqes[head & uring->cq_mask];
+    uint64_t tag                   = cqe->user_data & URING_TAG_MASK;
+
+    if (tag == URING_TAG_RECV) {
+      if (count == uring->buf_count) {
+        break;
+      }
+      if (complete_recv(uring, cqe, &uring->packets[count])) {
+        count++;
+      }
+    } else if (tag == URING_TAG_SEND) {
+      if (cqe->res < 0) {
+        uring->stats.send_errors++;
+      } else {
+        uring->stats.sends++;
+      }
+      uring->free_sends[uring->free_send_count++] = (uint32_t) (cqe->user_data & ~URING_TAG_MASK);
+    } else if (tag == URING_TAG_WATCH) {
+      uring->woken = true;
+    } else if (tag == URING_TAG_NOTIFY) {
+      uring->notify_armed[cqe->user_data & ~URING_TAG_MASK] = false;
+    }
+  }
+  __atomic_store_n(uring->cq_head, head, __ATOMIC_RELEASE);
+
+  if (count > 0) {
+    uring->stats.batches++;
+    uring->stats.datagrams += count;
+  }
+
+  *packets = uring->packets;
+  return count;
+}
+
+// Copies a datagram into a send slot and queues it
+// @param uring Engine
+// @param addr Destination address
+// @param addr_len Destination address length
+// @param buf Payload
+// @param len Payload length
+// @return len on success, -1 on failure
+ssize_t sc_uring_send(sc_uring_t *uring, const struct sockaddr *addr, socklen_t addr_len,
+                      const uint8_t *buf, size_t len) {
+  if (len > uring->slot_size || addr_len > sizeof(struct sockaddr_storage)) {
+    errno = EMSGSIZE;
+    return -1;
+  }
+  if (uring->free_send_count == 0) {
+    uring->stats.send_dropped++;
+    errno = EAGAIN;
+    return -1;
+  }
+
+  // Send slots never outnumber the spare queue entries, so this cannot fail
+  struct io_uring_sqe *sqe = get_sqe(uring);
+  if (!sqe) {
+    uring->stats.send_dropped++;
+    errno = EAGAIN;
+    return -1;
+  }
+
+  uint32_t index          = uring->free_sends[--uring->free_send_count];
+  uring_send_slot_t *slot = &uring->send_slots[index];
+  memcpy(slot->data, buf, len);
+  memcpy(&slot->addr, addr, addr_len);
+  slot->iov.iov_len     = len;
+  slot->msg.msg_namelen = addr_len;
+
+  sqe->opcode    = IORING_OP_SENDMSG;
+  sqe->fd        = uring->fd;
+  sqe->addr      = (uint64_t) (uintptr_t) &slot->msg;
+  sqe->len       = 1;
+  sqe->user_data = URING_TAG_SEND | index;
+  return (ssize_t) len;
+}
+
+// Checks whether a watched descriptor became readable
+// @param uring Engine
+// @return true once the watch has completed
+bool sc_uring_woken(const sc_uring_t *uring) {
+  return uring->woken;
+}
+
+// Gets the engine counters
+// @param uring Engine
+// @return Counters since init
+const sc_uring_stats_t *sc_uring_stats(const sc_uring_t *uring) {
+  return &uring->stats;
+}
@@ -0,0 +1,103 @@
+#ifndef URING_H
+#define URING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include "ingress.h"
+
+// io_uring datagram engine for one UDP socket, driven through the raw system
+// calls. A single multishot recvmsg backed by a ring of kernel-provided
+// buffers keeps receiving without being resubmitted, and outbound datagrams
+// are copied into preallocated send slots and queued as sendmsg requests that
+// reach the kernel together, with the next sc_uring_wait() call. All memory
+// is allocated at init time.
+//
+// Needs Linux 6.0 or later (multishot recvmsg and provided buffer rings).
+// Only built when SC_HAVE_IO_URING is defined (make IO_URING=1, the default).
+
+// ============================================================================
+// Type Definitions
+// ============================================================================
+
+typedef struct sc_uring sc_uring_t;
+
+// Engine counters
+typedef struct {
+  uint64_t batches;      // Non-empty sc_uring_recv() results
+  uint64_t datagrams;    // Datagrams delivered
+  uint64_t truncated;    // Datagrams dropped because they exceeded slot_size
+  uint64_t no_buffers;   // Times receiving paused because every buffer was in use
+  uint64_t sends;        // Datagrams sent
+  uint64_t send_errors;  // Sends the kernel failed
+  uint64_t send_dropped; // Sends refused because every send slot was in flight
+  uint64_t enters;       // io_uring_enter(2) calls
+} sc_uring_stats_t;
+
+// ============================================================================
+// Lifecycle Functions
+// ============================================================================
+
+// Create an engine serving a bound AF_INET UDP socket
+// Parameters:
+//   fd: UDP socket to receive from and send on
+//   recv_buffers: Number of provided receive buffers (power of two, at most 32768)
+//   send_slots: Number of sends that may be in flight at once
+//   slot_size: Largest datagram payload, in bytes, for both directions
+// Returns: Pointer to the engine, or NULL on invalid parameters, allocation
+//          failure, or a kernel without the required io_uring features
+sc_uring_t *sc_uring_init(int fd, size_t recv_buffers, size_t send_slots, size_t slot_size);
+
+// Destroy an engine; in-flight operations are cancelled when the ring closes
+void sc_uring_nuke(sc_uring_t *uring);
+
+// ============================================================================
+// Operations
+// ============================================================================
+
+// Watch a descriptor for readability (one shot); see sc_uring_woken()
+// Returns: 0 on success, -1 if the submission queue is full
+int sc_uring_watch(sc_uring_t *uring, int fd);
+
+// Have a descriptor's readability end sc_uring_wait(), for as long as it stays
+// readable; the caller reads it to stop being woken. Several descriptors can
+// be added, each polled until the engine is destroyed.
+// Parameters:
+//   uring: Engine
+//   fd: Descriptor to poll
+// Returns: 0 on success, -1 if the engine already polls its maximum of four
+int sc_uring_notify(sc_uring_t *uring, int fd);
+
+// Submit queued work and wait for at least one completion
+// Parameters:
+//   uring: Engine
+//   timeout_ms: Longest wait in milliseconds, or -1 to wait indefinitely
+// Returns: 0 on completion or timeout, -1 on error with errno set
+int sc_uring_wait(sc_uring_t *uring, int timeout_ms);
+
+// Collect completed receives and sends
+// Buffers from the previous call are handed back to the kernel first, so the
+// returned packets are only valid until the next call. Call until it returns
+// 0 before waiting again, so receiving can resume after running out of buffers.
+// Parameters:
+//   uring: Engine
+//   packets: Set to the received datagrams
+// Returns: Number of datagrams in *packets
+size_t sc_uring_recv(sc_uring_t *uring, const sc_ingress_packet_t **packets);
+
+// Queue a datagram; it is copied, so buf may be reused immediately
+// Returns: len on success, -1 with errno EMSGSIZE if len exceeds slot_size or
+//          EAGAIN if every send slot is in flight
+ssize_t sc_uring_send(sc_uring_t *uring, const struct sockaddr *addr, socklen_t addr_len,
+                      const uint8_t *buf, size_t len);
+
+// Whether a descriptor passed to sc_uring_watch() has become readable
+bool sc_uring_woken(const sc_uring_t *uring);
+
+// Engine counters since init
+const sc_uring_stats_t *sc_uring_stats(const sc_uring_t *uring);
+
+#endif // URING_H
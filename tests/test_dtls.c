@@ -1,10 +1,13 @@
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include "unity.h"
 #include "../src/dtls.h"
+#include "../src/tls_arena.h"
 
 // Unity framework functions
 void setUp(void);
@@ -17,6 +20,24 @@ void test_dtls_context_creation_client(void);
 void test_dtls_cert_hash(void);
 void test_dtls_error_strings(void);
 void test_dtls_session_creation(void);
+void test_dtls_feed_invalid_params(void);
+void test_dtls_server_session_never_reads_socket(void);
+void test_dtls_session_pool(void);
+void test_dtls_check_hello_cookie_exchange(void);
+void test_dtls_session_send_override(void);
+void test_dtls_retransmit_timer(void);
+void test_dtls_client_hello_requests_small_records(void);
+void test_dtls_session_ticket_resumption(void);
+void test_dtls_record_cid(void);
+void test_dtls_connection_id_survives_address_change(void);
+void test_dtls_older_record_does_not_move_client(void);
+void test_dtls_rank_ciphers(void);
+void test_dtls_server_identities(void);
+void test_dtls_handshakes_on_other_threads(void);
+void test_dtls_plain_transport(void);
+void test_dtls_plain_rejects_dtls_peers(void);
+void test_dtls_plain_hello_cookie(void);
+void test_dtls_session_memory(void);
 
 static bool g_dtls_test_initialized = false;
 
@@ -111,6 +132,1074 @@ void test_dtls_session_creation(void) {
   close(fd);
 }
 
+void test_dtls_feed_invalid_params(void) {
+  uint8_t datagram[16] = {0};
+
+  TEST_ASSERT_EQUAL(DTLS_ERROR_INVALID_PARAMS, sc_dtls_feed(NULL, datagram, sizeof(datagram)));
+
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  TEST_ASSERT_NOT_EQUAL(-1, fd);
+  dtls_context_t *ctx = sc_dtls_context_create(DTLS_ROLE_CLIENT, NULL, NULL, NULL, 0);
+  TEST_ASSERT_NOT_NULL(ctx);
+  dtls_session_t *session = sc_dtls_session_create(ctx, fd, NULL, 0);
+  TEST_ASSERT_NOT_NULL(session);
+
+  TEST_ASSERT_EQUAL(DTLS_ERROR_INVALID_PARAMS, sc_dtls_feed(session, NULL, sizeof(datagram)));
+  TEST_ASSERT_EQUAL(DTLS_ERROR_INVALID_PARAMS, sc_dtls_feed(session, datagram, 0));
+
+  sc_dtls_session_destroy(session);
+  sc_dtls_context_destroy(ctx);
+  close(fd);
+}
+
+void test_dtls_server_session_never_reads_socket(void) {
+  // Bind a server socket to an ephemeral loopback port
+  int server_fd = socket(AF_INET, SOCK_DGRAM, 0);
+  TEST_ASSERT_NOT_EQUAL(-1, server_fd);
+  struct sockaddr_in server_addr;
+  memset(&server_addr, 0, sizeof(server_addr));
+  server_addr.sin_family      = AF_INET;
+  server_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  TEST_ASSERT_EQUAL(0, bind(server_fd, (struct sockaddr *) &server_addr, sizeof(server_addr)));
+  socklen_t server_len = sizeof(server_addr);
+  TEST_ASSERT_EQUAL(0, getsockname(server_fd, (struct sockaddr *) &server_addr, &server_len));
+
+  dtls_context_t *ctx = sc_dtls_context_create(DTLS_ROLE_SERVER, ".secrets/certs/server.crt",
+                                               ".secrets/certs/server.key", NULL, 0);
+  TEST_ASSERT_NOT_NULL(ctx);
+
+  struct sockaddr_in client_addr;
+  memset(&client_addr, 0, sizeof(client_addr));
+  client_addr.sin_family      = AF_INET;
+  client_addr.sin_port        = htons(12345);
+  client_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  dtls_session_t *session =
+    sc_dtls_session_create(ctx, server_fd, (struct sockaddr *) &client_addr, sizeof(client_addr));
+  TEST_ASSERT_NOT_NULL(session);
+
+  // Queue a datagram on the shared socket from some other peer
+  int other_fd = socket(AF_INET, SOCK_DGRAM, 0);
+  TEST_ASSERT_NOT_EQUAL(-1, other_fd);
+  const char *other = "not for this session";
+  TEST_ASSERT_EQUAL((ssize_t) strlen(other), sendto(other_fd, other, strlen(other), 0,
+                                                    (struct sockaddr *) &server_addr,
+                                                    sizeof(server_addr)));
+  usleep(10000); // 10ms for loopback delivery
+
+  // Without a fed datagram the session has nothing to do
+  TEST_ASSERT_EQUAL(DTLS_ERROR_WOULD_BLOCK, sc_dtls_handshake(session));
+
+  // The other peer's datagram is still waiting on the socket for its owner
+  char buf[64];
+  ssize_t len = recv(server_fd, buf, sizeof(buf), MSG_DONTWAIT);
+  TEST_ASSERT_EQUAL((ssize_t) strlen(other), len);
+  TEST_ASSERT_EQUAL_MEMORY(other, buf, (size_t) len);
+
+  sc_dtls_session_destroy(session);
+  sc_dtls_context_destroy(ctx);
+  close(other_fd);
+  close(server_fd);
+}
+
+void test_dtls_session_pool(void) {
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  TEST_ASSERT_NOT_EQUAL(-1, fd);
+
+  dtls_context_t *ctx = sc_dtls_context_create(DTLS_ROLE_SERVER, ".secrets/certs/server.crt",
+                                               ".secrets/certs/server.key", NULL, 0);
+  TEST_ASSERT_NOT_NULL(ctx);
+  TEST_ASSERT_EQUAL(DTLS_ERROR_INVALID_PARAMS, sc_dtls_context_reserve_sessions(ctx, 0));
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_context_reserve_sessions(ctx, 2));
+  TEST_ASSERT_EQUAL(DTLS_ERROR_INVALID_PARAMS, sc_dtls_context_reserve_sessions(ctx, 2));
+
+  struct sockaddr_in client_addr;
+  memset(&client_addr, 0, sizeof(client_addr));
+  client_addr.sin_family      = AF_INET;
+  client_addr.sin_port        = htons(12345);
+  client_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  dtls_session_t *a =
+    sc_dtls_session_create(ctx, fd, (struct sockaddr *) &client_addr, sizeof(client_addr));
+  client_addr.sin_port = htons(12346);
+  dtls_session_t *b =
+    sc_dtls_session_create(ctx, fd, (struct sockaddr *) &client_addr, sizeof(client_addr));
+  TEST_ASSERT_NOT_NULL(a);
+  TEST_ASSERT_NOT_NULL(b);
+  TEST_ASSERT_EQUAL(2, sc_dtls_context_sessions_in_use(ctx));
+
+  // The pool is full
+  client_addr.sin_port = htons(12347);
+  TEST_ASSERT_NULL(
+    sc_dtls_session_create(ctx, fd, (struct sockaddr *) &client_addr, sizeof(client_addr)));
+
+  // A destroyed session is reset and handed to the next client
+  sc_dtls_session_destroy(a);
+  TEST_ASSERT_EQUAL(1, sc_dtls_context_sessions_in_use(ctx));
+  dtls_session_t *c =
+    sc_dtls_session_create(ctx, fd, (struct sockaddr *) &client_addr, sizeof(client_addr));
+  TEST_ASSERT_EQUAL_PTR(a, c);
+  TEST_ASSERT_FALSE(sc_dtls_is_handshake_complete(c));
+  TEST_ASSERT_EQUAL(htons(12347),
+                    ((const struct sockaddr_in *) sc_dtls_get_client_addr(c))->sin_port);
+  TEST_ASSERT_EQUAL(DTLS_ERROR_WOULD_BLOCK, sc_dtls_handshake(c));
+
+  sc_dtls_session_destroy(b);
+  sc_dtls_session_destroy(c);
+  TEST_ASSERT_EQUAL(0, sc_dtls_context_sessions_in_use(ctx));
+  sc_dtls_context_destroy(ctx);
+  close(fd);
+}
+
+// Transmit hook capturing the last datagram the context sent
+static uint8_t g_sent[512];
+static size_t g_sent_len;
+
+static ssize_t capture_send(void *user_data, const struct sockaddr *addr, socklen_t addr_len,
+                            const uint8_t *buf, size_t len) {
+  (void) user_data;
+  (void) addr;
+  (void) addr_len;
+  g_sent_len = len < sizeof(g_sent) ? len : sizeof(g_sent);
+  memcpy(g_sent, buf, g_sent_len);
+  return (ssize_t) len;
+}
+
+// Build a minimal DTLS 1.2 ClientHello record carrying the given cookie
+// Returns: Length of the record
+static size_t build_client_hello(uint8_t *out, const uint8_t *cookie, size_t cookie_len) {
+  size_t body_len = 2 + 32 + 1 + 1 + cookie_len + 4 + 2;
+  size_t len      = 0;
+
+  // Record header: handshake, DTLS 1.2, epoch 0, sequence number 0
+  out[len++] = 22;
+  out[len++] = 0xfe;
+  out[len++] = 0xfd;
+  memset(out + len, 0, 8);
+  len += 8;
+  out[len++] = (uint8_t) ((12 + body_len) >> 8);
+  out[len++] = (uint8_t) (12 + body_len);
+
+  // Handshake header: ClientHello, message_seq 0, unfragmented
+  out[len++] = 1;
+  out[len++] = 0;
+  out[len++] = (uint8_t) (body_len >> 8);
+  out[len++] = (uint8_t) body_len;
+  memset(out + len, 0, 5);
+  len += 5;
+  out[len++] = 0;
+  out[len++] = (uint8_t) (body_len >> 8);
+  out[len++] = (uint8_t) body_len;
+
+  // Body: version, random, empty session_id, cookie, one suite, null compression
+  out[len++] = 0xfe;
+  out[len++] = 0xfd;
+  memset(out + len, 0x42, 32);
+  len += 32;
+  out[len++] = 0;
+  out[len++] = (uint8_t) cookie_len;
+  memcpy(out + len, cookie, cookie_len);
+  len += cookie_len;
+  out[len++] = 0;
+  out[len++] = 2;
+  out[len++] = 0xc0;
+  out[len++] = 0x2b;
+  out[len++] = 1;
+  out[len++] = 0;
+  return len;
+}
+
+void test_dtls_check_hello_cookie_exchange(void) {
+  dtls_context_t *ctx = sc_dtls_context_create(DTLS_ROLE_SERVER, ".secrets/certs/server.crt",
+                                               ".secrets/certs/server.key", NULL, 0);
+  TEST_ASSERT_NOT_NULL(ctx);
+  sc_dtls_context_set_send(ctx, capture_send, NULL);
+
+  struct sockaddr_in client_addr;
+  memset(&client_addr, 0, sizeof(client_addr));
+  client_addr.sin_family      = AF_INET;
+  client_addr.sin_port        = htons(12345);
+  client_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  const struct sockaddr *addr = (const struct sockaddr *) &client_addr;
+
+  // Anything but a ClientHello is dropped without a reply
+  uint8_t garbage[32];
+  memset(garbage, 0x17, sizeof(garbage));
+  g_sent_len = 0;
+  TEST_ASSERT_EQUAL(DTLS_HELLO_DROPPED,
+                    sc_dtls_check_hello(ctx, -1, addr, sizeof(client_addr), garbage,
+                                        sizeof(garbage)));
+  TEST_ASSERT_EQUAL(0, g_sent_len);
+
+  // A ClientHello without a cookie is answered with a HelloVerifyRequest
+  uint8_t hello[512];
+  uint8_t cookie[255];
+  size_t hello_len = build_client_hello(hello, cookie, 0);
+  TEST_ASSERT_EQUAL(DTLS_HELLO_CHALLENGED,
+                    sc_dtls_check_hello(ctx, -1, addr, sizeof(client_addr), hello, hello_len));
+  TEST_ASSERT_TRUE(g_sent_len > 28);
+  TEST_ASSERT_EQUAL(22, g_sent[0]);
+  TEST_ASSERT_EQUAL(3, g_sent[13]);
+  TEST_ASSERT_EQUAL(g_sent_len - 28, g_sent[27]);
+
+  // Echoing the cookie from the same address passes
+  size_t cookie_len = g_sent[27];
+  memcpy(cookie, g_sent + 28, cookie_len);
+  hello_len = build_client_hello(hello, cookie, cookie_len);
+  TEST_ASSERT_EQUAL(DTLS_HELLO_VERIFIED,
+                    sc_dtls_check_hello(ctx, -1, addr, sizeof(client_addr), hello, hello_len));
+
+  // The same cookie from another address is challenged again
+  client_addr.sin_port = htons(12346);
+  TEST_ASSERT_EQUAL(DTLS_HELLO_CHALLENGED,
+                    sc_dtls_check_hello(ctx, -1, addr, sizeof(client_addr), hello, hello_len));
+
+  // A truncated ClientHello is dropped
+  TEST_ASSERT_EQUAL(DTLS_HELLO_DROPPED,
+                    sc_dtls_check_hello(ctx, -1, addr, sizeof(client_addr), hello, hello_len - 8));
+
+  const dtls_hello_stats_t *stats = sc_dtls_context_hello_stats(ctx);
+  TEST_ASSERT_EQUAL(2, stats->challenged);
+  TEST_ASSERT_EQUAL(1, stats->verified);
+  TEST_ASSERT_EQUAL(2, stats->dropped);
+
+  sc_dtls_context_destroy(ctx);
+}
+
+// Transmit hook counting the datagrams a session sent through it
+static ssize_t count_send(void *user_data, const struct sockaddr *addr, socklen_t addr_len,
+                          const uint8_t *buf, size_t len) {
+  (void) addr;
+  (void) addr_len;
+  (void) buf;
+  (*(size_t *) user_data)++;
+  return (ssize_t) len;
+}
+
+void test_dtls_session_send_override(void) {
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  TEST_ASSERT_NOT_EQUAL(-1, fd);
+  dtls_context_t *ctx = sc_dtls_context_create(DTLS_ROLE_SERVER, ".secrets/certs/server.crt",
+                                               ".secrets/certs/server.key", NULL, 0);
+  TEST_ASSERT_NOT_NULL(ctx);
+  sc_dtls_context_set_send(ctx, capture_send, NULL);
+
+  struct sockaddr_in client_addr;
+  memset(&client_addr, 0, sizeof(client_addr));
+  client_addr.sin_family      = AF_INET;
+  client_addr.sin_port        = htons(12345);
+  client_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  const struct sockaddr *addr = (const struct sockaddr *) &client_addr;
+
+  // Get a cookie for the address, then hand the session the verified hello
+  uint8_t hello[512];
+  uint8_t cookie[255];
+  size_t hello_len = build_client_hello(hello, cookie, 0);
+  TEST_ASSERT_EQUAL(DTLS_HELLO_CHALLENGED,
+                    sc_dtls_check_hello(ctx, fd, addr, sizeof(client_addr), hello, hello_len));
+  size_t cookie_len = g_sent[27];
+  memcpy(cookie, g_sent + 28, cookie_len);
+  hello_len = build_client_hello(hello, cookie, cookie_len);
+
+  dtls_session_t *session = sc_dtls_session_create(ctx, fd, addr, sizeof(client_addr));
+  TEST_ASSERT_NOT_NULL(session);
+
+  // Whatever the session answers goes through its own hook, not the context's
+  size_t sent = 0;
+  g_sent_len  = 0;
+  sc_dtls_session_set_send(session, count_send, &sent);
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_feed(session, hello, hello_len));
+  sc_dtls_handshake(session);
+  TEST_ASSERT_TRUE(sent > 0);
+  TEST_ASSERT_EQUAL(0, g_sent_len);
+
+  sc_dtls_session_set_send(session, NULL, NULL);
+  sc_dtls_session_destroy(session);
+  sc_dtls_context_destroy(ctx);
+  close(fd);
+}
+
+// Helper to read the monotonic clock in milliseconds
+static uint64_t monotonic_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000u + (uint64_t) ts.tv_nsec / 1000000u;
+}
+
+void test_dtls_retransmit_timer(void) {
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  TEST_ASSERT_NOT_EQUAL(-1, fd);
+  dtls_context_t *ctx = sc_dtls_context_create(DTLS_ROLE_CLIENT, NULL, NULL, NULL, 0);
+  TEST_ASSERT_NOT_NULL(ctx);
+
+  // A server that never answers
+  struct sockaddr_in server_addr;
+  memset(&server_addr, 0, sizeof(server_addr));
+  server_addr.sin_family      = AF_INET;
+  server_addr.sin_port        = htons(12345);
+  server_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  dtls_session_t *session =
+    sc_dtls_session_create(ctx, fd, (struct sockaddr *) &server_addr, sizeof(server_addr));
+  TEST_ASSERT_NOT_NULL(session);
+  TEST_ASSERT_EQUAL(0, sc_dtls_session_timeout_ms(session));
+  TEST_ASSERT_EQUAL(DTLS_ERROR_INVALID_PARAMS, sc_dtls_handle_timeout(NULL));
+
+  // Sending the ClientHello arms the timer instead of blocking for the reply
+  size_t sent = 0;
+  sc_dtls_session_set_send(session, count_send, &sent);
+  uint64_t start = monotonic_ms();
+  TEST_ASSERT_EQUAL(DTLS_ERROR_WOULD_BLOCK, sc_dtls_handshake(session));
+  TEST_ASSERT_TRUE(monotonic_ms() - start < 100);
+  TEST_ASSERT_EQUAL(1, sent);
+  uint64_t deadline = sc_dtls_session_timeout_ms(session);
+  TEST_ASSERT_TRUE(deadline > start);
+
+  // Nothing is resent before the deadline
+  TEST_ASSERT_EQUAL(DTLS_ERROR_WOULD_BLOCK, sc_dtls_handle_timeout(session));
+  TEST_ASSERT_EQUAL(1, sent);
+
+  // After it the hello goes out again and the next deadline is further away
+  usleep((useconds_t) (deadline - monotonic_ms() + 10) * 1000);
+  TEST_ASSERT_EQUAL(DTLS_ERROR_WOULD_BLOCK, sc_dtls_handle_timeout(session));
+  TEST_ASSERT_EQUAL(2, sent);
+  TEST_ASSERT_TRUE(sc_dtls_session_timeout_ms(session) - monotonic_ms() >
+                   deadline - start - 10);
+
+  sc_dtls_session_set_send(session, NULL, NULL);
+  sc_dtls_session_destroy(session);
+  sc_dtls_context_destroy(ctx);
+  close(fd);
+}
+
+// Find an extension in a captured ClientHello record
+// Returns: Pointer to the extension's data, or NULL if it is not there
+static const uint8_t *find_hello_extension(const uint8_t *rec, size_t len, unsigned type,
+                                           size_t *ext_len) {
+  // Skip record and handshake headers, version, random, session_id and cookie
+  size_t pos = 13 + 12 + 2 + 32;
+  if (pos >= len)
+    return NULL;
+  pos += 1 + rec[pos];
+  if (pos >= len)
+    return NULL;
+  pos += 1 + rec[pos];
+
+  // Cipher suites, compression methods, then the extension list
+  if (pos + 2 > len)
+    return NULL;
+  pos += 2 + ((size_t) rec[pos] << 8 | rec[pos + 1]);
+  if (pos >= len)
+    return NULL;
+  pos += 1 + rec[pos];
+  if (pos + 2 > len)
+    return NULL;
+  pos += 2;
+
+  while (pos + 4 <= len) {
+    unsigned ext_type = (unsigned) rec[pos] << 8 | rec[pos + 1];
+    size_t data_len   = (size_t) rec[pos + 2] << 8 | rec[pos + 3];
+    if (pos + 4 + data_len > len)
+      return NULL;
+    if (ext_type == type) {
+      *ext_len = data_len;
+      return rec + pos + 4;
+    }
+    pos += 4 + data_len;
+  }
+  return NULL;
+}
+
+void test_dtls_client_hello_requests_small_records(void) {
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  TEST_ASSERT_NOT_EQUAL(-1, fd);
+  dtls_context_t *ctx = sc_dtls_context_create(DTLS_ROLE_CLIENT, NULL, NULL, NULL, 0);
+  TEST_ASSERT_NOT_NULL(ctx);
+  sc_dtls_context_set_send(ctx, capture_send, NULL);
+
+  struct sockaddr_in server_addr;
+  memset(&server_addr, 0, sizeof(server_addr));
+  server_addr.sin_family      = AF_INET;
+  server_addr.sin_port        = htons(12345);
+  server_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  dtls_session_t *session =
+    sc_dtls_session_create(ctx, fd, (struct sockaddr *) &server_addr, sizeof(server_addr));
+  TEST_ASSERT_NOT_NULL(session);
+
+  g_sent_len = 0;
+  TEST_ASSERT_EQUAL(DTLS_ERROR_WOULD_BLOCK, sc_dtls_handshake(session));
+  TEST_ASSERT_TRUE(g_sent_len > 0);
+  TEST_ASSERT_EQUAL(22, g_sent[0]);
+  TEST_ASSERT_EQUAL(1, g_sent[13]);
+
+  // max_fragment_length (extension 1) asking for 2^12 byte records (code 4)
+  size_t ext_len          = 0;
+  const uint8_t *mfl_code = find_hello_extension(g_sent, g_sent_len, 1, &ext_len);
+  TEST_ASSERT_NOT_NULL(mfl_code);
+  TEST_ASSERT_EQUAL(1, ext_len);
+  TEST_ASSERT_EQUAL(4, mfl_code[0]);
+
+  sc_dtls_session_destroy(session);
+  sc_dtls_context_destroy(ctx);
+  close(fd);
+}
+
+// Datagrams queued for one side of an in-memory handshake
+#define TEST_FLIGHT_DATAGRAMS 16
+#define TEST_DATAGRAM_SIZE    8192
+
+typedef struct {
+  uint8_t data[TEST_FLIGHT_DATAGRAMS][TEST_DATAGRAM_SIZE];
+  size_t len[TEST_FLIGHT_DATAGRAMS];
+  size_t count;
+} test_flight_t;
+
+static test_flight_t g_to_server;
+static test_flight_t g_to_client;
+
+static ssize_t queue_send(void *user_data, const struct sockaddr *addr, socklen_t addr_len,
+                          const uint8_t *buf, size_t len) {
+  test_flight_t *flight = user_data;
+  (void) addr;
+  (void) addr_len;
+  TEST_ASSERT_TRUE(flight->count < TEST_FLIGHT_DATAGRAMS && len <= TEST_DATAGRAM_SIZE);
+  memcpy(flight->data[flight->count], buf, len);
+  flight->len[flight->count++] = len;
+  return (ssize_t) len;
+}
+
+// Run a handshake between a new client session and a new server session,
+// passing every datagram across, with the server's cookie exchange in front
+// Returns: true if both sides completed it
+// Run a handshake between two in-memory sessions and keep them; the server
+// session gets connection ID cid unless it is NULL
+static bool handshake_in_memory(dtls_context_t *client_ctx, dtls_context_t *server_ctx, int fd,
+                                const uint8_t *cid, dtls_session_t **client_out,
+                                dtls_session_t **server_out) {
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family             = AF_INET;
+  addr.sin_port               = htons(12345);
+  addr.sin_addr.s_addr        = htonl(INADDR_LOOPBACK);
+  const struct sockaddr *peer = (const struct sockaddr *) &addr;
+
+  sc_dtls_context_set_send(client_ctx, queue_send, &g_to_server);
+  sc_dtls_context_set_send(server_ctx, queue_send, &g_to_client);
+  g_to_server.count = 0;
+  g_to_client.count = 0;
+
+  dtls_session_t *client = sc_dtls_session_create(client_ctx, fd, peer, sizeof(addr));
+  dtls_session_t *server = NULL;
+  TEST_ASSERT_NOT_NULL(client);
+  dtls_result_t client_state = sc_dtls_handshake(client);
+  dtls_result_t server_state = DTLS_ERROR_WOULD_BLOCK;
+
+  for (int round = 0; round < 8 && (client_state != DTLS_OK || server_state != DTLS_OK); round++) {
+    for (size_t i = 0; i < g_to_server.count; i++) {
+      if (!server) {
+        if (sc_dtls_check_hello(server_ctx, fd, peer, sizeof(addr), g_to_server.data[i],
+                                g_to_server.len[i]) != DTLS_HELLO_VERIFIED) {
+          continue;
+        }
+        server = sc_dtls_session_create(server_ctx, fd, peer, sizeof(addr));
+        TEST_ASSERT_NOT_NULL(server);
+        if (cid) {
+          TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_session_set_cid(server, cid));
+        }
+      }
+      sc_dtls_feed(server, g_to_server.data[i], g_to_server.len[i]);
+      server_state = sc_dtls_handshake(server);
+    }
+    g_to_server.count = 0;
+
+    for (size_t i = 0; i < g_to_client.count; i++) {
+      sc_dtls_feed(client, g_to_client.data[i], g_to_client.len[i]);
+      client_state = sc_dtls_handshake(client);
+    }
+    g_to_client.count = 0;
+  }
+
+  *client_out = client;
+  *server_out = server;
+  return client_state == DTLS_OK && server_state == DTLS_OK;
+}
+
+static bool connect_in_memory(dtls_context_t *client_ctx, dtls_context_t *server_ctx, int fd) {
+  dtls_session_t *client;
+  dtls_session_t *server;
+  bool connected = handshake_in_memory(client_ctx, server_ctx, fd, NULL, &client, &server);
+  sc_dtls_session_destroy(server);
+  sc_dtls_session_destroy(client);
+  return connected;
+}
+
+void test_dtls_session_ticket_resumption(void) {
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  TEST_ASSERT_NOT_EQUAL(-1, fd);
+  dtls_context_t *server_ctx = sc_dtls_context_create(
+    DTLS_ROLE_SERVER, ".secrets/certs/server.crt", ".secrets/certs/server.key", NULL, 0);
+  dtls_context_t *sharing_ctx = sc_dtls_context_create(
+    DTLS_ROLE_SERVER, ".secrets/certs/server.crt", ".secrets/certs/server.key", NULL, 0);
+  dtls_context_t *other_ctx = sc_dtls_context_create(
+    DTLS_ROLE_SERVER, ".secrets/certs/server.crt", ".secrets/certs/server.key", NULL, 0);
+  dtls_context_t *client_ctx = sc_dtls_context_create(DTLS_ROLE_CLIENT, NULL, NULL, NULL, 0);
+  TEST_ASSERT_NOT_NULL(server_ctx);
+  TEST_ASSERT_NOT_NULL(sharing_ctx);
+  TEST_ASSERT_NOT_NULL(other_ctx);
+  TEST_ASSERT_NOT_NULL(client_ctx);
+  TEST_ASSERT_EQUAL(DTLS_ERROR_INVALID_PARAMS,
+                    sc_dtls_context_share_tickets(client_ctx, server_ctx));
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_context_share_tickets(sharing_ctx, server_ctx));
+
+  // A full handshake leaves the client a ticket
+  TEST_ASSERT_FALSE(sc_dtls_context_has_saved_session(client_ctx));
+  TEST_ASSERT_TRUE(connect_in_memory(client_ctx, server_ctx, fd));
+  TEST_ASSERT_TRUE(sc_dtls_context_has_saved_session(client_ctx));
+  dtls_ticket_stats_t stats = sc_dtls_context_ticket_stats(server_ctx);
+  TEST_ASSERT_EQUAL(1, stats.issued);
+  TEST_ASSERT_EQUAL(0, stats.resumed);
+
+  // Reconnecting resumes, on the issuing context or one sharing its keys
+  TEST_ASSERT_TRUE(connect_in_memory(client_ctx, server_ctx, fd));
+  TEST_ASSERT_EQUAL(1, sc_dtls_context_ticket_stats(server_ctx).resumed);
+  TEST_ASSERT_TRUE(connect_in_memory(client_ctx, sharing_ctx, fd));
+  TEST_ASSERT_EQUAL(1, sc_dtls_context_ticket_stats(sharing_ctx).resumed);
+
+  // A context with its own keys cannot open the ticket and falls back to a
+  // full handshake
+  TEST_ASSERT_TRUE(connect_in_memory(client_ctx, other_ctx, fd));
+  stats = sc_dtls_context_ticket_stats(other_ctx);
+  TEST_ASSERT_EQUAL(0, stats.resumed);
+  TEST_ASSERT_EQUAL(1, stats.rejected);
+
+  // Forgetting the session means no ticket is offered
+  sc_dtls_context_forget_session(client_ctx);
+  TEST_ASSERT_FALSE(sc_dtls_context_has_saved_session(client_ctx));
+  stats = sc_dtls_context_ticket_stats(server_ctx);
+  TEST_ASSERT_TRUE(connect_in_memory(client_ctx, server_ctx, fd));
+  TEST_ASSERT_EQUAL(stats.resumed, sc_dtls_context_ticket_stats(server_ctx).resumed);
+  TEST_ASSERT_EQUAL(stats.rejected, sc_dtls_context_ticket_stats(server_ctx).rejected);
+
+  sc_dtls_context_destroy(client_ctx);
+  sc_dtls_context_destroy(other_ctx);
+  sc_dtls_context_destroy(sharing_ctx);
+  sc_dtls_context_destroy(server_ctx);
+  close(fd);
+}
+
+void test_dtls_record_cid(void) {
+  uint8_t record[DTLS_CID_OFFSET + DTLS_CID_LEN + 2 + 16];
+  memset(record, 0, sizeof(record));
+  record[0] = DTLS_CID_CONTENT_TYPE;
+  memcpy(record + DTLS_CID_OFFSET, "shardid!", DTLS_CID_LEN);
+
+  TEST_ASSERT_EQUAL_PTR(record + DTLS_CID_OFFSET, sc_dtls_record_cid(record, sizeof(record)));
+  TEST_ASSERT_NULL(sc_dtls_record_cid(NULL, sizeof(record)));
+  TEST_ASSERT_NULL(sc_dtls_record_cid(record, DTLS_CID_OFFSET + DTLS_CID_LEN + 1));
+
+  // Records without an ID, such as handshakes and plain application data
+  record[0] = 22;
+  TEST_ASSERT_NULL(sc_dtls_record_cid(record, sizeof(record)));
+  record[0] = 23;
+  TEST_ASSERT_NULL(sc_dtls_record_cid(record, sizeof(record)));
+}
+
+void test_dtls_connection_id_survives_address_change(void) {
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  TEST_ASSERT_NOT_EQUAL(-1, fd);
+  dtls_context_t *server_ctx = sc_dtls_context_create(
+    DTLS_ROLE_SERVER, ".secrets/certs/server.crt", ".secrets/certs/server.key", NULL, 0);
+  dtls_context_t *client_ctx = sc_dtls_context_create(DTLS_ROLE_CLIENT, NULL, NULL, NULL, 0);
+  TEST_ASSERT_NOT_NULL(server_ctx);
+  TEST_ASSERT_NOT_NULL(client_ctx);
+
+  const uint8_t cid[DTLS_CID_LEN] = {3, 0, 0, 0, 7, 0, 0, 1};
+  dtls_session_t *client;
+  dtls_session_t *server;
+  TEST_ASSERT_TRUE(handshake_in_memory(client_ctx, server_ctx, fd, cid, &client, &server));
+  TEST_ASSERT_TRUE(sc_dtls_session_uses_cid(client));
+  TEST_ASSERT_TRUE(sc_dtls_session_uses_cid(server));
+  TEST_ASSERT_EQUAL(DTLS_ERROR_INVALID_PARAMS, sc_dtls_session_set_cid(client, cid));
+
+  // Every record the client sends now names the server session
+  size_t written = 0;
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_write(client, (const uint8_t *) "moved", 5, &written));
+  TEST_ASSERT_EQUAL(1, g_to_server.count);
+  const uint8_t *record_cid = sc_dtls_record_cid(g_to_server.data[0], g_to_server.len[0]);
+  TEST_ASSERT_NOT_NULL(record_cid);
+  TEST_ASSERT_EQUAL_MEMORY(cid, record_cid, DTLS_CID_LEN);
+
+  // The session decrypts it whatever address it came from, and answers the new one
+  struct sockaddr_in moved;
+  memset(&moved, 0, sizeof(moved));
+  moved.sin_family      = AF_INET;
+  moved.sin_port        = htons(23456);
+  moved.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  uint8_t buf[64];
+  size_t bytes_read = 0;
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_feed(server, g_to_server.data[0], g_to_server.len[0]));
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_read(server, buf, sizeof(buf), &bytes_read));
+  TEST_ASSERT_EQUAL(5, bytes_read);
+  TEST_ASSERT_EQUAL_MEMORY("moved", buf, 5);
+  sc_dtls_session_set_peer(server, (const struct sockaddr *) &moved, sizeof(moved));
+  const struct sockaddr_in *peer = (const struct sockaddr_in *) sc_dtls_get_client_addr(server);
+  TEST_ASSERT_EQUAL(htons(23456), peer->sin_port);
+
+  // A replayed record decrypts to nothing, so it cannot move the client again
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_feed(server, g_to_server.data[0], g_to_server.len[0]));
+  TEST_ASSERT_EQUAL(DTLS_ERROR_WOULD_BLOCK, sc_dtls_read(server, buf, sizeof(buf), &bytes_read));
+  sc_dtls_session_destroy(server);
+  sc_dtls_session_destroy(client);
+
+  // Without an ID from the server the client's records carry none
+  TEST_ASSERT_TRUE(handshake_in_memory(client_ctx, server_ctx, fd, NULL, &client, &server));
+  TEST_ASSERT_FALSE(sc_dtls_session_uses_cid(client));
+  g_to_server.count = 0;
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_write(client, (const uint8_t *) "stays", 5, &written));
+  TEST_ASSERT_EQUAL(1, g_to_server.count);
+  TEST_ASSERT_NULL(sc_dtls_record_cid(g_to_server.data[0], g_to_server.len[0]));
+  sc_dtls_session_destroy(server);
+  sc_dtls_session_destroy(client);
+
+  sc_dtls_context_destroy(client_ctx);
+  sc_dtls_context_destroy(server_ctx);
+  close(fd);
+}
+
+// Reads two records from a client in the order they were not sent
+static void check_older_record_after_newer(dtls_context_t *client_ctx,
+                                           dtls_context_t *server_ctx, int fd) {
+  const uint8_t cid[DTLS_CID_LEN] = {3, 0, 0, 0, 7, 0, 0, 2};
+  dtls_session_t *client;
+  dtls_session_t *server;
+  TEST_ASSERT_TRUE(handshake_in_memory(client_ctx, server_ctx, fd, cid, &client, &server));
+  TEST_ASSERT_EQUAL(0, sc_dtls_session_last_record(server));
+  TEST_ASSERT_FALSE(sc_dtls_session_last_record_is_newest(server));
+
+  size_t written = 0;
+  g_to_server.count = 0;
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_write(client, (const uint8_t *) "old", 3, &written));
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_write(client, (const uint8_t *) "new", 3, &written));
+  TEST_ASSERT_EQUAL(2, g_to_server.count);
+
+  // The later record arrives first, from the client's new address: it moves
+  // the client
+  uint8_t buf[64];
+  size_t bytes_read = 0;
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_feed(server, g_to_server.data[1], g_to_server.len[1]));
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_read(server, buf, sizeof(buf), &bytes_read));
+  TEST_ASSERT_EQUAL_MEMORY("new", buf, 3);
+  TEST_ASSERT_TRUE(sc_dtls_session_last_record_is_newest(server));
+  uint64_t newest = sc_dtls_session_last_record(server);
+
+  // The earlier one, late from the old address, is still delivered but must
+  // not move it back
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_feed(server, g_to_server.data[0], g_to_server.len[0]));
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_read(server, buf, sizeof(buf), &bytes_read));
+  TEST_ASSERT_EQUAL_MEMORY("old", buf, 3);
+  TEST_ASSERT_FALSE(sc_dtls_session_last_record_is_newest(server));
+  TEST_ASSERT_TRUE(sc_dtls_session_last_record(server) < newest);
+
+  // The next record is the newest again
+  g_to_server.count = 0;
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_write(client, (const uint8_t *) "next", 4, &written));
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_feed(server, g_to_server.data[0], g_to_server.len[0]));
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_read(server, buf, sizeof(buf), &bytes_read));
+  TEST_ASSERT_TRUE(sc_dtls_session_last_record_is_newest(server));
+  TEST_ASSERT_TRUE(sc_dtls_session_last_record(server) > newest);
+
+  sc_dtls_session_destroy(server);
+  sc_dtls_session_destroy(client);
+}
+
+void test_dtls_older_record_does_not_move_client(void) {
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  TEST_ASSERT_NOT_EQUAL(-1, fd);
+  dtls_context_t *server_ctx = sc_dtls_context_create(
+    DTLS_ROLE_SERVER, ".secrets/certs/server.crt", ".secrets/certs/server.key", NULL, 0);
+  dtls_context_t *client_ctx = sc_dtls_context_create(DTLS_ROLE_CLIENT, NULL, NULL, NULL, 0);
+  TEST_ASSERT_NOT_NULL(server_ctx);
+  TEST_ASSERT_NOT_NULL(client_ctx);
+  check_older_record_after_newer(client_ctx, server_ctx, fd);
+  sc_dtls_context_destroy(client_ctx);
+  sc_dtls_context_destroy(server_ctx);
+
+  // Plaintext sessions number their records the same way
+  server_ctx = sc_dtls_context_create_plain(DTLS_ROLE_SERVER);
+  client_ctx = sc_dtls_context_create_plain(DTLS_ROLE_CLIENT);
+  TEST_ASSERT_NOT_NULL(server_ctx);
+  TEST_ASSERT_NOT_NULL(client_ctx);
+  check_older_record_after_newer(client_ctx, server_ctx, fd);
+  sc_dtls_context_destroy(client_ctx);
+  sc_dtls_context_destroy(server_ctx);
+  close(fd);
+}
+
+void test_dtls_rank_ciphers(void) {
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_rank_ciphers());
+  const dtls_cipher_ranking_t *ranking = sc_dtls_cipher_ranking();
+  TEST_ASSERT_NOT_NULL(ranking);
+  TEST_ASSERT_NOT_NULL(ranking->unit);
+  TEST_ASSERT_NOT_NULL(ranking->preferred_suite);
+
+  // Every cipher ran, fastest first, and the preferred suite uses the fastest
+  for (size_t i = 0; i < DTLS_CIPHER_COUNT; i++) {
+    TEST_ASSERT_NOT_NULL(ranking->rates[i].name);
+    TEST_ASSERT_TRUE(ranking->rates[i].bytes_per_tick > 0);
+    if (i > 0) {
+      TEST_ASSERT_TRUE(ranking->rates[i - 1].bytes_per_tick >= ranking->rates[i].bytes_per_tick);
+    }
+  }
+  const char *fastest = ranking->rates[0].name;
+  bool chacha         = strcmp(fastest, "ChaCha20-Poly1305") == 0;
+  TEST_ASSERT_NOT_NULL(strstr(ranking->preferred_suite, chacha ? "CHACHA20-POLY1305" : fastest));
+
+  // Contexts created afterwards still agree on a suite
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  TEST_ASSERT_NOT_EQUAL(-1, fd);
+  dtls_context_t *server_ctx = sc_dtls_context_create(
+    DTLS_ROLE_SERVER, ".secrets/certs/server.crt", ".secrets/certs/server.key", NULL, 0);
+  dtls_context_t *client_ctx = sc_dtls_context_create(DTLS_ROLE_CLIENT, NULL, NULL, NULL, 0);
+  TEST_ASSERT_NOT_NULL(server_ctx);
+  TEST_ASSERT_NOT_NULL(client_ctx);
+  TEST_ASSERT_TRUE(connect_in_memory(client_ctx, server_ctx, fd));
+
+  sc_dtls_context_destroy(client_ctx);
+  sc_dtls_context_destroy(server_ctx);
+  close(fd);
+}
+
+void test_dtls_server_identities(void) {
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  TEST_ASSERT_NOT_EQUAL(-1, fd);
+  dtls_context_t *client_ctx = sc_dtls_context_create(DTLS_ROLE_CLIENT, NULL, NULL, NULL, 0);
+  TEST_ASSERT_NOT_NULL(client_ctx);
+
+  // make certs generates an ECDSA P-256 identity and an RSA-2048 one; clients
+  // complete a handshake with either
+  dtls_context_t *ecdsa_ctx = sc_dtls_context_create(
+    DTLS_ROLE_SERVER, ".secrets/certs/server.crt", ".secrets/certs/server.key", NULL, 0);
+  dtls_context_t *rsa_ctx = sc_dtls_context_create(
+    DTLS_ROLE_SERVER, ".secrets/certs/server-rsa.crt", ".secrets/certs/server-rsa.key", NULL, 0);
+  TEST_ASSERT_NOT_NULL(ecdsa_ctx);
+  TEST_ASSERT_NOT_NULL(rsa_ctx);
+  TEST_ASSERT_TRUE(connect_in_memory(client_ctx, ecdsa_ctx, fd));
+  sc_dtls_context_forget_session(client_ctx);
+  TEST_ASSERT_TRUE(connect_in_memory(client_ctx, rsa_ctx, fd));
+
+  // A key that does not belong to the certificate is refused up front
+  TEST_ASSERT_NULL(sc_dtls_context_create(DTLS_ROLE_SERVER, ".secrets/certs/server.crt",
+                                          ".secrets/certs/server-rsa.key", NULL, 0));
+  TEST_ASSERT_NULL(sc_dtls_context_create(DTLS_ROLE_SERVER, ".secrets/certs/server-rsa.crt",
+                                          ".secrets/certs/server.key", NULL, 0));
+
+  sc_dtls_context_destroy(rsa_ctx);
+  sc_dtls_context_destroy(ecdsa_ctx);
+  sc_dtls_context_destroy(client_ctx);
+  close(fd);
+}
+
+// Contexts a handshake thread connects, and whether it succeeded
+typedef struct {
+  dtls_context_t *client_ctx;
+  dtls_context_t *server_ctx;
+  int fd;
+  bool connected;
+} handshake_thread_t;
+
+static void *run_handshake_thread(void *arg) {
+  handshake_thread_t *job = arg;
+  job->connected          = connect_in_memory(job->client_ctx, job->server_ctx, job->fd);
+  return NULL;
+}
+
+void test_dtls_handshakes_on_other_threads(void) {
+  handshake_thread_t job;
+  job.fd = socket(AF_INET, SOCK_DGRAM, 0);
+  TEST_ASSERT_NOT_EQUAL(-1, job.fd);
+  job.server_ctx = sc_dtls_context_create(DTLS_ROLE_SERVER, ".secrets/certs/server.crt",
+                                          ".secrets/certs/server.key", NULL, 0);
+  job.client_ctx = sc_dtls_context_create(DTLS_ROLE_CLIENT, NULL, NULL, NULL, 0);
+  TEST_ASSERT_NOT_NULL(job.server_ctx);
+  TEST_ASSERT_NOT_NULL(job.client_ctx);
+
+  // Each thread seeds a generator of its own on its first handshake and frees
+  // it on exit; contexts made on this thread work from any of them
+  for (int i = 0; i < 3; i++) {
+    pthread_t thread;
+    job.connected = false;
+    sc_dtls_context_forget_session(job.client_ctx);
+    TEST_ASSERT_EQUAL(0, pthread_create(&thread, NULL, run_handshake_thread, &job));
+    TEST_ASSERT_EQUAL(0, pthread_join(thread, NULL));
+    TEST_ASSERT_TRUE(job.connected);
+  }
+
+  // And this thread's generator is unaffected
+  TEST_ASSERT_TRUE(connect_in_memory(job.client_ctx, job.server_ctx, job.fd));
+
+  sc_dtls_context_destroy(job.client_ctx);
+  sc_dtls_context_destroy(job.server_ctx);
+  close(job.fd);
+}
+
+void test_dtls_plain_transport(void) {
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  TEST_ASSERT_NOT_EQUAL(-1, fd);
+  dtls_context_t *server_ctx = sc_dtls_context_create_plain(DTLS_ROLE_SERVER);
+  dtls_context_t *client_ctx = sc_dtls_context_create_plain(DTLS_ROLE_CLIENT);
+  TEST_ASSERT_NOT_NULL(server_ctx);
+  TEST_ASSERT_NOT_NULL(client_ctx);
+  TEST_ASSERT_TRUE(sc_dtls_context_is_plain(server_ctx));
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_context_reserve_sessions(server_ctx, 2));
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_context_share_tickets(server_ctx, server_ctx));
+
+  // The same calls that drive a DTLS handshake complete a plaintext one
+  const uint8_t cid[DTLS_CID_LEN] = {1, 0, 0, 0, 0, 0, 0, 9};
+  dtls_session_t *client;
+  dtls_session_t *server;
+  TEST_ASSERT_TRUE(handshake_in_memory(client_ctx, server_ctx, fd, cid, &client, &server));
+  TEST_ASSERT_TRUE(sc_dtls_session_uses_cid(client));
+  TEST_ASSERT_TRUE(sc_dtls_session_uses_cid(server));
+  TEST_ASSERT_EQUAL(1, sc_dtls_context_sessions_in_use(server_ctx));
+  TEST_ASSERT_EQUAL(0, sc_dtls_session_timeout_ms(client));
+
+  // Records carry the payload as it is, behind the connection ID
+  size_t written = 0;
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_write(client, (const uint8_t *) "hello", 5, &written));
+  TEST_ASSERT_EQUAL(5, written);
+  TEST_ASSERT_EQUAL(1, g_to_server.count);
+  const uint8_t *record_cid = sc_dtls_record_cid(g_to_server.data[0], g_to_server.len[0]);
+  TEST_ASSERT_NOT_NULL(record_cid);
+  TEST_ASSERT_EQUAL_MEMORY(cid, record_cid, DTLS_CID_LEN);
+
+  uint8_t buf[64];
+  size_t bytes_read = 0;
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_feed(server, g_to_server.data[0], g_to_server.len[0]));
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_read(server, buf, sizeof(buf), &bytes_read));
+  TEST_ASSERT_EQUAL(5, bytes_read);
+  TEST_ASSERT_EQUAL_MEMORY("hello", buf, 5);
+
+  // A duplicate is dropped, and so is a record with another session's ID
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_feed(server, g_to_server.data[0], g_to_server.len[0]));
+  TEST_ASSERT_EQUAL(DTLS_ERROR_WOULD_BLOCK, sc_dtls_read(server, buf, sizeof(buf), &bytes_read));
+  g_to_server.count = 0;
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_write(client, (const uint8_t *) "again", 5, &written));
+  g_to_server.data[0][DTLS_CID_OFFSET] ^= 0xff;
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_feed(server, g_to_server.data[0], g_to_server.len[0]));
+  TEST_ASSERT_EQUAL(DTLS_ERROR_WOULD_BLOCK, sc_dtls_read(server, buf, sizeof(buf), &bytes_read));
+
+  // The server answers without an ID, and closing reaches the peer
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_write(server, (const uint8_t *) "world", 5, &written));
+  TEST_ASSERT_EQUAL(1, g_to_client.count);
+  TEST_ASSERT_NULL(sc_dtls_record_cid(g_to_client.data[0], g_to_client.len[0]));
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_feed(client, g_to_client.data[0], g_to_client.len[0]));
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_read(client, buf, sizeof(buf), &bytes_read));
+  TEST_ASSERT_EQUAL_MEMORY("world", buf, 5);
+
+  g_to_server.count = 0;
+  sc_dtls_close(client);
+  TEST_ASSERT_EQUAL(1, g_to_server.count);
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_feed(server, g_to_server.data[0], g_to_server.len[0]));
+  TEST_ASSERT_EQUAL(DTLS_ERROR_PEER_CLOSED, sc_dtls_read(server, buf, sizeof(buf), &bytes_read));
+
+  sc_dtls_session_destroy(server);
+  sc_dtls_session_destroy(client);
+  TEST_ASSERT_EQUAL(0, sc_dtls_context_sessions_in_use(server_ctx));
+
+  // A pooled session starts over for the next client, here one without an ID
+  TEST_ASSERT_TRUE(handshake_in_memory(client_ctx, server_ctx, fd, NULL, &client, &server));
+  TEST_ASSERT_FALSE(sc_dtls_session_uses_cid(client));
+  g_to_server.count = 0;
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_write(client, (const uint8_t *) "plain", 5, &written));
+  TEST_ASSERT_NULL(sc_dtls_record_cid(g_to_server.data[0], g_to_server.len[0]));
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_feed(server, g_to_server.data[0], g_to_server.len[0]));
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_read(server, buf, sizeof(buf), &bytes_read));
+  TEST_ASSERT_EQUAL_MEMORY("plain", buf, 5);
+  sc_dtls_session_destroy(server);
+  sc_dtls_session_destroy(client);
+
+  sc_dtls_context_destroy(client_ctx);
+  sc_dtls_context_destroy(server_ctx);
+  close(fd);
+}
+
+void test_dtls_plain_rejects_dtls_peers(void) {
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  TEST_ASSERT_NOT_EQUAL(-1, fd);
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family             = AF_INET;
+  addr.sin_port               = htons(12345);
+  addr.sin_addr.s_addr        = htonl(INADDR_LOOPBACK);
+  const struct sockaddr *peer = (const struct sockaddr *) &addr;
+
+  dtls_context_t *plain_server = sc_dtls_context_create_plain(DTLS_ROLE_SERVER);
+  dtls_context_t *plain_client = sc_dtls_context_create_plain(DTLS_ROLE_CLIENT);
+  dtls_context_t *dtls_server  = sc_dtls_context_create(
+    DTLS_ROLE_SERVER, ".secrets/certs/server.crt", ".secrets/certs/server.key", NULL, 0);
+  dtls_context_t *dtls_client = sc_dtls_context_create(DTLS_ROLE_CLIENT, NULL, NULL, NULL, 0);
+  TEST_ASSERT_NOT_NULL(plain_server);
+  TEST_ASSERT_NOT_NULL(plain_client);
+  TEST_ASSERT_NOT_NULL(dtls_server);
+  TEST_ASSERT_NOT_NULL(dtls_client);
+  sc_dtls_context_set_send(plain_client, queue_send, &g_to_server);
+  sc_dtls_context_set_send(dtls_client, queue_send, &g_to_server);
+  sc_dtls_context_set_send(dtls_server, queue_send, &g_to_client);
+
+  // Each kind of server drops the other kind's hello without answering
+  g_to_server.count = 0;
+  g_to_client.count = 0;
+  dtls_session_t *client = sc_dtls_session_create(dtls_client, fd, peer, sizeof(addr));
+  TEST_ASSERT_EQUAL(DTLS_ERROR_WOULD_BLOCK, sc_dtls_handshake(client));
+  TEST_ASSERT_EQUAL(1, g_to_server.count);
+  TEST_ASSERT_EQUAL(DTLS_HELLO_DROPPED, sc_dtls_check_hello(plain_server, fd, peer, sizeof(addr),
+                                                            g_to_server.data[0],
+                                                            g_to_server.len[0]));
+  sc_dtls_session_destroy(client);
+
+  g_to_server.count = 0;
+  client            = sc_dtls_session_create(plain_client, fd, peer, sizeof(addr));
+  TEST_ASSERT_EQUAL(DTLS_ERROR_WOULD_BLOCK, sc_dtls_handshake(client));
+  TEST_ASSERT_NOT_EQUAL(0, sc_dtls_session_timeout_ms(client));
+  TEST_ASSERT_EQUAL(1, g_to_server.count);
+  TEST_ASSERT_EQUAL(DTLS_HELLO_DROPPED, sc_dtls_check_hello(dtls_server, fd, peer, sizeof(addr),
+                                                            g_to_server.data[0],
+                                                            g_to_server.len[0]));
+  TEST_ASSERT_EQUAL(0, g_to_client.count);
+  TEST_ASSERT_EQUAL(1, sc_dtls_context_hello_stats(plain_server)->dropped);
+  sc_dtls_session_destroy(client);
+
+  sc_dtls_context_destroy(dtls_client);
+  sc_dtls_context_destroy(dtls_server);
+  sc_dtls_context_destroy(plain_client);
+  sc_dtls_context_destroy(plain_server);
+  close(fd);
+}
+
+void test_dtls_plain_hello_cookie(void) {
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  TEST_ASSERT_NOT_EQUAL(-1, fd);
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family             = AF_INET;
+  addr.sin_port               = htons(12345);
+  addr.sin_addr.s_addr        = htonl(INADDR_LOOPBACK);
+  const struct sockaddr *peer = (const struct sockaddr *) &addr;
+  struct sockaddr_in spoofed  = addr;
+  spoofed.sin_port            = htons(54321);
+
+  dtls_context_t *server_ctx = sc_dtls_context_create_plain(DTLS_ROLE_SERVER);
+  dtls_context_t *client_ctx = sc_dtls_context_create_plain(DTLS_ROLE_CLIENT);
+  TEST_ASSERT_NOT_NULL(server_ctx);
+  TEST_ASSERT_NOT_NULL(client_ctx);
+  sc_dtls_context_set_send(client_ctx, queue_send, &g_to_server);
+  sc_dtls_context_set_send(server_ctx, queue_send, &g_to_client);
+
+  // A first hello carries no cookie and is only challenged
+  g_to_server.count      = 0;
+  g_to_client.count      = 0;
+  dtls_session_t *client = sc_dtls_session_create(client_ctx, fd, peer, sizeof(addr));
+  TEST_ASSERT_EQUAL(DTLS_ERROR_WOULD_BLOCK, sc_dtls_handshake(client));
+  TEST_ASSERT_EQUAL(1, g_to_server.count);
+  TEST_ASSERT_EQUAL(DTLS_HELLO_CHALLENGED,
+                    sc_dtls_check_hello(server_ctx, fd, peer, sizeof(addr), g_to_server.data[0],
+                                        g_to_server.len[0]));
+  TEST_ASSERT_EQUAL(1, g_to_client.count);
+
+  // The client echoes the cookie at once
+  g_to_server.count = 0;
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_feed(client, g_to_client.data[0], g_to_client.len[0]));
+  TEST_ASSERT_EQUAL(DTLS_ERROR_WOULD_BLOCK, sc_dtls_handshake(client));
+  TEST_ASSERT_EQUAL(1, g_to_server.count);
+
+  // The cookie is bound to the address it was sent to
+  TEST_ASSERT_EQUAL(DTLS_HELLO_CHALLENGED,
+                    sc_dtls_check_hello(server_ctx, fd, (const struct sockaddr *) &spoofed,
+                                        sizeof(spoofed), g_to_server.data[0],
+                                        g_to_server.len[0]));
+  TEST_ASSERT_EQUAL(DTLS_HELLO_VERIFIED,
+                    sc_dtls_check_hello(server_ctx, fd, peer, sizeof(addr), g_to_server.data[0],
+                                        g_to_server.len[0]));
+
+  // A forged cookie is challenged like a missing one
+  g_to_server.data[0][g_to_server.len[0] - 1] ^= 0xff;
+  TEST_ASSERT_EQUAL(DTLS_HELLO_CHALLENGED,
+                    sc_dtls_check_hello(server_ctx, fd, peer, sizeof(addr), g_to_server.data[0],
+                                        g_to_server.len[0]));
+
+  const dtls_hello_stats_t *stats = sc_dtls_context_hello_stats(server_ctx);
+  TEST_ASSERT_EQUAL(3, stats->challenged);
+  TEST_ASSERT_EQUAL(1, stats->verified);
+  TEST_ASSERT_EQUAL(0, stats->dropped);
+  sc_dtls_session_destroy(client);
+
+  sc_dtls_context_destroy(client_ctx);
+  sc_dtls_context_destroy(server_ctx);
+  close(fd);
+}
+
+void test_dtls_session_memory(void) {
+  sc_tls_pool_stats_t before = sc_tls_arena_pool_stats();
+
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  TEST_ASSERT_NOT_EQUAL(-1, fd);
+  dtls_context_t *server_ctx = sc_dtls_context_create(
+    DTLS_ROLE_SERVER, ".secrets/certs/server.crt", ".secrets/certs/server.key", NULL, 0);
+  dtls_context_t *client_ctx = sc_dtls_context_create(DTLS_ROLE_CLIENT, NULL, NULL, NULL, 0);
+  TEST_ASSERT_NOT_NULL(server_ctx);
+  TEST_ASSERT_NOT_NULL(client_ctx);
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_context_reserve_sessions(server_ctx, 1));
+
+  // mbedTLS's memory comes from the pool
+  TEST_ASSERT_TRUE(sc_tls_arena_pool_stats().in_use_bytes > before.in_use_bytes);
+
+  dtls_session_t *client;
+  dtls_session_t *server;
+  TEST_ASSERT_TRUE(handshake_in_memory(client_ctx, server_ctx, fd, NULL, &client, &server));
+
+  // Once complete, nothing counts as the handshake's; what it left is established
+  dtls_session_t *sessions[] = {client, server};
+  for (size_t i = 0; i < 2; i++) {
+    dtls_memory_stats_t memory = sc_dtls_session_memory(sessions[i]);
+    TEST_ASSERT_EQUAL(0, memory.handshake_bytes);
+    TEST_ASSERT_TRUE(memory.handshake_peak > 0);
+    TEST_ASSERT_TRUE(memory.established_bytes > 0);
+  }
+
+  // The server kept its last flight; the client's first record lets it go
+  dtls_memory_stats_t kept = sc_dtls_session_memory(server);
+  size_t written           = 0;
+  size_t bytes_read        = 0;
+  uint8_t buf[64];
+  g_to_server.count = 0;
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_write(client, (const uint8_t *) "hello", 5, &written));
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_feed(server, g_to_server.data[0], g_to_server.len[0]));
+  TEST_ASSERT_EQUAL(DTLS_OK, sc_dtls_read(server, buf, sizeof(buf), &bytes_read));
+  TEST_ASSERT_TRUE(sc_dtls_session_memory(server).established_bytes < kept.established_bytes);
+
+  // A parked session starts counting its next handshake
+  sc_dtls_session_destroy(server);
+  sc_dtls_session_destroy(client);
+  server = sc_dtls_session_create(server_ctx, fd, NULL, 0);
+  TEST_ASSERT_NOT_NULL(server);
+  TEST_ASSERT_TRUE(sc_dtls_session_memory(server).handshake_bytes > 0);
+  sc_dtls_session_destroy(server);
+
+  // Plaintext sessions hold no mbedTLS memory
+  dtls_context_t *plain_ctx = sc_dtls_context_create_plain(DTLS_ROLE_CLIENT);
+  TEST_ASSERT_NOT_NULL(plain_ctx);
+  dtls_session_t *plain = sc_dtls_session_create(plain_ctx, fd, NULL, 0);
+  TEST_ASSERT_NOT_NULL(plain);
+  TEST_ASSERT_EQUAL(0, sc_dtls_session_memory(plain).established_bytes);
+  sc_dtls_session_destroy(plain);
+  sc_dtls_context_destroy(plain_ctx);
+
+  // Everything went back to the pool
+  sc_dtls_context_destroy(client_ctx);
+  sc_dtls_context_destroy(server_ctx);
+  TEST_ASSERT_EQUAL(before.in_use_bytes, sc_tls_arena_pool_stats().in_use_bytes);
+  TEST_ASSERT_EQUAL(before.large_bytes, sc_tls_arena_pool_stats().large_bytes);
+  close(fd);
+}
+
 int main(void) {
   UNITY_BEGIN();
 
@@ -120,6 +1209,24 @@ int main(void) {
   RUN_TEST(test_dtls_cert_hash);
   RUN_TEST(test_dtls_error_strings);
   RUN_TEST(test_dtls_session_creation);
+  RUN_TEST(test_dtls_feed_invalid_params);
+  RUN_TEST(test_dtls_server_session_never_reads_socket);
+  RUN_TEST(test_dtls_session_pool);
+  RUN_TEST(test_dtls_check_hello_cookie_exchange);
+  RUN_TEST(test_dtls_session_send_override);
+  RUN_TEST(test_dtls_retransmit_timer);
+  RUN_TEST(test_dtls_client_hello_requests_small_records);
+  RUN_TEST(test_dtls_session_ticket_resumption);
+  RUN_TEST(test_dtls_record_cid);
+  RUN_TEST(test_dtls_connection_id_survives_address_change);
+  RUN_TEST(test_dtls_older_record_does_not_move_client);
+  RUN_TEST(test_dtls_rank_ciphers);
+  RUN_TEST(test_dtls_server_identities);
+  RUN_TEST(test_dtls_handshakes_on_other_threads);
+  RUN_TEST(test_dtls_plain_transport);
+  RUN_TEST(test_dtls_plain_rejects_dtls_peers);
+  RUN_TEST(test_dtls_plain_hello_cookie);
+  RUN_TEST(test_dtls_session_memory);
 
   int result = UNITY_END();
 
@@ -0,0 +1,286 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "unity.h"
+
+#include "../src/egress.h"
+
+// Unity framework functions
+void setUp(void);
+void tearDown(void);
+
+// Test function prototypes
+void test_egress_init_rejects_bad_dimensions(void);
+void test_egress_queue_rejects_bad_arguments(void);
+void test_egress_flush_sends_in_order_across_peers(void);
+void test_egress_coalesces_equal_sizes(void);
+void test_egress_without_gso_sends_each_datagram(void);
+void test_egress_full_queue_flushes(void);
+void test_egress_oversized_sent_in_order(void);
+void test_egress_avg_batch_size(void);
+
+#define TEST_SLOT_SIZE 256
+#define TEST_CAPACITY  16
+
+static int g_send_fd    = -1;
+static int g_recv_fd[2] = {-1, -1};
+static struct sockaddr_in g_recv_addr[2];
+
+// Bind a non-blocking receiver to an ephemeral loopback port
+static int bind_receiver(struct sockaddr_in *addr) {
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  TEST_ASSERT_NOT_EQUAL(-1, fd);
+
+  memset(addr, 0, sizeof(*addr));
+  addr->sin_family      = AF_INET;
+  addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  TEST_ASSERT_EQUAL(0, bind(fd, (struct sockaddr *) addr, sizeof(*addr)));
+
+  socklen_t len = sizeof(*addr);
+  TEST_ASSERT_EQUAL(0, getsockname(fd, (struct sockaddr *) addr, &len));
+
+  int flags = fcntl(fd, F_GETFL, 0);
+  TEST_ASSERT_NOT_EQUAL(-1, fcntl(fd, F_SETFL, flags | O_NONBLOCK));
+  return fd;
+}
+
+void setUp(void) {
+  g_send_fd = socket(AF_INET, SOCK_DGRAM, 0);
+  TEST_ASSERT_NOT_EQUAL(-1, g_send_fd);
+  g_recv_fd[0] = bind_receiver(&g_recv_addr[0]);
+  g_recv_fd[1] = bind_receiver(&g_recv_addr[1]);
+}
+
+void tearDown(void) {
+  if (g_send_fd >= 0) {
+    close(g_send_fd);
+    g_send_fd = -1;
+  }
+  for (size_t i = 0; i < 2; i++) {
+    if (g_recv_fd[i] >= 0) {
+      close(g_recv_fd[i]);
+      g_recv_fd[i] = -1;
+    }
+  }
+}
+
+// Helper to queue a numbered datagram for one of the receivers
+static void queue_datagram(sc_egress_t *egress, size_t peer, int id, size_t len) {
+  uint8_t payload[TEST_SLOT_SIZE * 2];
+  memset(payload, id, sizeof(payload));
+  ssize_t queued = sc_egress_queue(egress, (const struct sockaddr *) &g_recv_addr[peer],
+                                   sizeof(g_recv_addr[peer]), payload, len);
+  TEST_ASSERT_EQUAL((ssize_t) len, queued);
+}
+
+// Helper to check the next datagram a receiver holds
+static void expect_datagram(size_t peer, int id, size_t len) {
+  uint8_t payload[TEST_SLOT_SIZE * 2];
+  ssize_t received = recv(g_recv_fd[peer], payload, sizeof(payload), 0);
+  TEST_ASSERT_EQUAL((ssize_t) len, received);
+  TEST_ASSERT_EQUAL(id, payload[0]);
+  TEST_ASSERT_EQUAL(id, payload[len - 1]);
+}
+
+// Helper to check that a receiver holds nothing more
+static void expect_empty(size_t peer) {
+  uint8_t payload[TEST_SLOT_SIZE * 2];
+  TEST_ASSERT_EQUAL(-1, recv(g_recv_fd[peer], payload, sizeof(payload), 0));
+}
+
+void test_egress_init_rejects_bad_dimensions(void) {
+  TEST_ASSERT_NULL(sc_egress_init(-1, TEST_CAPACITY, TEST_SLOT_SIZE));
+  TEST_ASSERT_NULL(sc_egress_init(g_send_fd, 0, TEST_SLOT_SIZE));
+  TEST_ASSERT_NULL(sc_egress_init(g_send_fd, TEST_CAPACITY, 0));
+  TEST_ASSERT_NULL(sc_egress_init(g_send_fd, TEST_CAPACITY, SC_EGRESS_MAX_GSO_BYTES + 1));
+}
+
+void test_egress_queue_rejects_bad_arguments(void) {
+  sc_egress_t *egress = sc_egress_init(g_send_fd, TEST_CAPACITY, TEST_SLOT_SIZE);
+  TEST_ASSERT_NOT_NULL(egress);
+
+  const struct sockaddr *addr = (const struct sockaddr *) &g_recv_addr[0];
+  uint8_t payload[8]          = {0};
+
+  errno = 0;
+  TEST_ASSERT_EQUAL(-1, sc_egress_queue(egress, addr, sizeof(g_recv_addr[0]), payload, 0));
+  TEST_ASSERT_EQUAL(EINVAL, errno);
+  TEST_ASSERT_EQUAL(-1, sc_egress_queue(egress, addr, 4, payload, sizeof(payload)));
+  TEST_ASSERT_EQUAL(-1, sc_egress_queue(egress, NULL, 0, payload, sizeof(payload)));
+  TEST_ASSERT_EQUAL(0, egress->queued);
+
+  sc_egress_nuke(egress);
+}
+
+void test_egress_flush_sends_in_order_across_peers(void) {
+  sc_egress_t *egress = sc_egress_init(g_send_fd, TEST_CAPACITY, TEST_SLOT_SIZE);
+  TEST_ASSERT_NOT_NULL(egress);
+
+  queue_datagram(egress, 0, 1, 10);
+  queue_datagram(egress, 1, 2, 20);
+  queue_datagram(egress, 0, 3, 30);
+  TEST_ASSERT_EQUAL(3, egress->queued);
+  TEST_ASSERT_EQUAL(3, egress->message_count);
+
+  // Nothing leaves before the flush, then everything leaves in one call
+  expect_empty(0);
+  TEST_ASSERT_EQUAL(3, sc_egress_flush(egress));
+  TEST_ASSERT_EQUAL(1, egress->calls);
+  TEST_ASSERT_EQUAL(3, egress->messages);
+  TEST_ASSERT_EQUAL(0, egress->queued);
+
+  expect_datagram(0, 1, 10);
+  expect_datagram(0, 3, 30);
+  expect_datagram(1, 2, 20);
+  expect_empty(0);
+  expect_empty(1);
+
+  // An empty flush makes no system call
+  TEST_ASSERT_EQUAL(0, sc_egress_flush(egress));
+  TEST_ASSERT_EQUAL(1, egress->calls);
+
+  sc_egress_nuke(egress);
+}
+
+void test_egress_coalesces_equal_sizes(void) {
+  sc_egress_t *egress = sc_egress_init(g_send_fd, TEST_CAPACITY, TEST_SLOT_SIZE);
+  TEST_ASSERT_NOT_NULL(egress);
+  if (!egress->gso) {
+    sc_egress_nuke(egress);
+    TEST_IGNORE_MESSAGE("Kernel lacks UDP GSO");
+  }
+
+  // Four full segments and a short one share a message; the short one
+  // seals it, so the last datagram starts another
+  for (int i = 1; i <= 4; i++) {
+    queue_datagram(egress, 0, i, 100);
+  }
+  queue_datagram(egress, 0, 5, 40);
+  queue_datagram(egress, 0, 6, 100);
+  queue_datagram(egress, 1, 7, 100);
+  TEST_ASSERT_EQUAL(7, egress->queued);
+  TEST_ASSERT_EQUAL(3, egress->message_count);
+
+  TEST_ASSERT_EQUAL(7, sc_egress_flush(egress));
+  TEST_ASSERT_EQUAL(1, egress->calls);
+  TEST_ASSERT_EQUAL(3, egress->messages);
+  TEST_ASSERT_EQUAL(1, egress->gso_messages);
+
+  // The kernel splits the message back into the original datagrams
+  for (int i = 1; i <= 4; i++) {
+    expect_datagram(0, i, 100);
+  }
+  expect_datagram(0, 5, 40);
+  expect_datagram(0, 6, 100);
+  expect_datagram(1, 7, 100);
+  expect_empty(0);
+
+  sc_egress_nuke(egress);
+}
+
+void test_egress_without_gso_sends_each_datagram(void) {
+  sc_egress_t *egress = sc_egress_init(g_send_fd, TEST_CAPACITY, TEST_SLOT_SIZE);
+  TEST_ASSERT_NOT_NULL(egress);
+  egress->gso = false;
+
+  for (int i = 1; i <= 3; i++) {
+    queue_datagram(egress, 0, i, 100);
+  }
+  TEST_ASSERT_EQUAL(3, egress->message_count);
+
+  TEST_ASSERT_EQUAL(3, sc_egress_flush(egress));
+  TEST_ASSERT_EQUAL(1, egress->calls);
+  TEST_ASSERT_EQUAL(0, egress->gso_messages);
+  for (int i = 1; i <= 3; i++) {
+    expect_datagram(0, i, 100);
+  }
+
+  sc_egress_nuke(egress);
+}
+
+void test_egress_full_queue_flushes(void) {
+  sc_egress_t *egress = sc_egress_init(g_send_fd, 4, TEST_SLOT_SIZE);
+  TEST_ASSERT_NOT_NULL(egress);
+
+  for (int i = 1; i <= 6; i++) {
+    queue_datagram(egress, (size_t) i % 2, i, 16);
+  }
+
+  // The fifth datagram found the queue full and sent the first four
+  TEST_ASSERT_EQUAL(4, egress->datagrams);
+  TEST_ASSERT_EQUAL(2, egress->queued);
+
+  TEST_ASSERT_EQUAL(2, sc_egress_flush(egress));
+  TEST_ASSERT_EQUAL(6, egress->datagrams);
+  for (int i = 2; i <= 6; i += 2) {
+    expect_datagram(0, i, 16);
+  }
+  for (int i = 1; i <= 5; i += 2) {
+    expect_datagram(1, i, 16);
+  }
+
+  sc_egress_nuke(egress);
+}
+
+void test_egress_oversized_sent_in_order(void) {
+  sc_egress_t *egress = sc_egress_init(g_send_fd, TEST_CAPACITY, 64);
+  TEST_ASSERT_NOT_NULL(egress);
+
+  queue_datagram(egress, 0, 1, 16);
+  queue_datagram(egress, 0, 2, 100);
+
+  // The oversized datagram went straight out, behind the one queued first
+  TEST_ASSERT_EQUAL(2, egress->datagrams);
+  TEST_ASSERT_EQUAL(0, egress->queued);
+
+  queue_datagram(egress, 0, 3, 16);
+  TEST_ASSERT_EQUAL(1, sc_egress_flush(egress));
+
+  expect_datagram(0, 1, 16);
+  expect_datagram(0, 2, 100);
+  expect_datagram(0, 3, 16);
+
+  sc_egress_nuke(egress);
+}
+
+void test_egress_avg_batch_size(void) {
+  sc_egress_t *egress = sc_egress_init(g_send_fd, TEST_CAPACITY, TEST_SLOT_SIZE);
+  TEST_ASSERT_NOT_NULL(egress);
+
+  TEST_ASSERT_TRUE(sc_egress_avg_batch_size(egress) == 0.0);
+
+  for (int i = 1; i <= 6; i++) {
+    queue_datagram(egress, (size_t) i % 2, i, 16);
+  }
+  sc_egress_flush(egress);
+  queue_datagram(egress, 0, 7, 16);
+  queue_datagram(egress, 1, 8, 16);
+  sc_egress_flush(egress);
+
+  TEST_ASSERT_EQUAL(2, egress->calls);
+  TEST_ASSERT_EQUAL(8, egress->datagrams);
+  TEST_ASSERT_TRUE(sc_egress_avg_batch_size(egress) == 4.0);
+
+  sc_egress_nuke(egress);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_egress_init_rejects_bad_dimensions);
+  RUN_TEST(test_egress_queue_rejects_bad_arguments);
+  RUN_TEST(test_egress_flush_sends_in_order_across_peers);
+  RUN_TEST(test_egress_coalesces_equal_sizes);
+  RUN_TEST(test_egress_without_gso_sends_each_datagram);
+  RUN_TEST(test_egress_full_queue_flushes);
+  RUN_TEST(test_egress_oversized_sent_in_order);
+  RUN_TEST(test_egress_avg_batch_size);
+
+  return UNITY_END();
+}
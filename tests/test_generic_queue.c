@@ -5,6 +5,9 @@
 #include <stdlib.h>
 #include <time.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <sched.h>
+#include <poll.h>
 
 #include "unity.h"
 
@@ -78,6 +81,19 @@ void test_queue_init_with_overflow_capacity(void);
 void test_queue_init_with_max_capacity(void);
 void test_queue_init_with_safe_large_capacity(void);
 void test_queue_init_memory_allocation_failure(void);
+void test_queue_add_n_fills_to_capacity(void);
+void test_queue_pop_n_keeps_order(void);
+void test_queue_batch_null_parameters(void);
+void test_queue_drain_takes_everything(void);
+void test_queue_add_n_wakes_blocked_consumers(void);
+void test_queue_batch_threads_lose_nothing(void);
+void test_queue_pop_until_honors_deadline(void);
+void test_queue_add_until_waits_for_room(void);
+void test_queue_eventfd_readable_while_items_wait(void);
+void test_queue_eventfd_written_once_per_transition(void);
+void test_queue_eventfd_stays_readable_for_items_left(void);
+void test_queue_eventfd_cleared_by_last_pop(void);
+void test_queue_eventfd_threads_lose_no_wakeup(void);
 
 // Test data structure for generic queue testing
 typedef struct {
@@ -1451,6 +1467,418 @@ void test_queue_init_memory_allocation_failure(void) {
   }
 }
 
+// Batch tests
+
+#define BATCH_CAPACITY  10
+#define BATCH_PRODUCERS 4
+#define BATCH_ROUNDS    2000
+#define BATCH_SIZE      7
+
+// Fills items with distinct non-NULL pointers
+static void fill_items(void **items, size_t count, uintptr_t first) {
+  for (size_t i = 0; i < count; i++) {
+    items[i] = (void *) (first + i + 1);
+  }
+}
+
+void test_queue_add_n_fills_to_capacity(void) {
+  sc_generic_queue_t *queue = sc_generic_queue_init(BATCH_CAPACITY);
+  TEST_ASSERT_NOT_NULL(queue);
+  void *items[BATCH_CAPACITY + 5];
+  fill_items(items, BATCH_CAPACITY + 5, 0);
+
+  // Only as many as fit go in, from the start of the batch
+  TEST_ASSERT_EQUAL(6, sc_generic_queue_add_n(queue, items, 6));
+  TEST_ASSERT_EQUAL(BATCH_CAPACITY - 6, sc_generic_queue_add_n(queue, items + 6, 9));
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_SUCCESS, sc_generic_queue_get_error());
+  TEST_ASSERT_TRUE(sc_generic_queue_is_full(queue));
+
+  TEST_ASSERT_EQUAL(0, sc_generic_queue_add_n(queue, items, 1));
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_ERR_FULL, sc_generic_queue_get_error());
+  TEST_ASSERT_EQUAL(0, sc_generic_queue_add_n(queue, items, 0));
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_SUCCESS, sc_generic_queue_get_error());
+
+  sc_generic_queue_nuke(queue);
+}
+
+void test_queue_pop_n_keeps_order(void) {
+  sc_generic_queue_t *queue = sc_generic_queue_init(BATCH_CAPACITY);
+  TEST_ASSERT_NOT_NULL(queue);
+  void *items[BATCH_CAPACITY];
+  void *popped[BATCH_CAPACITY];
+
+  // Run positions around the ring several times with odd-sized batches
+  uintptr_t added = 0;
+  uintptr_t taken = 0;
+  for (size_t round = 0; round < 20; round++) {
+    fill_items(items, BATCH_CAPACITY, added);
+    added += sc_generic_queue_add_n(queue, items, BATCH_CAPACITY);
+    size_t got = sc_generic_queue_pop_n(queue, popped, round % 4 + 3);
+    TEST_ASSERT_EQUAL(round % 4 + 3, got);
+    for (size_t i = 0; i < got; i++) {
+      TEST_ASSERT_EQUAL_PTR((void *) (taken + i + 1), popped[i]);
+    }
+    taken += got;
+    TEST_ASSERT_EQUAL(added - taken, sc_generic_queue_get_size(queue));
+  }
+
+  size_t got = sc_generic_queue_pop_n(queue, popped, BATCH_CAPACITY);
+  TEST_ASSERT_EQUAL(added - taken, got);
+  TEST_ASSERT_EQUAL(0, sc_generic_queue_pop_n(queue, popped, BATCH_CAPACITY));
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_ERR_EMPTY, sc_generic_queue_get_error());
+
+  sc_generic_queue_nuke(queue);
+}
+
+void test_queue_batch_null_parameters(void) {
+  sc_generic_queue_t *queue = sc_generic_queue_init(BATCH_CAPACITY);
+  TEST_ASSERT_NOT_NULL(queue);
+  void *items[3] = {(void *) 1, NULL, (void *) 3};
+
+  TEST_ASSERT_EQUAL(0, sc_generic_queue_add_n(NULL, items, 1));
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_ERR_NULL, sc_generic_queue_get_error());
+  TEST_ASSERT_EQUAL(0, sc_generic_queue_add_n(queue, NULL, 1));
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_ERR_NULL, sc_generic_queue_get_error());
+
+  // A NULL anywhere in the batch rejects all of it
+  TEST_ASSERT_EQUAL(0, sc_generic_queue_add_n(queue, items, 3));
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_ERR_NULL, sc_generic_queue_get_error());
+  TEST_ASSERT_TRUE(sc_generic_queue_is_empty(queue));
+
+  TEST_ASSERT_EQUAL(0, sc_generic_queue_pop_n(queue, NULL, 1));
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_ERR_NULL, sc_generic_queue_get_error());
+  TEST_ASSERT_EQUAL(0, sc_generic_queue_drain(queue, NULL, NULL));
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_ERR_NULL, sc_generic_queue_get_error());
+
+  sc_generic_queue_nuke(queue);
+}
+
+void test_queue_drain_takes_everything(void) {
+  sc_generic_queue_t *queue = sc_generic_queue_init(100);
+  TEST_ASSERT_NOT_NULL(queue);
+
+  TestData *items[100];
+  TestData *cleaned[100];
+  cleanup_tracker_t tracker = {0, cleaned, 100};
+  for (int i = 0; i < 100; i++) {
+    items[i] = create_test_data(i, "drain");
+  }
+  TEST_ASSERT_EQUAL(100, sc_generic_queue_add_n(queue, (void *const *) items, 100));
+
+  // More than one internal batch, in order
+  TEST_ASSERT_EQUAL(100, sc_generic_queue_drain(queue, test_cleanup_callback, &tracker));
+  TEST_ASSERT_EQUAL(100, tracker.cleanup_call_count);
+  for (int i = 0; i < 100; i++) {
+    TEST_ASSERT_EQUAL_PTR(items[i], cleaned[i]);
+  }
+  TEST_ASSERT_TRUE(sc_generic_queue_is_empty(queue));
+
+  TEST_ASSERT_EQUAL(0, sc_generic_queue_drain(queue, test_cleanup_callback, &tracker));
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_ERR_EMPTY, sc_generic_queue_get_error());
+
+  sc_generic_queue_nuke(queue);
+}
+
+// Pops one item with the blocking pop and returns it
+static void *blocking_pop_thread(void *arg) {
+  void *item = NULL;
+  sc_generic_queue_pop(arg, &item);
+  return item;
+}
+
+void test_queue_add_n_wakes_blocked_consumers(void) {
+  sc_generic_queue_t *queue = sc_generic_queue_init(BATCH_CAPACITY);
+  TEST_ASSERT_NOT_NULL(queue);
+
+  pthread_t consumers[3];
+  for (size_t i = 0; i < 3; i++) {
+    TEST_ASSERT_EQUAL(0, pthread_create(&consumers[i], NULL, blocking_pop_thread, queue));
+  }
+  usleep(100000);
+
+  // One batch must wake every blocked consumer, not just one of them
+  void *items[3];
+  fill_items(items, 3, 0);
+  long long start = get_time_ms();
+  TEST_ASSERT_EQUAL(3, sc_generic_queue_add_n(queue, items, 3));
+  for (size_t i = 0; i < 3; i++) {
+    void *item = NULL;
+    pthread_join(consumers[i], &item);
+    TEST_ASSERT_NOT_NULL(item);
+  }
+  TEST_ASSERT_LESS_THAN(1000, get_time_ms() - start);
+
+  sc_generic_queue_nuke(queue);
+}
+
+// Adds BATCH_ROUNDS batches of BATCH_SIZE items, retrying what did not fit
+static void *batch_producer_thread(void *arg) {
+  sc_generic_queue_t *queue = arg;
+  for (size_t round = 0; round < BATCH_ROUNDS; round++) {
+    void *items[BATCH_SIZE];
+    fill_items(items, BATCH_SIZE, 0);
+    size_t added = 0;
+    while (added < BATCH_SIZE) {
+      added += sc_generic_queue_add_n(queue, items + added, BATCH_SIZE - added);
+      if (added < BATCH_SIZE) {
+        sched_yield();
+      }
+    }
+  }
+  return NULL;
+}
+
+void test_queue_batch_threads_lose_nothing(void) {
+  sc_generic_queue_t *queue = sc_generic_queue_init(BATCH_CAPACITY);
+  TEST_ASSERT_NOT_NULL(queue);
+
+  pthread_t producers[BATCH_PRODUCERS];
+  for (size_t i = 0; i < BATCH_PRODUCERS; i++) {
+    TEST_ASSERT_EQUAL(0, pthread_create(&producers[i], NULL, batch_producer_thread, queue));
+  }
+
+  // Every item of a batch is 1..BATCH_SIZE, so the total is known
+  size_t expected = BATCH_PRODUCERS * BATCH_ROUNDS * BATCH_SIZE;
+  uintptr_t sum   = 0;
+  size_t taken    = 0;
+  while (taken < expected) {
+    void *popped[BATCH_SIZE];
+    size_t got = sc_generic_queue_pop_n(queue, popped, BATCH_SIZE);
+    if (got == 0) {
+      sched_yield();
+    }
+    for (size_t i = 0; i < got; i++) {
+      TEST_ASSERT_NOT_NULL(popped[i]);
+      sum += (uintptr_t) popped[i];
+    }
+    taken += got;
+  }
+  for (size_t i = 0; i < BATCH_PRODUCERS; i++) {
+    pthread_join(producers[i], NULL);
+  }
+
+  TEST_ASSERT_EQUAL(expected, taken);
+  TEST_ASSERT_EQUAL(BATCH_PRODUCERS * BATCH_ROUNDS * BATCH_SIZE * (BATCH_SIZE + 1) / 2, sum);
+  TEST_ASSERT_TRUE(sc_generic_queue_is_empty(queue));
+  sc_generic_queue_nuke(queue);
+}
+
+// Deadline tests
+
+#define DEADLINE_MS 30
+
+void test_queue_pop_until_honors_deadline(void) {
+  sc_generic_queue_t *queue = sc_generic_queue_init(BATCH_CAPACITY);
+  TEST_ASSERT_NOT_NULL(queue);
+
+  // Tens of milliseconds, not whole seconds, and measured on the same clock
+  void *item        = (void *) 1;
+  uint64_t deadline = sc_queue_deadline(DEADLINE_MS * SC_QUEUE_NS_PER_MS);
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_ERR_TIMEOUT,
+                    sc_generic_queue_pop_until(queue, &item, deadline));
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_ERR_TIMEOUT, sc_generic_queue_get_error());
+  TEST_ASSERT_NULL(item);
+
+  uint64_t late = sc_queue_deadline(0) - deadline;
+  TEST_ASSERT_TRUE(late < TIMEOUT_MARGIN_MS * SC_QUEUE_NS_PER_MS);
+
+  // An item already there is returned however early the deadline
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_SUCCESS, sc_generic_queue_try_add(queue, (void *) 2));
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_SUCCESS, sc_generic_queue_pop_until(queue, &item, 0));
+  TEST_ASSERT_EQUAL_PTR((void *) 2, item);
+
+  sc_generic_queue_nuke(queue);
+}
+
+// Pops one item after DEADLINE_MS
+static void *delayed_pop_thread(void *arg) {
+  usleep(DEADLINE_MS * 1000);
+  void *item = NULL;
+  sc_generic_queue_try_pop(arg, &item);
+  return item;
+}
+
+void test_queue_add_until_waits_for_room(void) {
+  sc_generic_queue_t *queue = sc_generic_queue_init(1);
+  TEST_ASSERT_NOT_NULL(queue);
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_SUCCESS, sc_generic_queue_try_add(queue, (void *) 1));
+
+  pthread_t consumer;
+  TEST_ASSERT_EQUAL(0, pthread_create(&consumer, NULL, delayed_pop_thread, queue));
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_SUCCESS,
+                    sc_generic_queue_add_until(queue, (void *) 2, SC_QUEUE_WAIT_FOREVER));
+
+  void *popped = NULL;
+  pthread_join(consumer, &popped);
+  TEST_ASSERT_EQUAL_PTR((void *) 1, popped);
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_SUCCESS, sc_generic_queue_try_pop(queue, &popped));
+  TEST_ASSERT_EQUAL_PTR((void *) 2, popped);
+
+  sc_generic_queue_nuke(queue);
+}
+
+// Eventfd tests
+
+// Helper to wait until the queue's eventfd is readable
+static bool wait_readable(const sc_generic_queue_t *queue, int timeout_ms) {
+  struct pollfd pfd = {.fd = queue->event_fd, .events = POLLIN};
+  return poll(&pfd, 1, timeout_ms) == 1;
+}
+
+// Drain callback for items that own nothing
+static void ignore_item(void *item, void *user_data) {
+  (void) item;
+  (void) user_data;
+}
+
+void test_queue_eventfd_readable_while_items_wait(void) {
+  sc_generic_queue_t *queue = sc_generic_queue_init(BATCH_CAPACITY);
+  TEST_ASSERT_NOT_NULL(queue);
+  TEST_ASSERT_EQUAL(-1, queue->event_fd);
+  TEST_ASSERT_EQUAL(-1, sc_generic_queue_attach_eventfd(NULL));
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_ERR_NULL, sc_generic_queue_get_error());
+
+  int fd = sc_generic_queue_attach_eventfd(queue);
+  TEST_ASSERT_TRUE(fd >= 0);
+  TEST_ASSERT_EQUAL(fd, queue->event_fd);
+  TEST_ASSERT_EQUAL(-1, sc_generic_queue_attach_eventfd(queue));
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_ERR_INVALID, sc_generic_queue_get_error());
+  TEST_ASSERT_FALSE(wait_readable(queue, 0));
+
+  // Every way of adding makes it readable, every way of emptying clears it
+  void *item = NULL;
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_SUCCESS, sc_generic_queue_try_add(queue, (void *) 1));
+  TEST_ASSERT_TRUE(wait_readable(queue, 0));
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_SUCCESS, sc_generic_queue_try_pop(queue, &item));
+  TEST_ASSERT_FALSE(wait_readable(queue, 0));
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_ERR_EMPTY, sc_generic_queue_try_pop(queue, &item));
+  TEST_ASSERT_FALSE(wait_readable(queue, 0));
+
+  void *items[BATCH_SIZE];
+  fill_items(items, BATCH_SIZE, 0);
+  TEST_ASSERT_EQUAL(BATCH_SIZE, sc_generic_queue_add_n(queue, items, BATCH_SIZE));
+  TEST_ASSERT_TRUE(wait_readable(queue, 0));
+  TEST_ASSERT_EQUAL(BATCH_SIZE, sc_generic_queue_pop_n(queue, items, BATCH_CAPACITY));
+  TEST_ASSERT_FALSE(wait_readable(queue, 0));
+
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_SUCCESS, sc_generic_queue_add(queue, (void *) 1));
+  TEST_ASSERT_TRUE(wait_readable(queue, 0));
+  TEST_ASSERT_EQUAL(1, sc_generic_queue_drain(queue, ignore_item, NULL));
+  TEST_ASSERT_FALSE(wait_readable(queue, 0));
+
+  sc_generic_queue_nuke(queue);
+}
+
+void test_queue_eventfd_written_once_per_transition(void) {
+  sc_generic_queue_t *queue = sc_generic_queue_init(BATCH_CAPACITY);
+  TEST_ASSERT_NOT_NULL(queue);
+
+  // Items added before attaching are announced straight away
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_SUCCESS, sc_generic_queue_try_add(queue, (void *) 1));
+  int fd = sc_generic_queue_attach_eventfd(queue);
+  TEST_ASSERT_TRUE(fd >= 0);
+  TEST_ASSERT_TRUE(wait_readable(queue, 0));
+
+  // Adds to a queue already signalled leave the counter alone
+  void *items[BATCH_SIZE];
+  fill_items(items, BATCH_SIZE, 0);
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_SUCCESS, sc_generic_queue_try_add(queue, (void *) 2));
+  TEST_ASSERT_EQUAL(BATCH_SIZE, sc_generic_queue_add_n(queue, items, BATCH_SIZE));
+
+  uint64_t writes = 0;
+  TEST_ASSERT_EQUAL(sizeof(writes), read(fd, &writes, sizeof(writes)));
+  TEST_ASSERT_EQUAL(1, writes);
+
+  sc_generic_queue_nuke(queue);
+}
+
+void test_queue_eventfd_stays_readable_for_items_left(void) {
+  sc_generic_queue_t *queue = sc_generic_queue_init(BATCH_CAPACITY);
+  TEST_ASSERT_NOT_NULL(queue);
+  TEST_ASSERT_TRUE(sc_generic_queue_attach_eventfd(queue) >= 0);
+
+  void *items[BATCH_SIZE];
+  fill_items(items, BATCH_SIZE, 0);
+  TEST_ASSERT_EQUAL(BATCH_SIZE, sc_generic_queue_add_n(queue, items, BATCH_SIZE));
+
+  // A consumer taking a bounded number per wakeup is woken for the rest
+  void *popped[BATCH_SIZE];
+  TEST_ASSERT_EQUAL(3, sc_generic_queue_pop_n(queue, popped, 3));
+  TEST_ASSERT_TRUE(wait_readable(queue, 0));
+  TEST_ASSERT_EQUAL(3, sc_generic_queue_pop_n(queue, popped, 3));
+  TEST_ASSERT_TRUE(wait_readable(queue, 0));
+
+  // The last one fits with room to spare
+  TEST_ASSERT_EQUAL(1, sc_generic_queue_pop_n(queue, popped, 3));
+  TEST_ASSERT_EQUAL_PTR((void *) BATCH_SIZE, popped[0]);
+  TEST_ASSERT_FALSE(wait_readable(queue, 0));
+
+  sc_generic_queue_nuke(queue);
+}
+
+void test_queue_eventfd_cleared_by_last_pop(void) {
+  sc_generic_queue_t *queue = sc_generic_queue_init(BATCH_CAPACITY);
+  TEST_ASSERT_NOT_NULL(queue);
+  TEST_ASSERT_TRUE(sc_generic_queue_attach_eventfd(queue) >= 0);
+
+  // Whichever pop takes the last item clears it, with no empty pop after
+  void *item = NULL;
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_SUCCESS, sc_generic_queue_try_add(queue, (void *) 1));
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_SUCCESS, sc_generic_queue_try_add(queue, (void *) 2));
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_SUCCESS, sc_generic_queue_try_pop(queue, &item));
+  TEST_ASSERT_TRUE(wait_readable(queue, 0));
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_SUCCESS, sc_generic_queue_try_pop(queue, &item));
+  TEST_ASSERT_EQUAL_PTR((void *) 2, item);
+  TEST_ASSERT_FALSE(wait_readable(queue, 0));
+
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_SUCCESS, sc_generic_queue_add(queue, (void *) 3));
+  TEST_ASSERT_TRUE(wait_readable(queue, 0));
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_SUCCESS, sc_generic_queue_pop(queue, &item));
+  TEST_ASSERT_EQUAL_PTR((void *) 3, item);
+  TEST_ASSERT_FALSE(wait_readable(queue, 0));
+
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_SUCCESS, sc_generic_queue_add(queue, (void *) 4));
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_SUCCESS,
+                    sc_generic_queue_pop_until(queue, &item, SC_QUEUE_WAIT_FOREVER));
+  TEST_ASSERT_FALSE(wait_readable(queue, 0));
+
+  // A batch pop that fills its array exactly
+  void *items[BATCH_SIZE];
+  fill_items(items, BATCH_SIZE, 0);
+  TEST_ASSERT_EQUAL(BATCH_SIZE, sc_generic_queue_add_n(queue, items, BATCH_SIZE));
+  TEST_ASSERT_EQUAL(BATCH_SIZE, sc_generic_queue_pop_n(queue, items, BATCH_SIZE));
+  TEST_ASSERT_FALSE(wait_readable(queue, 0));
+
+  sc_generic_queue_nuke(queue);
+}
+
+void test_queue_eventfd_threads_lose_no_wakeup(void) {
+  sc_generic_queue_t *queue = sc_generic_queue_init(BATCH_CAPACITY);
+  TEST_ASSERT_NOT_NULL(queue);
+  TEST_ASSERT_TRUE(sc_generic_queue_attach_eventfd(queue) >= 0);
+
+  pthread_t producers[BATCH_PRODUCERS];
+  for (size_t i = 0; i < BATCH_PRODUCERS; i++) {
+    TEST_ASSERT_EQUAL(0, pthread_create(&producers[i], NULL, batch_producer_thread, queue));
+  }
+
+  // The consumer only pops after the eventfd says so; a lost wakeup shows up
+  // as a poll timing out with items still to come
+  size_t expected = BATCH_PRODUCERS * BATCH_ROUNDS * BATCH_SIZE;
+  size_t taken    = 0;
+  while (taken < expected && wait_readable(queue, 1000)) {
+    void *popped[3];
+    taken += sc_generic_queue_pop_n(queue, popped, 3);
+  }
+  for (size_t i = 0; i < BATCH_PRODUCERS; i++) {
+    pthread_join(producers[i], NULL);
+  }
+
+  TEST_ASSERT_EQUAL(expected, taken);
+  TEST_ASSERT_FALSE(wait_readable(queue, 0));
+  sc_generic_queue_nuke(queue);
+}
+
 void setUp(void) {
 }
 
@@ -1520,5 +1948,24 @@ int main(void) {
   RUN_TEST(test_queue_init_with_safe_large_capacity);
   RUN_TEST(test_queue_init_memory_allocation_failure);
 
+  // Batch tests
+  RUN_TEST(test_queue_add_n_fills_to_capacity);
+  RUN_TEST(test_queue_pop_n_keeps_order);
+  RUN_TEST(test_queue_batch_null_parameters);
+  RUN_TEST(test_queue_drain_takes_everything);
+  RUN_TEST(test_queue_add_n_wakes_blocked_consumers);
+  RUN_TEST(test_queue_batch_threads_lose_nothing);
+
+  // Deadline tests
+  RUN_TEST(test_queue_pop_until_honors_deadline);
+  RUN_TEST(test_queue_add_until_waits_for_room);
+
+  // Eventfd tests
+  RUN_TEST(test_queue_eventfd_readable_while_items_wait);
+  RUN_TEST(test_queue_eventfd_written_once_per_transition);
+  RUN_TEST(test_queue_eventfd_stays_readable_for_items_left);
+  RUN_TEST(test_queue_eventfd_cleared_by_last_pop);
+  RUN_TEST(test_queue_eventfd_threads_lose_no_wakeup);
+
   return (UnityEnd());
 }
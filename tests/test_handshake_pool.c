@@ -0,0 +1,225 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#include "unity.h"
+
+#include "../src/handshake_pool.h"
+
+// Unity framework functions
+void setUp(void);
+void tearDown(void);
+
+// Test function prototypes
+void test_handshake_pool_init_rejects_no_threads(void);
+void test_handshake_pool_submit_rejects_bad_arguments(void);
+void test_handshake_pool_runs_jobs_off_thread(void);
+void test_handshake_port_collect_is_bounded(void);
+void test_handshake_port_tracks_depth_and_latency(void);
+void test_handshake_pool_nuke_returns_queued_jobs(void);
+
+#define TEST_JOBS 8
+
+// A job that records where and whether it ran
+typedef struct {
+  sc_handshake_job_t job;
+  pthread_t ran_on;
+  int sleep_ms;
+  atomic_bool ran;
+} test_job_t;
+
+static test_job_t g_jobs[TEST_JOBS];
+
+void setUp(void) {
+  memset(g_jobs, 0, sizeof(g_jobs));
+}
+
+void tearDown(void) {
+}
+
+static void run_test_job(sc_handshake_job_t *job) {
+  test_job_t *test_job = (test_job_t *) job;
+  if (test_job->sleep_ms > 0) {
+    usleep((useconds_t) test_job->sleep_ms * 1000);
+  }
+  test_job->ran_on = pthread_self();
+  atomic_store(&test_job->ran, true);
+}
+
+// Helper to submit the first count test jobs
+static void submit_jobs(sc_handshake_pool_t *pool, sc_handshake_port_t *port, size_t count,
+                        int sleep_ms) {
+  for (size_t i = 0; i < count; i++) {
+    g_jobs[i].job.fn   = run_test_job;
+    g_jobs[i].sleep_ms = sleep_ms;
+    TEST_ASSERT_EQUAL(0, sc_handshake_pool_submit(pool, port, &g_jobs[i].job));
+  }
+}
+
+// Helper to wait until the port's eventfd is readable
+static bool wait_readable(const sc_handshake_port_t *port, int timeout_ms) {
+  struct pollfd pfd = {.fd = port->event_fd, .events = POLLIN};
+  return poll(&pfd, 1, timeout_ms) == 1;
+}
+
+// Helper to collect until count jobs came back, max at a time
+static size_t collect_all(sc_handshake_port_t *port, size_t count, size_t max) {
+  sc_handshake_job_t *jobs[TEST_JOBS];
+  size_t collected = 0;
+  while (collected < count && wait_readable(port, 1000)) {
+    collected += sc_handshake_port_collect(port, jobs, max);
+  }
+  return collected;
+}
+
+void test_handshake_pool_init_rejects_no_threads(void) {
+  TEST_ASSERT_NULL(sc_handshake_pool_init(0));
+}
+
+void test_handshake_pool_submit_rejects_bad_arguments(void) {
+  sc_handshake_pool_t *pool = sc_handshake_pool_init(1);
+  sc_handshake_port_t *port = sc_handshake_port_init();
+  TEST_ASSERT_NOT_NULL(pool);
+  TEST_ASSERT_NOT_NULL(port);
+
+  // A job without a work function is refused
+  errno = 0;
+  TEST_ASSERT_EQUAL(-1, sc_handshake_pool_submit(pool, port, &g_jobs[0].job));
+  TEST_ASSERT_EQUAL(EINVAL, errno);
+  g_jobs[0].job.fn = run_test_job;
+  TEST_ASSERT_EQUAL(-1, sc_handshake_pool_submit(NULL, port, &g_jobs[0].job));
+  TEST_ASSERT_EQUAL(-1, sc_handshake_pool_submit(pool, NULL, &g_jobs[0].job));
+  TEST_ASSERT_EQUAL(-1, sc_handshake_pool_submit(pool, port, NULL));
+  TEST_ASSERT_EQUAL(0, port->stats.submitted);
+
+  sc_handshake_pool_nuke(pool);
+  sc_handshake_port_nuke(port);
+}
+
+void test_handshake_pool_runs_jobs_off_thread(void) {
+  sc_handshake_pool_t *pool = sc_handshake_pool_init(2);
+  sc_handshake_port_t *port = sc_handshake_port_init();
+  TEST_ASSERT_NOT_NULL(pool);
+  TEST_ASSERT_NOT_NULL(port);
+  TEST_ASSERT_EQUAL(2, pool->thread_count);
+
+  // Nothing finished yet, so the eventfd is quiet
+  TEST_ASSERT_FALSE(wait_readable(port, 0));
+
+  submit_jobs(pool, port, TEST_JOBS, 0);
+  TEST_ASSERT_EQUAL(TEST_JOBS, collect_all(port, TEST_JOBS, TEST_JOBS));
+
+  for (size_t i = 0; i < TEST_JOBS; i++) {
+    TEST_ASSERT_TRUE(atomic_load(&g_jobs[i].ran));
+    TEST_ASSERT_FALSE(pthread_equal(g_jobs[i].ran_on, pthread_self()));
+    TEST_ASSERT_EQUAL_PTR(port, g_jobs[i].job.port);
+  }
+
+  // Everything was collected, so the eventfd is quiet again
+  TEST_ASSERT_FALSE(wait_readable(port, 0));
+
+  sc_handshake_pool_nuke(pool);
+  sc_handshake_port_nuke(port);
+}
+
+void test_handshake_port_collect_is_bounded(void) {
+  sc_handshake_pool_t *pool = sc_handshake_pool_init(1);
+  sc_handshake_port_t *port = sc_handshake_port_init();
+  TEST_ASSERT_NOT_NULL(pool);
+  TEST_ASSERT_NOT_NULL(port);
+
+  // Wait until all five are back on the port
+  submit_jobs(pool, port, 5, 0);
+  bool all_back = false;
+  while (!all_back) {
+    pthread_mutex_lock(&port->lock);
+    all_back = port->tail == &g_jobs[4].job;
+    pthread_mutex_unlock(&port->lock);
+    usleep(1000);
+  }
+  TEST_ASSERT_TRUE(wait_readable(port, 0));
+
+  // A bounded collect leaves the rest and keeps the eventfd readable, in order
+  sc_handshake_job_t *jobs[TEST_JOBS];
+  TEST_ASSERT_EQUAL(2, sc_handshake_port_collect(port, jobs, 2));
+  TEST_ASSERT_EQUAL_PTR(&g_jobs[0].job, jobs[0]);
+  TEST_ASSERT_EQUAL_PTR(&g_jobs[1].job, jobs[1]);
+  TEST_ASSERT_TRUE(wait_readable(port, 0));
+
+  TEST_ASSERT_EQUAL(2, sc_handshake_port_collect(port, jobs, 2));
+  TEST_ASSERT_EQUAL_PTR(&g_jobs[2].job, jobs[0]);
+  TEST_ASSERT_EQUAL(1, sc_handshake_port_collect(port, jobs, 2));
+  TEST_ASSERT_EQUAL_PTR(&g_jobs[4].job, jobs[0]);
+  TEST_ASSERT_FALSE(wait_readable(port, 0));
+  TEST_ASSERT_EQUAL(0, sc_handshake_port_collect(port, jobs, 2));
+
+  sc_handshake_pool_nuke(pool);
+  sc_handshake_port_nuke(port);
+}
+
+void test_handshake_port_tracks_depth_and_latency(void) {
+  sc_handshake_pool_t *pool = sc_handshake_pool_init(1);
+  sc_handshake_port_t *port = sc_handshake_port_init();
+  TEST_ASSERT_NOT_NULL(pool);
+  TEST_ASSERT_NOT_NULL(port);
+  TEST_ASSERT_TRUE(sc_handshake_port_avg_latency_us(port) == 0.0);
+
+  // One thread working through 10 ms jobs keeps the others waiting
+  submit_jobs(pool, port, 4, 10);
+  TEST_ASSERT_EQUAL(4, port->stats.in_flight);
+  TEST_ASSERT_EQUAL(4, port->stats.peak_in_flight);
+  TEST_ASSERT_TRUE(sc_handshake_pool_depth(pool) >= 3);
+
+  TEST_ASSERT_EQUAL(4, collect_all(port, 4, TEST_JOBS));
+  TEST_ASSERT_EQUAL(4, port->stats.submitted);
+  TEST_ASSERT_EQUAL(4, port->stats.completed);
+  TEST_ASSERT_EQUAL(0, port->stats.in_flight);
+  TEST_ASSERT_EQUAL(0, sc_handshake_pool_depth(pool));
+  TEST_ASSERT_TRUE(sc_handshake_pool_peak_depth(pool) >= 3);
+
+  // The last job waited behind three others
+  TEST_ASSERT_TRUE(port->stats.work_ns >= 4 * 10000000u);
+  TEST_ASSERT_TRUE(port->stats.max_latency_ns >= 4 * 10000000u);
+  TEST_ASSERT_TRUE(sc_handshake_port_avg_latency_us(port) >= 10000.0);
+
+  sc_handshake_pool_nuke(pool);
+  sc_handshake_port_nuke(port);
+}
+
+void test_handshake_pool_nuke_returns_queued_jobs(void) {
+  sc_handshake_pool_t *pool = sc_handshake_pool_init(1);
+  sc_handshake_port_t *port = sc_handshake_port_init();
+  TEST_ASSERT_NOT_NULL(pool);
+  TEST_ASSERT_NOT_NULL(port);
+
+  // The single thread is busy with the first job when the pool stops, so the
+  // rest come back without being run
+  submit_jobs(pool, port, 3, 50);
+  usleep(10000);
+  sc_handshake_pool_nuke(pool);
+
+  TEST_ASSERT_EQUAL(3, collect_all(port, 3, TEST_JOBS));
+  TEST_ASSERT_FALSE(atomic_load(&g_jobs[1].ran));
+  TEST_ASSERT_FALSE(atomic_load(&g_jobs[2].ran));
+  TEST_ASSERT_EQUAL(0, g_jobs[2].job.started_ns);
+  TEST_ASSERT_EQUAL(0, port->stats.in_flight);
+
+  sc_handshake_port_nuke(port);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_handshake_pool_init_rejects_no_threads);
+  RUN_TEST(test_handshake_pool_submit_rejects_bad_arguments);
+  RUN_TEST(test_handshake_pool_runs_jobs_off_thread);
+  RUN_TEST(test_handshake_port_collect_is_bounded);
+  RUN_TEST(test_handshake_port_tracks_depth_and_latency);
+  RUN_TEST(test_handshake_pool_nuke_returns_queued_jobs);
+
+  return UNITY_END();
+}
@@ -0,0 +1,243 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <arpa/inet.h>
+
+#include "unity.h"
+
+#include "../src/ingress.h"
+
+// Unity framework functions
+void setUp(void);
+void tearDown(void);
+
+// Test function prototypes
+void test_ingress_init_rejects_zero_dimensions(void);
+void test_ingress_recv_empty_socket(void);
+void test_ingress_recv_single_batch(void);
+void test_ingress_recv_multiple_batches(void);
+void test_ingress_recv_drops_truncated(void);
+void test_ingress_avg_batch_size(void);
+void test_ingress_gro_splits_coalesced(void);
+
+#define TEST_SLOT_SIZE 64
+
+static int g_recv_fd = -1;
+static int g_send_fd = -1;
+static struct sockaddr_in g_recv_addr;
+
+void setUp(void) {
+  g_recv_fd = socket(AF_INET, SOCK_DGRAM, 0);
+  TEST_ASSERT_NOT_EQUAL(-1, g_recv_fd);
+  g_send_fd = socket(AF_INET, SOCK_DGRAM, 0);
+  TEST_ASSERT_NOT_EQUAL(-1, g_send_fd);
+
+  // Bind the receiver to an ephemeral loopback port
+  memset(&g_recv_addr, 0, sizeof(g_recv_addr));
+  g_recv_addr.sin_family      = AF_INET;
+  g_recv_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  g_recv_addr.sin_port        = 0;
+  TEST_ASSERT_EQUAL(0, bind(g_recv_fd, (struct sockaddr *) &g_recv_addr, sizeof(g_recv_addr)));
+
+  socklen_t len = sizeof(g_recv_addr);
+  TEST_ASSERT_EQUAL(0, getsockname(g_recv_fd, (struct sockaddr *) &g_recv_addr, &len));
+
+  int flags = fcntl(g_recv_fd, F_GETFL, 0);
+  TEST_ASSERT_NOT_EQUAL(-1, fcntl(g_recv_fd, F_SETFL, flags | O_NONBLOCK));
+}
+
+void tearDown(void) {
+  if (g_recv_fd >= 0) {
+    close(g_recv_fd);
+    g_recv_fd = -1;
+  }
+  if (g_send_fd >= 0) {
+    close(g_send_fd);
+    g_send_fd = -1;
+  }
+}
+
+// Helper to send a numbered datagram to the receiving socket
+static void send_datagram(int id, size_t len) {
+  uint8_t payload[TEST_SLOT_SIZE * 2];
+  memset(payload, id, sizeof(payload));
+  ssize_t sent =
+    sendto(g_send_fd, payload, len, 0, (struct sockaddr *) &g_recv_addr, sizeof(g_recv_addr));
+  TEST_ASSERT_EQUAL((ssize_t) len, sent);
+}
+
+void test_ingress_init_rejects_zero_dimensions(void) {
+  TEST_ASSERT_NULL(sc_ingress_init(0, TEST_SLOT_SIZE));
+  TEST_ASSERT_NULL(sc_ingress_init(8, 0));
+}
+
+void test_ingress_recv_empty_socket(void) {
+  sc_ingress_t *ingress = sc_ingress_init(8, TEST_SLOT_SIZE);
+  TEST_ASSERT_NOT_NULL(ingress);
+
+  TEST_ASSERT_EQUAL(0, sc_ingress_recv(ingress, g_recv_fd));
+  TEST_ASSERT_TRUE(ingress->drained);
+  TEST_ASSERT_EQUAL(0, ingress->batches);
+
+  sc_ingress_nuke(ingress);
+}
+
+void test_ingress_recv_single_batch(void) {
+  sc_ingress_t *ingress = sc_ingress_init(8, TEST_SLOT_SIZE);
+  TEST_ASSERT_NOT_NULL(ingress);
+
+  for (int i = 1; i <= 3; i++) {
+    send_datagram(i, (size_t) (i * 10));
+  }
+
+  TEST_ASSERT_EQUAL(3, sc_ingress_recv(ingress, g_recv_fd));
+  TEST_ASSERT_TRUE(ingress->drained);
+
+  // Datagrams arrive in order with their own lengths and source address
+  for (int i = 0; i < 3; i++) {
+    const sc_ingress_packet_t *packet = &ingress->packets[i];
+    TEST_ASSERT_EQUAL((size_t) ((i + 1) * 10), packet->len);
+    TEST_ASSERT_EQUAL(i + 1, packet->data[0]);
+    TEST_ASSERT_EQUAL(i + 1, packet->data[packet->len - 1]);
+    TEST_ASSERT_EQUAL(AF_INET, packet->addr.sin_family);
+    TEST_ASSERT_EQUAL(htonl(INADDR_LOOPBACK), packet->addr.sin_addr.s_addr);
+  }
+
+  sc_ingress_nuke(ingress);
+}
+
+void test_ingress_recv_multiple_batches(void) {
+  sc_ingress_t *ingress = sc_ingress_init(4, TEST_SLOT_SIZE);
+  TEST_ASSERT_NOT_NULL(ingress);
+
+  for (int i = 1; i <= 6; i++) {
+    send_datagram(i, 16);
+  }
+
+  // A full batch signals that more datagrams may be waiting
+  TEST_ASSERT_EQUAL(4, sc_ingress_recv(ingress, g_recv_fd));
+  TEST_ASSERT_FALSE(ingress->drained);
+  TEST_ASSERT_EQUAL(4, ingress->packets[3].data[0]);
+
+  TEST_ASSERT_EQUAL(2, sc_ingress_recv(ingress, g_recv_fd));
+  TEST_ASSERT_TRUE(ingress->drained);
+  TEST_ASSERT_EQUAL(5, ingress->packets[0].data[0]);
+  TEST_ASSERT_EQUAL(6, ingress->packets[1].data[0]);
+
+  sc_ingress_nuke(ingress);
+}
+
+void test_ingress_recv_drops_truncated(void) {
+  sc_ingress_t *ingress = sc_ingress_init(8, TEST_SLOT_SIZE);
+  TEST_ASSERT_NOT_NULL(ingress);
+
+  send_datagram(1, 16);
+  send_datagram(2, TEST_SLOT_SIZE + 1);
+  send_datagram(3, 16);
+
+  TEST_ASSERT_EQUAL(2, sc_ingress_recv(ingress, g_recv_fd));
+  TEST_ASSERT_EQUAL(1, ingress->truncated);
+  TEST_ASSERT_EQUAL(1, ingress->packets[0].data[0]);
+  TEST_ASSERT_EQUAL(3, ingress->packets[1].data[0]);
+
+  sc_ingress_nuke(ingress);
+}
+
+void test_ingress_avg_batch_size(void) {
+  sc_ingress_t *ingress = sc_ingress_init(4, TEST_SLOT_SIZE);
+  TEST_ASSERT_NOT_NULL(ingress);
+
+  TEST_ASSERT_TRUE(sc_ingress_avg_batch_size(ingress) == 0.0);
+
+  for (int i = 1; i <= 6; i++) {
+    send_datagram(i, 16);
+  }
+  TEST_ASSERT_EQUAL(4, sc_ingress_recv(ingress, g_recv_fd));
+  TEST_ASSERT_EQUAL(2, sc_ingress_recv(ingress, g_recv_fd));
+
+  // Empty reads do not count as batches
+  TEST_ASSERT_EQUAL(0, sc_ingress_recv(ingress, g_recv_fd));
+
+  TEST_ASSERT_EQUAL(2, ingress->batches);
+  TEST_ASSERT_EQUAL(6, ingress->datagrams);
+  TEST_ASSERT_TRUE(sc_ingress_avg_batch_size(ingress) == 3.0);
+
+  sc_ingress_nuke(ingress);
+}
+
+void test_ingress_gro_splits_coalesced(void) {
+  sc_ingress_t *ingress = sc_ingress_init(4, 4096);
+  TEST_ASSERT_NOT_NULL(ingress);
+  if (sc_ingress_enable_gro(ingress, g_recv_fd) < 0) {
+    sc_ingress_nuke(ingress);
+    TEST_IGNORE_MESSAGE("Kernel lacks UDP GRO");
+  }
+  TEST_ASSERT_TRUE(ingress->gro);
+
+  // Send three datagrams as one UDP_SEGMENT message; loopback hands the run
+  // to a GRO socket without splitting it
+  uint8_t payload[240];
+  memset(payload, 1, 100);
+  memset(payload + 100, 2, 100);
+  memset(payload + 200, 3, 40);
+
+  union {
+    char buf[CMSG_SPACE(sizeof(uint16_t))];
+    struct cmsghdr align;
+  } control;
+  memset(&control, 0, sizeof(control));
+
+  struct iovec iov   = {.iov_base = payload, .iov_len = sizeof(payload)};
+  struct msghdr msg  = {0};
+  msg.msg_name       = &g_recv_addr;
+  msg.msg_namelen    = sizeof(g_recv_addr);
+  msg.msg_iov        = &iov;
+  msg.msg_iovlen     = 1;
+  msg.msg_control    = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+
+  uint16_t segment     = 100;
+  struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level     = IPPROTO_UDP;
+  cmsg->cmsg_type      = UDP_SEGMENT;
+  cmsg->cmsg_len       = CMSG_LEN(sizeof(segment));
+  memcpy(CMSG_DATA(cmsg), &segment, sizeof(segment));
+  TEST_ASSERT_EQUAL((ssize_t) sizeof(payload), sendmsg(g_send_fd, &msg, 0));
+
+  // A plain datagram after the run stays a single packet
+  send_datagram(4, 16);
+
+  TEST_ASSERT_EQUAL(4, sc_ingress_recv(ingress, g_recv_fd));
+  TEST_ASSERT_EQUAL(100, ingress->packets[0].len);
+  TEST_ASSERT_EQUAL(100, ingress->packets[1].len);
+  TEST_ASSERT_EQUAL(40, ingress->packets[2].len);
+  TEST_ASSERT_EQUAL(16, ingress->packets[3].len);
+  for (int i = 0; i < 4; i++) {
+    const sc_ingress_packet_t *packet = &ingress->packets[i];
+    TEST_ASSERT_EQUAL(i + 1, packet->data[0]);
+    TEST_ASSERT_EQUAL(i + 1, packet->data[packet->len - 1]);
+    TEST_ASSERT_EQUAL(htonl(INADDR_LOOPBACK), packet->addr.sin_addr.s_addr);
+  }
+  TEST_ASSERT_EQUAL(3, ingress->coalesced);
+  TEST_ASSERT_EQUAL(4, ingress->datagrams);
+
+  sc_ingress_nuke(ingress);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_ingress_init_rejects_zero_dimensions);
+  RUN_TEST(test_ingress_recv_empty_socket);
+  RUN_TEST(test_ingress_recv_single_batch);
+  RUN_TEST(test_ingress_recv_multiple_batches);
+  RUN_TEST(test_ingress_recv_drops_truncated);
+  RUN_TEST(test_ingress_avg_batch_size);
+  RUN_TEST(test_ingress_gro_splits_coalesced);
+
+  return UNITY_END();
+}
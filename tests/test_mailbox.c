@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <string.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "unity.h"
+
+#include "../src/mailbox.h"
+
+// Unity framework functions
+void setUp(void);
+void tearDown(void);
+
+// Test function prototypes
+void test_mailbox_init_rejects_zero_capacity(void);
+void test_mailbox_post_rejects_null(void);
+void test_mailbox_drain_in_order_and_clears_eventfd(void);
+void test_mailbox_bounded_drain_stays_readable(void);
+void test_mailbox_full_refuses_posts(void);
+void test_mailbox_many_producers_lose_no_wakeup(void);
+
+#define TEST_MESSAGES        8
+#define TEST_PRODUCERS       4
+#define TEST_PER_PRODUCER    5000
+#define TEST_STRESS_CAPACITY 64
+
+static message_t g_messages[TEST_MESSAGES];
+
+void setUp(void) {
+  memset(g_messages, 0, sizeof(g_messages));
+}
+
+void tearDown(void) {
+}
+
+// Helper to wait until the mailbox's eventfd is readable
+static bool wait_readable(const sc_mailbox_t *mailbox, int timeout_ms) {
+  struct pollfd pfd = {.fd = mailbox->event_fd, .events = POLLIN};
+  return poll(&pfd, 1, timeout_ms) == 1;
+}
+
+void test_mailbox_init_rejects_zero_capacity(void) {
+  TEST_ASSERT_NULL(sc_mailbox_init(0));
+}
+
+void test_mailbox_post_rejects_null(void) {
+  sc_mailbox_t *mailbox = sc_mailbox_init(4);
+  TEST_ASSERT_NOT_NULL(mailbox);
+
+  TEST_ASSERT_EQUAL(-1, sc_mailbox_post(NULL, &g_messages[0]));
+  TEST_ASSERT_EQUAL(-1, sc_mailbox_post(mailbox, NULL));
+  TEST_ASSERT_EQUAL(0, sc_mailbox_drain(mailbox, NULL, 4));
+  TEST_ASSERT_FALSE(wait_readable(mailbox, 0));
+
+  sc_mailbox_nuke(mailbox);
+}
+
+void test_mailbox_drain_in_order_and_clears_eventfd(void) {
+  sc_mailbox_t *mailbox = sc_mailbox_init(TEST_MESSAGES);
+  TEST_ASSERT_NOT_NULL(mailbox);
+  TEST_ASSERT_FALSE(wait_readable(mailbox, 0));
+
+  for (size_t i = 0; i < 3; i++) {
+    TEST_ASSERT_EQUAL(0, sc_mailbox_post(mailbox, &g_messages[i]));
+  }
+  TEST_ASSERT_TRUE(wait_readable(mailbox, 0));
+
+  message_t *msgs[TEST_MESSAGES];
+  TEST_ASSERT_EQUAL(3, sc_mailbox_drain(mailbox, msgs, TEST_MESSAGES));
+  for (size_t i = 0; i < 3; i++) {
+    TEST_ASSERT_EQUAL_PTR(&g_messages[i], msgs[i]);
+  }
+  TEST_ASSERT_FALSE(wait_readable(mailbox, 0));
+  TEST_ASSERT_EQUAL(3, atomic_load(&mailbox->posted));
+  TEST_ASSERT_EQUAL(3, mailbox->drained);
+
+  // The next post signals again
+  TEST_ASSERT_EQUAL(0, sc_mailbox_post(mailbox, &g_messages[3]));
+  TEST_ASSERT_TRUE(wait_readable(mailbox, 0));
+  TEST_ASSERT_EQUAL(1, sc_mailbox_drain(mailbox, msgs, TEST_MESSAGES));
+  TEST_ASSERT_EQUAL(0, sc_mailbox_drain(mailbox, msgs, TEST_MESSAGES));
+
+  sc_mailbox_nuke(mailbox);
+}
+
+void test_mailbox_bounded_drain_stays_readable(void) {
+  sc_mailbox_t *mailbox = sc_mailbox_init(TEST_MESSAGES);
+  TEST_ASSERT_NOT_NULL(mailbox);
+
+  for (size_t i = 0; i < 5; i++) {
+    TEST_ASSERT_EQUAL(0, sc_mailbox_post(mailbox, &g_messages[i]));
+  }
+
+  message_t *msgs[TEST_MESSAGES];
+  TEST_ASSERT_EQUAL(2, sc_mailbox_drain(mailbox, msgs, 2));
+  TEST_ASSERT_EQUAL_PTR(&g_messages[1], msgs[1]);
+  TEST_ASSERT_TRUE(wait_readable(mailbox, 0));
+  TEST_ASSERT_EQUAL(2, sc_mailbox_drain(mailbox, msgs, 2));
+  TEST_ASSERT_EQUAL_PTR(&g_messages[2], msgs[0]);
+  TEST_ASSERT_TRUE(wait_readable(mailbox, 0));
+
+  // The last one fits with room to spare, so the eventfd stays quiet
+  TEST_ASSERT_EQUAL(1, sc_mailbox_drain(mailbox, msgs, 2));
+  TEST_ASSERT_EQUAL_PTR(&g_messages[4], msgs[0]);
+  TEST_ASSERT_FALSE(wait_readable(mailbox, 0));
+
+  sc_mailbox_nuke(mailbox);
+}
+
+void test_mailbox_full_refuses_posts(void) {
+  sc_mailbox_t *mailbox = sc_mailbox_init(2);
+  TEST_ASSERT_NOT_NULL(mailbox);
+
+  TEST_ASSERT_EQUAL(0, sc_mailbox_post(mailbox, &g_messages[0]));
+  TEST_ASSERT_EQUAL(0, sc_mailbox_post(mailbox, &g_messages[1]));
+  TEST_ASSERT_EQUAL(-1, sc_mailbox_post(mailbox, &g_messages[2]));
+  TEST_ASSERT_EQUAL(2, atomic_load(&mailbox->posted));
+  TEST_ASSERT_EQUAL(1, atomic_load(&mailbox->refused));
+
+  // Draining makes room again
+  message_t *msgs[TEST_MESSAGES];
+  TEST_ASSERT_EQUAL(2, sc_mailbox_drain(mailbox, msgs, TEST_MESSAGES));
+  TEST_ASSERT_EQUAL(0, sc_mailbox_post(mailbox, &g_messages[2]));
+
+  sc_mailbox_nuke(mailbox);
+}
+
+// Producer thread: post TEST_PER_PRODUCER messages, retrying while full
+static void *produce(void *arg) {
+  sc_mailbox_t *mailbox = arg;
+  for (size_t i = 0; i < TEST_PER_PRODUCER; i++) {
+    while (sc_mailbox_post(mailbox, &g_messages[i % TEST_MESSAGES]) < 0) {
+      sched_yield();
+    }
+  }
+  return NULL;
+}
+
+void test_mailbox_many_producers_lose_no_wakeup(void) {
+  sc_mailbox_t *mailbox = sc_mailbox_init(TEST_STRESS_CAPACITY);
+  TEST_ASSERT_NOT_NULL(mailbox);
+
+  pthread_t producers[TEST_PRODUCERS];
+  for (size_t i = 0; i < TEST_PRODUCERS; i++) {
+    TEST_ASSERT_EQUAL(0, pthread_create(&producers[i], NULL, produce, mailbox));
+  }
+
+  // The consumer only drains after the eventfd says so; a lost wakeup shows
+  // up as a poll timing out with messages still to come
+  message_t *msgs[TEST_STRESS_CAPACITY];
+  size_t received = 0;
+  while (received < TEST_PRODUCERS * TEST_PER_PRODUCER && wait_readable(mailbox, 1000)) {
+    received += sc_mailbox_drain(mailbox, msgs, 16);
+  }
+
+  for (size_t i = 0; i < TEST_PRODUCERS; i++) {
+    pthread_join(producers[i], NULL);
+  }
+  TEST_ASSERT_EQUAL(TEST_PRODUCERS * TEST_PER_PRODUCER, received);
+  TEST_ASSERT_EQUAL(received, mailbox->drained);
+
+  sc_mailbox_nuke(mailbox);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_mailbox_init_rejects_zero_capacity);
+  RUN_TEST(test_mailbox_post_rejects_null);
+  RUN_TEST(test_mailbox_drain_in_order_and_clears_eventfd);
+  RUN_TEST(test_mailbox_bounded_drain_stays_readable);
+  RUN_TEST(test_mailbox_full_refuses_posts);
+  RUN_TEST(test_mailbox_many_producers_lose_no_wakeup);
+
+  return UNITY_END();
+}
@@ -0,0 +1,272 @@
+#include <pthread.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "unity.h"
+
+#include "../src/mpsc_queue.h"
+
+// Unity framework functions
+void setUp(void);
+void tearDown(void);
+
+// Test function prototypes
+void test_mpsc_queue_init_rejects_bad_capacity(void);
+void test_mpsc_queue_rejects_null(void);
+void test_mpsc_queue_fifo_within_capacity(void);
+void test_mpsc_queue_wraps_around(void);
+void test_mpsc_queue_batches(void);
+void test_mpsc_queue_nuke_with_cleanup(void);
+void test_mpsc_queue_pop_wakes_on_add(void);
+void test_mpsc_queue_threads_keep_order(void);
+void test_mpsc_queue_producers_keep_their_order(void);
+
+#define TEST_CAPACITY     5 // Not a power of two: the ring is bigger than the queue
+#define TEST_ITEMS        200000
+#define TEST_PRODUCERS    4
+#define TEST_PER_PRODUCER 50000
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// Encodes a sequence number as a non-NULL item
+static void *item_of(uintptr_t n) {
+  return (void *) (n + 1);
+}
+
+void test_mpsc_queue_init_rejects_bad_capacity(void) {
+  TEST_ASSERT_NULL(sc_mpsc_queue_init(0));
+  TEST_ASSERT_NULL(sc_mpsc_queue_init(SC_GENERIC_QUEUE_MAX_CAPACITY + 1));
+}
+
+void test_mpsc_queue_rejects_null(void) {
+  sc_mpsc_queue_t *q = sc_mpsc_queue_init(TEST_CAPACITY);
+  TEST_ASSERT_NOT_NULL(q);
+  void *item = item_of(0);
+
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_ERR_NULL, sc_mpsc_queue_try_add(NULL, item));
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_ERR_NULL, sc_mpsc_queue_try_add(q, NULL));
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_ERR_NULL, sc_mpsc_queue_add(q, NULL));
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_ERR_NULL, sc_mpsc_queue_try_pop(q, NULL));
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_ERR_NULL, sc_mpsc_queue_pop(NULL, &item));
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_ERR_NULL, sc_mpsc_queue_nuke(NULL));
+  TEST_ASSERT_FALSE(sc_mpsc_queue_is_empty(NULL));
+  TEST_ASSERT_FALSE(sc_mpsc_queue_is_full(NULL));
+  TEST_ASSERT_EQUAL(0, sc_mpsc_queue_get_size(NULL));
+
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_SUCCESS, sc_mpsc_queue_nuke(q));
+}
+
+void test_mpsc_queue_fifo_within_capacity(void) {
+  sc_mpsc_queue_t *q = sc_mpsc_queue_init(TEST_CAPACITY);
+  TEST_ASSERT_NOT_NULL(q);
+  TEST_ASSERT_TRUE(sc_mpsc_queue_is_empty(q));
+
+  void *item = item_of(0);
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_ERR_EMPTY, sc_mpsc_queue_try_pop(q, &item));
+  TEST_ASSERT_NULL(item);
+
+  for (uintptr_t i = 0; i < TEST_CAPACITY; i++) {
+    TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_SUCCESS, sc_mpsc_queue_try_add(q, item_of(i)));
+  }
+  TEST_ASSERT_TRUE(sc_mpsc_queue_is_full(q));
+  TEST_ASSERT_EQUAL(TEST_CAPACITY, sc_mpsc_queue_get_size(q));
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_ERR_FULL, sc_mpsc_queue_try_add(q, item_of(99)));
+
+  for (uintptr_t i = 0; i < TEST_CAPACITY; i++) {
+    TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_SUCCESS, sc_mpsc_queue_try_pop(q, &item));
+    TEST_ASSERT_EQUAL_PTR(item_of(i), item);
+  }
+  TEST_ASSERT_TRUE(sc_mpsc_queue_is_empty(q));
+
+  sc_mpsc_queue_nuke(q);
+}
+
+void test_mpsc_queue_wraps_around(void) {
+  sc_mpsc_queue_t *q = sc_mpsc_queue_init(TEST_CAPACITY);
+  TEST_ASSERT_NOT_NULL(q);
+
+  // Keep the queue partly full while positions run many laps past the ring
+  uintptr_t added = 0;
+  uintptr_t taken = 0;
+  for (size_t lap = 0; lap < 100; lap++) {
+    while (sc_mpsc_queue_try_add(q, item_of(added)) == SC_GENERIC_QUEUE_SUCCESS) {
+      added++;
+    }
+    TEST_ASSERT_EQUAL(TEST_CAPACITY, added - taken);
+    for (size_t i = 0; i < lap % TEST_CAPACITY + 1; i++) {
+      void *item;
+      TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_SUCCESS, sc_mpsc_queue_try_pop(q, &item));
+      TEST_ASSERT_EQUAL_PTR(item_of(taken), item);
+      taken++;
+    }
+  }
+
+  sc_mpsc_queue_nuke(q);
+}
+
+// Counts the items handed to it
+static void count_item(void *item, void *user_data) {
+  (void) item;
+  (*(size_t *) user_data)++;
+}
+
+void test_mpsc_queue_batches(void) {
+  sc_mpsc_queue_t *q = sc_mpsc_queue_init(TEST_CAPACITY);
+  TEST_ASSERT_NOT_NULL(q);
+  void *items[TEST_CAPACITY + 2];
+  void *popped[TEST_CAPACITY + 2];
+
+  // Batches run laps past the ring; only what fits goes in, in order
+  uintptr_t added = 0;
+  uintptr_t taken = 0;
+  for (size_t lap = 0; lap < 50; lap++) {
+    for (size_t i = 0; i < TEST_CAPACITY + 2; i++) {
+      items[i] = item_of(added + i);
+    }
+    added += sc_mpsc_queue_add_n(q, items, TEST_CAPACITY + 2);
+    TEST_ASSERT_EQUAL(TEST_CAPACITY, added - taken);
+    TEST_ASSERT_EQUAL(0, sc_mpsc_queue_add_n(q, items, 1));
+
+    size_t got = sc_mpsc_queue_pop_n(q, popped, lap % TEST_CAPACITY + 1);
+    TEST_ASSERT_EQUAL(lap % TEST_CAPACITY + 1, got);
+    for (size_t i = 0; i < got; i++) {
+      TEST_ASSERT_EQUAL_PTR(item_of(taken + i), popped[i]);
+    }
+    taken += got;
+  }
+
+  size_t drained = 0;
+  TEST_ASSERT_EQUAL(added - taken, sc_mpsc_queue_drain(q, count_item, &drained));
+  TEST_ASSERT_EQUAL(added - taken, drained);
+  TEST_ASSERT_TRUE(sc_mpsc_queue_is_empty(q));
+  TEST_ASSERT_EQUAL(0, sc_mpsc_queue_pop_n(q, popped, 1));
+  TEST_ASSERT_EQUAL(0, sc_mpsc_queue_add_n(q, NULL, 1));
+
+  sc_mpsc_queue_nuke(q);
+}
+
+void test_mpsc_queue_nuke_with_cleanup(void) {
+  sc_mpsc_queue_t *q = sc_mpsc_queue_init(TEST_CAPACITY);
+  TEST_ASSERT_NOT_NULL(q);
+  for (uintptr_t i = 0; i < 3; i++) {
+    TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_SUCCESS, sc_mpsc_queue_add(q, item_of(i)));
+  }
+
+  size_t cleaned = 0;
+  sc_mpsc_queue_nuke_with_cleanup(q, count_item, &cleaned);
+  TEST_ASSERT_EQUAL(3, cleaned);
+}
+
+// Adds one item after a short delay
+static void *add_later(void *arg) {
+  usleep(50000);
+  sc_mpsc_queue_add(arg, item_of(7));
+  return NULL;
+}
+
+void test_mpsc_queue_pop_wakes_on_add(void) {
+  sc_mpsc_queue_t *q = sc_mpsc_queue_init(TEST_CAPACITY);
+  TEST_ASSERT_NOT_NULL(q);
+
+  pthread_t producer;
+  TEST_ASSERT_EQUAL(0, pthread_create(&producer, NULL, add_later, q));
+  void *item = NULL;
+  TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_SUCCESS, sc_mpsc_queue_pop(q, &item));
+  TEST_ASSERT_EQUAL_PTR(item_of(7), item);
+  pthread_join(producer, NULL);
+
+  sc_mpsc_queue_nuke(q);
+}
+
+// Adds TEST_ITEMS numbered items, blocking whenever the queue is full
+static void *produce(void *arg) {
+  for (uintptr_t i = 0; i < TEST_ITEMS; i++) {
+    if (sc_mpsc_queue_add(arg, item_of(i)) != SC_GENERIC_QUEUE_SUCCESS) {
+      return arg;
+    }
+  }
+  return NULL;
+}
+
+void test_mpsc_queue_threads_keep_order(void) {
+  sc_mpsc_queue_t *q = sc_mpsc_queue_init(TEST_CAPACITY);
+  TEST_ASSERT_NOT_NULL(q);
+
+  pthread_t producer;
+  TEST_ASSERT_EQUAL(0, pthread_create(&producer, NULL, produce, q));
+  for (uintptr_t i = 0; i < TEST_ITEMS; i++) {
+    void *item = NULL;
+    TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_SUCCESS, sc_mpsc_queue_pop(q, &item));
+    TEST_ASSERT_EQUAL_PTR(item_of(i), item);
+  }
+  void *result = q;
+  pthread_join(producer, &result);
+  TEST_ASSERT_NULL(result);
+  TEST_ASSERT_TRUE(sc_mpsc_queue_is_empty(q));
+
+  sc_mpsc_queue_nuke(q);
+}
+
+// Adds TEST_PER_PRODUCER items tagged with the producer's number
+static void *produce_tagged(void *arg) {
+  sc_mpsc_queue_t *q = ((void **) arg)[0];
+  uintptr_t producer = (uintptr_t) ((void **) arg)[1];
+  for (uintptr_t i = 0; i < TEST_PER_PRODUCER; i++) {
+    if (sc_mpsc_queue_add(q, item_of(i * TEST_PRODUCERS + producer)) != SC_GENERIC_QUEUE_SUCCESS) {
+      return arg;
+    }
+  }
+  return NULL;
+}
+
+void test_mpsc_queue_producers_keep_their_order(void) {
+  sc_mpsc_queue_t *q = sc_mpsc_queue_init(TEST_CAPACITY);
+  TEST_ASSERT_NOT_NULL(q);
+
+  pthread_t producers[TEST_PRODUCERS];
+  void *args[TEST_PRODUCERS][2];
+  for (uintptr_t i = 0; i < TEST_PRODUCERS; i++) {
+    args[i][0] = q;
+    args[i][1] = (void *) i;
+    TEST_ASSERT_EQUAL(0, pthread_create(&producers[i], NULL, produce_tagged, args[i]));
+  }
+
+  // Items of different producers interleave, but each producer's stay in order
+  uintptr_t next[TEST_PRODUCERS] = {0};
+  for (size_t n = 0; n < TEST_PRODUCERS * TEST_PER_PRODUCER; n++) {
+    void *item = NULL;
+    TEST_ASSERT_EQUAL(SC_GENERIC_QUEUE_SUCCESS, sc_mpsc_queue_pop(q, &item));
+    uintptr_t value    = (uintptr_t) item - 1;
+    uintptr_t producer = value % TEST_PRODUCERS;
+    TEST_ASSERT_EQUAL(next[producer], value / TEST_PRODUCERS);
+    next[producer]++;
+  }
+  for (size_t i = 0; i < TEST_PRODUCERS; i++) {
+    void *result = q;
+    pthread_join(producers[i], &result);
+    TEST_ASSERT_NULL(result);
+  }
+  TEST_ASSERT_TRUE(sc_mpsc_queue_is_empty(q));
+
+  sc_mpsc_queue_nuke(q);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_mpsc_queue_init_rejects_bad_capacity);
+  RUN_TEST(test_mpsc_queue_rejects_null);
+  RUN_TEST(test_mpsc_queue_fifo_within_capacity);
+  RUN_TEST(test_mpsc_queue_wraps_around);
+  RUN_TEST(test_mpsc_queue_batches);
+  RUN_TEST(test_mpsc_queue_nuke_with_cleanup);
+  RUN_TEST(test_mpsc_queue_pop_wakes_on_add);
+  RUN_TEST(test_mpsc_queue_threads_keep_order);
+  RUN_TEST(test_mpsc_queue_producers_keep_their_order);
+
+  return UNITY_END();
+}
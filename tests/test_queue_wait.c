@@ -0,0 +1,179 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "unity.h"
+
+#include "../src/queue_wait.h"
+
+// Unity framework functions
+void setUp(void);
+void tearDown(void);
+
+// Test function prototypes
+void test_queue_wait_deadline_is_monotonic_and_saturates(void);
+void test_queue_wait_succeeds_without_parking(void);
+void test_queue_wait_times_out_at_deadline(void);
+void test_queue_wait_tries_once_more_at_deadline(void);
+void test_queue_wake_skipped_without_waiters(void);
+void test_queue_wake_releases_parked_thread(void);
+void test_queue_wake_all_releases_every_thread(void);
+
+#define TEST_THREADS     4
+#define TEST_DEADLINE_MS 20
+#define TEST_SLACK_MS    200 // Scheduling delay tolerated past a deadline
+
+// A flag the attempt function waits for, with the wait it is signaled through
+typedef struct {
+  sc_queue_wait_t wait;
+  _Atomic int ready;
+  _Atomic int attempts;
+} flag_t;
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+static uint64_t now_ns(void) {
+  return sc_queue_deadline(0);
+}
+
+// Succeeds once the flag is set
+static bool flag_set(void *ctx) {
+  flag_t *flag = ctx;
+  atomic_fetch_add(&flag->attempts, 1);
+  return atomic_load(&flag->ready) != 0;
+}
+
+// Succeeds once for every time the flag was raised
+static bool take_flag(void *ctx) {
+  flag_t *flag = ctx;
+  int ready    = atomic_load(&flag->ready);
+  while (ready > 0) {
+    if (atomic_compare_exchange_weak(&flag->ready, &ready, ready - 1)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Blocks on the flag with no deadline
+static void *wait_forever(void *arg) {
+  flag_t *flag = arg;
+  return sc_queue_wait(&flag->wait, take_flag, flag, SC_QUEUE_WAIT_FOREVER) ? flag : NULL;
+}
+
+// Spins until a thread is parked in the wait
+static void await_waiters(flag_t *flag, uint32_t count) {
+  while (atomic_load(&flag->wait.waiters) < count) {
+    usleep(1000);
+  }
+}
+
+void test_queue_wait_deadline_is_monotonic_and_saturates(void) {
+  uint64_t first  = now_ns();
+  uint64_t second = sc_queue_deadline(SC_QUEUE_NS_PER_MS);
+  TEST_ASSERT_TRUE(second >= first + SC_QUEUE_NS_PER_MS);
+  TEST_ASSERT_EQUAL_UINT64(SC_QUEUE_WAIT_FOREVER, sc_queue_deadline(UINT64_MAX - 1));
+}
+
+void test_queue_wait_succeeds_without_parking(void) {
+  flag_t flag = {0};
+  sc_queue_wait_init(&flag.wait);
+  atomic_store(&flag.ready, 1);
+
+  TEST_ASSERT_TRUE(sc_queue_wait(&flag.wait, flag_set, &flag, now_ns()));
+  TEST_ASSERT_EQUAL(1, atomic_load(&flag.attempts));
+  TEST_ASSERT_EQUAL(0, atomic_load(&flag.wait.waiters));
+}
+
+void test_queue_wait_times_out_at_deadline(void) {
+  flag_t flag = {0};
+  sc_queue_wait_init(&flag.wait);
+
+  // Far shorter than the whole seconds waits used to be limited to
+  uint64_t start    = now_ns();
+  uint64_t deadline = start + TEST_DEADLINE_MS * SC_QUEUE_NS_PER_MS;
+  TEST_ASSERT_FALSE(sc_queue_wait(&flag.wait, flag_set, &flag, deadline));
+  uint64_t end = now_ns();
+
+  TEST_ASSERT_TRUE(end >= deadline);
+  TEST_ASSERT_TRUE(end - deadline < TEST_SLACK_MS * SC_QUEUE_NS_PER_MS);
+  TEST_ASSERT_EQUAL(0, atomic_load(&flag.wait.waiters));
+}
+
+void test_queue_wait_tries_once_more_at_deadline(void) {
+  flag_t flag = {0};
+  sc_queue_wait_init(&flag.wait);
+
+  // A deadline already past still retries after the futex times out
+  uint64_t past = now_ns() - 1;
+  TEST_ASSERT_FALSE(sc_queue_wait(&flag.wait, flag_set, &flag, past));
+  TEST_ASSERT_TRUE(atomic_load(&flag.attempts) >= 2);
+}
+
+void test_queue_wake_skipped_without_waiters(void) {
+  flag_t flag = {0};
+  sc_queue_wait_init(&flag.wait);
+
+  sc_queue_wake(&flag.wait);
+  sc_queue_wake_all(&flag.wait);
+  TEST_ASSERT_EQUAL(0, atomic_load(&flag.wait.epoch));
+}
+
+void test_queue_wake_releases_parked_thread(void) {
+  flag_t flag = {0};
+  sc_queue_wait_init(&flag.wait);
+
+  pthread_t thread;
+  TEST_ASSERT_EQUAL(0, pthread_create(&thread, NULL, wait_forever, &flag));
+  await_waiters(&flag, 1);
+
+  atomic_store(&flag.ready, 1);
+  sc_queue_wake(&flag.wait);
+
+  void *result = NULL;
+  TEST_ASSERT_EQUAL(0, pthread_join(thread, &result));
+  TEST_ASSERT_EQUAL_PTR(&flag, result);
+  TEST_ASSERT_TRUE(atomic_load(&flag.wait.epoch) > 0);
+  TEST_ASSERT_EQUAL(0, atomic_load(&flag.wait.waiters));
+}
+
+void test_queue_wake_all_releases_every_thread(void) {
+  flag_t flag = {0};
+  sc_queue_wait_init(&flag.wait);
+
+  pthread_t threads[TEST_THREADS];
+  for (size_t i = 0; i < TEST_THREADS; i++) {
+    TEST_ASSERT_EQUAL(0, pthread_create(&threads[i], NULL, wait_forever, &flag));
+  }
+  await_waiters(&flag, TEST_THREADS);
+
+  // One wake for the lot, as after a batch add
+  atomic_store(&flag.ready, TEST_THREADS);
+  sc_queue_wake_all(&flag.wait);
+
+  for (size_t i = 0; i < TEST_THREADS; i++) {
+    void *result = NULL;
+    TEST_ASSERT_EQUAL(0, pthread_join(threads[i], &result));
+    TEST_ASSERT_EQUAL_PTR(&flag, result);
+  }
+  TEST_ASSERT_EQUAL(0, atomic_load(&flag.ready));
+}
+
+int main(void) {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_queue_wait_deadline_is_monotonic_and_saturates);
+  RUN_TEST(test_queue_wait_succeeds_without_parking);
+  RUN_TEST(test_queue_wait_times_out_at_deadline);
+  RUN_TEST(test_queue_wait_tries_once_more_at_deadline);
+  RUN_TEST(test_queue_wake_skipped_without_waiters);
+  RUN_TEST(test_queue_wake_releases_parked_thread);
+  RUN_TEST(test_queue_wake_all_releases_every_thread);
+
+  return UNITY_END();
+}
@@ -0,0 +1,297 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <arpa/inet.h>
+
+#include "unity.h"
+
+#include "../src/session_table.h"
+
+// Unity framework functions
+void setUp(void);
+void tearDown(void);
+
+// Test function prototypes
+void test_session_table_init_nuke(void);
+void test_session_table_put_get(void);
+void test_session_table_put_replaces(void);
+void test_session_table_put_rejects_null(void);
+void test_session_table_remove(void);
+void test_session_table_remove_keeps_probe_runs(void);
+void test_session_table_incremental_resize(void);
+void test_session_table_remove_during_resize(void);
+void test_session_table_sweep(void);
+void test_session_table_key(void);
+void test_session_table_random_operations(void);
+
+#define TEST_ENTRIES     4096
+#define TEST_RANDOM_KEYS 512
+#define TEST_RANDOM_OPS  200000
+
+// Values are pointers into this array so every key maps to a distinct non-NULL value
+static int g_values[TEST_ENTRIES];
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// Keys that resemble client addresses: one subnet, varying host and port
+static uint64_t test_key(size_t i) {
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_addr.s_addr = htonl(0x0a000000u | (uint32_t) (i / 8));
+  addr.sin_port        = htons((uint16_t) (40000 + i % 8));
+  return sc_session_table_key(&addr);
+}
+
+void test_session_table_init_nuke(void) {
+  sc_session_table_t *table = sc_session_table_init(0);
+  TEST_ASSERT_NOT_NULL(table);
+  TEST_ASSERT_EQUAL(SC_SESSION_TABLE_MIN_CAPACITY, table->active.mask + 1);
+  TEST_ASSERT_EQUAL(0, sc_session_table_count(table));
+  sc_session_table_nuke(table);
+
+  // Capacity is sized so the expected entries fit under the load limit
+  table = sc_session_table_init(1000);
+  TEST_ASSERT_NOT_NULL(table);
+  TEST_ASSERT_EQUAL(2048, table->active.mask + 1);
+  sc_session_table_nuke(table);
+
+  // Nuking NULL is a no-op
+  sc_session_table_nuke(NULL);
+}
+
+void test_session_table_put_get(void) {
+  sc_session_table_t *table = sc_session_table_init(16);
+  TEST_ASSERT_NOT_NULL(table);
+
+  for (size_t i = 0; i < 8; i++) {
+    TEST_ASSERT_EQUAL(0, sc_session_table_put(table, test_key(i), &g_values[i]));
+  }
+  TEST_ASSERT_EQUAL(8, sc_session_table_count(table));
+
+  for (size_t i = 0; i < 8; i++) {
+    TEST_ASSERT_EQUAL_PTR(&g_values[i], sc_session_table_get(table, test_key(i)));
+  }
+  TEST_ASSERT_NULL(sc_session_table_get(table, test_key(8)));
+
+  sc_session_table_nuke(table);
+}
+
+void test_session_table_put_replaces(void) {
+  sc_session_table_t *table = sc_session_table_init(16);
+  TEST_ASSERT_NOT_NULL(table);
+
+  TEST_ASSERT_EQUAL(0, sc_session_table_put(table, 42, &g_values[0]));
+  TEST_ASSERT_EQUAL(0, sc_session_table_put(table, 42, &g_values[1]));
+  TEST_ASSERT_EQUAL(1, sc_session_table_count(table));
+  TEST_ASSERT_EQUAL_PTR(&g_values[1], sc_session_table_get(table, 42));
+
+  sc_session_table_nuke(table);
+}
+
+void test_session_table_put_rejects_null(void) {
+  sc_session_table_t *table = sc_session_table_init(16);
+  TEST_ASSERT_NOT_NULL(table);
+
+  errno = 0;
+  TEST_ASSERT_EQUAL(-1, sc_session_table_put(table, 1, NULL));
+  TEST_ASSERT_EQUAL(EINVAL, errno);
+  TEST_ASSERT_EQUAL(-1, sc_session_table_put(NULL, 1, &g_values[0]));
+  TEST_ASSERT_EQUAL(0, sc_session_table_count(table));
+
+  sc_session_table_nuke(table);
+}
+
+void test_session_table_remove(void) {
+  sc_session_table_t *table = sc_session_table_init(16);
+  TEST_ASSERT_NOT_NULL(table);
+
+  TEST_ASSERT_EQUAL(0, sc_session_table_put(table, 7, &g_values[7]));
+  TEST_ASSERT_NULL(sc_session_table_remove(table, 8));
+  TEST_ASSERT_EQUAL_PTR(&g_values[7], sc_session_table_remove(table, 7));
+  TEST_ASSERT_NULL(sc_session_table_remove(table, 7));
+  TEST_ASSERT_NULL(sc_session_table_get(table, 7));
+  TEST_ASSERT_EQUAL(0, sc_session_table_count(table));
+
+  sc_session_table_nuke(table);
+}
+
+void test_session_table_remove_keeps_probe_runs(void) {
+  // Fill a minimum-size table to its load limit so probe runs form, then
+  // delete entries one at a time and check everything else stays reachable
+  sc_session_table_t *table = sc_session_table_init(0);
+  TEST_ASSERT_NOT_NULL(table);
+  size_t fill = SC_SESSION_TABLE_MIN_CAPACITY * 3 / 4;
+
+  for (size_t i = 0; i < fill; i++) {
+    TEST_ASSERT_EQUAL(0, sc_session_table_put(table, test_key(i), &g_values[i]));
+  }
+  TEST_ASSERT_EQUAL(0, table->resizes);
+
+  for (size_t removed = 0; removed < fill; removed++) {
+    TEST_ASSERT_EQUAL_PTR(&g_values[removed], sc_session_table_remove(table, test_key(removed)));
+    for (size_t i = removed + 1; i < fill; i++) {
+      TEST_ASSERT_EQUAL_PTR(&g_values[i], sc_session_table_get(table, test_key(i)));
+    }
+  }
+
+  // No tombstones: every slot is empty again
+  for (size_t i = 0; i <= table->active.mask; i++) {
+    TEST_ASSERT_NULL(table->active.slots[i].value);
+  }
+
+  sc_session_table_nuke(table);
+}
+
+void test_session_table_incremental_resize(void) {
+  sc_session_table_t *table = sc_session_table_init(0);
+  TEST_ASSERT_NOT_NULL(table);
+
+  bool saw_migration = false;
+  for (size_t i = 0; i < TEST_ENTRIES; i++) {
+    TEST_ASSERT_EQUAL(0, sc_session_table_put(table, test_key(i), &g_values[i]));
+    saw_migration |= table->retired.slots != NULL;
+
+    // Entries stay visible whichever array currently holds them
+    for (size_t j = 0; j <= i; j += 97) {
+      TEST_ASSERT_EQUAL_PTR(&g_values[j], sc_session_table_get(table, test_key(j)));
+    }
+  }
+
+  TEST_ASSERT_TRUE(saw_migration);
+  TEST_ASSERT_TRUE(table->resizes > 0);
+  TEST_ASSERT_EQUAL(TEST_ENTRIES, sc_session_table_count(table));
+  for (size_t i = 0; i < TEST_ENTRIES; i++) {
+    TEST_ASSERT_EQUAL_PTR(&g_values[i], sc_session_table_get(table, test_key(i)));
+  }
+
+  sc_session_table_nuke(table);
+}
+
+void test_session_table_remove_during_resize(void) {
+  // Large enough that migration spans many operations
+  sc_session_table_t *table = sc_session_table_init(1000);
+  TEST_ASSERT_NOT_NULL(table);
+
+  // Insert until a resize starts, then remove everything while it is running
+  size_t inserted = 0;
+  while (!table->retired.slots) {
+    TEST_ASSERT_EQUAL(0, sc_session_table_put(table, test_key(inserted), &g_values[inserted]));
+    inserted++;
+  }
+
+  for (size_t i = 0; i < inserted; i++) {
+    TEST_ASSERT_EQUAL_PTR(&g_values[i], sc_session_table_remove(table, test_key(i)));
+    for (size_t j = i + 1; j < inserted; j++) {
+      TEST_ASSERT_EQUAL_PTR(&g_values[j], sc_session_table_get(table, test_key(j)));
+    }
+  }
+
+  TEST_ASSERT_EQUAL(0, sc_session_table_count(table));
+  TEST_ASSERT_NULL(table->retired.slots);
+
+  sc_session_table_nuke(table);
+}
+
+// Sweep callback removing entries whose value index is even
+static bool remove_even(uint64_t key, void *value, void *user_data) {
+  (void) key;
+  size_t *visits = user_data;
+  (*visits)++;
+  return (((int *) value - g_values) % 2) == 0;
+}
+
+void test_session_table_sweep(void) {
+  sc_session_table_t *table = sc_session_table_init(0);
+  TEST_ASSERT_NOT_NULL(table);
+
+  for (size_t i = 0; i < 1000; i++) {
+    TEST_ASSERT_EQUAL(0, sc_session_table_put(table, test_key(i), &g_values[i]));
+  }
+
+  size_t visits = 0;
+  sc_session_table_sweep(table, remove_even, &visits);
+
+  TEST_ASSERT_EQUAL(1000, visits);
+  TEST_ASSERT_EQUAL(500, sc_session_table_count(table));
+  for (size_t i = 0; i < 1000; i++) {
+    void *expected = (i % 2) ? &g_values[i] : NULL;
+    TEST_ASSERT_EQUAL_PTR(expected, sc_session_table_get(table, test_key(i)));
+  }
+
+  sc_session_table_nuke(table);
+}
+
+void test_session_table_key(void) {
+  struct sockaddr_in a;
+  struct sockaddr_in b;
+  memset(&a, 0, sizeof(a));
+  memset(&b, 0, sizeof(b));
+  a.sin_addr.s_addr = htonl(0x7f000001);
+  a.sin_port        = htons(5000);
+  b.sin_addr.s_addr = htonl(0x7f000001);
+  b.sin_port        = htons(5001);
+
+  TEST_ASSERT_TRUE(sc_session_table_key(&a) != sc_session_table_key(&b));
+  b.sin_port = a.sin_port;
+  TEST_ASSERT_TRUE(sc_session_table_key(&a) == sc_session_table_key(&b));
+}
+
+void test_session_table_random_operations(void) {
+  sc_session_table_t *table = sc_session_table_init(0);
+  TEST_ASSERT_NOT_NULL(table);
+
+  // Reference model: which of the keys are currently present
+  bool present[TEST_RANDOM_KEYS] = {false};
+  size_t count                   = 0;
+
+  srand(12345);
+  for (int op = 0; op < TEST_RANDOM_OPS; op++) {
+    size_t k = (size_t) rand() % TEST_RANDOM_KEYS;
+    int action = rand() % 3;
+
+    if (action == 0) {
+      TEST_ASSERT_EQUAL(0, sc_session_table_put(table, test_key(k), &g_values[k]));
+      if (!present[k]) {
+        present[k] = true;
+        count++;
+      }
+    } else if (action == 1) {
+      void *removed = sc_session_table_remove(table, test_key(k));
+      TEST_ASSERT_EQUAL_PTR(present[k] ? &g_values[k] : NULL, removed);
+      if (present[k]) {
+        present[k] = false;
+        count--;
+      }
+    } else {
+      void *found = sc_session_table_get(table, test_key(k));
+      TEST_ASSERT_EQUAL_PTR(present[k] ? &g_values[k] : NULL, found);
+    }
+
+    TEST_ASSERT_EQUAL(count, sc_session_table_count(table));
+  }
+
+  sc_session_table_nuke(table);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_session_table_init_nuke);
+  RUN_TEST(test_session_table_put_get);
+  RUN_TEST(test_session_table_put_replaces);
+  RUN_TEST(test_session_table_put_rejects_null);
+  RUN_TEST(test_session_table_remove);
+  RUN_TEST(test_session_table_remove_keeps_probe_runs);
+  RUN_TEST(test_session_table_incremental_resize);
+  RUN_TEST(test_session_table_remove_during_resize);
+  RUN_TEST(test_session_table_sweep);
+  RUN_TEST(test_session_table_key);
+  RUN_TEST(test_session_table_random_operations);
+
+  return UNITY_END();
+}
@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "../src/slab.h"
+
+// Unity framework functions
+void setUp(void);
+void tearDown(void);
+
+// Test function prototypes
+void test_slab_init_rejects_zero_dimensions(void);
+void test_slab_alloc_until_exhausted(void);
+void test_slab_slots_are_aligned_and_distinct(void);
+void test_slab_free_reuses_last_slot(void);
+void test_slab_preserves_contents(void);
+void test_slab_free_rejects_foreign_pointer(void);
+void test_slab_free_rejects_double_free(void);
+void test_slab_high_water(void);
+
+#define TEST_CAPACITY 8
+
+// Object deliberately not a multiple of the slot alignment
+typedef struct {
+  uint32_t id;
+  char name[70];
+} test_object_t;
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_slab_init_rejects_zero_dimensions(void) {
+  TEST_ASSERT_NULL(sc_slab_init(0, TEST_CAPACITY));
+  TEST_ASSERT_NULL(sc_slab_init(sizeof(test_object_t), 0));
+}
+
+void test_slab_alloc_until_exhausted(void) {
+  sc_slab_t *slab = sc_slab_init(sizeof(test_object_t), TEST_CAPACITY);
+  TEST_ASSERT_NOT_NULL(slab);
+  TEST_ASSERT_EQUAL(0, sc_slab_in_use(slab));
+
+  for (size_t i = 0; i < TEST_CAPACITY; i++) {
+    TEST_ASSERT_NOT_NULL(sc_slab_alloc(slab));
+    TEST_ASSERT_EQUAL(i + 1, sc_slab_in_use(slab));
+  }
+
+  TEST_ASSERT_NULL(sc_slab_alloc(slab));
+  TEST_ASSERT_EQUAL(1, slab->exhausted);
+  TEST_ASSERT_EQUAL(TEST_CAPACITY, sc_slab_in_use(slab));
+
+  sc_slab_nuke(slab);
+}
+
+void test_slab_slots_are_aligned_and_distinct(void) {
+  sc_slab_t *slab = sc_slab_init(sizeof(test_object_t), TEST_CAPACITY);
+  TEST_ASSERT_NOT_NULL(slab);
+  TEST_ASSERT_TRUE(slab->stride >= sizeof(test_object_t));
+  TEST_ASSERT_EQUAL(0, slab->stride % SC_SLAB_ALIGN);
+
+  test_object_t *objects[TEST_CAPACITY];
+  for (size_t i = 0; i < TEST_CAPACITY; i++) {
+    objects[i] = sc_slab_alloc(slab);
+    TEST_ASSERT_NOT_NULL(objects[i]);
+    TEST_ASSERT_EQUAL(0, (uintptr_t) objects[i] % SC_SLAB_ALIGN);
+    TEST_ASSERT_TRUE(sc_slab_contains(slab, objects[i]));
+    TEST_ASSERT_EQUAL_PTR(sc_slab_slot(slab, i), objects[i]);
+    TEST_ASSERT_EQUAL(i, sc_slab_index(slab, objects[i]));
+
+    // Writing a whole object must not disturb the others
+    memset(objects[i], (int) i + 1, sizeof(test_object_t));
+  }
+
+  for (size_t i = 0; i < TEST_CAPACITY; i++) {
+    TEST_ASSERT_EQUAL(i + 1, objects[i]->name[sizeof(objects[i]->name) - 1]);
+  }
+  TEST_ASSERT_NULL(sc_slab_slot(slab, TEST_CAPACITY));
+
+  sc_slab_nuke(slab);
+}
+
+void test_slab_free_reuses_last_slot(void) {
+  sc_slab_t *slab = sc_slab_init(sizeof(test_object_t), TEST_CAPACITY);
+  TEST_ASSERT_NOT_NULL(slab);
+
+  void *a = sc_slab_alloc(slab);
+  void *b = sc_slab_alloc(slab);
+  TEST_ASSERT_NOT_NULL(a);
+  TEST_ASSERT_NOT_NULL(b);
+
+  sc_slab_free(slab, a);
+  TEST_ASSERT_EQUAL(1, sc_slab_in_use(slab));
+  TEST_ASSERT_EQUAL_PTR(a, sc_slab_alloc(slab));
+
+  sc_slab_free(slab, b);
+  sc_slab_free(slab, a);
+  TEST_ASSERT_EQUAL(0, sc_slab_in_use(slab));
+
+  sc_slab_nuke(slab);
+}
+
+void test_slab_preserves_contents(void) {
+  sc_slab_t *slab = sc_slab_init(sizeof(test_object_t), 1);
+  TEST_ASSERT_NOT_NULL(slab);
+
+  // Owners may keep state in a returned slot and find it again on reuse
+  test_object_t *object = sc_slab_alloc(slab);
+  TEST_ASSERT_NOT_NULL(object);
+  object->id = 1234;
+  sc_slab_free(slab, object);
+
+  object = sc_slab_alloc(slab);
+  TEST_ASSERT_NOT_NULL(object);
+  TEST_ASSERT_EQUAL(1234, object->id);
+
+  sc_slab_nuke(slab);
+}
+
+void test_slab_free_rejects_foreign_pointer(void) {
+  sc_slab_t *slab = sc_slab_init(sizeof(test_object_t), TEST_CAPACITY);
+  TEST_ASSERT_NOT_NULL(slab);
+
+  test_object_t outside;
+  uint8_t *inside = sc_slab_alloc(slab);
+  TEST_ASSERT_NOT_NULL(inside);
+
+  TEST_ASSERT_FALSE(sc_slab_contains(slab, &outside));
+  TEST_ASSERT_FALSE(sc_slab_contains(slab, inside + 1));
+  TEST_ASSERT_EQUAL(SIZE_MAX, sc_slab_index(slab, &outside));
+  TEST_ASSERT_EQUAL(SIZE_MAX, sc_slab_index(slab, inside + 1));
+
+  // Neither pointer is returned to the free stack
+  sc_slab_free(slab, &outside);
+  sc_slab_free(slab, inside + 1);
+  TEST_ASSERT_EQUAL(1, sc_slab_in_use(slab));
+
+  sc_slab_nuke(slab);
+}
+
+void test_slab_free_rejects_double_free(void) {
+  sc_slab_t *slab = sc_slab_init(sizeof(test_object_t), TEST_CAPACITY);
+  TEST_ASSERT_NOT_NULL(slab);
+
+  void *kept  = sc_slab_alloc(slab);
+  void *freed = sc_slab_alloc(slab);
+  TEST_ASSERT_NOT_NULL(kept);
+  TEST_ASSERT_NOT_NULL(freed);
+
+  // The second free of a slot is ignored while other slots are in use
+  sc_slab_free(slab, freed);
+  sc_slab_free(slab, freed);
+  TEST_ASSERT_EQUAL(1, sc_slab_in_use(slab));
+
+  // So the slot has a single new owner
+  void *first  = sc_slab_alloc(slab);
+  void *second = sc_slab_alloc(slab);
+  TEST_ASSERT_EQUAL_PTR(freed, first);
+  TEST_ASSERT_NOT_EQUAL(first, second);
+  TEST_ASSERT_NOT_EQUAL(kept, second);
+  TEST_ASSERT_EQUAL(3, sc_slab_in_use(slab));
+
+  // A slot never handed out cannot be freed either
+  sc_slab_free(slab, sc_slab_slot(slab, TEST_CAPACITY - 1));
+  TEST_ASSERT_EQUAL(3, sc_slab_in_use(slab));
+
+  sc_slab_nuke(slab);
+}
+
+void test_slab_high_water(void) {
+  sc_slab_t *slab = sc_slab_init(sizeof(test_object_t), TEST_CAPACITY);
+  TEST_ASSERT_NOT_NULL(slab);
+
+  void *objects[3];
+  for (size_t i = 0; i < 3; i++) {
+    objects[i] = sc_slab_alloc(slab);
+  }
+  for (size_t i = 0; i < 3; i++) {
+    sc_slab_free(slab, objects[i]);
+  }
+  TEST_ASSERT_NOT_NULL(sc_slab_alloc(slab));
+
+  TEST_ASSERT_EQUAL(1, sc_slab_in_use(slab));
+  TEST_ASSERT_EQUAL(3, slab->high_water);
+
+  sc_slab_nuke(slab);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_slab_init_rejects_zero_dimensions);
+  RUN_TEST(test_slab_alloc_until_exhausted);
+  RUN_TEST(test_slab_slots_are_aligned_and_distinct);
+  RUN_TEST(test_slab_free_reuses_last_slot);
+  RUN_TEST(test_slab_preserves_contents);
+  RUN_TEST(test_slab_free_rejects_foreign_pointer);
+  RUN_TEST(test_slab_free_rejects_double_free);
+  RUN_TEST(test_slab_high_water);
+
+  return UNITY_END();
+}
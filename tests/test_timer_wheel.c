@@ -0,0 +1,309 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "../src/timer_wheel.h"
+
+// Unity framework functions
+void setUp(void);
+void tearDown(void);
+
+// Test function prototypes
+void test_timer_wheel_init_rejects_zero_tick(void);
+void test_timer_wheel_fires_at_deadline(void);
+void test_timer_wheel_rounds_up_to_tick(void);
+void test_timer_wheel_past_deadline_fires_next_advance(void);
+void test_timer_wheel_rearm_postpones(void);
+void test_timer_wheel_cancel(void);
+void test_timer_wheel_cascades_across_levels(void);
+void test_timer_wheel_beyond_range(void);
+void test_timer_wheel_callback_rearms(void);
+void test_timer_wheel_callback_cancels_other(void);
+void test_timer_wheel_next_expiry(void);
+void test_timer_wheel_random_deadlines(void);
+
+#define TEST_TICK_MS      10
+#define TEST_START_MS     1000000
+#define TEST_RANDOM_COUNT 2000
+
+// Timer with the bookkeeping the tests check
+typedef struct {
+  sc_timer_t timer;
+  uint64_t deadline_ms; // Requested deadline
+  uint64_t fired_ms;    // Clock value of the advance that fired it
+  int fire_count;
+} test_timer_t;
+
+static sc_timer_wheel_t *g_wheel = NULL;
+static uint64_t g_now_ms         = 0;
+
+void setUp(void) {
+  g_now_ms = TEST_START_MS;
+  g_wheel  = sc_timer_wheel_init(TEST_TICK_MS, g_now_ms);
+  TEST_ASSERT_NOT_NULL(g_wheel);
+}
+
+void tearDown(void) {
+  sc_timer_wheel_nuke(g_wheel);
+  g_wheel = NULL;
+}
+
+static void record_fire(sc_timer_t *timer, void *data) {
+  (void) timer;
+  test_timer_t *t = data;
+  t->fired_ms     = g_now_ms;
+  t->fire_count++;
+}
+
+static void arm(test_timer_t *t, uint64_t deadline_ms) {
+  t->deadline_ms = deadline_ms;
+  sc_timer_wheel_schedule(g_wheel, &t->timer, deadline_ms);
+}
+
+// Advance the clock to now_ms and return how many timers fired
+static size_t advance_to(uint64_t now_ms) {
+  g_now_ms = now_ms;
+  return sc_timer_wheel_advance(g_wheel, now_ms);
+}
+
+void test_timer_wheel_init_rejects_zero_tick(void) {
+  TEST_ASSERT_NULL(sc_timer_wheel_init(0, 0));
+}
+
+void test_timer_wheel_fires_at_deadline(void) {
+  test_timer_t t = {0};
+  sc_timer_init(&t.timer, record_fire, &t);
+  TEST_ASSERT_FALSE(sc_timer_pending(&t.timer));
+
+  arm(&t, TEST_START_MS + 500);
+  TEST_ASSERT_TRUE(sc_timer_pending(&t.timer));
+
+  TEST_ASSERT_EQUAL(0, advance_to(TEST_START_MS + 490));
+  TEST_ASSERT_EQUAL(0, t.fire_count);
+
+  TEST_ASSERT_EQUAL(1, advance_to(TEST_START_MS + 500));
+  TEST_ASSERT_EQUAL(1, t.fire_count);
+  TEST_ASSERT_FALSE(sc_timer_pending(&t.timer));
+
+  // Fires only once
+  TEST_ASSERT_EQUAL(0, advance_to(TEST_START_MS + 5000));
+  TEST_ASSERT_EQUAL(1, t.fire_count);
+}
+
+void test_timer_wheel_rounds_up_to_tick(void) {
+  test_timer_t t = {0};
+  sc_timer_init(&t.timer, record_fire, &t);
+
+  // A deadline inside a tick never fires before it is reached
+  arm(&t, TEST_START_MS + 25);
+  TEST_ASSERT_EQUAL(0, advance_to(TEST_START_MS + 29));
+  TEST_ASSERT_EQUAL(1, advance_to(TEST_START_MS + 30));
+}
+
+void test_timer_wheel_past_deadline_fires_next_advance(void) {
+  test_timer_t t = {0};
+  sc_timer_init(&t.timer, record_fire, &t);
+
+  advance_to(TEST_START_MS + 1000);
+  arm(&t, TEST_START_MS);
+  TEST_ASSERT_EQUAL(0, advance_to(TEST_START_MS + 1000));
+  TEST_ASSERT_EQUAL(1, advance_to(TEST_START_MS + 1000 + TEST_TICK_MS));
+}
+
+void test_timer_wheel_rearm_postpones(void) {
+  test_timer_t t = {0};
+  sc_timer_init(&t.timer, record_fire, &t);
+
+  // Re-arming on every "packet" keeps pushing the deadline out
+  for (uint64_t ms = 0; ms < 60000; ms += 1000) {
+    arm(&t, TEST_START_MS + ms + 30000);
+    TEST_ASSERT_EQUAL(0, advance_to(TEST_START_MS + ms));
+  }
+  TEST_ASSERT_EQUAL(1, g_wheel->count);
+
+  TEST_ASSERT_EQUAL(0, advance_to(TEST_START_MS + 59000 + 29990));
+  TEST_ASSERT_EQUAL(1, advance_to(TEST_START_MS + 59000 + 30000));
+  TEST_ASSERT_EQUAL(0, g_wheel->count);
+}
+
+void test_timer_wheel_cancel(void) {
+  test_timer_t t = {0};
+  sc_timer_init(&t.timer, record_fire, &t);
+
+  arm(&t, TEST_START_MS + 100);
+  sc_timer_wheel_cancel(g_wheel, &t.timer);
+  TEST_ASSERT_FALSE(sc_timer_pending(&t.timer));
+  TEST_ASSERT_EQUAL(0, g_wheel->count);
+
+  // Cancelling an idle timer is harmless
+  sc_timer_wheel_cancel(g_wheel, &t.timer);
+
+  TEST_ASSERT_EQUAL(0, advance_to(TEST_START_MS + 1000));
+  TEST_ASSERT_EQUAL(0, t.fire_count);
+}
+
+void test_timer_wheel_cascades_across_levels(void) {
+  // One timer per level: 0.5 s, 30 s, 1 h and 24 h at 10 ms ticks
+  const uint64_t delays[] = {500, 30000, 3600000, 86400000};
+  test_timer_t timers[4]  = {0};
+
+  for (size_t i = 0; i < 4; i++) {
+    sc_timer_init(&timers[i].timer, record_fire, &timers[i]);
+    arm(&timers[i], TEST_START_MS + delays[i]);
+  }
+
+  // Advance in uneven steps so cascades happen mid-advance
+  for (uint64_t ms = TEST_START_MS; ms <= TEST_START_MS + delays[3]; ms += 7777) {
+    advance_to(ms);
+  }
+  advance_to(TEST_START_MS + delays[3]);
+
+  for (size_t i = 0; i < 4; i++) {
+    TEST_ASSERT_EQUAL(1, timers[i].fire_count);
+    TEST_ASSERT_TRUE(timers[i].fired_ms >= timers[i].deadline_ms);
+    TEST_ASSERT_TRUE(timers[i].fired_ms < timers[i].deadline_ms + 7777);
+  }
+}
+
+void test_timer_wheel_beyond_range(void) {
+  test_timer_t t = {0};
+  sc_timer_init(&t.timer, record_fire, &t);
+
+  // Further out than SLOTS^LEVELS ticks (about 46 h at 10 ms)
+  uint64_t deadline = TEST_START_MS + 100ull * 3600 * 1000;
+  arm(&t, deadline);
+
+  for (uint64_t ms = TEST_START_MS; ms < deadline; ms += 60000) {
+    advance_to(ms);
+  }
+  TEST_ASSERT_EQUAL(0, t.fire_count);
+
+  advance_to(deadline);
+  TEST_ASSERT_EQUAL(1, t.fire_count);
+}
+
+// Callback that re-arms its own timer three times
+static void rearm_fire(sc_timer_t *timer, void *data) {
+  test_timer_t *t = data;
+  t->fire_count++;
+  if (t->fire_count < 3) {
+    sc_timer_wheel_schedule(g_wheel, timer, g_now_ms + 100);
+  }
+}
+
+void test_timer_wheel_callback_rearms(void) {
+  test_timer_t t = {0};
+  sc_timer_init(&t.timer, rearm_fire, &t);
+
+  arm(&t, TEST_START_MS + 100);
+  advance_to(TEST_START_MS + 100);
+  TEST_ASSERT_EQUAL(1, t.fire_count);
+  advance_to(TEST_START_MS + 200);
+  TEST_ASSERT_EQUAL(2, t.fire_count);
+  advance_to(TEST_START_MS + 300);
+  TEST_ASSERT_EQUAL(3, t.fire_count);
+  TEST_ASSERT_FALSE(sc_timer_pending(&t.timer));
+}
+
+// Callback that cancels the timer passed as data
+static void cancel_other(sc_timer_t *timer, void *data) {
+  (void) timer;
+  sc_timer_wheel_cancel(g_wheel, data);
+}
+
+void test_timer_wheel_callback_cancels_other(void) {
+  test_timer_t victim = {0};
+  sc_timer_t killer;
+  sc_timer_init(&victim.timer, record_fire, &victim);
+  sc_timer_init(&killer, cancel_other, &victim.timer);
+
+  // Same slot: the killer is linked last so it runs first
+  arm(&victim, TEST_START_MS + 100);
+  sc_timer_wheel_schedule(g_wheel, &killer, TEST_START_MS + 100);
+
+  TEST_ASSERT_EQUAL(1, advance_to(TEST_START_MS + 100));
+  TEST_ASSERT_EQUAL(0, victim.fire_count);
+  TEST_ASSERT_EQUAL(0, g_wheel->count);
+}
+
+void test_timer_wheel_next_expiry(void) {
+  TEST_ASSERT_EQUAL_UINT64(UINT64_MAX, sc_timer_wheel_next_expiry(g_wheel));
+
+  test_timer_t near = {0};
+  test_timer_t far  = {0};
+  sc_timer_init(&near.timer, record_fire, &near);
+  sc_timer_init(&far.timer, record_fire, &far);
+
+  // Within the first level the answer is exact
+  arm(&near, TEST_START_MS + 250);
+  TEST_ASSERT_EQUAL_UINT64(TEST_START_MS + 250, sc_timer_wheel_next_expiry(g_wheel));
+
+  // Further out it is a lower bound that never overshoots
+  sc_timer_wheel_cancel(g_wheel, &near.timer);
+  arm(&far, TEST_START_MS + 30000);
+  uint64_t next = sc_timer_wheel_next_expiry(g_wheel);
+  TEST_ASSERT_TRUE(next > TEST_START_MS);
+  TEST_ASSERT_TRUE(next <= TEST_START_MS + 30000);
+
+  // Following the hint reaches the deadline without skipping past it
+  int wakeups = 0;
+  while (far.fire_count == 0) {
+    next = sc_timer_wheel_next_expiry(g_wheel);
+    TEST_ASSERT_TRUE(next <= far.deadline_ms);
+    advance_to(next);
+    wakeups++;
+  }
+  TEST_ASSERT_EQUAL_UINT64(far.deadline_ms, far.fired_ms);
+  TEST_ASSERT_TRUE(wakeups < 10);
+}
+
+void test_timer_wheel_random_deadlines(void) {
+  test_timer_t *timers = calloc(TEST_RANDOM_COUNT, sizeof(test_timer_t));
+  TEST_ASSERT_NOT_NULL(timers);
+
+  srand(4242);
+  uint64_t last = TEST_START_MS;
+  for (size_t i = 0; i < TEST_RANDOM_COUNT; i++) {
+    sc_timer_init(&timers[i].timer, record_fire, &timers[i]);
+    uint64_t deadline = TEST_START_MS + (uint64_t) rand() % 3600000;
+    arm(&timers[i], deadline);
+    if (deadline > last) {
+      last = deadline;
+    }
+  }
+
+  // Tick-by-tick steps would take too long; 1 s steps bound the lateness
+  for (uint64_t ms = TEST_START_MS; ms <= last + 1000; ms += 1000) {
+    advance_to(ms);
+  }
+
+  for (size_t i = 0; i < TEST_RANDOM_COUNT; i++) {
+    TEST_ASSERT_EQUAL(1, timers[i].fire_count);
+    TEST_ASSERT_TRUE(timers[i].fired_ms >= timers[i].deadline_ms);
+    TEST_ASSERT_TRUE(timers[i].fired_ms < timers[i].deadline_ms + 1000 + TEST_TICK_MS);
+  }
+  TEST_ASSERT_EQUAL(0, g_wheel->count);
+
+  free(timers);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_timer_wheel_init_rejects_zero_tick);
+  RUN_TEST(test_timer_wheel_fires_at_deadline);
+  RUN_TEST(test_timer_wheel_rounds_up_to_tick);
+  RUN_TEST(test_timer_wheel_past_deadline_fires_next_advance);
+  RUN_TEST(test_timer_wheel_rearm_postpones);
+  RUN_TEST(test_timer_wheel_cancel);
+  RUN_TEST(test_timer_wheel_cascades_across_levels);
+  RUN_TEST(test_timer_wheel_beyond_range);
+  RUN_TEST(test_timer_wheel_callback_rearms);
+  RUN_TEST(test_timer_wheel_callback_cancels_other);
+  RUN_TEST(test_timer_wheel_next_expiry);
+  RUN_TEST(test_timer_wheel_random_deadlines);
+
+  return UNITY_END();
+}
@@ -0,0 +1,278 @@
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "../src/tls_arena.h"
+
+// Unity framework functions
+void setUp(void);
+void tearDown(void);
+
+// Test function prototypes
+void test_tls_arena_calloc_zeroes_and_aligns(void);
+void test_tls_arena_calloc_rejects_overflow(void);
+void test_tls_arena_large_blocks(void);
+void test_tls_arena_cache_reuses_blocks(void);
+void test_tls_arena_counts_handshake_and_established(void);
+void test_tls_arena_release_returns_cache_to_pool(void);
+void test_tls_arena_free_outside_arena(void);
+void test_tls_arena_free_in_other_arena(void);
+void test_tls_arena_threads(void);
+
+#define TEST_THREADS    4
+#define TEST_ITERATIONS 2000
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_tls_arena_calloc_zeroes_and_aligns(void) {
+  static const size_t sizes[] = {0, 1, 16, 17, 100, 1000, 4096, 5000, SC_TLS_ARENA_MAX_BLOCK - 16};
+
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    uint8_t *p = sc_tls_arena_calloc(1, sizes[i]);
+    TEST_ASSERT_NOT_NULL(p);
+    TEST_ASSERT_EQUAL(0, (uintptr_t) p % 16);
+    for (size_t j = 0; j < sizes[i]; j++) {
+      TEST_ASSERT_EQUAL(0, p[j]);
+    }
+    memset(p, 0xa5, sizes[i]);
+    sc_tls_arena_free(p);
+
+    // A recycled block is zeroed again
+    p = sc_tls_arena_calloc(sizes[i], 1);
+    TEST_ASSERT_NOT_NULL(p);
+    for (size_t j = 0; j < sizes[i]; j++) {
+      TEST_ASSERT_EQUAL(0, p[j]);
+    }
+    sc_tls_arena_free(p);
+  }
+
+  sc_tls_arena_free(NULL);
+}
+
+void test_tls_arena_calloc_rejects_overflow(void) {
+  TEST_ASSERT_NULL(sc_tls_arena_calloc(SIZE_MAX, 2));
+  TEST_ASSERT_NULL(sc_tls_arena_calloc(1, SIZE_MAX));
+  TEST_ASSERT_NULL(sc_tls_arena_calloc(1, UINT32_MAX));
+}
+
+void test_tls_arena_large_blocks(void) {
+  sc_tls_pool_stats_t before = sc_tls_arena_pool_stats();
+
+  uint8_t *p = sc_tls_arena_calloc(2, SC_TLS_ARENA_MAX_BLOCK);
+  TEST_ASSERT_NOT_NULL(p);
+  TEST_ASSERT_EQUAL(0, p[2 * SC_TLS_ARENA_MAX_BLOCK - 1]);
+  sc_tls_pool_stats_t during = sc_tls_arena_pool_stats();
+  TEST_ASSERT_TRUE(during.large_bytes >= before.large_bytes + 2 * SC_TLS_ARENA_MAX_BLOCK);
+  TEST_ASSERT_EQUAL(before.in_use_bytes, during.in_use_bytes);
+
+  sc_tls_arena_free(p);
+  TEST_ASSERT_EQUAL(before.large_bytes, sc_tls_arena_pool_stats().large_bytes);
+}
+
+void test_tls_arena_cache_reuses_blocks(void) {
+  sc_tls_arena_t arena;
+  sc_tls_arena_init(&arena);
+  sc_tls_arena_t *previous = sc_tls_arena_enter(&arena);
+
+  void *p = sc_tls_arena_calloc(1, 100);
+  TEST_ASSERT_NOT_NULL(p);
+  sc_tls_arena_free(p);
+  TEST_ASSERT_TRUE(arena.cached_bytes > 0);
+
+  // The arena hands its own freed block out again, then has none cached
+  TEST_ASSERT_EQUAL_PTR(p, sc_tls_arena_calloc(100, 1));
+  TEST_ASSERT_EQUAL(0, arena.cached_bytes);
+  sc_tls_arena_free(p);
+
+  sc_tls_arena_release(&arena);
+  TEST_ASSERT_EQUAL(0, arena.cached_bytes);
+  for (size_t i = 0; i < SC_TLS_ARENA_CLASSES; i++) {
+    TEST_ASSERT_NULL(arena.cache[i]);
+  }
+  sc_tls_arena_leave(previous);
+}
+
+void test_tls_arena_counts_handshake_and_established(void) {
+  sc_tls_arena_t arena;
+  sc_tls_arena_init(&arena);
+  sc_tls_arena_t *previous = sc_tls_arena_enter(&arena);
+
+  // Set-up allocations before the handshake count as established
+  void *setup = sc_tls_arena_calloc(1, 1000);
+  TEST_ASSERT_NOT_NULL(setup);
+  size_t setup_bytes = arena.established_bytes;
+  TEST_ASSERT_TRUE(setup_bytes >= 1000);
+  TEST_ASSERT_EQUAL(0, arena.handshake_bytes);
+
+  sc_tls_arena_begin_handshake(&arena);
+  void *temporary = sc_tls_arena_calloc(1, 3000);
+  void *kept      = sc_tls_arena_calloc(1, 200);
+  TEST_ASSERT_NOT_NULL(temporary);
+  TEST_ASSERT_NOT_NULL(kept);
+  size_t peak = arena.handshake_bytes;
+  TEST_ASSERT_TRUE(peak >= 3200);
+  TEST_ASSERT_EQUAL(setup_bytes, arena.established_bytes);
+
+  sc_tls_arena_free(temporary);
+  TEST_ASSERT_TRUE(arena.handshake_bytes < peak);
+  TEST_ASSERT_EQUAL(peak, arena.handshake_peak);
+  TEST_ASSERT_TRUE(arena.cached_bytes > 0);
+
+  // What the handshake left is established; what it freed is released
+  size_t kept_bytes = arena.handshake_bytes;
+  sc_tls_arena_end_handshake(&arena);
+  TEST_ASSERT_EQUAL(0, arena.handshake_bytes);
+  TEST_ASSERT_EQUAL(setup_bytes + kept_bytes, arena.established_bytes);
+  TEST_ASSERT_EQUAL(peak, arena.handshake_peak);
+  TEST_ASSERT_EQUAL(0, arena.cached_bytes);
+
+  sc_tls_arena_free(kept);
+  sc_tls_arena_free(setup);
+  TEST_ASSERT_EQUAL(0, arena.established_bytes);
+  TEST_ASSERT_EQUAL(0, arena.handshake_bytes);
+
+  sc_tls_arena_release(&arena);
+  sc_tls_arena_leave(previous);
+}
+
+void test_tls_arena_release_returns_cache_to_pool(void) {
+  sc_tls_arena_t arena;
+  sc_tls_arena_init(&arena);
+  sc_tls_pool_stats_t before = sc_tls_arena_pool_stats();
+
+  sc_tls_arena_t *previous = sc_tls_arena_enter(&arena);
+  void *blocks[64];
+  for (size_t i = 0; i < 64; i++) {
+    blocks[i] = sc_tls_arena_calloc(1, 16 + i * 64);
+    TEST_ASSERT_NOT_NULL(blocks[i]);
+  }
+  for (size_t i = 0; i < 64; i++) {
+    sc_tls_arena_free(blocks[i]);
+  }
+  sc_tls_arena_leave(previous);
+
+  // Cached blocks still count as handed out until the arena lets them go
+  TEST_ASSERT_EQUAL(before.in_use_bytes + arena.cached_bytes,
+                    sc_tls_arena_pool_stats().in_use_bytes);
+  sc_tls_arena_release(&arena);
+  TEST_ASSERT_EQUAL(before.in_use_bytes, sc_tls_arena_pool_stats().in_use_bytes);
+}
+
+void test_tls_arena_free_outside_arena(void) {
+  sc_tls_arena_t arena;
+  sc_tls_arena_init(&arena);
+  sc_tls_pool_stats_t before = sc_tls_arena_pool_stats();
+
+  sc_tls_arena_t *previous = sc_tls_arena_enter(&arena);
+  void *p                  = sc_tls_arena_calloc(1, 64);
+  sc_tls_arena_leave(previous);
+  TEST_ASSERT_NOT_NULL(p);
+
+  // Freed with no arena entered, the block goes straight back to the pool
+  sc_tls_arena_free(p);
+  TEST_ASSERT_EQUAL(0, arena.cached_bytes);
+  TEST_ASSERT_EQUAL(before.in_use_bytes, sc_tls_arena_pool_stats().in_use_bytes);
+}
+
+void test_tls_arena_free_in_other_arena(void) {
+  sc_tls_arena_t a;
+  sc_tls_arena_t b;
+  sc_tls_arena_init(&a);
+  sc_tls_arena_init(&b);
+  sc_tls_pool_stats_t before = sc_tls_arena_pool_stats();
+
+  sc_tls_arena_t *previous = sc_tls_arena_enter(&a);
+  void *established        = sc_tls_arena_calloc(1, 64);
+  sc_tls_arena_begin_handshake(&a);
+  void *handshake = sc_tls_arena_calloc(1, 200);
+  sc_tls_arena_leave(previous);
+  TEST_ASSERT_NOT_NULL(established);
+  TEST_ASSERT_NOT_NULL(handshake);
+  TEST_ASSERT_TRUE(a.established_bytes > 0);
+  TEST_ASSERT_TRUE(a.handshake_bytes > 0);
+
+  // Freed while b is entered, the blocks leave a's counts and never reach b
+  previous = sc_tls_arena_enter(&b);
+  sc_tls_arena_free(established);
+  sc_tls_arena_free(handshake);
+  sc_tls_arena_leave(previous);
+  TEST_ASSERT_EQUAL(0, a.established_bytes);
+  TEST_ASSERT_EQUAL(0, a.handshake_bytes);
+  TEST_ASSERT_EQUAL(0, a.cached_bytes);
+  TEST_ASSERT_EQUAL(0, b.established_bytes);
+  TEST_ASSERT_EQUAL(0, b.handshake_bytes);
+  TEST_ASSERT_EQUAL(0, b.cached_bytes);
+  TEST_ASSERT_EQUAL(before.in_use_bytes, sc_tls_arena_pool_stats().in_use_bytes);
+}
+
+// Returned by a thread whose arena went wrong
+static int g_churn_failed;
+
+static void *churn(void *arg) {
+  (void) arg;
+  sc_tls_arena_t arena;
+  sc_tls_arena_init(&arena);
+  sc_tls_arena_t *previous = sc_tls_arena_enter(&arena);
+
+  void *live[16] = {NULL};
+  for (size_t i = 0; i < TEST_ITERATIONS; i++) {
+    size_t slot = i % 16;
+    sc_tls_arena_free(live[slot]);
+    if (i % 100 == 0) {
+      sc_tls_arena_begin_handshake(&arena);
+    } else if (i % 100 == 50) {
+      sc_tls_arena_end_handshake(&arena);
+    }
+    live[slot] = sc_tls_arena_calloc(1, (i * 37) % 6000);
+    if (!live[slot]) {
+      return &g_churn_failed;
+    }
+    memset(live[slot], (int) slot, (i * 37) % 6000);
+  }
+  for (size_t slot = 0; slot < 16; slot++) {
+    sc_tls_arena_free(live[slot]);
+  }
+
+  bool empty = arena.handshake_bytes == 0 && arena.established_bytes == 0;
+  sc_tls_arena_release(&arena);
+  sc_tls_arena_leave(previous);
+  return empty ? NULL : &g_churn_failed;
+}
+
+void test_tls_arena_threads(void) {
+  sc_tls_pool_stats_t before = sc_tls_arena_pool_stats();
+
+  pthread_t threads[TEST_THREADS];
+  for (size_t i = 0; i < TEST_THREADS; i++) {
+    TEST_ASSERT_EQUAL(0, pthread_create(&threads[i], NULL, churn, NULL));
+  }
+  for (size_t i = 0; i < TEST_THREADS; i++) {
+    void *result = &threads[i];
+    TEST_ASSERT_EQUAL(0, pthread_join(threads[i], &result));
+    TEST_ASSERT_NULL(result);
+  }
+
+  TEST_ASSERT_EQUAL(before.in_use_bytes, sc_tls_arena_pool_stats().in_use_bytes);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_tls_arena_calloc_zeroes_and_aligns);
+  RUN_TEST(test_tls_arena_calloc_rejects_overflow);
+  RUN_TEST(test_tls_arena_large_blocks);
+  RUN_TEST(test_tls_arena_cache_reuses_blocks);
+  RUN_TEST(test_tls_arena_counts_handshake_and_established);
+  RUN_TEST(test_tls_arena_release_returns_cache_to_pool);
+  RUN_TEST(test_tls_arena_free_outside_arena);
+  RUN_TEST(test_tls_arena_free_in_other_arena);
+  RUN_TEST(test_tls_arena_threads);
+
+  return UNITY_END();
+}
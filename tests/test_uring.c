@@ -0,0 +1,350 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "unity.h"
+
+#include "../src/uring.h"
+
+// Unity framework functions
+void setUp(void);
+void tearDown(void);
+
+// Test function prototypes
+void test_uring_init_rejects_bad_dimensions(void);
+void test_uring_wait_times_out(void);
+void test_uring_recv_datagrams(void);
+void test_uring_recv_survives_buffer_exhaustion(void);
+void test_uring_recv_drops_truncated(void);
+void test_uring_send_batch(void);
+void test_uring_send_slots_exhausted(void);
+void test_uring_watch(void);
+void test_uring_notify_rearms(void);
+void test_uring_notify_several(void);
+
+#define TEST_SLOT_SIZE   64
+#define TEST_BUFFERS     8
+#define TEST_SEND_SLOTS  4
+#define TEST_TIMEOUT_MS  1000
+
+static int g_recv_fd = -1;
+static int g_send_fd = -1;
+static struct sockaddr_in g_recv_addr;
+static struct sockaddr_in g_send_addr;
+
+void setUp(void) {
+  g_recv_fd = socket(AF_INET, SOCK_DGRAM, 0);
+  TEST_ASSERT_NOT_EQUAL(-1, g_recv_fd);
+  g_send_fd = socket(AF_INET, SOCK_DGRAM, 0);
+  TEST_ASSERT_NOT_EQUAL(-1, g_send_fd);
+
+  // Bind both sockets to ephemeral loopback ports
+  struct sockaddr_in *addrs[] = {&g_recv_addr, &g_send_addr};
+  int fds[]                   = {g_recv_fd, g_send_fd};
+  for (size_t i = 0; i < 2; i++) {
+    memset(addrs[i], 0, sizeof(*addrs[i]));
+    addrs[i]->sin_family      = AF_INET;
+    addrs[i]->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    TEST_ASSERT_EQUAL(0, bind(fds[i], (struct sockaddr *) addrs[i], sizeof(*addrs[i])));
+    socklen_t len = sizeof(*addrs[i]);
+    TEST_ASSERT_EQUAL(0, getsockname(fds[i], (struct sockaddr *) addrs[i], &len));
+  }
+
+  int flags = fcntl(g_recv_fd, F_GETFL, 0);
+  TEST_ASSERT_NOT_EQUAL(-1, fcntl(g_recv_fd, F_SETFL, flags | O_NONBLOCK));
+}
+
+void tearDown(void) {
+  if (g_recv_fd >= 0) {
+    close(g_recv_fd);
+    g_recv_fd = -1;
+  }
+  if (g_send_fd >= 0) {
+    close(g_send_fd);
+    g_send_fd = -1;
+  }
+}
+
+// Helper to send a numbered datagram to the receiving socket
+static void send_datagram(int id, size_t len) {
+  uint8_t payload[TEST_SLOT_SIZE * 2];
+  memset(payload, id, sizeof(payload));
+  ssize_t sent =
+    sendto(g_send_fd, payload, len, 0, (struct sockaddr *) &g_recv_addr, sizeof(g_recv_addr));
+  TEST_ASSERT_EQUAL((ssize_t) len, sent);
+}
+
+// Helper to wait until at least want datagrams have been collected
+static size_t collect(sc_uring_t *uring, size_t want, uint8_t *ids) {
+  size_t total = 0;
+  for (int attempt = 0; attempt < 10 && total < want; attempt++) {
+    TEST_ASSERT_EQUAL(0, sc_uring_wait(uring, TEST_TIMEOUT_MS));
+
+    const sc_ingress_packet_t *packets;
+    size_t count;
+    while ((count = sc_uring_recv(uring, &packets)) > 0) {
+      for (size_t i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL(g_send_addr.sin_port, packets[i].addr.sin_port);
+        TEST_ASSERT_EQUAL(sizeof(struct sockaddr_in), packets[i].addr_len);
+        if (ids) {
+          ids[total] = packets[i].data[0];
+        }
+        total++;
+      }
+    }
+  }
+  return total;
+}
+
+void test_uring_init_rejects_bad_dimensions(void) {
+  TEST_ASSERT_NULL(sc_uring_init(-1, TEST_BUFFERS, TEST_SEND_SLOTS, TEST_SLOT_SIZE));
+  TEST_ASSERT_NULL(sc_uring_init(g_recv_fd, 0, TEST_SEND_SLOTS, TEST_SLOT_SIZE));
+  TEST_ASSERT_NULL(sc_uring_init(g_recv_fd, 6, TEST_SEND_SLOTS, TEST_SLOT_SIZE));
+  TEST_ASSERT_NULL(sc_uring_init(g_recv_fd, TEST_BUFFERS, 0, TEST_SLOT_SIZE));
+  TEST_ASSERT_NULL(sc_uring_init(g_recv_fd, TEST_BUFFERS, TEST_SEND_SLOTS, 0));
+}
+
+void test_uring_wait_times_out(void) {
+  sc_uring_t *uring = sc_uring_init(g_recv_fd, TEST_BUFFERS, TEST_SEND_SLOTS, TEST_SLOT_SIZE);
+  TEST_ASSERT_NOT_NULL(uring);
+
+  TEST_ASSERT_EQUAL(0, sc_uring_wait(uring, 10));
+
+  const sc_ingress_packet_t *packets;
+  TEST_ASSERT_EQUAL(0, sc_uring_recv(uring, &packets));
+  TEST_ASSERT_FALSE(sc_uring_woken(uring));
+
+  sc_uring_nuke(uring);
+}
+
+void test_uring_recv_datagrams(void) {
+  sc_uring_t *uring = sc_uring_init(g_recv_fd, TEST_BUFFERS, TEST_SEND_SLOTS, TEST_SLOT_SIZE);
+  TEST_ASSERT_NOT_NULL(uring);
+
+  // Arm the receive before anything arrives
+  TEST_ASSERT_EQUAL(0, sc_uring_wait(uring, 0));
+
+  for (int i = 0; i < 5; i++) {
+    send_datagram(i + 1, (size_t) (10 + i));
+  }
+
+  uint8_t ids[5];
+  TEST_ASSERT_EQUAL(5, collect(uring, 5, ids));
+  for (int i = 0; i < 5; i++) {
+    TEST_ASSERT_EQUAL(i + 1, ids[i]);
+  }
+  TEST_ASSERT_EQUAL(5, sc_uring_stats(uring)->datagrams);
+
+  sc_uring_nuke(uring);
+}
+
+void test_uring_recv_survives_buffer_exhaustion(void) {
+  sc_uring_t *uring = sc_uring_init(g_recv_fd, TEST_BUFFERS, TEST_SEND_SLOTS, TEST_SLOT_SIZE);
+  TEST_ASSERT_NOT_NULL(uring);
+  TEST_ASSERT_EQUAL(0, sc_uring_wait(uring, 0));
+
+  // More datagrams than buffers: receiving pauses and is re-armed once the
+  // first batch has been handed back
+  for (int i = 0; i < 3 * TEST_BUFFERS; i++) {
+    send_datagram(i + 1, 16);
+  }
+
+  uint8_t ids[3 * TEST_BUFFERS];
+  TEST_ASSERT_EQUAL(3 * TEST_BUFFERS, collect(uring, 3 * TEST_BUFFERS, ids));
+  for (int i = 0; i < 3 * TEST_BUFFERS; i++) {
+    TEST_ASSERT_EQUAL(i + 1, ids[i]);
+  }
+
+  sc_uring_nuke(uring);
+}
+
+void test_uring_recv_drops_truncated(void) {
+  sc_uring_t *uring = sc_uring_init(g_recv_fd, TEST_BUFFERS, TEST_SEND_SLOTS, TEST_SLOT_SIZE);
+  TEST_ASSERT_NOT_NULL(uring);
+  TEST_ASSERT_EQUAL(0, sc_uring_wait(uring, 0));
+
+  send_datagram(1, TEST_SLOT_SIZE);
+  send_datagram(2, TEST_SLOT_SIZE + 1);
+  send_datagram(3, 8);
+
+  uint8_t ids[3];
+  TEST_ASSERT_EQUAL(2, collect(uring, 2, ids));
+  TEST_ASSERT_EQUAL(1, ids[0]);
+  TEST_ASSERT_EQUAL(3, ids[1]);
+  TEST_ASSERT_EQUAL(1, sc_uring_stats(uring)->truncated);
+
+  sc_uring_nuke(uring);
+}
+
+void test_uring_send_batch(void) {
+  sc_uring_t *uring = sc_uring_init(g_recv_fd, TEST_BUFFERS, TEST_SEND_SLOTS, TEST_SLOT_SIZE);
+  TEST_ASSERT_NOT_NULL(uring);
+
+  // Queue a full set of sends; the caller's buffer is reused between them
+  uint8_t payload[16];
+  for (int i = 0; i < TEST_SEND_SLOTS; i++) {
+    memset(payload, i + 1, sizeof(payload));
+    TEST_ASSERT_EQUAL((ssize_t) sizeof(payload),
+                      sc_uring_send(uring, (struct sockaddr *) &g_send_addr, sizeof(g_send_addr),
+                                    payload, sizeof(payload)));
+  }
+
+  // One wait submits them all
+  TEST_ASSERT_EQUAL(0, sc_uring_wait(uring, TEST_TIMEOUT_MS));
+  uint64_t enters = sc_uring_stats(uring)->enters;
+  TEST_ASSERT_EQUAL(1, enters);
+
+  for (int i = 0; i < TEST_SEND_SLOTS; i++) {
+    uint8_t buf[TEST_SLOT_SIZE];
+    ssize_t len = recv(g_send_fd, buf, sizeof(buf), 0);
+    TEST_ASSERT_EQUAL((ssize_t) sizeof(payload), len);
+    TEST_ASSERT_EQUAL(i + 1, buf[0]);
+  }
+
+  TEST_ASSERT_EQUAL(-1, sc_uring_send(uring, (struct sockaddr *) &g_send_addr,
+                                      sizeof(g_send_addr), payload, TEST_SLOT_SIZE + 1));
+
+  sc_uring_nuke(uring);
+}
+
+void test_uring_send_slots_exhausted(void) {
+  sc_uring_t *uring = sc_uring_init(g_recv_fd, TEST_BUFFERS, TEST_SEND_SLOTS, TEST_SLOT_SIZE);
+  TEST_ASSERT_NOT_NULL(uring);
+
+  uint8_t payload[8] = {0};
+  for (int i = 0; i < TEST_SEND_SLOTS; i++) {
+    TEST_ASSERT_EQUAL((ssize_t) sizeof(payload),
+                      sc_uring_send(uring, (struct sockaddr *) &g_send_addr, sizeof(g_send_addr),
+                                    payload, sizeof(payload)));
+  }
+  TEST_ASSERT_EQUAL(-1, sc_uring_send(uring, (struct sockaddr *) &g_send_addr,
+                                      sizeof(g_send_addr), payload, sizeof(payload)));
+  TEST_ASSERT_EQUAL(1, sc_uring_stats(uring)->send_dropped);
+
+  // Slots come back once their completions are collected
+  const sc_ingress_packet_t *packets;
+  for (int attempt = 0; attempt < 10 && sc_uring_stats(uring)->sends < TEST_SEND_SLOTS;
+       attempt++) {
+    TEST_ASSERT_EQUAL(0, sc_uring_wait(uring, TEST_TIMEOUT_MS));
+    sc_uring_recv(uring, &packets);
+  }
+  TEST_ASSERT_EQUAL(TEST_SEND_SLOTS, sc_uring_stats(uring)->sends);
+  TEST_ASSERT_EQUAL((ssize_t) sizeof(payload),
+                    sc_uring_send(uring, (struct sockaddr *) &g_send_addr, sizeof(g_send_addr),
+                                  payload, sizeof(payload)));
+
+  sc_uring_nuke(uring);
+}
+
+void test_uring_watch(void) {
+  sc_uring_t *uring = sc_uring_init(g_recv_fd, TEST_BUFFERS, TEST_SEND_SLOTS, TEST_SLOT_SIZE);
+  TEST_ASSERT_NOT_NULL(uring);
+
+  int event_fd = eventfd(0, EFD_CLOEXEC);
+  TEST_ASSERT_NOT_EQUAL(-1, event_fd);
+  TEST_ASSERT_EQUAL(0, sc_uring_watch(uring, event_fd));
+
+  const sc_ingress_packet_t *packets;
+  TEST_ASSERT_EQUAL(0, sc_uring_wait(uring, 10));
+  sc_uring_recv(uring, &packets);
+  TEST_ASSERT_FALSE(sc_uring_woken(uring));
+
+  uint64_t one = 1;
+  TEST_ASSERT_EQUAL(sizeof(one), write(event_fd, &one, sizeof(one)));
+  TEST_ASSERT_EQUAL(0, sc_uring_wait(uring, TEST_TIMEOUT_MS));
+  sc_uring_recv(uring, &packets);
+  TEST_ASSERT_TRUE(sc_uring_woken(uring));
+
+  sc_uring_nuke(uring);
+  close(event_fd);
+}
+
+// Helper to time one wait in milliseconds
+static double timed_wait_ms(sc_uring_t *uring, int timeout_ms) {
+  struct timespec start;
+  struct timespec end;
+  const sc_ingress_packet_t *packets;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  TEST_ASSERT_EQUAL(0, sc_uring_wait(uring, timeout_ms));
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  sc_uring_recv(uring, &packets);
+  return (double) (end.tv_sec - start.tv_sec) * 1e3 + (double) (end.tv_nsec - start.tv_nsec) / 1e6;
+}
+
+void test_uring_notify_rearms(void) {
+  sc_uring_t *uring = sc_uring_init(g_recv_fd, TEST_BUFFERS, TEST_SEND_SLOTS, TEST_SLOT_SIZE);
+  TEST_ASSERT_NOT_NULL(uring);
+
+  int event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  TEST_ASSERT_NOT_EQUAL(-1, event_fd);
+  TEST_ASSERT_EQUAL(0, sc_uring_notify(uring, event_fd));
+
+  // Quiet descriptor: the wait runs to its timeout
+  TEST_ASSERT_TRUE(timed_wait_ms(uring, 50) >= 40.0);
+
+  // Readable descriptor: every wait returns at once until it is read
+  uint64_t one = 1;
+  TEST_ASSERT_EQUAL(sizeof(one), write(event_fd, &one, sizeof(one)));
+  TEST_ASSERT_TRUE(timed_wait_ms(uring, TEST_TIMEOUT_MS) < TEST_TIMEOUT_MS / 2);
+  TEST_ASSERT_TRUE(timed_wait_ms(uring, TEST_TIMEOUT_MS) < TEST_TIMEOUT_MS / 2);
+  TEST_ASSERT_FALSE(sc_uring_woken(uring));
+
+  uint64_t value;
+  TEST_ASSERT_EQUAL(sizeof(value), read(event_fd, &value, sizeof(value)));
+  TEST_ASSERT_TRUE(timed_wait_ms(uring, 50) >= 40.0);
+
+  sc_uring_nuke(uring);
+  close(event_fd);
+}
+
+void test_uring_notify_several(void) {
+  sc_uring_t *uring = sc_uring_init(g_recv_fd, TEST_BUFFERS, TEST_SEND_SLOTS, TEST_SLOT_SIZE);
+  TEST_ASSERT_NOT_NULL(uring);
+
+  int event_fds[4];
+  for (size_t i = 0; i < 4; i++) {
+    event_fds[i] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    TEST_ASSERT_NOT_EQUAL(-1, event_fds[i]);
+    TEST_ASSERT_EQUAL(0, sc_uring_notify(uring, event_fds[i]));
+  }
+  TEST_ASSERT_EQUAL(-1, sc_uring_notify(uring, event_fds[0]));
+  TEST_ASSERT_TRUE(timed_wait_ms(uring, 50) >= 40.0);
+
+  // Each descriptor wakes the wait on its own, and is polled again afterwards
+  uint64_t value = 1;
+  for (size_t i = 0; i < 4; i++) {
+    TEST_ASSERT_EQUAL(sizeof(value), write(event_fds[i], &value, sizeof(value)));
+    TEST_ASSERT_TRUE(timed_wait_ms(uring, TEST_TIMEOUT_MS) < TEST_TIMEOUT_MS / 2);
+    TEST_ASSERT_EQUAL(sizeof(value), read(event_fds[i], &value, sizeof(value)));
+  }
+  TEST_ASSERT_TRUE(timed_wait_ms(uring, 50) >= 40.0);
+
+  sc_uring_nuke(uring);
+  for (size_t i = 0; i < 4; i++) {
+    close(event_fds[i]);
+  }
+}
+
+int main(void) {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_uring_init_rejects_bad_dimensions);
+  RUN_TEST(test_uring_wait_times_out);
+  RUN_TEST(test_uring_recv_datagrams);
+  RUN_TEST(test_uring_recv_survives_buffer_exhaustion);
+  RUN_TEST(test_uring_recv_drops_truncated);
+  RUN_TEST(test_uring_send_batch);
+  RUN_TEST(test_uring_send_slots_exhausted);
+  RUN_TEST(test_uring_watch);
+  RUN_TEST(test_uring_notify_rearms);
+  RUN_TEST(test_uring_notify_several);
+
+  return UNITY_END();
+}